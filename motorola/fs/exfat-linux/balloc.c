@@ -6,41 +6,10 @@
 #include <linux/blkdev.h>
 #include <linux/slab.h>
 #include <linux/buffer_head.h>
+#include <linux/bitmap.h>
 
 #include "exfat_fs.h"
 
-static const unsigned char free_bit[] = {
-	0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4, 0, 1, 0, 2,/*  0 ~  19*/
-	0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 5, 0, 1, 0, 2, 0, 1, 0, 3,/* 20 ~  39*/
-	0, 1, 0, 2, 0, 1, 0, 4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2,/* 40 ~  59*/
-	0, 1, 0, 6, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4,/* 60 ~  79*/
-	0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 5, 0, 1, 0, 2,/* 80 ~  99*/
-	0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4, 0, 1, 0, 2, 0, 1, 0, 3,/*100 ~ 119*/
-	0, 1, 0, 2, 0, 1, 0, 7, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2,/*120 ~ 139*/
-	0, 1, 0, 4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 5,/*140 ~ 159*/
-	0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4, 0, 1, 0, 2,/*160 ~ 179*/
-	0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 6, 0, 1, 0, 2, 0, 1, 0, 3,/*180 ~ 199*/
-	0, 1, 0, 2, 0, 1, 0, 4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2,/*200 ~ 219*/
-	0, 1, 0, 5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4,/*220 ~ 239*/
-	0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0                /*240 ~ 254*/
-};
-
-static const unsigned char used_bit[] = {
-	0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 1, 2, 2, 3,/*  0 ~  19*/
-	2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5, 1, 2, 2, 3, 2, 3, 3, 4,/* 20 ~  39*/
-	2, 3, 3, 4, 3, 4, 4, 5, 2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5,/* 40 ~  59*/
-	4, 5, 5, 6, 1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,/* 60 ~  79*/
-	2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 2, 3, 3, 4,/* 80 ~  99*/
-	3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 3, 4, 4, 5, 4, 5, 5, 6,/*100 ~ 119*/
-	4, 5, 5, 6, 5, 6, 6, 7, 1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4,/*120 ~ 139*/
-	3, 4, 4, 5, 2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,/*140 ~ 159*/
-	2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 3, 4, 4, 5,/*160 ~ 179*/
-	4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7, 2, 3, 3, 4, 3, 4, 4, 5,/*180 ~ 199*/
-	3, 4, 4, 5, 4, 5, 5, 6, 3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6,/*200 ~ 219*/
-	5, 6, 6, 7, 3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,/*220 ~ 239*/
-	4, 5, 5, 6, 5, 6, 6, 7, 5, 6, 6, 7, 6, 7, 7, 8             /*240 ~ 255*/
-};
-
 /*
  *  Allocation Bitmap Management Functions
  */
@@ -157,6 +126,36 @@ int exfat_set_bitmap(struct inode *inode, unsigned int clu,bool sync)
 	return 0;
 }
 
+/*
+ * Mark "len" clusters starting at "clu" as used, writing each bitmap sector
+ * back once rather than once per cluster.
+ */
+int exfat_set_bitmap_run(struct inode *inode, unsigned int clu,
+		unsigned int len, bool sync)
+{
+	int i, b;
+	unsigned int ent_idx, end_idx;
+	struct super_block *sb = inode->i_sb;
+	struct exfat_sb_info *sbi = EXFAT_SB(sb);
+
+	WARN_ON(clu < EXFAT_FIRST_CLUSTER);
+	ent_idx = CLUSTER_TO_BITMAP_ENT(clu);
+	end_idx = ent_idx + len;
+
+	while (ent_idx < end_idx) {
+		i = BITMAP_OFFSET_SECTOR_INDEX(sb, ent_idx);
+		b = BITMAP_OFFSET_BIT_IN_SECTOR(sb, ent_idx);
+
+		do {
+			set_bit_le(b++, sbi->vol_amap[i]->b_data);
+			ent_idx++;
+		} while (ent_idx < end_idx && b < BITS_PER_SECTOR(sb));
+
+		exfat_update_bh(sbi->vol_amap[i], sync);
+	}
+	return 0;
+}
+
 void exfat_clear_bitmap(struct inode *inode, unsigned int clu, bool sync)
 {
 	int i, b;
@@ -187,79 +186,212 @@ void exfat_clear_bitmap(struct inode *inode, unsigned int clu, bool sync)
 	}
 }
 
+/*
+ * Number of bits of the allocation bitmap stored in the map_i-th sector; only the last sector
+ * can be partially used.
+ */
+static unsigned int exfat_bitmap_sector_bits(struct super_block *sb,
+		unsigned int map_i)
+{
+	struct exfat_sb_info *sbi = EXFAT_SB(sb);
+	unsigned int total_clus = EXFAT_DATA_CLUSTER_COUNT(sbi);
+	unsigned int start = map_i * BITS_PER_SECTOR(sb);
+
+	return min_t(unsigned int, BITS_PER_SECTOR(sb), total_clus - start);
+}
+
 /*
  * If the value of "clu" is 0, it means cluster 2 which is the first cluster of
  * the cluster heap.
  */
 unsigned int exfat_find_free_bitmap(struct super_block *sb, unsigned int clu)
 {
-	unsigned int i, map_i, map_b, ent_idx;
-	unsigned int clu_base, clu_free;
-	unsigned char k, clu_mask;
+	unsigned int i, map_i, bit, nbits, ent_idx;
 	struct exfat_sb_info *sbi = EXFAT_SB(sb);
 
 	WARN_ON(clu < EXFAT_FIRST_CLUSTER);
-	ent_idx = CLUSTER_TO_BITMAP_ENT(clu);
-	clu_base = BITMAP_ENT_TO_CLUSTER(ent_idx & ~(BITS_PER_BYTE_MASK));
-	clu_mask = IGNORED_BITS_REMAINED(clu, clu_base);
+	if (clu >= sbi->num_clusters)
+		clu = EXFAT_FIRST_CLUSTER;
 
+	ent_idx = CLUSTER_TO_BITMAP_ENT(clu);
 	map_i = BITMAP_OFFSET_SECTOR_INDEX(sb, ent_idx);
-	map_b = BITMAP_OFFSET_BYTE_IN_SECTOR(sb, ent_idx);
-
-	for (i = EXFAT_FIRST_CLUSTER; i < sbi->num_clusters;
-	     i += BITS_PER_BYTE) {
-		k = *(sbi->vol_amap[map_i]->b_data + map_b);
-		if (clu_mask > 0) {
-			k |= clu_mask;
-			clu_mask = 0;
-		}
-		if (k < 0xFF) {
-			clu_free = clu_base + free_bit[k];
-			if (clu_free < sbi->num_clusters)
-				return clu_free;
-		}
-		clu_base += BITS_PER_BYTE;
-
-		if (++map_b >= sb->s_blocksize ||
-		    clu_base >= sbi->num_clusters) {
-			if (++map_i >= sbi->map_sectors) {
-				clu_base = EXFAT_FIRST_CLUSTER;
-				map_i = 0;
-			}
-			map_b = 0;
-		}
+	bit = BITMAP_OFFSET_BIT_IN_SECTOR(sb, ent_idx);
+
+	/*
+	 * Scan a sector worth of bits at a time, wrapping around to the first
+	 * sector. The starting sector is visited twice so that the bits before
+	 * "clu" are checked last.
+	 */
+	for (i = 0; i <= sbi->map_sectors; i++) {
+		nbits = exfat_bitmap_sector_bits(sb, map_i);
+		bit = find_next_zero_bit_le(sbi->vol_amap[map_i]->b_data,
+				nbits, bit);
+		if (bit < nbits)
+			return BITMAP_ENT_TO_CLUSTER(map_i * BITS_PER_SECTOR(sb) +
+					bit);
+
+		bit = 0;
+		if (++map_i >= sbi->map_sectors)
+			map_i = 0;
 	}
 
 	return EXFAT_EOF_CLUSTER;
 }
 
-int exfat_count_used_clusters(struct super_block *sb, unsigned int *ret_count)
+/*
+ * Return the first cluster in [clu, end) whose bitmap bit is set ("used") or
+ * clear (!"used"), or "end" if there is none. Unlike exfat_find_free_bitmap()
+ * this never wraps around.
+ */
+static unsigned int exfat_find_bitmap(struct super_block *sb, unsigned int clu,
+		unsigned int end, bool used)
 {
+	unsigned int map_i, bit, nbits, ent_idx, end_idx;
 	struct exfat_sb_info *sbi = EXFAT_SB(sb);
-	unsigned int count = 0;
-	unsigned int i, map_i = 0, map_b = 0;
-	unsigned int total_clus = EXFAT_DATA_CLUSTER_COUNT(sbi);
-	unsigned int last_mask = total_clus & BITS_PER_BYTE_MASK;
-	unsigned char clu_bits;
-	const unsigned char last_bit_mask[] = {0, 0b00000001, 0b00000011,
-		0b00000111, 0b00001111, 0b00011111, 0b00111111, 0b01111111};
-
-	total_clus &= ~last_mask;
-	for (i = 0; i < total_clus; i += BITS_PER_BYTE) {
-		clu_bits = *(sbi->vol_amap[map_i]->b_data + map_b);
-		count += used_bit[clu_bits];
-		if (++map_b >= (unsigned int)sb->s_blocksize) {
-			map_i++;
-			map_b = 0;
+	const void *map;
+
+	ent_idx = CLUSTER_TO_BITMAP_ENT(clu);
+	end_idx = CLUSTER_TO_BITMAP_ENT(end);
+
+	while (ent_idx < end_idx) {
+		map_i = BITMAP_OFFSET_SECTOR_INDEX(sb, ent_idx);
+		bit = BITMAP_OFFSET_BIT_IN_SECTOR(sb, ent_idx);
+		nbits = min(exfat_bitmap_sector_bits(sb, map_i),
+				bit + end_idx - ent_idx);
+		map = sbi->vol_amap[map_i]->b_data;
+
+		if (used)
+			bit = find_next_bit_le(map, nbits, bit);
+		else
+			bit = find_next_zero_bit_le(map, nbits, bit);
+		if (bit < nbits)
+			return BITMAP_ENT_TO_CLUSTER(map_i * BITS_PER_SECTOR(sb) +
+					bit);
+
+		ent_idx = (map_i + 1) * BITS_PER_SECTOR(sb);
+	}
+
+	return end;
+}
+
+/*
+ * Number of free clusters starting at "clu", up to "max". Returns 0 if "clu"
+ * itself is in use or out of range.
+ */
+unsigned int exfat_free_run_length(struct super_block *sb, unsigned int clu,
+		unsigned int max)
+{
+	struct exfat_sb_info *sbi = EXFAT_SB(sb);
+	unsigned int end;
+
+	if (clu < EXFAT_FIRST_CLUSTER || clu >= sbi->num_clusters)
+		return 0;
+
+	end = min_t(unsigned int, sbi->num_clusters, clu + max);
+	return exfat_find_bitmap(sb, clu, end, true) - clu;
+}
+
+/* Track the longest free run in [clu, end); true once one reaches "want" */
+static bool exfat_scan_free_runs(struct super_block *sb, unsigned int clu,
+		unsigned int end, unsigned int want, unsigned int *run_clu,
+		unsigned int *run_len)
+{
+	unsigned int next;
+
+	while (clu < end) {
+		clu = exfat_find_bitmap(sb, clu, end, false);
+		if (clu >= end)
+			break;
+
+		next = exfat_find_bitmap(sb, clu, end, true);
+		if (next - clu > *run_len) {
+			*run_clu = clu;
+			*run_len = next - clu;
+			if (*run_len >= want)
+				return true;
 		}
+		clu = next;
 	}
 
-	if (last_mask) {
-		clu_bits = *(sbi->vol_amap[map_i]->b_data + map_b);
-		clu_bits &= last_bit_mask[last_mask];
-		count += used_bit[clu_bits];
+	return false;
+}
+
+/*
+ * Find the first run of at least "want" free clusters at or after "clu",
+ * looking no further than EXFAT_FREE_RUN_SCAN_MAX clusters ahead (wrapping
+ * around to the start of the cluster heap), so that an allocation never
+ * walks the whole bitmap under s_lock. If there is no such run the longest
+ * one seen is returned instead, and if the window has no free cluster at
+ * all this falls back to the plain first-fit search. The length of the
+ * returned run, capped at "want", is stored in "ret_len".
+ */
+unsigned int exfat_find_free_run(struct super_block *sb, unsigned int clu,
+		unsigned int want, unsigned int *ret_len)
+{
+	struct exfat_sb_info *sbi = EXFAT_SB(sb);
+	unsigned int run_clu = EXFAT_EOF_CLUSTER, run_len = 0;
+	unsigned int span, wrap_span;
+
+	*ret_len = 0;
+
+	if (clu < EXFAT_FIRST_CLUSTER || clu >= sbi->num_clusters)
+		clu = EXFAT_FIRST_CLUSTER;
+
+	span = min_t(unsigned int, EXFAT_FREE_RUN_SCAN_MAX,
+			sbi->num_clusters - clu);
+	wrap_span = min_t(unsigned int, EXFAT_FREE_RUN_SCAN_MAX - span,
+			clu - EXFAT_FIRST_CLUSTER);
+
+	if (!exfat_scan_free_runs(sb, clu, clu + span, want,
+			&run_clu, &run_len) && wrap_span)
+		exfat_scan_free_runs(sb, EXFAT_FIRST_CLUSTER,
+				EXFAT_FIRST_CLUSTER + wrap_span, want,
+				&run_clu, &run_len);
+
+	if (run_clu == EXFAT_EOF_CLUSTER) {
+		run_clu = exfat_find_free_bitmap(sb, clu);
+		if (run_clu == EXFAT_EOF_CLUSTER)
+			return EXFAT_EOF_CLUSTER;
 	}
 
+	/* the window may have cut the run short */
+	if (run_len < want)
+		run_len = exfat_free_run_length(sb, run_clu, want);
+
+	*ret_len = min(run_len, want);
+	return run_clu;
+}
+
+/* Number of set bits in the first "nbits" bits of a little-endian bitmap */
+static unsigned int exfat_bitmap_weight(const unsigned char *bitmap,
+		unsigned int nbits)
+{
+	unsigned int nbytes = nbits / BITS_PER_BYTE;
+	unsigned int nwords = nbytes / sizeof(unsigned long);
+	unsigned int last_bits = nbits & BITS_PER_BYTE_MASK;
+	unsigned int i, count;
+
+	/* whole words hold whole bytes, so the bit order does not matter */
+	count = bitmap_weight((const unsigned long *)bitmap,
+			nwords * BITS_PER_LONG);
+	for (i = nwords * sizeof(unsigned long); i < nbytes; i++)
+		count += hweight8(bitmap[i]);
+	if (last_bits)
+		count += hweight8(bitmap[nbytes] & ((1 << last_bits) - 1));
+
+	return count;
+}
+
+int exfat_count_used_clusters(struct super_block *sb, unsigned int *ret_count)
+{
+	struct exfat_sb_info *sbi = EXFAT_SB(sb);
+	unsigned int count = 0;
+	unsigned int map_i;
+
+	for (map_i = 0; map_i < sbi->map_sectors; map_i++)
+		count += exfat_bitmap_weight(sbi->vol_amap[map_i]->b_data,
+				exfat_bitmap_sector_bits(sb, map_i));
+
 	*ret_count = count;
 	return 0;
 }
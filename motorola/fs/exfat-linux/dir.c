@@ -6,6 +6,7 @@
 #include <linux/slab.h>
 #include <linux/bio.h>
 #include <linux/buffer_head.h>
+#include <linux/hash.h>
 
 #include "exfat_fs.h"
 
@@ -910,6 +911,336 @@ enum {
 	DIRENT_STEP_SECD,
 };
 
+/*
+ * Name hash index of a directory.
+ *
+ * Maps the name hash kept in each stream entry to the position of the file
+ * entry, so that a lookup only has to compare the names of the few files
+ * sharing that hash instead of walking the whole directory. It is built by
+ * one scan on the first lookup and kept up to date by create, rename, unlink
+ * and rmdir, all under sbi->s_lock. Nodes are charged to a per-volume budget;
+ * a directory that does not fit is simply not indexed.
+ */
+struct exfat_dir_index_node {
+	struct hlist_node hnode;
+	int entry;
+	u16 name_hash;
+};
+
+struct exfat_dir_index {
+	struct hlist_head *buckets;
+	unsigned int bits;
+	unsigned int count;
+	bool disabled; /* over budget or failed, don't build again */
+};
+
+static void exfat_dir_index_clear(struct super_block *sb,
+		struct exfat_dir_index *index)
+{
+	struct exfat_dir_index_node *n;
+	struct hlist_node *tmp;
+	unsigned int i;
+
+	if (!index->buckets)
+		return;
+
+	for (i = 0; i < (1U << index->bits); i++) {
+		hlist_for_each_entry_safe(n, tmp, &index->buckets[i], hnode) {
+			hlist_del(&n->hnode);
+			kfree(n);
+		}
+	}
+	atomic_sub(index->count, &EXFAT_SB(sb)->dir_index_nodes);
+	index->count = 0;
+}
+
+/* Drop the nodes but remember not to index this directory again */
+static void exfat_dir_index_disable(struct super_block *sb,
+		struct exfat_dir_index *index)
+{
+	exfat_dir_index_clear(sb, index);
+	kfree(index->buckets);
+	index->buckets = NULL;
+	index->disabled = true;
+}
+
+/* Double the bucket table once chains get long, if memory allows */
+static void exfat_dir_index_grow(struct exfat_dir_index *index)
+{
+	struct exfat_dir_index_node *n;
+	struct hlist_node *tmp;
+	struct hlist_head *buckets;
+	unsigned int i, bits = index->bits + 1;
+
+	buckets = kcalloc(1U << bits, sizeof(*buckets),
+			GFP_NOFS | __GFP_NOWARN);
+	if (!buckets)
+		return;
+
+	for (i = 0; i < (1U << index->bits); i++) {
+		hlist_for_each_entry_safe(n, tmp, &index->buckets[i], hnode) {
+			hlist_del(&n->hnode);
+			hlist_add_head(&n->hnode,
+				&buckets[hash_32(n->name_hash, bits)]);
+		}
+	}
+	kfree(index->buckets);
+	index->buckets = buckets;
+	index->bits = bits;
+}
+
+static int exfat_dir_index_insert(struct super_block *sb,
+		struct exfat_dir_index *index, int entry, u16 name_hash)
+{
+	struct exfat_sb_info *sbi = EXFAT_SB(sb);
+	struct exfat_dir_index_node *n;
+
+	if (atomic_inc_return(&sbi->dir_index_nodes) > EXFAT_DIR_INDEX_BUDGET)
+		goto over_budget;
+
+	n = kmalloc(sizeof(*n), GFP_NOFS);
+	if (!n)
+		goto over_budget;
+
+	n->entry = entry;
+	n->name_hash = name_hash;
+	hlist_add_head(&n->hnode,
+		&index->buckets[hash_32(name_hash, index->bits)]);
+	index->count++;
+
+	if (index->count > (2U << index->bits) &&
+	    index->bits < EXFAT_DIR_INDEX_MAX_BITS)
+		exfat_dir_index_grow(index);
+	return 0;
+
+over_budget:
+	atomic_dec(&sbi->dir_index_nodes);
+	return -ENOMEM;
+}
+
+static int exfat_dir_index_build(struct super_block *sb,
+		struct exfat_inode_info *ei, struct exfat_chain *p_dir)
+{
+	int i, dentry = 0, file_entry = -1, ret = 0;
+	unsigned int entry_type;
+	struct exfat_dir_index *index;
+	struct exfat_chain clu;
+	struct exfat_dentry *ep;
+	struct buffer_head *bh;
+	struct exfat_sb_info *sbi = EXFAT_SB(sb);
+
+	index = kzalloc(sizeof(*index), GFP_NOFS);
+	if (!index)
+		return -ENOMEM;
+
+	index->bits = EXFAT_DIR_INDEX_MIN_BITS;
+	index->buckets = kcalloc(1U << index->bits, sizeof(*index->buckets),
+			GFP_NOFS);
+	if (!index->buckets) {
+		kfree(index);
+		return -ENOMEM;
+	}
+	ei->dir_index = index;
+
+	exfat_chain_dup(&clu, p_dir);
+	while (clu.dir != EXFAT_EOF_CLUSTER) {
+		for (i = 0; i < sbi->dentries_per_clu; i++, dentry++) {
+			ep = exfat_get_dentry(sb, &clu, i, &bh, NULL);
+			if (!ep) {
+				ret = -EIO;
+				goto disable;
+			}
+
+			entry_type = exfat_get_entry_type(ep);
+			if (entry_type == TYPE_FILE || entry_type == TYPE_DIR) {
+				file_entry = dentry;
+			} else if (entry_type == TYPE_STREAM &&
+				   file_entry == dentry - 1) {
+				ret = exfat_dir_index_insert(sb, index,
+					file_entry, le16_to_cpu(
+						ep->dentry.stream.name_hash));
+			}
+			brelse(bh);
+
+			if (ret)
+				goto disable;
+			if (entry_type == TYPE_UNUSED)
+				return 0;
+		}
+
+		if (clu.flags == ALLOC_NO_FAT_CHAIN) {
+			if (--clu.size > 0)
+				clu.dir++;
+			else
+				clu.dir = EXFAT_EOF_CLUSTER;
+		} else {
+			if (exfat_get_next_cluster(sb, &(clu.dir))) {
+				ret = -EIO;
+				goto disable;
+			}
+		}
+	}
+	return 0;
+
+disable:
+	exfat_dir_index_disable(sb, index);
+	return ret;
+}
+
+/*
+ * Check the entry set at "entry" against p_uniname.
+ * Returns 1 on a match, 0 if it is another file, -EIO if it can't be read.
+ */
+static int exfat_dir_index_match(struct super_block *sb,
+		struct exfat_chain *p_dir, int entry,
+		struct exfat_uni_name *p_uniname, unsigned int type)
+{
+	int i, len, name_len = 0, ret = 0;
+	unsigned short entry_uniname[16], unichar, *uniname;
+	struct exfat_entry_set_cache *es;
+	struct exfat_dentry *ep;
+
+	es = exfat_get_dentry_set(sb, p_dir, entry, ES_ALL_ENTRIES);
+	if (!es)
+		return -EIO;
+
+	ep = exfat_get_dentry_cached(es, 0);
+	if (type != TYPE_ALL && type != exfat_get_entry_type(ep))
+		goto out;
+
+	ep = exfat_get_dentry_cached(es, 1);
+	if (ep->dentry.stream.name_len != p_uniname->name_len ||
+	    le16_to_cpu(ep->dentry.stream.name_hash) != p_uniname->name_hash)
+		goto out;
+
+	uniname = p_uniname->name;
+	for (i = 2; i < es->num_entries && name_len < p_uniname->name_len;
+	     i++, uniname += EXFAT_FILE_NAME_LEN) {
+		ep = exfat_get_dentry_cached(es, i);
+		if (exfat_get_entry_type(ep) != TYPE_EXTEND)
+			goto out;
+
+		len = exfat_extract_uni_name(ep, entry_uniname);
+		name_len += len;
+
+		unichar = *(uniname + len);
+		*(uniname + len) = 0x0;
+		ret = exfat_uniname_ncmp(sb, uniname, entry_uniname, len);
+		*(uniname + len) = unichar;
+		if (ret) {
+			ret = 0;
+			goto out;
+		}
+	}
+	ret = name_len == p_uniname->name_len;
+out:
+	exfat_free_dentry_set(es, false);
+	return ret;
+}
+
+/*
+ * Look p_uniname up through the index of ei.
+ * Returns the entry position, -ENOENT, or -EAGAIN if the directory has to be
+ * scanned instead.
+ */
+static int exfat_dir_index_find(struct super_block *sb,
+		struct exfat_inode_info *ei, struct exfat_chain *p_dir,
+		struct exfat_uni_name *p_uniname, unsigned int type,
+		struct exfat_hint *hint_opt)
+{
+	struct exfat_dir_index *index = ei->dir_index;
+	struct exfat_dir_index_node *n;
+	struct exfat_sb_info *sbi = EXFAT_SB(sb);
+	unsigned int clu;
+	int ret;
+
+	hlist_for_each_entry(n, &index->buckets[hash_32(p_uniname->name_hash,
+			index->bits)], hnode) {
+		if (n->name_hash != p_uniname->name_hash)
+			continue;
+
+		ret = exfat_dir_index_match(sb, p_dir, n->entry, p_uniname,
+				type);
+		if (!ret)
+			continue;
+		if (ret < 0 || exfat_walk_fat_chain(sb, p_dir,
+				EXFAT_DEN_TO_B(n->entry), &clu))
+			goto fallback;
+
+		hint_opt->clu = clu;
+		hint_opt->eidx = n->entry & (sbi->dentries_per_clu - 1);
+		return n->entry;
+	}
+	return -ENOENT;
+
+fallback:
+	exfat_dir_index_disable(sb, index);
+	return -EAGAIN;
+}
+
+/* Record a new entry set of "dir" at "entry", named p_uniname */
+void exfat_dir_index_add(struct inode *dir, int entry,
+		struct exfat_uni_name *p_uniname)
+{
+	struct exfat_dir_index *index = EXFAT_I(dir)->dir_index;
+
+	if (!index || index->disabled)
+		return;
+
+	if (exfat_dir_index_insert(dir->i_sb, index, entry,
+			p_uniname->name_hash))
+		exfat_dir_index_disable(dir->i_sb, index);
+}
+
+/*
+ * Forget the entry set of "dir" at "entry". Must be called while the entry
+ * is still on disk, since its name hash is read from the stream entry.
+ */
+void exfat_dir_index_del(struct inode *dir, struct exfat_chain *p_dir,
+		int entry)
+{
+	struct exfat_dir_index *index = EXFAT_I(dir)->dir_index;
+	struct exfat_dir_index_node *n;
+	struct exfat_dentry *ep;
+	struct buffer_head *bh;
+	u16 name_hash;
+
+	if (!index || index->disabled)
+		return;
+
+	ep = exfat_get_dentry(dir->i_sb, p_dir, entry + 1, &bh, NULL);
+	if (!ep) {
+		exfat_dir_index_disable(dir->i_sb, index);
+		return;
+	}
+	name_hash = le16_to_cpu(ep->dentry.stream.name_hash);
+	brelse(bh);
+
+	hlist_for_each_entry(n, &index->buckets[hash_32(name_hash,
+			index->bits)], hnode) {
+		if (n->entry == entry) {
+			hlist_del(&n->hnode);
+			kfree(n);
+			index->count--;
+			atomic_dec(&EXFAT_SB(dir->i_sb)->dir_index_nodes);
+			return;
+		}
+	}
+}
+
+void exfat_dir_index_free(struct inode *dir)
+{
+	struct exfat_dir_index *index = EXFAT_I(dir)->dir_index;
+
+	if (!index)
+		return;
+
+	exfat_dir_index_clear(dir->i_sb, index);
+	kfree(index->buckets);
+	kfree(index);
+	EXFAT_I(dir)->dir_index = NULL;
+}
+
 /*
  * @ei:         inode info of parent directory
  * @p_dir:      directory structure of parent directory
@@ -937,6 +1268,16 @@ int exfat_find_dir_entry(struct super_block *sb, struct exfat_inode_info *ei,
 
 	dentries_per_clu = sbi->dentries_per_clu;
 
+	if (!ei->dir_index)
+		exfat_dir_index_build(sb, ei, p_dir);
+	if (ei->dir_index && !ei->dir_index->disabled) {
+		dentry = exfat_dir_index_find(sb, ei, p_dir, p_uniname, type,
+				hint_opt);
+		if (dentry != -EAGAIN)
+			return dentry;
+		dentry = 0;
+	}
+
 	exfat_chain_dup(&clu, p_dir);
 
 	if (hint_stat->eidx) {
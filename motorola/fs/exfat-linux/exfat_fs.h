@@ -14,6 +14,7 @@
 #include "compat.h"
 #include "version.h"
 #include "exfat_raw.h"
+#include "exfat_uapi.h"
 
 #define EXFAT_SUPER_MAGIC       0x2011BAB0UL
 #define EXFAT_ROOT_INO		1
@@ -80,6 +81,24 @@ enum {
 #define EXFAT_HINT_NONE		-1
 #define EXFAT_MIN_SUBDIR	2
 
+/*
+ * Free space a regular file looks for when it cannot grow in place, scaled
+ * with the size of the file (see exfat_alloc_cluster()).
+ */
+#define EXFAT_ALLOC_WINDOW_MIN	(1 << 20)
+#define EXFAT_ALLOC_WINDOW_MAX	(64 << 20)
+
+/* Clusters exfat_find_free_run() looks at before falling back to first-fit */
+#define EXFAT_FREE_RUN_SCAN_MAX	(1 << 16)
+
+/*
+ * Directory name hash index: nodes (one per file) a volume may hold across
+ * all of its directory indexes, and the largest bucket table per directory.
+ */
+#define EXFAT_DIR_INDEX_BUDGET		(1 << 17)
+#define EXFAT_DIR_INDEX_MIN_BITS	4
+#define EXFAT_DIR_INDEX_MAX_BITS	13
+
 /*
  * helpers for cluster size to byte conversion.
  */
@@ -246,6 +265,7 @@ struct exfat_sb_info {
 
 	struct mutex s_lock; /* superblock lock */
 	struct mutex bitmap_lock; /* bitmap lock */
+	atomic_t dir_index_nodes; /* nodes held by directory name indexes */
 	struct exfat_mount_options options;
 	struct nls_table *nls_io; /* Charset used for input and display */
 	struct ratelimit_state ratelimit;
@@ -280,6 +300,8 @@ struct exfat_inode_info {
 	struct exfat_hint hint_stat;
 	/* hint for first empty entry */
 	struct exfat_hint_femp hint_femp;
+	/* name hash index of a directory, built on first lookup */
+	struct exfat_dir_index *dir_index;
 
 	spinlock_t cache_lru_lock;
 	struct list_head cache_lru;
@@ -415,8 +437,14 @@ int exfat_count_num_clusters(struct super_block *sb,
 int exfat_load_bitmap(struct super_block *sb);
 void exfat_free_bitmap(struct exfat_sb_info *sbi);
 int exfat_set_bitmap(struct inode *inode, unsigned int clu, bool sync);
+int exfat_set_bitmap_run(struct inode *inode, unsigned int clu,
+		unsigned int len, bool sync);
 void exfat_clear_bitmap(struct inode *inode, unsigned int clu, bool sync);
 unsigned int exfat_find_free_bitmap(struct super_block *sb, unsigned int clu);
+unsigned int exfat_free_run_length(struct super_block *sb, unsigned int clu,
+		unsigned int max);
+unsigned int exfat_find_free_run(struct super_block *sb, unsigned int clu,
+		unsigned int want, unsigned int *ret_len);
 int exfat_count_used_clusters(struct super_block *sb, unsigned int *ret_count);
 int exfat_trim_fs(struct inode *inode, struct fstrim_range *range);
 
@@ -480,6 +508,11 @@ struct exfat_entry_set_cache *exfat_get_dentry_set(struct super_block *sb,
 		struct exfat_chain *p_dir, int entry, unsigned int type);
 int exfat_free_dentry_set(struct exfat_entry_set_cache *es, int sync);
 int exfat_count_dir_entries(struct super_block *sb, struct exfat_chain *p_dir);
+void exfat_dir_index_add(struct inode *dir, int entry,
+		struct exfat_uni_name *p_uniname);
+void exfat_dir_index_del(struct inode *dir, struct exfat_chain *p_dir,
+		int entry);
+void exfat_dir_index_free(struct inode *dir);
 
 /* inode.c */
 extern const struct inode_operations exfat_file_inode_operations;
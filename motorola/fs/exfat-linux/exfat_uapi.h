@@ -0,0 +1,28 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later WITH Linux-syscall-note */
+/*
+ * ioctl interface of the exfat driver, usable from user space.
+ */
+
+#ifndef _EXFAT_UAPI_H
+#define _EXFAT_UAPI_H
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+/*
+ * 'r' 0x10-0x13 are taken by the FAT ioctls (FAT_IOCTL_GET_ATTRIBUTES,
+ * FAT_IOCTL_SET_ATTRIBUTES and FAT_IOCTL_GET_VOLUME_ID), so exfat's own
+ * commands start at 0x20.
+ */
+
+/* EXFAT_IOC_GET_FRAG_INFO: layout of a file on disk */
+struct exfat_frag_info {
+	__u32 clusters;		/* clusters allocated to the file */
+	__u32 extents;		/* physically contiguous runs of clusters */
+	__u32 frag_rate;	/* discontiguous cluster links, per mille */
+	__u32 no_fat_chain;	/* 1 if the file is stored without a FAT chain */
+};
+
+#define EXFAT_IOC_GET_FRAG_INFO	_IOR('r', 0x20, struct exfat_frag_info)
+
+#endif /* !_EXFAT_UAPI_H */
@@ -318,12 +318,34 @@ release_bhs:
 	return err;
 }
 
+/*
+ * Number of clusters worth of free space to look for whenever a file has to
+ * continue somewhere else. For regular files it grows with the file, so a
+ * long sequential write (e.g. video recording) moves to a run big enough for
+ * a good part of its future growth and keeps extending it in place.
+ */
+static unsigned int exfat_alloc_window(struct inode *inode,
+		unsigned int num_alloc)
+{
+	struct exfat_sb_info *sbi = EXFAT_SB(inode->i_sb);
+	struct exfat_inode_info *ei = EXFAT_I(inode);
+	loff_t window;
+
+	if (ei->type != TYPE_FILE)
+		return num_alloc;
+
+	window = clamp_t(loff_t, ei->i_size_ondisk, EXFAT_ALLOC_WINDOW_MIN,
+			EXFAT_ALLOC_WINDOW_MAX);
+	return max_t(unsigned int, EXFAT_B_TO_CLU(window, sbi), num_alloc);
+}
+
 int exfat_alloc_cluster(struct inode *inode, unsigned int num_alloc,
 		struct exfat_chain *p_chain, bool sync_bmap)
 {
 	int ret = -ENOSPC;
-	unsigned int num_clusters = 0, total_cnt;
+	unsigned int num_clusters = 0, total_cnt, want, run_len;
 	unsigned int hint_clu, new_clu, last_clu = EXFAT_EOF_CLUSTER;
+	unsigned int srch_ptr = EXFAT_EOF_CLUSTER;
 	struct super_block *sb = inode->i_sb;
 	struct exfat_sb_info *sbi = EXFAT_SB(sb);
 
@@ -341,6 +363,7 @@ int exfat_alloc_cluster(struct inode *inode, unsigned int num_alloc,
 
 	mutex_lock(&sbi->bitmap_lock);
 
+	want = exfat_alloc_window(inode, num_alloc);
 	hint_clu = p_chain->dir;
 	/* find new cluster */
 	if (hint_clu == EXFAT_EOF_CLUSTER) {
@@ -350,11 +373,13 @@ int exfat_alloc_cluster(struct inode *inode, unsigned int num_alloc,
 			sbi->clu_srch_ptr = EXFAT_FIRST_CLUSTER;
 		}
 
-		hint_clu = exfat_find_free_bitmap(sb, sbi->clu_srch_ptr);
+		hint_clu = exfat_find_free_run(sb, sbi->clu_srch_ptr, want,
+				&run_len);
 		if (hint_clu == EXFAT_EOF_CLUSTER) {
 			ret = -ENOSPC;
 			goto unlock;
 		}
+		srch_ptr = hint_clu + run_len;
 	}
 
 	/* check cluster validation */
@@ -374,29 +399,42 @@ int exfat_alloc_cluster(struct inode *inode, unsigned int num_alloc,
 
 	p_chain->dir = EXFAT_EOF_CLUSTER;
 
-	while ((new_clu = exfat_find_free_bitmap(sb, hint_clu)) !=
-	       EXFAT_EOF_CLUSTER) {
-		if (new_clu != hint_clu &&
-		    p_chain->flags == ALLOC_NO_FAT_CHAIN) {
-			if (exfat_chain_cont_cluster(sb, p_chain->dir,
-					num_clusters)) {
-				ret = -EIO;
+	while (num_alloc) {
+		/* take as much as possible right where the chain ends */
+		new_clu = hint_clu;
+		run_len = exfat_free_run_length(sb, new_clu, num_alloc);
+		if (!run_len) {
+			new_clu = exfat_find_free_run(sb, hint_clu, want,
+					&run_len);
+			if (new_clu == EXFAT_EOF_CLUSTER) {
+				ret = -ENOSPC;
 				goto free_cluster;
 			}
-			p_chain->flags = ALLOC_FAT_CHAIN;
+			/* leave the rest of the run to this file */
+			srch_ptr = new_clu + run_len;
+			run_len = min(run_len, num_alloc);
+
+			if (p_chain->flags == ALLOC_NO_FAT_CHAIN) {
+				if (exfat_chain_cont_cluster(sb, p_chain->dir,
+						num_clusters)) {
+					ret = -EIO;
+					goto free_cluster;
+				}
+				p_chain->flags = ALLOC_FAT_CHAIN;
+			}
 		}
 
 		/* update allocation bitmap */
-		if (exfat_set_bitmap(inode, new_clu, sync_bmap)) {
+		if (exfat_set_bitmap_run(inode, new_clu, run_len, sync_bmap)) {
 			ret = -EIO;
 			goto free_cluster;
 		}
 
-		num_clusters++;
+		num_clusters += run_len;
 
 		/* update FAT table */
 		if (p_chain->flags == ALLOC_FAT_CHAIN) {
-			if (exfat_ent_set(sb, new_clu, EXFAT_EOF_CLUSTER)) {
+			if (exfat_chain_cont_cluster(sb, new_clu, run_len)) {
 				ret = -EIO;
 				goto free_cluster;
 			}
@@ -410,19 +448,11 @@ int exfat_alloc_cluster(struct inode *inode, unsigned int num_alloc,
 				goto free_cluster;
 			}
 		}
-		last_clu = new_clu;
-
-		if (--num_alloc == 0) {
-			sbi->clu_srch_ptr = hint_clu;
-			sbi->used_clusters += num_clusters;
-
-			p_chain->size += num_clusters;
-			mutex_unlock(&sbi->bitmap_lock);
-			return 0;
-		}
+		last_clu = new_clu + run_len - 1;
+		num_alloc -= run_len;
 
-		hint_clu = new_clu + 1;
-		if (hint_clu >= sbi->num_clusters) {
+		hint_clu = last_clu + 1;
+		if (num_alloc && hint_clu >= sbi->num_clusters) {
 			hint_clu = EXFAT_FIRST_CLUSTER;
 
 			if (p_chain->flags == ALLOC_NO_FAT_CHAIN) {
@@ -435,6 +465,26 @@ int exfat_alloc_cluster(struct inode *inode, unsigned int num_alloc,
 			}
 		}
 	}
+
+	/*
+	 * Files extending in place keep the search pointer where it is, so other
+	 * allocations do not land in the free space right after them. When a new
+	 * run was picked, searching resumes past the part of it meant for this
+	 * chain.
+	 */
+	if (srch_ptr == EXFAT_EOF_CLUSTER && EXFAT_I(inode)->type != TYPE_FILE)
+		srch_ptr = last_clu + 1;
+	if (srch_ptr != EXFAT_EOF_CLUSTER) {
+		if (srch_ptr >= sbi->num_clusters)
+			srch_ptr = EXFAT_FIRST_CLUSTER;
+		sbi->clu_srch_ptr = srch_ptr;
+	}
+	sbi->used_clusters += num_clusters;
+
+	p_chain->size += num_clusters;
+	mutex_unlock(&sbi->bitmap_lock);
+	return 0;
+
 free_cluster:
 	if (num_clusters)
 		__exfat_free_cluster(inode, p_chain);
@@ -400,6 +400,57 @@ static int exfat_ioctl_fitrim(struct inode *inode, unsigned long arg)
 	return 0;
 }
 
+static int exfat_ioctl_get_frag_info(struct inode *inode, unsigned long arg)
+{
+	struct super_block *sb = inode->i_sb;
+	struct exfat_sb_info *sbi = EXFAT_SB(sb);
+	struct exfat_inode_info *ei = EXFAT_I(inode);
+	struct exfat_frag_info info = { 0 };
+	unsigned int clu, next, i;
+	int ret = 0;
+
+	mutex_lock(&sbi->s_lock);
+	if (ei->i_size_ondisk > 0 && ei->start_clu != EXFAT_EOF_CLUSTER)
+		info.clusters = EXFAT_B_TO_CLU_ROUND_UP(ei->i_size_ondisk, sbi);
+
+	if (!info.clusters)
+		goto unlock;
+
+	info.extents = 1;
+	if (ei->flags == ALLOC_NO_FAT_CHAIN) {
+		info.no_fat_chain = 1;
+		goto unlock;
+	}
+
+	clu = ei->start_clu;
+	for (i = 1; i < info.clusters; i++) {
+		if (exfat_ent_get(sb, clu, &next)) {
+			ret = -EIO;
+			goto unlock;
+		}
+		if (next == EXFAT_EOF_CLUSTER)
+			break;
+		if (next != clu + 1)
+			info.extents++;
+		clu = next;
+	}
+
+	/* a single cluster has no links, so it cannot be fragmented */
+	if (info.clusters > 1)
+		info.frag_rate = div_u64((u64)(info.extents - 1) * 1000,
+				info.clusters - 1);
+unlock:
+	mutex_unlock(&sbi->s_lock);
+	if (ret)
+		return ret;
+
+	if (copy_to_user((struct exfat_frag_info __user *)arg, &info,
+			sizeof(info)))
+		return -EFAULT;
+
+	return 0;
+}
+
 long exfat_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 {
 	struct inode *inode = file_inode(filp);
@@ -407,6 +458,8 @@ long exfat_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 	switch (cmd) {
 	case FITRIM:
 		return exfat_ioctl_fitrim(inode, arg);
+	case EXFAT_IOC_GET_FRAG_INFO:
+		return exfat_ioctl_get_frag_info(inode, arg);
 	default:
 		return -ENOTTY;
 	}
@@ -515,6 +515,7 @@ static int exfat_add_entry(struct inode *inode, const char *path,
 	ret = exfat_init_ext_entry(inode, p_dir, dentry, num_entries, &uniname);
 	if (ret)
 		goto out;
+	exfat_dir_index_add(inode, dentry, &uniname);
 
 	info->dir = *p_dir;
 	info->entry = dentry;
@@ -803,8 +804,10 @@ static int exfat_unlink(struct inode *dir, struct dentry *dentry)
 	brelse(bh);
 
 	exfat_set_volume_dirty(sb);
+	exfat_dir_index_del(dir, &cdir, entry);
 	/* update the directory entry */
 	if (exfat_remove_entries(dir, &cdir, entry, 0, num_entries)) {
+		exfat_dir_index_free(dir);
 		err = -EIO;
 		goto unlock;
 	}
@@ -970,9 +973,11 @@ static int exfat_rmdir(struct inode *dir, struct dentry *dentry)
 	brelse(bh);
 
 	exfat_set_volume_dirty(sb);
+	exfat_dir_index_del(dir, &cdir, entry);
 	err = exfat_remove_entries(dir, &cdir, entry, 0, num_entries);
 	if (err) {
 		exfat_err(sb, "failed to exfat_remove_entries : err(%d)", err);
+		exfat_dir_index_free(dir);
 		goto unlock;
 	}
 	ei->dir.dir = DIR_DELETED;
@@ -1265,6 +1270,7 @@ static int __exfat_rename(struct inode *old_parent_inode,
 		goto out;
 
 	exfat_set_volume_dirty(sb);
+	exfat_dir_index_del(old_parent_inode, &olddir, dentry);
 
 	if (olddir.dir == newdir.dir)
 		ret = exfat_rename_file(new_parent_inode, &olddir, dentry,
@@ -1273,6 +1279,14 @@ static int __exfat_rename(struct inode *old_parent_inode,
 		ret = exfat_move_file(new_parent_inode, &olddir, dentry,
 				&newdir, &uni_name, ei);
 
+	if (!ret) {
+		exfat_dir_index_add(new_parent_inode, ei->entry, &uni_name);
+	} else {
+		/* the entry sets may be half moved, rebuild on next lookup */
+		exfat_dir_index_free(old_parent_inode);
+		exfat_dir_index_free(new_parent_inode);
+	}
+
 	if (!ret && new_inode) {
 		/* delete entries of new_dir */
 		ep = exfat_get_dentry(sb, p_dir, new_entry, &new_bh, NULL);
@@ -1288,6 +1302,7 @@ static int __exfat_rename(struct inode *old_parent_inode,
 		}
 		brelse(new_bh);
 
+		exfat_dir_index_del(new_parent_inode, p_dir, new_entry);
 		if (exfat_remove_entries(new_inode, p_dir, new_entry, 0,
 				num_entries + 1)) {
 			ret = -EIO;
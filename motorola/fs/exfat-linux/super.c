@@ -191,6 +191,7 @@ static struct inode *exfat_alloc_inode(struct super_block *sb)
 		return NULL;
 
 	init_rwsem(&ei->truncate_lock);
+	ei->dir_index = NULL;
 	return &ei->vfs_inode;
 }
 
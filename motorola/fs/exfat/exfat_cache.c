@@ -44,23 +44,26 @@
 /*  Global Variable Definitions                                         */
 /*----------------------------------------------------------------------*/
 
+/*
+ * The caches are only used with p_fs->v_sem held, which already
+ * serializes every access to a volume, so they need no lock of their own.
+ */
 #define sm_P(s)
 #define sm_V(s)
 
 static s32 __FAT_read(struct super_block *sb, u32 loc, u32 *content);
 static s32 __FAT_write(struct super_block *sb, u32 loc, u32 content);
 
-static BUF_CACHE_T *FAT_cache_find(struct super_block *sb, sector_t sec);
-static BUF_CACHE_T *FAT_cache_get(struct super_block *sb, sector_t sec);
-static void FAT_cache_insert_hash(struct super_block *sb, BUF_CACHE_T *bp);
-static void FAT_cache_remove_hash(BUF_CACHE_T *bp);
+static void FAT_readahead(struct super_block *sb, sector_t sec);
 
 static u8 *__buf_getblk(struct super_block *sb, sector_t sec);
 
-static BUF_CACHE_T *buf_cache_find(struct super_block *sb, sector_t sec);
-static BUF_CACHE_T *buf_cache_get(struct super_block *sb, sector_t sec);
-static void buf_cache_insert_hash(struct super_block *sb, BUF_CACHE_T *bp);
-static void buf_cache_remove_hash(BUF_CACHE_T *bp);
+static BUF_CACHE_T *cache_find(struct super_block *sb, BUF_CACHE_POOL_T *pool, sector_t sec);
+static BUF_CACHE_T *cache_get(BUF_CACHE_POOL_T *pool);
+static u8 *cache_getblk(struct super_block *sb, BUF_CACHE_POOL_T *pool, sector_t sec);
+static void cache_release(BUF_CACHE_T *bp);
+static void cache_insert_hash(struct super_block *sb, BUF_CACHE_POOL_T *pool, BUF_CACHE_T *bp);
+static void cache_remove_hash(BUF_CACHE_T *bp);
 
 static void push_to_mru(BUF_CACHE_T *bp, BUF_CACHE_T *list);
 static void push_to_lru(BUF_CACHE_T *bp, BUF_CACHE_T *list);
@@ -71,59 +74,140 @@ static void move_to_lru(BUF_CACHE_T *bp, BUF_CACHE_T *list);
 /*  Cache Initialization Functions                                      */
 /*======================================================================*/
 
-s32 buf_init(struct super_block *sb)
+/*
+ * Set up a cache of "size" sectors. The hash table gets one head per two
+ * entries (rounded to a power of 2), so chains stay short however large the
+ * cache is made.
+ */
+static s32 cache_pool_alloc(BUF_CACHE_POOL_T *pool, u32 size)
 {
-	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
+	u32 i, hash_size;
+	BUF_CACHE_T *array, *hash_list;
 
-	int i;
+	hash_size = roundup_pow_of_two(max_t(u32, size >> 1, 1));
 
-	/* LRU list */
-	p_fs->FAT_cache_lru_list.next = p_fs->FAT_cache_lru_list.prev = &p_fs->FAT_cache_lru_list;
-
-	for (i = 0; i < FAT_CACHE_SIZE; i++) {
-		p_fs->FAT_cache_array[i].drv = -1;
-		p_fs->FAT_cache_array[i].sec = ~0;
-		p_fs->FAT_cache_array[i].flag = 0;
-		p_fs->FAT_cache_array[i].buf_bh = NULL;
-		p_fs->FAT_cache_array[i].prev = p_fs->FAT_cache_array[i].next = NULL;
-		push_to_mru(&(p_fs->FAT_cache_array[i]), &p_fs->FAT_cache_lru_list);
+	array = kvzalloc(size * sizeof(BUF_CACHE_T), GFP_KERNEL);
+	if (!array)
+		return FFS_MEMORYERR;
+
+	hash_list = kvzalloc(hash_size * sizeof(BUF_CACHE_T), GFP_KERNEL);
+	if (!hash_list) {
+		kvfree(array);
+		return FFS_MEMORYERR;
 	}
 
-	p_fs->buf_cache_lru_list.next = p_fs->buf_cache_lru_list.prev = &p_fs->buf_cache_lru_list;
+	memset(pool, 0, sizeof(BUF_CACHE_POOL_T));
+	pool->array = array;
+	pool->hash_list = hash_list;
+	pool->size = size;
+	pool->hash_mask = hash_size - 1;
 
-	for (i = 0; i < BUF_CACHE_SIZE; i++) {
-		p_fs->buf_cache_array[i].drv = -1;
-		p_fs->buf_cache_array[i].sec = ~0;
-		p_fs->buf_cache_array[i].flag = 0;
-		p_fs->buf_cache_array[i].buf_bh = NULL;
-		p_fs->buf_cache_array[i].prev = p_fs->buf_cache_array[i].next = NULL;
-		push_to_mru(&(p_fs->buf_cache_array[i]), &p_fs->buf_cache_lru_list);
+	/* LRU list */
+	pool->lru_list.next = pool->lru_list.prev = &pool->lru_list;
+
+	for (i = 0; i < size; i++) {
+		array[i].drv = -1;
+		array[i].sec = ~0;
+		array[i].flag = 0;
+		array[i].buf_bh = NULL;
+		array[i].prev = array[i].next = NULL;
+		/* invalid entries are kept out of the hash table */
+		array[i].hash_next = array[i].hash_prev = &array[i];
+		push_to_mru(&array[i], &pool->lru_list);
 	}
 
 	/* HASH list */
-	for (i = 0; i < FAT_CACHE_HASH_SIZE; i++) {
-		p_fs->FAT_cache_hash_list[i].drv = -1;
-		p_fs->FAT_cache_hash_list[i].sec = ~0;
-		p_fs->FAT_cache_hash_list[i].hash_next = p_fs->FAT_cache_hash_list[i].hash_prev = &(p_fs->FAT_cache_hash_list[i]);
+	for (i = 0; i < hash_size; i++) {
+		hash_list[i].drv = -1;
+		hash_list[i].sec = ~0;
+		hash_list[i].hash_next = hash_list[i].hash_prev = &hash_list[i];
 	}
 
-	for (i = 0; i < FAT_CACHE_SIZE; i++)
-		FAT_cache_insert_hash(sb, &(p_fs->FAT_cache_array[i]));
+	return FFS_SUCCESS;
+} /* end of cache_pool_alloc */
 
-	for (i = 0; i < BUF_CACHE_HASH_SIZE; i++) {
-		p_fs->buf_cache_hash_list[i].drv = -1;
-		p_fs->buf_cache_hash_list[i].sec = ~0;
-		p_fs->buf_cache_hash_list[i].hash_next = p_fs->buf_cache_hash_list[i].hash_prev = &(p_fs->buf_cache_hash_list[i]);
-	}
+static void cache_pool_free(BUF_CACHE_POOL_T *pool)
+{
+	u32 i;
+
+	if (!pool->array)
+		return;
+
+	for (i = 0; i < pool->size; i++)
+		cache_release(&pool->array[i]);
+
+	kvfree(pool->hash_list);
+	kvfree(pool->array);
+	pool->array = NULL;
+	pool->hash_list = NULL;
+	pool->size = 0;
+} /* end of cache_pool_free */
+
+s32 buf_init(struct super_block *sb)
+{
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
 
-	for (i = 0; i < BUF_CACHE_SIZE; i++)
-		buf_cache_insert_hash(sb, &(p_fs->buf_cache_array[i]));
+	if (cache_pool_alloc(&p_fs->FAT_cache, FAT_CACHE_SIZE))
+		return FFS_MEMORYERR;
+
+	if (cache_pool_alloc(&p_fs->buf_cache, BUF_CACHE_SIZE)) {
+		cache_pool_free(&p_fs->FAT_cache);
+		return FFS_MEMORYERR;
+	}
 
 	return FFS_SUCCESS;
 } /* end of buf_init */
 
+/*
+ * Resize the caches once the volume geometry is known. The FAT cache
+ * covers a quarter of the FAT and the buffer cache grows with the cluster
+ * count, unless the fat_cache= / buf_cache= mount options say otherwise.
+ * Keeps the current caches if the new ones can't be allocated.
+ */
+s32 buf_resize(struct super_block *sb)
+{
+	u32 fat_size, buf_size;
+	BUF_CACHE_POOL_T fat_pool, buf_pool;
+	struct exfat_mount_options *opts = &(EXFAT_SB(sb)->options);
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
+
+	fat_size = opts->fat_cache ? opts->fat_cache : (p_fs->num_FAT_sectors >> 2);
+	fat_size = clamp_t(u32, fat_size, FAT_CACHE_SIZE, FAT_CACHE_MAX_SIZE);
+	buf_size = opts->buf_cache ? opts->buf_cache : (p_fs->num_clusters >> 10);
+	buf_size = clamp_t(u32, buf_size, BUF_CACHE_SIZE, BUF_CACHE_MAX_SIZE);
+
+	if (fat_size == p_fs->FAT_cache.size && buf_size == p_fs->buf_cache.size)
+		return FFS_SUCCESS;
+
+	if (cache_pool_alloc(&fat_pool, fat_size))
+		return FFS_MEMORYERR;
+
+	if (cache_pool_alloc(&buf_pool, buf_size)) {
+		cache_pool_free(&fat_pool);
+		return FFS_MEMORYERR;
+	}
+
+	cache_pool_free(&p_fs->FAT_cache);
+	cache_pool_free(&p_fs->buf_cache);
+	p_fs->FAT_cache = fat_pool;
+	p_fs->buf_cache = buf_pool;
+
+	/* the list heads moved, fix up the pointers into them */
+	fat_pool.lru_list.next->prev = &p_fs->FAT_cache.lru_list;
+	fat_pool.lru_list.prev->next = &p_fs->FAT_cache.lru_list;
+	buf_pool.lru_list.next->prev = &p_fs->buf_cache.lru_list;
+	buf_pool.lru_list.prev->next = &p_fs->buf_cache.lru_list;
+
+	return FFS_SUCCESS;
+} /* end of buf_resize */
+
 s32 buf_shutdown(struct super_block *sb)
 {
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
+
+	cache_pool_free(&p_fs->FAT_cache);
+	cache_pool_free(&p_fs->buf_cache);
+
 	return FFS_SUCCESS;
 } /* end of buf_shutdown */
 
@@ -384,44 +468,61 @@ static s32 __FAT_write(struct super_block *sb, u32 loc, u32 content)
 
 u8 *FAT_getblk(struct super_block *sb, sector_t sec)
 {
-	BUF_CACHE_T *bp;
 	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
+	BUF_CACHE_T *bp;
 
-	bp = FAT_cache_find(sb, sec);
+	bp = cache_find(sb, &p_fs->FAT_cache, sec);
 	if (bp != NULL) {
-		move_to_mru(bp, &p_fs->FAT_cache_lru_list);
+		p_fs->FAT_cache.hit++;
+		move_to_mru(bp, &p_fs->FAT_cache.lru_list);
 		return bp->buf_bh->b_data;
 	}
 
-	bp = FAT_cache_get(sb, sec);
+	p_fs->FAT_cache.miss++;
+	FAT_readahead(sb, sec);
+
+	return cache_getblk(sb, &p_fs->FAT_cache, sec);
+} /* end of FAT_getblk */
 
-	FAT_cache_remove_hash(bp);
+/*
+ * Chain walks read the FAT front to back, so on a miss start reading the
+ * following FAT sectors into the buffer cache. A new window is issued once
+ * the walk gets halfway through the previous one.
+ */
+static void FAT_readahead(struct super_block *sb, sector_t sec)
+{
+	sector_t start, end, fat_end;
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
+	BUF_CACHE_POOL_T *pool = &p_fs->FAT_cache;
 
-	bp->drv = p_fs->drv;
-	bp->sec = sec;
-	bp->flag = 0;
+	fat_end = p_fs->FAT1_start_sector + p_fs->num_FAT_sectors;
+	if (sec < p_fs->FAT1_start_sector || sec >= fat_end)
+		return;
 
-	FAT_cache_insert_hash(sb, bp);
+	if (sec >= pool->ra_start && sec + (FAT_CACHE_RA_SECTORS >> 1) < pool->ra_next)
+		return;
 
-	if (sector_read(sb, sec, &(bp->buf_bh), 1) != FFS_SUCCESS) {
-		FAT_cache_remove_hash(bp);
-		bp->drv = -1;
-		bp->sec = ~0;
-		bp->flag = 0;
-		bp->buf_bh = NULL;
+	start = sec + 1;
+	if (sec >= pool->ra_start && start < pool->ra_next)
+		start = pool->ra_next;
 
-		move_to_lru(bp, &p_fs->FAT_cache_lru_list);
-		return NULL;
-	}
+	end = min_t(sector_t, sec + 1 + FAT_CACHE_RA_SECTORS, fat_end);
 
-	return bp->buf_bh->b_data;
-} /* end of FAT_getblk */
+	pool->ra_start = sec;
+	pool->ra_next = end;
+
+	for (; start < end; start++) {
+		sb_breadahead(sb, start);
+		pool->readahead++;
+	}
+} /* end of FAT_readahead */
 
 void FAT_modify(struct super_block *sb, sector_t sec)
 {
 	BUF_CACHE_T *bp;
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
 
-	bp = FAT_cache_find(sb, sec);
+	bp = cache_find(sb, &p_fs->FAT_cache, sec);
 	if (bp != NULL)
 		sector_write(sb, sec, bp->buf_bh, 0);
 } /* end of FAT_modify */
@@ -433,18 +534,10 @@ void FAT_release_all(struct super_block *sb)
 
 	sm_P(&f_sem);
 
-	bp = p_fs->FAT_cache_lru_list.next;
-	while (bp != &p_fs->FAT_cache_lru_list) {
-		if (bp->drv == p_fs->drv) {
-			bp->drv = -1;
-			bp->sec = ~0;
-			bp->flag = 0;
-
-			if (bp->buf_bh) {
-				__brelse(bp->buf_bh);
-				bp->buf_bh = NULL;
-			}
-		}
+	bp = p_fs->FAT_cache.lru_list.next;
+	while (bp != &p_fs->FAT_cache.lru_list) {
+		if (bp->drv == p_fs->drv)
+			cache_release(bp);
 		bp = bp->next;
 	}
 
@@ -458,8 +551,8 @@ void FAT_sync(struct super_block *sb)
 
 	sm_P(&f_sem);
 
-	bp = p_fs->FAT_cache_lru_list.next;
-	while (bp != &p_fs->FAT_cache_lru_list) {
+	bp = p_fs->FAT_cache.lru_list.next;
+	while (bp != &p_fs->FAT_cache.lru_list) {
 		if ((bp->drv == p_fs->drv) && (bp->flag & DIRTYBIT)) {
 			sync_dirty_buffer(bp->buf_bh);
 			bp->flag &= ~(DIRTYBIT);
@@ -470,62 +563,6 @@ void FAT_sync(struct super_block *sb)
 	sm_V(&f_sem);
 } /* end of FAT_sync */
 
-static BUF_CACHE_T *FAT_cache_find(struct super_block *sb, sector_t sec)
-{
-	s32 off;
-	BUF_CACHE_T *bp, *hp;
-	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
-
-	off = (sec + (sec >> p_fs->sectors_per_clu_bits)) & (FAT_CACHE_HASH_SIZE - 1);
-
-	hp = &(p_fs->FAT_cache_hash_list[off]);
-	for (bp = hp->hash_next; bp != hp; bp = bp->hash_next) {
-		if ((bp->drv == p_fs->drv) && (bp->sec == sec)) {
-
-			WARN(!bp->buf_bh, "[EXFAT] FAT_cache has no bh. "
-					  "It will make system panic.\n");
-
-			touch_buffer(bp->buf_bh);
-			return bp;
-		}
-	}
-	return NULL;
-} /* end of FAT_cache_find */
-
-static BUF_CACHE_T *FAT_cache_get(struct super_block *sb, sector_t sec)
-{
-	BUF_CACHE_T *bp;
-	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
-
-	bp = p_fs->FAT_cache_lru_list.prev;
-
-
-	move_to_mru(bp, &p_fs->FAT_cache_lru_list);
-	return bp;
-} /* end of FAT_cache_get */
-
-static void FAT_cache_insert_hash(struct super_block *sb, BUF_CACHE_T *bp)
-{
-	s32 off;
-	BUF_CACHE_T *hp;
-	FS_INFO_T *p_fs;
-
-	p_fs = &(EXFAT_SB(sb)->fs_info);
-	off = (bp->sec + (bp->sec >> p_fs->sectors_per_clu_bits)) & (FAT_CACHE_HASH_SIZE-1);
-
-	hp = &(p_fs->FAT_cache_hash_list[off]);
-	bp->hash_next = hp->hash_next;
-	bp->hash_prev = hp;
-	hp->hash_next->hash_prev = bp;
-	hp->hash_next = bp;
-} /* end of FAT_cache_insert_hash */
-
-static void FAT_cache_remove_hash(BUF_CACHE_T *bp)
-{
-	(bp->hash_prev)->hash_next = bp->hash_next;
-	(bp->hash_next)->hash_prev = bp->hash_prev;
-} /* end of FAT_cache_remove_hash */
-
 /*======================================================================*/
 /*  Buffer Read/Write Functions                                         */
 /*======================================================================*/
@@ -548,44 +585,26 @@ static u8 *__buf_getblk(struct super_block *sb, sector_t sec)
 	BUF_CACHE_T *bp;
 	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
 
-	bp = buf_cache_find(sb, sec);
+	bp = cache_find(sb, &p_fs->buf_cache, sec);
 	if (bp != NULL) {
-		move_to_mru(bp, &p_fs->buf_cache_lru_list);
+		p_fs->buf_cache.hit++;
+		move_to_mru(bp, &p_fs->buf_cache.lru_list);
 		return bp->buf_bh->b_data;
 	}
 
-	bp = buf_cache_get(sb, sec);
-
-	buf_cache_remove_hash(bp);
-
-	bp->drv = p_fs->drv;
-	bp->sec = sec;
-	bp->flag = 0;
-
-	buf_cache_insert_hash(sb, bp);
-
-	if (sector_read(sb, sec, &(bp->buf_bh), 1) != FFS_SUCCESS) {
-		buf_cache_remove_hash(bp);
-		bp->drv = -1;
-		bp->sec = ~0;
-		bp->flag = 0;
-		bp->buf_bh = NULL;
-
-		move_to_lru(bp, &p_fs->buf_cache_lru_list);
-		return NULL;
-	}
-
-	return bp->buf_bh->b_data;
+	p_fs->buf_cache.miss++;
 
+	return cache_getblk(sb, &p_fs->buf_cache, sec);
 } /* end of __buf_getblk */
 
 void buf_modify(struct super_block *sb, sector_t sec)
 {
 	BUF_CACHE_T *bp;
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
 
 	sm_P(&b_sem);
 
-	bp = buf_cache_find(sb, sec);
+	bp = cache_find(sb, &p_fs->buf_cache, sec);
 	if (likely(bp != NULL))
 		sector_write(sb, sec, bp->buf_bh, 0);
 
@@ -598,10 +617,11 @@ void buf_modify(struct super_block *sb, sector_t sec)
 void buf_lock(struct super_block *sb, sector_t sec)
 {
 	BUF_CACHE_T *bp;
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
 
 	sm_P(&b_sem);
 
-	bp = buf_cache_find(sb, sec);
+	bp = cache_find(sb, &p_fs->buf_cache, sec);
 	if (likely(bp != NULL))
 		bp->flag |= LOCKBIT;
 
@@ -614,10 +634,11 @@ void buf_lock(struct super_block *sb, sector_t sec)
 void buf_unlock(struct super_block *sb, sector_t sec)
 {
 	BUF_CACHE_T *bp;
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
 
 	sm_P(&b_sem);
 
-	bp = buf_cache_find(sb, sec);
+	bp = cache_find(sb, &p_fs->buf_cache, sec);
 	if (likely(bp != NULL))
 		bp->flag &= ~(LOCKBIT);
 
@@ -634,18 +655,10 @@ void buf_release(struct super_block *sb, sector_t sec)
 
 	sm_P(&b_sem);
 
-	bp = buf_cache_find(sb, sec);
+	bp = cache_find(sb, &p_fs->buf_cache, sec);
 	if (likely(bp != NULL)) {
-		bp->drv = -1;
-		bp->sec = ~0;
-		bp->flag = 0;
-
-		if (bp->buf_bh) {
-			__brelse(bp->buf_bh);
-			bp->buf_bh = NULL;
-		}
-
-		move_to_lru(bp, &p_fs->buf_cache_lru_list);
+		cache_release(bp);
+		move_to_lru(bp, &p_fs->buf_cache.lru_list);
 	}
 
 	sm_V(&b_sem);
@@ -658,18 +671,10 @@ void buf_release_all(struct super_block *sb)
 
 	sm_P(&b_sem);
 
-	bp = p_fs->buf_cache_lru_list.next;
-	while (bp != &p_fs->buf_cache_lru_list) {
-		if (bp->drv == p_fs->drv) {
-			bp->drv = -1;
-			bp->sec = ~0;
-			bp->flag = 0;
-
-			if (bp->buf_bh) {
-				__brelse(bp->buf_bh);
-				bp->buf_bh = NULL;
-			}
-		}
+	bp = p_fs->buf_cache.lru_list.next;
+	while (bp != &p_fs->buf_cache.lru_list) {
+		if (bp->drv == p_fs->drv)
+			cache_release(bp);
 		bp = bp->next;
 	}
 
@@ -683,8 +688,8 @@ void buf_sync(struct super_block *sb)
 
 	sm_P(&b_sem);
 
-	bp = p_fs->buf_cache_lru_list.next;
-	while (bp != &p_fs->buf_cache_lru_list) {
+	bp = p_fs->buf_cache.lru_list.next;
+	while (bp != &p_fs->buf_cache.lru_list) {
 		if ((bp->drv == p_fs->drv) && (bp->flag & DIRTYBIT)) {
 			bdev_sync_dirty_buffer(bp->buf_bh, sb, 1);
 			bp->flag &= ~(DIRTYBIT);
@@ -695,59 +700,106 @@ void buf_sync(struct super_block *sb)
 	sm_V(&b_sem);
 } /* end of buf_sync */
 
-static BUF_CACHE_T *buf_cache_find(struct super_block *sb, sector_t sec)
+/*======================================================================*/
+/*  Cache Pool Functions                                                */
+/*======================================================================*/
+
+static inline u32 cache_hash(struct super_block *sb, BUF_CACHE_POOL_T *pool, sector_t sec)
 {
-	s32 off;
-	BUF_CACHE_T *bp, *hp;
 	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
 
-	off = (sec + (sec >> p_fs->sectors_per_clu_bits)) & (BUF_CACHE_HASH_SIZE - 1);
+	return (u32)(sec + (sec >> p_fs->sectors_per_clu_bits)) & pool->hash_mask;
+} /* end of cache_hash */
 
-	hp = &(p_fs->buf_cache_hash_list[off]);
+static BUF_CACHE_T *cache_find(struct super_block *sb, BUF_CACHE_POOL_T *pool, sector_t sec)
+{
+	BUF_CACHE_T *bp, *hp;
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
+
+	hp = &(pool->hash_list[cache_hash(sb, pool, sec)]);
 	for (bp = hp->hash_next; bp != hp; bp = bp->hash_next) {
 		if ((bp->drv == p_fs->drv) && (bp->sec == sec)) {
+
+			WARN(!bp->buf_bh, "[EXFAT] cache has no bh. "
+					  "It will make system panic.\n");
+
 			touch_buffer(bp->buf_bh);
 			return bp;
 		}
 	}
 	return NULL;
-} /* end of buf_cache_find */
+} /* end of cache_find */
 
-static BUF_CACHE_T *buf_cache_get(struct super_block *sb, sector_t sec)
+/* Take the least recently used entry that is not locked */
+static BUF_CACHE_T *cache_get(BUF_CACHE_POOL_T *pool)
 {
 	BUF_CACHE_T *bp;
-	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
 
-	bp = p_fs->buf_cache_lru_list.prev;
+	bp = pool->lru_list.prev;
 	while (bp->flag & LOCKBIT)
 		bp = bp->prev;
 
-
-	move_to_mru(bp, &p_fs->buf_cache_lru_list);
+	move_to_mru(bp, &pool->lru_list);
 	return bp;
-} /* end of buf_cache_get */
+} /* end of cache_get */
 
-static void buf_cache_insert_hash(struct super_block *sb, BUF_CACHE_T *bp)
+/* Read "sec" into the least recently used entry of the pool */
+static u8 *cache_getblk(struct super_block *sb, BUF_CACHE_POOL_T *pool, sector_t sec)
 {
-	s32 off;
-	BUF_CACHE_T *hp;
-	FS_INFO_T *p_fs;
+	BUF_CACHE_T *bp;
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
+
+	bp = cache_get(pool);
+
+	cache_remove_hash(bp);
 
-	p_fs = &(EXFAT_SB(sb)->fs_info);
-	off = (bp->sec + (bp->sec >> p_fs->sectors_per_clu_bits)) & (BUF_CACHE_HASH_SIZE-1);
+	bp->drv = p_fs->drv;
+	bp->sec = sec;
+	bp->flag = 0;
+
+	cache_insert_hash(sb, pool, bp);
+
+	if (sector_read(sb, sec, &(bp->buf_bh), 1) != FFS_SUCCESS) {
+		cache_release(bp);
+		move_to_lru(bp, &pool->lru_list);
+		return NULL;
+	}
+
+	return bp->buf_bh->b_data;
+} /* end of cache_getblk */
+
+/* Invalidate an entry and drop its buffer */
+static void cache_release(BUF_CACHE_T *bp)
+{
+	cache_remove_hash(bp);
+
+	bp->drv = -1;
+	bp->sec = ~0;
+	bp->flag = 0;
+
+	if (bp->buf_bh) {
+		__brelse(bp->buf_bh);
+		bp->buf_bh = NULL;
+	}
+} /* end of cache_release */
+
+static void cache_insert_hash(struct super_block *sb, BUF_CACHE_POOL_T *pool, BUF_CACHE_T *bp)
+{
+	BUF_CACHE_T *hp;
 
-	hp = &(p_fs->buf_cache_hash_list[off]);
+	hp = &(pool->hash_list[cache_hash(sb, pool, bp->sec)]);
 	bp->hash_next = hp->hash_next;
 	bp->hash_prev = hp;
 	hp->hash_next->hash_prev = bp;
 	hp->hash_next = bp;
-} /* end of buf_cache_insert_hash */
+} /* end of cache_insert_hash */
 
-static void buf_cache_remove_hash(BUF_CACHE_T *bp)
+static void cache_remove_hash(BUF_CACHE_T *bp)
 {
 	(bp->hash_prev)->hash_next = bp->hash_next;
 	(bp->hash_next)->hash_prev = bp->hash_prev;
-} /* end of buf_cache_remove_hash */
+	bp->hash_next = bp->hash_prev = bp;
+} /* end of cache_remove_hash */
 
 /*======================================================================*/
 /*  Local Function Definitions                                          */
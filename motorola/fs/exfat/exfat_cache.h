@@ -37,6 +37,7 @@
 #define _EXFAT_CACHE_H
 
 #include <linux/fs.h>
+#include <linux/log2.h>
 #include <linux/types.h>
 #include "exfat_config.h"
 
@@ -62,11 +63,25 @@ typedef struct __BUF_CACHE_T {
 	struct buffer_head   *buf_bh;
 } BUF_CACHE_T;
 
+typedef struct __BUF_CACHE_POOL_T {
+	BUF_CACHE_T *array;               /* cache entries */
+	BUF_CACHE_T *hash_list;           /* hash_mask + 1 hash heads */
+	BUF_CACHE_T lru_list;
+	u32               size;
+	u32               hash_mask;
+	unsigned long     hit;
+	unsigned long     miss;
+	unsigned long     readahead;      /* sectors read ahead */
+	sector_t          ra_start;       /* sector that triggered readahead */
+	sector_t          ra_next;        /* first sector not read ahead */
+} BUF_CACHE_POOL_T;
+
 /*----------------------------------------------------------------------*/
 /*  External Function Declarations                                      */
 /*----------------------------------------------------------------------*/
 
 s32  buf_init(struct super_block *sb);
+s32  buf_resize(struct super_block *sb);
 s32  buf_shutdown(struct super_block *sb);
 s32  FAT_read(struct super_block *sb, u32 loc, u32 *content);
 s32  FAT_write(struct super_block *sb, u32 loc, u32 content);
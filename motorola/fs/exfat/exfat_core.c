@@ -239,6 +239,10 @@ s32 ffsMountVol(struct super_block *sb)
 		return FFS_MEDIAERR;
 	}
 
+	/* not fatal, the default sized caches are kept */
+	if (buf_resize(sb) != FFS_SUCCESS)
+		printk("[EXFAT] failed to resize the FAT and buffer caches\n");
+
 	printk("[EXFAT] mounted successfully\n");
 
 	return FFS_SUCCESS;
@@ -49,10 +49,14 @@
 #define MAX_DENTRY              512
 
 /* cache size (in number of sectors)                */
-/* (should be an exponential value of 2)            */
+/* the caches start at *_SIZE and are resized to    */
+/* the volume at mount, up to *_MAX_SIZE            */
 #define FAT_CACHE_SIZE          128
-#define FAT_CACHE_HASH_SIZE     64
+#define FAT_CACHE_MAX_SIZE      4096
 #define BUF_CACHE_SIZE          256
-#define BUF_CACHE_HASH_SIZE     64
+#define BUF_CACHE_MAX_SIZE      2048
+
+/* FAT sectors read ahead on a FAT cache miss       */
+#define FAT_CACHE_RA_SECTORS    16
 
 #endif /* _EXFAT_DATA_H */
@@ -2116,6 +2116,7 @@ static void exfat_put_super(struct super_block *sb)
 	if (__is_sb_dirty(sb))
 		exfat_write_super(sb);
 
+	exfat_sysfs_unregister(sb);
 	FsUmountVol(sb);
 
 	sb->s_fs_info = NULL;
@@ -2233,6 +2234,10 @@ static int exfat_show_options(struct seq_file *m, struct vfsmount *mnt)
 	if (opts->discard)
 		seq_printf(m, ",discard");
 #endif
+	if (opts->fat_cache)
+		seq_printf(m, ",fat_cache=%u", opts->fat_cache);
+	if (opts->buf_cache)
+		seq_printf(m, ",buf_cache=%u", opts->buf_cache);
 	return 0;
 }
 
@@ -2314,6 +2319,8 @@ enum {
 	Opt_err_panic,
 	Opt_err_ro,
 	Opt_utf8_hack,
+	Opt_fat_cache,
+	Opt_buf_cache,
 	Opt_err,
 #ifdef CONFIG_EXFAT_DISCARD
 	Opt_discard,
@@ -2335,6 +2342,8 @@ static const match_table_t exfat_tokens = {
 	{Opt_err_panic, "errors=panic"},
 	{Opt_err_ro, "errors=remount-ro"},
 	{Opt_utf8_hack, "utf8"},
+	{Opt_fat_cache, "fat_cache=%u"},
+	{Opt_buf_cache, "buf_cache=%u"},
 #ifdef CONFIG_EXFAT_DISCARD
 	{Opt_discard, "discard"},
 #endif /* CONFIG_EXFAT_DISCARD */
@@ -2360,6 +2369,8 @@ static int parse_options(char *options, int silent, int *debug,
 #ifdef CONFIG_EXFAT_DISCARD
 	opts->discard = 0;
 #endif
+	opts->fat_cache = 0;
+	opts->buf_cache = 0;
 	*debug = 0;
 
 	if (!options)
@@ -2442,6 +2453,16 @@ static int parse_options(char *options, int silent, int *debug,
 #endif /* CONFIG_EXFAT_DISCARD */
 		case Opt_utf8_hack:
 			break;
+		case Opt_fat_cache:
+			if (match_int(&args[0], &option))
+				return 0;
+			opts->fat_cache = option;
+			break;
+		case Opt_buf_cache:
+			if (match_int(&args[0], &option))
+				return 0;
+			opts->buf_cache = option;
+			break;
 		default:
 			if (!silent)
 				printk(KERN_ERR "[EXFAT] Unrecognized mount option %s or missing value\n", p);
@@ -2466,6 +2487,102 @@ static void exfat_hash_init(struct super_block *sb)
 		INIT_HLIST_HEAD(&sbi->inode_hashtable[i]);
 }
 
+/*======================================================================*/
+/*  Sysfs Interface                                                     */
+/*======================================================================*/
+
+static struct kset *exfat_kset;
+
+struct exfat_attr {
+	struct attribute attr;
+	ssize_t (*show)(struct exfat_sb_info *sbi, char *buf);
+};
+
+#define EXFAT_CACHE_ATTR(_name, _pool, _field)				\
+static ssize_t _name##_show(struct exfat_sb_info *sbi, char *buf)	\
+{									\
+	return snprintf(buf, PAGE_SIZE, "%lu\n",			\
+			(unsigned long) sbi->fs_info._pool._field);	\
+}									\
+static struct exfat_attr exfat_attr_##_name = __ATTR_RO(_name)
+
+EXFAT_CACHE_ATTR(fat_cache_size, FAT_cache, size);
+EXFAT_CACHE_ATTR(fat_cache_hit, FAT_cache, hit);
+EXFAT_CACHE_ATTR(fat_cache_miss, FAT_cache, miss);
+EXFAT_CACHE_ATTR(fat_readahead, FAT_cache, readahead);
+EXFAT_CACHE_ATTR(buf_cache_size, buf_cache, size);
+EXFAT_CACHE_ATTR(buf_cache_hit, buf_cache, hit);
+EXFAT_CACHE_ATTR(buf_cache_miss, buf_cache, miss);
+
+static struct attribute *exfat_attrs[] = {
+	&exfat_attr_fat_cache_size.attr,
+	&exfat_attr_fat_cache_hit.attr,
+	&exfat_attr_fat_cache_miss.attr,
+	&exfat_attr_fat_readahead.attr,
+	&exfat_attr_buf_cache_size.attr,
+	&exfat_attr_buf_cache_hit.attr,
+	&exfat_attr_buf_cache_miss.attr,
+	NULL,
+};
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5,2,0)
+ATTRIBUTE_GROUPS(exfat);
+#endif
+
+static ssize_t exfat_attr_show(struct kobject *kobj,
+			       struct attribute *attr, char *buf)
+{
+	struct exfat_sb_info *sbi = container_of(kobj, struct exfat_sb_info, s_kobj);
+	struct exfat_attr *a = container_of(attr, struct exfat_attr, attr);
+
+	return a->show(sbi, buf);
+}
+
+static const struct sysfs_ops exfat_attr_ops = {
+	.show = exfat_attr_show,
+};
+
+static void exfat_sb_release(struct kobject *kobj)
+{
+	struct exfat_sb_info *sbi = container_of(kobj, struct exfat_sb_info, s_kobj);
+
+	complete(&sbi->s_kobj_unregister);
+}
+
+static struct kobj_type exfat_sb_ktype = {
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5,2,0)
+	.default_groups = exfat_groups,
+#else
+	.default_attrs = exfat_attrs,
+#endif
+	.sysfs_ops = &exfat_attr_ops,
+	.release = exfat_sb_release,
+};
+
+static int exfat_sysfs_register(struct super_block *sb)
+{
+	struct exfat_sb_info *sbi = EXFAT_SB(sb);
+	int err;
+
+	sbi->s_kobj.kset = exfat_kset;
+	init_completion(&sbi->s_kobj_unregister);
+	err = kobject_init_and_add(&sbi->s_kobj, &exfat_sb_ktype, NULL,
+				   "%s", sb->s_id);
+	if (err) {
+		kobject_put(&sbi->s_kobj);
+		wait_for_completion(&sbi->s_kobj_unregister);
+	}
+	return err;
+}
+
+static void exfat_sysfs_unregister(struct super_block *sb)
+{
+	struct exfat_sb_info *sbi = EXFAT_SB(sb);
+
+	kobject_del(&sbi->s_kobj);
+	kobject_put(&sbi->s_kobj);
+	wait_for_completion(&sbi->s_kobj_unregister);
+}
+
 static int exfat_read_root(struct inode *inode)
 {
 	struct super_block *sb = inode->i_sb;
@@ -2575,6 +2692,11 @@ static int exfat_fill_super(struct super_block *sb, void *data, int silent)
 		goto out_fail;
 	}
 
+	error = exfat_sysfs_register(sb);
+	if (error)
+		goto out_fail2;
+	error = -EIO;
+
 	/* set up enough so that it can read an inode */
 	exfat_hash_init(sb);
 
@@ -2593,7 +2715,7 @@ static int exfat_fill_super(struct super_block *sb, void *data, int silent)
 		sbi->nls_disk = load_nls(buf);
 		if (!sbi->nls_disk) {
 			printk(KERN_ERR "[EXFAT] Codepage %s not found\n", buf);
-			goto out_fail2;
+			goto out_fail3;
 		}
 	}
 
@@ -2602,13 +2724,13 @@ static int exfat_fill_super(struct super_block *sb, void *data, int silent)
 	error = -ENOMEM;
 	root_inode = new_inode(sb);
 	if (!root_inode)
-		goto out_fail2;
+		goto out_fail3;
 	root_inode->i_ino = EXFAT_ROOT_INO;
 	SET_IVERSION(root_inode, 1);
 
 	error = exfat_read_root(root_inode);
 	if (error < 0)
-		goto out_fail2;
+		goto out_fail3;
 	error = -ENOMEM;
 	exfat_attach(root_inode, EXFAT_I(root_inode)->i_pos);
 	insert_inode_hash(root_inode);
@@ -2619,11 +2741,13 @@ static int exfat_fill_super(struct super_block *sb, void *data, int silent)
 #endif
 	if (!sb->s_root) {
 		printk(KERN_ERR "[EXFAT] Getting the root inode failed\n");
-		goto out_fail2;
+		goto out_fail3;
 	}
 
 	return 0;
 
+out_fail3:
+	exfat_sysfs_unregister(sb);
 out_fail2:
 	FsUmountVol(sb);
 out_fail:
@@ -2741,11 +2865,21 @@ static int __init init_exfat(void)
 	if (err)
 		goto out;
 
+	exfat_kset = kset_create_and_add("exfat", NULL, fs_kobj);
+	if (!exfat_kset) {
+		err = -ENOMEM;
+		goto out_inodecache;
+	}
+
 	err = register_filesystem(&exfat_fs_type);
 	if (err)
-		goto out;
+		goto out_kset;
 
 	return 0;
+out_kset:
+	kset_unregister(exfat_kset);
+out_inodecache:
+	kmem_cache_destroy(exfat_inode_cachep);
 out:
 	FsShutdown();
 	return err;
@@ -2755,6 +2889,7 @@ static void __exit exit_exfat(void)
 {
 	exfat_destroy_inodecache();
 	unregister_filesystem(&exfat_fs_type);
+	kset_unregister(exfat_kset);
 	FsShutdown();
 }
 
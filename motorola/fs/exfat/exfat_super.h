@@ -27,6 +27,8 @@
 #include <linux/fs.h>
 #include <linux/mutex.h>
 #include <linux/swap.h>
+#include <linux/kobject.h>
+#include <linux/completion.h>
 
 #include "exfat_config.h"
 #include "exfat_data.h"
@@ -67,6 +69,8 @@ struct exfat_mount_options {
 #ifdef CONFIG_EXFAT_DISCARD
 	unsigned char discard;      /* flag on if -o dicard specified and device support discard() */
 #endif /* CONFIG_EXFAT_DISCARD */
+	unsigned int fat_cache;     /* FAT cache size in sectors, 0 for auto */
+	unsigned int buf_cache;     /* buffer cache size in sectors, 0 for auto */
 };
 
 #define EXFAT_HASH_BITS    8
@@ -98,6 +102,10 @@ struct exfat_sb_info {
 	struct super_block *sb;
 	struct work_struct uevent_work;
 	int disable_uevent;
+
+	/* /sys/fs/exfat/<dev> */
+	struct kobject s_kobj;
+	struct completion s_kobj_unregister;
 };
 
 /*
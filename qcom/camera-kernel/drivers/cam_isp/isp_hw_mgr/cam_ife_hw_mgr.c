@@ -5174,6 +5174,7 @@ static int cam_ife_mgr_acquire_hw(void *hw_mgr_priv, void *acquire_hw_args)
 	ife_ctx->ctx_type = CAM_IFE_CTX_TYPE_NONE;
 	ife_ctx->num_acq_vfe_out = 0;
 	ife_ctx->num_acq_sfe_out = 0;
+	cam_packet_util_iova_cache_reset(&ife_ctx->iova_cache);
 
 	ife_ctx->common.cb_priv = acquire_args->context_data;
 	ife_ctx->common.mini_dump_cb = acquire_args->mini_dump_cb;
@@ -7487,6 +7488,7 @@ static int cam_ife_mgr_release_hw(void *hw_mgr_priv,
 	ctx->scratch_buf_info.ife_scratch_config = NULL;
 	ctx->try_recovery_cnt = 0;
 	ctx->recovery_req_id = 0;
+	cam_packet_util_iova_cache_reset(&ctx->iova_cache);
 
 	memset(&ctx->flags, 0, sizeof(struct cam_ife_hw_mgr_ctx_flags));
 	atomic_set(&ctx->overflow_pending, 0);
@@ -11564,13 +11566,15 @@ static int cam_ife_mgr_prepare_hw_update(void *hw_mgr_priv,
 	}
 
 	if (ctx->flags.internal_cdm)
-		rc = cam_packet_util_process_patches(prepare->packet,
+		rc = cam_packet_util_process_patches_cached(prepare->packet,
 			hw_mgr->mgr_common.img_iommu_hdl,
-			hw_mgr->mgr_common.img_iommu_hdl_secure, true);
+			hw_mgr->mgr_common.img_iommu_hdl_secure, true,
+			&ctx->iova_cache);
 	else
-		rc = cam_packet_util_process_patches(prepare->packet,
+		rc = cam_packet_util_process_patches_cached(prepare->packet,
 			hw_mgr->mgr_common.cmd_iommu_hdl,
-			hw_mgr->mgr_common.cmd_iommu_hdl_secure, true);
+			hw_mgr->mgr_common.cmd_iommu_hdl_secure, true,
+			&ctx->iova_cache);
 
 	if (rc) {
 		CAM_ERR(CAM_ISP, "Patch ISP packet failed.");
@@ -15,6 +15,7 @@
 #include "cam_tasklet_util.h"
 #include "cam_cdm_intf_api.h"
 #include "cam_cpas_api.h"
+#include "cam_packet_util.h"
 
 /*
  * enum cam_ife_ctx_master_type - HW master type
@@ -287,6 +288,7 @@ struct cam_ife_cdm_user_data {
  * @curr_num_exp:           Current num of exposures
  * @try_recovery_cnt:       Retry count for overflow recovery
  * @recovery_req_id:        The request id on which overflow recovery happens
+ * @iova_cache:             Patch source buffer IOVAs reused across requests
  *
  */
 struct cam_ife_hw_mgr_ctx {
@@ -346,6 +348,7 @@ struct cam_ife_hw_mgr_ctx {
 	uint32_t                                   curr_num_exp;
 	uint32_t                                   try_recovery_cnt;
 	uint64_t                                   recovery_req_id;
+	struct cam_packet_iova_cache               iova_cache;
 };
 
 /**
@@ -244,9 +244,12 @@ int cam_mem_mgr_init(void)
 	for (i = 1; i < CAM_MEM_BUFQ_MAX; i++) {
 		tbl.bufq[i].fd = -1;
 		tbl.bufq[i].buf_handle = -1;
+		mutex_init(&tbl.bufq[i].q_lock);
 		cam_mem_mgr_reset_presil_params(i);
 	}
 	mutex_init(&tbl.m_lock);
+	spin_lock_init(&tbl.fd_hash_lock);
+	hash_init(tbl.fd_hash);
 
 	atomic_set(&cam_mem_mgr_state, CAM_MEM_MGR_INITIALIZED);
 
@@ -262,37 +265,58 @@ put_heaps:
 	return rc;
 }
 
+static void cam_mem_util_hash_buf(int32_t idx)
+{
+	spin_lock(&tbl.fd_hash_lock);
+	hash_add(tbl.fd_hash, &tbl.bufq[idx].hnode, tbl.bufq[idx].i_ino);
+	spin_unlock(&tbl.fd_hash_lock);
+}
+
+static void cam_mem_util_unhash_buf(int32_t idx)
+{
+	spin_lock(&tbl.fd_hash_lock);
+	if (hash_hashed(&tbl.bufq[idx].hnode))
+		hash_del(&tbl.bufq[idx].hnode);
+	spin_unlock(&tbl.fd_hash_lock);
+}
+
 static int32_t cam_mem_get_slot(void)
 {
 	int32_t idx;
+	uint32_t gen;
 
-	mutex_lock(&tbl.m_lock);
-	idx = find_first_zero_bit(tbl.bitmap, tbl.bits);
-	if (idx >= CAM_MEM_BUFQ_MAX || idx <= 0) {
-		mutex_unlock(&tbl.m_lock);
-		return -ENOMEM;
-	}
+	/* Claim a free bit without a table lock, retry if another CPU won it */
+	do {
+		idx = find_first_zero_bit(tbl.bitmap, tbl.bits);
+		if (idx >= CAM_MEM_BUFQ_MAX || idx <= 0)
+			return -ENOMEM;
+	} while (test_and_set_bit_lock(idx, tbl.bitmap));
+
+	/* zero marks a free slot */
+	gen = atomic_inc_return(&tbl.gen);
+	if (!gen)
+		gen = atomic_inc_return(&tbl.gen);
 
-	set_bit(idx, tbl.bitmap);
+	mutex_lock(&tbl.bufq[idx].q_lock);
 	tbl.bufq[idx].active = true;
+	tbl.bufq[idx].gen = gen;
 	CAM_GET_TIMESTAMP((tbl.bufq[idx].timestamp));
-	mutex_init(&tbl.bufq[idx].q_lock);
-	mutex_unlock(&tbl.m_lock);
+	mutex_unlock(&tbl.bufq[idx].q_lock);
 
 	return idx;
 }
 
 static void cam_mem_put_slot(int32_t idx)
 {
-	mutex_lock(&tbl.m_lock);
+	cam_mem_util_unhash_buf(idx);
+
 	mutex_lock(&tbl.bufq[idx].q_lock);
 	tbl.bufq[idx].active = false;
+	tbl.bufq[idx].gen = 0;
 	tbl.bufq[idx].is_internal = false;
 	memset(&tbl.bufq[idx].timestamp, 0, sizeof(struct timespec64));
 	mutex_unlock(&tbl.bufq[idx].q_lock);
-	mutex_destroy(&tbl.bufq[idx].q_lock);
-	clear_bit(idx, tbl.bitmap);
-	mutex_unlock(&tbl.m_lock);
+	clear_bit_unlock(idx, tbl.bitmap);
 }
 
 int cam_mem_get_io_buf(int32_t buf_handle, int32_t mmu_handle,
@@ -348,6 +372,30 @@ handle_mismatch:
 }
 EXPORT_SYMBOL(cam_mem_get_io_buf);
 
+int cam_mem_get_buf_gen(int32_t buf_handle, uint32_t *gen)
+{
+	int idx;
+
+	if (!atomic_read(&cam_mem_mgr_state)) {
+		CAM_ERR(CAM_MEM, "failed. mem_mgr not initialized");
+		return -EINVAL;
+	}
+
+	if (!gen)
+		return -EINVAL;
+
+	idx = CAM_MEM_MGR_GET_HDL_IDX(buf_handle);
+	if (idx >= CAM_MEM_BUFQ_MAX || idx <= 0)
+		return -ENOENT;
+
+	if (!tbl.bufq[idx].active || (buf_handle != tbl.bufq[idx].buf_handle))
+		return -ENOENT;
+
+	*gen = tbl.bufq[idx].gen;
+	return 0;
+}
+EXPORT_SYMBOL(cam_mem_get_buf_gen);
+
 int cam_mem_get_cpu_buf(int32_t buf_handle, uintptr_t *vaddr_ptr, size_t *len)
 {
 	int idx;
@@ -407,17 +455,14 @@ int cam_mem_mgr_cache_ops(struct cam_mem_cache_ops_cmd *cmd)
 	if (idx >= CAM_MEM_BUFQ_MAX || idx <= 0)
 		return -EINVAL;
 
-	mutex_lock(&tbl.m_lock);
-
 	if (!test_bit(idx, tbl.bitmap)) {
 		CAM_ERR(CAM_MEM, "Buffer at idx=%d is already unmapped,",
 			idx);
-		mutex_unlock(&tbl.m_lock);
 		return -EINVAL;
 	}
 
+	/* A slot released meanwhile fails the handle check below */
 	mutex_lock(&tbl.bufq[idx].q_lock);
-	mutex_unlock(&tbl.m_lock);
 
 	if (cmd->buf_handle != tbl.bufq[idx].buf_handle) {
 		rc = -EINVAL;
@@ -499,16 +544,13 @@ int cam_mem_mgr_cpu_access_op(struct cam_mem_cpu_access_op *cmd)
 		return -EINVAL;
 	}
 
-	mutex_lock(&tbl.m_lock);
-
 	if (!test_bit(idx, tbl.bitmap)) {
 		CAM_ERR(CAM_MEM, "Buffer at idx=%d is already freed/unmapped", idx);
-		mutex_unlock(&tbl.m_lock);
 		return -EINVAL;
 	}
 
+	/* A slot released meanwhile fails the handle check below */
 	mutex_lock(&tbl.bufq[idx].q_lock);
-	mutex_unlock(&tbl.m_lock);
 
 	if (cmd->buf_handle != tbl.bufq[idx].buf_handle) {
 		CAM_ERR(CAM_MEM,
@@ -1186,6 +1228,7 @@ int cam_mem_mgr_alloc_and_map(struct cam_mem_mgr_alloc_cmd_v2 *cmd)
 		sizeof(int32_t) * cmd->num_hdl);
 	tbl.bufq[idx].is_imported = false;
 	mutex_unlock(&tbl.bufq[idx].q_lock);
+	cam_mem_util_hash_buf(idx);
 
 	cmd->out.buf_handle = tbl.bufq[idx].buf_handle;
 	cmd->out.fd = tbl.bufq[idx].fd;
@@ -1207,19 +1250,19 @@ slot_fail:
 	return rc;
 }
 
-static bool cam_mem_util_is_map_internal(int32_t fd, unsigned i_ino)
+static bool cam_mem_util_is_map_internal(int32_t fd, unsigned long i_ino)
 {
-	uint32_t i;
+	struct cam_mem_buf_queue *bufq;
 	bool is_internal = false;
 
-	mutex_lock(&tbl.m_lock);
-	for_each_set_bit(i, tbl.bitmap, tbl.bits) {
-		if ((tbl.bufq[i].fd == fd) && (tbl.bufq[i].i_ino == i_ino)) {
-			is_internal = tbl.bufq[i].is_internal;
+	spin_lock(&tbl.fd_hash_lock);
+	hash_for_each_possible(tbl.fd_hash, bufq, hnode, i_ino) {
+		if ((bufq->fd == fd) && (bufq->i_ino == i_ino)) {
+			is_internal = bufq->is_internal;
 			break;
 		}
 	}
-	mutex_unlock(&tbl.m_lock);
+	spin_unlock(&tbl.fd_hash_lock);
 
 	return is_internal;
 }
@@ -1326,6 +1369,7 @@ int cam_mem_mgr_map(struct cam_mem_mgr_map_cmd_v2 *cmd)
 	tbl.bufq[idx].is_imported = true;
 	tbl.bufq[idx].is_internal = is_internal;
 	mutex_unlock(&tbl.bufq[idx].q_lock);
+	cam_mem_util_hash_buf(idx);
 
 	cmd->out.buf_handle = tbl.bufq[idx].buf_handle;
 	cmd->out.vaddr = 0;
@@ -1445,6 +1489,7 @@ static int cam_mem_mgr_cleanup_table(void)
 			cam_mem_mgr_unmap_active_buf(i);
 		}
 
+		cam_mem_util_unhash_buf(i);
 		mutex_lock(&tbl.bufq[i].q_lock);
 		if (tbl.bufq[i].dma_buf) {
 			dma_buf_put(tbl.bufq[i].dma_buf);
@@ -1461,10 +1506,10 @@ static int cam_mem_mgr_cleanup_table(void)
 		tbl.bufq[i].num_hdl = 0;
 		tbl.bufq[i].dma_buf = NULL;
 		tbl.bufq[i].active = false;
+		tbl.bufq[i].gen = 0;
 		tbl.bufq[i].is_internal = false;
 		cam_mem_mgr_reset_presil_params(i);
 		mutex_unlock(&tbl.bufq[i].q_lock);
-		mutex_destroy(&tbl.bufq[i].q_lock);
 	}
 
 	bitmap_zero(tbl.bitmap, tbl.bits);
@@ -1477,11 +1522,15 @@ static int cam_mem_mgr_cleanup_table(void)
 
 void cam_mem_mgr_deinit(void)
 {
+	int i;
+
 	if (!atomic_read(&cam_mem_mgr_state))
 		return;
 
 	atomic_set(&cam_mem_mgr_state, CAM_MEM_MGR_UNINITIALIZED);
 	cam_mem_mgr_cleanup_table();
+	for (i = 1; i < CAM_MEM_BUFQ_MAX; i++)
+		mutex_destroy(&tbl.bufq[i].q_lock);
 	mutex_lock(&tbl.m_lock);
 	bitmap_zero(tbl.bitmap, tbl.bits);
 	kfree(tbl.bitmap);
@@ -1504,21 +1553,20 @@ static int cam_mem_util_unmap(int32_t idx,
 
 	CAM_DBG(CAM_MEM, "Flags = %X idx %d", tbl.bufq[idx].flags, idx);
 
-	mutex_lock(&tbl.m_lock);
+	mutex_lock(&tbl.bufq[idx].q_lock);
 	if ((!tbl.bufq[idx].active) &&
 		(tbl.bufq[idx].vaddr) == 0) {
 		CAM_WARN(CAM_MEM, "Buffer at idx=%d is already unmapped,",
 			idx);
-		mutex_unlock(&tbl.m_lock);
+		mutex_unlock(&tbl.bufq[idx].q_lock);
 		return 0;
 	}
 
 	/* Deactivate the buffer queue to prevent multiple unmap */
-	mutex_lock(&tbl.bufq[idx].q_lock);
 	tbl.bufq[idx].active = false;
+	tbl.bufq[idx].gen = 0;
 	tbl.bufq[idx].vaddr = 0;
 	mutex_unlock(&tbl.bufq[idx].q_lock);
-	mutex_unlock(&tbl.m_lock);
 
 	if (tbl.bufq[idx].flags & CAM_MEM_FLAG_KMD_ACCESS) {
 		if (tbl.bufq[idx].dma_buf && tbl.bufq[idx].kmdvaddr) {
@@ -1548,7 +1596,8 @@ static int cam_mem_util_unmap(int32_t idx,
 				tbl.bufq[idx].dma_buf);
 	}
 
-	mutex_lock(&tbl.m_lock);
+	cam_mem_util_unhash_buf(idx);
+
 	mutex_lock(&tbl.bufq[idx].q_lock);
 	tbl.bufq[idx].flags = 0;
 	tbl.bufq[idx].buf_handle = -1;
@@ -1573,9 +1622,7 @@ static int cam_mem_util_unmap(int32_t idx,
 	cam_mem_mgr_reset_presil_params(idx);
 	memset(&tbl.bufq[idx].timestamp, 0, sizeof(struct timespec64));
 	mutex_unlock(&tbl.bufq[idx].q_lock);
-	mutex_destroy(&tbl.bufq[idx].q_lock);
-	clear_bit(idx, tbl.bitmap);
-	mutex_unlock(&tbl.m_lock);
+	clear_bit_unlock(idx, tbl.bitmap);
 
 	return rc;
 }
@@ -9,12 +9,15 @@
 
 #include <linux/mutex.h>
 #include <linux/dma-buf.h>
+#include <linux/hashtable.h>
 #if IS_REACHABLE(CONFIG_DMABUF_HEAPS)
 #include <linux/dma-heap.h>
 #endif
 #include <media/cam_req_mgr.h>
 #include "cam_mem_mgr_api.h"
 
+#define CAM_MEM_FD_HASH_BITS 7
+
 /* Enum for possible mem mgr states */
 enum cam_mem_mgr_state {
 	CAM_MEM_MGR_UNINITIALIZED,
@@ -38,12 +41,15 @@ struct cam_presil_dmabuf_params {
  * struct cam_mem_buf_queue
  *
  * @dma_buf:        pointer to the allocated dma_buf in the table
- * @q_lock:         mutex lock for buffer
+ * @q_lock:         mutex lock for buffer, valid for the lifetime of the table
+ * @hnode:          node in the fd/inode index of the table
  * @hdls:           list of mapped handles
  * @num_hdl:        number of handles
  * @fd:             file descriptor of buffer
  * @i_ino:          inode number of this dmabuf. Uniquely identifies a buffer
  * @buf_handle:     unique handle for buffer
+ * @gen:            generation of the slot, changes every time the slot is
+ *                  reused and is zero while it is free
  * @align:          alignment for allocation
  * @len:            size of buffer
  * @flags:          attributes of buffer
@@ -58,11 +64,13 @@ struct cam_presil_dmabuf_params {
 struct cam_mem_buf_queue {
 	struct dma_buf *dma_buf;
 	struct mutex q_lock;
+	struct hlist_node hnode;
 	int32_t hdls[CAM_MEM_MMU_MAX_HANDLE];
 	int32_t num_hdl;
 	int32_t fd;
 	unsigned long i_ino;
 	int32_t buf_handle;
+	uint32_t gen;
 	int32_t align;
 	size_t len;
 	uint32_t flags;
@@ -81,9 +89,13 @@ struct cam_mem_buf_queue {
 /**
  * struct cam_mem_table
  *
- * @m_lock: mutex lock for table
+ * @m_lock: mutex lock for table wide cleanup, slots are claimed and
+ *          released locklessly through the bitmap
  * @bitmap: bitmap of the mem mgr utility
  * @bits: max bits of the utility
+ * @gen: last generation handed out to a buffer slot
+ * @fd_hash_lock: lock for fd_hash
+ * @fd_hash: index of the user buffers in bufq by inode
  * @bufq: array of buffers
  * @dbg_buf_idx: debug buffer index to get usecases info
  * @force_cache_allocs: Force all internal buffer allocations with cache
@@ -100,6 +112,9 @@ struct cam_mem_table {
 	struct mutex m_lock;
 	void *bitmap;
 	size_t bits;
+	atomic_t gen;
+	spinlock_t fd_hash_lock;
+	DECLARE_HASHTABLE(fd_hash, CAM_MEM_FD_HASH_BITS);
 	struct cam_mem_buf_queue bufq[CAM_MEM_BUFQ_MAX];
 	size_t dbg_buf_idx;
 	bool force_cache_allocs;
@@ -77,6 +77,18 @@ int cam_mem_mgr_release_mem(struct cam_mem_mgr_memory_desc *inp);
 int cam_mem_get_io_buf(int32_t buf_handle, int32_t mmu_handle,
 	dma_addr_t *iova_ptr, size_t *len_ptr, uint32_t *flags);
 
+/**
+ * @brief: Returns the generation of the slot backing a buffer handle.
+ *         It changes whenever the buffer is released, so callers caching
+ *         IOVA information can validate their entries with it.
+ *
+ * @buf_handle: Handle of the buffer
+ * @gen       : Generation of the buffer
+ *
+ * @return Status of operation. Negative in case of error. Zero otherwise.
+ */
+int cam_mem_get_buf_gen(int32_t buf_handle, uint32_t *gen);
+
 /**
  * @brief: This indicates begin of CPU access.
  *         Also returns CPU address information about DMA buffer
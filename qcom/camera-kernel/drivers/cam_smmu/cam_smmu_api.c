@@ -17,6 +17,8 @@
 #include <linux/genalloc.h>
 #include <linux/debugfs.h>
 #include <linux/dma-iommu.h>
+#include <linux/hashtable.h>
+#include <linux/rbtree.h>
 
 #include <soc/qcom/secure_buffer.h>
 
@@ -45,6 +47,7 @@
 #define GET_SMMU_TABLE_IDX(x) (((x) >> COOKIE_SIZE) & COOKIE_MASK)
 
 #define CAM_SMMU_MONITOR_MAX_ENTRIES   100
+#define CAM_SMMU_BUF_HASH_BITS         6
 #define CAM_SMMU_INC_MONITOR_HEAD(head, ret) \
 	div_u64_rem(atomic64_add_return(1, head),\
 	CAM_SMMU_MONITOR_MAX_ENTRIES, (ret))
@@ -163,6 +166,12 @@ struct cam_context_bank_info {
 
 	struct list_head smmu_buf_list;
 	struct list_head smmu_buf_kernel_list;
+	/* non-secure user mappings hashed by i_ino */
+	DECLARE_HASHTABLE(smmu_buf_hash, CAM_SMMU_BUF_HASH_BITS);
+	/* kernel mappings hashed by dma_buf */
+	DECLARE_HASHTABLE(smmu_buf_kernel_hash, CAM_SMMU_BUF_HASH_BITS);
+	/* non-secure user and scratch mappings sorted by iova */
+	struct rb_root smmu_buf_iova_tree;
 	struct mutex lock;
 	int handle;
 	enum cam_smmu_ops_param state;
@@ -217,6 +226,8 @@ struct cam_dma_buff_info {
 	int ref_count;
 	dma_addr_t paddr;
 	struct list_head list;
+	struct hlist_node hnode;
+	struct rb_node iova_node;
 	int ion_fd;
 	unsigned long i_ino;
 	size_t len;
@@ -689,7 +700,9 @@ static void cam_smmu_print_table(void)
 
 static uint32_t cam_smmu_find_closest_mapping(int idx, void *vaddr, bool *in_map_region)
 {
-	struct cam_dma_buff_info *mapping, *closest_mapping =  NULL;
+	struct cam_dma_buff_info *mapping = NULL, *closest_mapping =  NULL;
+	struct cam_dma_buff_info *prev = NULL, *next = NULL;
+	struct rb_node *node;
 	unsigned long start_addr, end_addr, current_addr;
 	uint32_t buf_info = 0;
 
@@ -697,12 +710,30 @@ static uint32_t cam_smmu_find_closest_mapping(int idx, void *vaddr, bool *in_map
 
 	current_addr = (unsigned long)vaddr;
 	*in_map_region = false;
-	list_for_each_entry(mapping,
-			&iommu_cb_set.cb_info[idx].smmu_buf_list, list) {
+
+	/*
+	 * Mappings don't overlap, so only the last one starting at or below
+	 * the address can contain it, and only that one and the next one
+	 * can be the closest.
+	 */
+	node = iommu_cb_set.cb_info[idx].smmu_buf_iova_tree.rb_node;
+	while (node) {
+		mapping = rb_entry(node, struct cam_dma_buff_info, iova_node);
+		if ((unsigned long)mapping->paddr <= current_addr) {
+			prev = mapping;
+			node = node->rb_right;
+		} else {
+			next = mapping;
+			node = node->rb_left;
+		}
+	}
+
+	if (prev) {
+		mapping = prev;
 		start_addr = (unsigned long)mapping->paddr;
 		end_addr = (unsigned long)mapping->paddr + mapping->len;
 
-		if (start_addr <= current_addr && current_addr <= end_addr) {
+		if (current_addr <= end_addr) {
 			closest_mapping = mapping;
 			*in_map_region = true;
 			CAM_INFO(CAM_SMMU,
@@ -711,21 +742,30 @@ static uint32_t cam_smmu_find_closest_mapping(int idx, void *vaddr, bool *in_map
 				end_addr, mapping->ion_fd, mapping->i_ino,
 				iommu_cb_set.cb_info[idx].name[0]);
 			goto end;
-		} else {
-			if (start_addr > current_addr)
-				delta =  start_addr - current_addr;
-			else
-				delta = current_addr - end_addr - 1;
-
-			if (delta < lowest_delta || lowest_delta == 0) {
-				lowest_delta = delta;
-				closest_mapping = mapping;
-			}
-			CAM_DBG(CAM_SMMU,
-				"approx va %lx not in range: %lx-%lx fd = %0x i_ino %lu",
-				current_addr, start_addr,
-				end_addr, mapping->ion_fd, mapping->i_ino);
 		}
+
+		lowest_delta = current_addr - end_addr - 1;
+		closest_mapping = mapping;
+		CAM_DBG(CAM_SMMU,
+			"approx va %lx not in range: %lx-%lx fd = %0x i_ino %lu",
+			current_addr, start_addr,
+			end_addr, mapping->ion_fd, mapping->i_ino);
+	}
+
+	if (next) {
+		mapping = next;
+		start_addr = (unsigned long)mapping->paddr;
+		end_addr = (unsigned long)mapping->paddr + mapping->len;
+		delta = start_addr - current_addr;
+
+		if (delta < lowest_delta || !closest_mapping) {
+			lowest_delta = delta;
+			closest_mapping = mapping;
+		}
+		CAM_DBG(CAM_SMMU,
+			"approx va %lx not in range: %lx-%lx fd = %0x i_ino %lu",
+			current_addr, start_addr,
+			end_addr, mapping->ion_fd, mapping->i_ino);
 	}
 
 end:
@@ -980,6 +1020,9 @@ void cam_smmu_reset_iommu_table(enum cam_smmu_init_dir ops)
 		iommu_cb_set.cb_info[i].handle = HANDLE_INIT;
 		INIT_LIST_HEAD(&iommu_cb_set.cb_info[i].smmu_buf_list);
 		INIT_LIST_HEAD(&iommu_cb_set.cb_info[i].smmu_buf_kernel_list);
+		hash_init(iommu_cb_set.cb_info[i].smmu_buf_hash);
+		hash_init(iommu_cb_set.cb_info[i].smmu_buf_kernel_hash);
+		iommu_cb_set.cb_info[i].smmu_buf_iova_tree = RB_ROOT;
 		iommu_cb_set.cb_info[i].state = CAM_SMMU_DETACH;
 		iommu_cb_set.cb_info[i].dev = NULL;
 		iommu_cb_set.cb_info[i].cb_count = 0;
@@ -1210,14 +1253,93 @@ static int cam_smmu_free_scratch_va(struct scratch_mapping *mapping,
 	return 0;
 }
 
+static void cam_smmu_add_user_mapping(int idx,
+	struct cam_dma_buff_info *mapping)
+{
+	struct cam_context_bank_info *cb_info = &iommu_cb_set.cb_info[idx];
+	struct rb_node **link = &cb_info->smmu_buf_iova_tree.rb_node;
+	struct rb_node *parent = NULL;
+	struct cam_dma_buff_info *entry;
+
+	list_add(&mapping->list, &cb_info->smmu_buf_list);
+	hash_add(cb_info->smmu_buf_hash, &mapping->hnode, mapping->i_ino);
+
+	while (*link) {
+		parent = *link;
+		entry = rb_entry(parent, struct cam_dma_buff_info, iova_node);
+		if (mapping->paddr < entry->paddr)
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
+	}
+	rb_link_node(&mapping->iova_node, parent, link);
+	rb_insert_color(&mapping->iova_node, &cb_info->smmu_buf_iova_tree);
+}
+
+static void cam_smmu_add_kernel_mapping(int idx,
+	struct cam_dma_buff_info *mapping)
+{
+	struct cam_context_bank_info *cb_info = &iommu_cb_set.cb_info[idx];
+
+	list_add(&mapping->list, &cb_info->smmu_buf_kernel_list);
+	hash_add(cb_info->smmu_buf_kernel_hash, &mapping->hnode,
+		(unsigned long)mapping->buf);
+}
+
+static void cam_smmu_remove_mapping(int idx,
+	struct cam_dma_buff_info *mapping)
+{
+	list_del_init(&mapping->list);
+	hash_del(&mapping->hnode);
+	if (!RB_EMPTY_NODE(&mapping->iova_node)) {
+		rb_erase(&mapping->iova_node,
+			&iommu_cb_set.cb_info[idx].smmu_buf_iova_tree);
+		RB_CLEAR_NODE(&mapping->iova_node);
+	}
+}
+
+static struct cam_dma_buff_info *cam_smmu_lookup_user_mapping(int idx,
+	int ion_fd, unsigned long i_ino)
+{
+	struct cam_dma_buff_info *mapping;
+
+	hash_for_each_possible(iommu_cb_set.cb_info[idx].smmu_buf_hash,
+		mapping, hnode, i_ino) {
+		if ((mapping->ion_fd == ion_fd) && (mapping->i_ino == i_ino))
+			return mapping;
+	}
+
+	return NULL;
+}
+
+static struct cam_dma_buff_info *cam_smmu_lookup_kernel_mapping(int idx,
+	struct dma_buf *buf)
+{
+	struct cam_dma_buff_info *mapping;
+
+	hash_for_each_possible(iommu_cb_set.cb_info[idx].smmu_buf_kernel_hash,
+		mapping, hnode, (unsigned long)buf) {
+		if (mapping->buf == buf)
+			return mapping;
+	}
+
+	return NULL;
+}
+
 static struct cam_dma_buff_info *cam_smmu_find_mapping_by_virt_address(int idx,
 	dma_addr_t virt_addr)
 {
 	struct cam_dma_buff_info *mapping;
-
-	list_for_each_entry(mapping, &iommu_cb_set.cb_info[idx].smmu_buf_list,
-			list) {
-		if (mapping->paddr == virt_addr) {
+	struct rb_node *node;
+
+	node = iommu_cb_set.cb_info[idx].smmu_buf_iova_tree.rb_node;
+	while (node) {
+		mapping = rb_entry(node, struct cam_dma_buff_info, iova_node);
+		if (virt_addr < mapping->paddr) {
+			node = node->rb_left;
+		} else if (virt_addr > mapping->paddr) {
+			node = node->rb_right;
+		} else {
 			CAM_DBG(CAM_SMMU, "Found virtual address %lx",
 				 (unsigned long)virt_addr);
 			return mapping;
@@ -1242,13 +1364,10 @@ static struct cam_dma_buff_info *cam_smmu_find_mapping_by_ion_index(int idx,
 
 	i_ino = file_inode(dmabuf->file)->i_ino;
 
-	list_for_each_entry(mapping,
-			&iommu_cb_set.cb_info[idx].smmu_buf_list,
-			list) {
-		if ((mapping->ion_fd == ion_fd) && (mapping->i_ino == i_ino)) {
-			CAM_DBG(CAM_SMMU, "find ion_fd %d i_ino %lu", ion_fd, i_ino);
-			return mapping;
-		}
+	mapping = cam_smmu_lookup_user_mapping(idx, ion_fd, i_ino);
+	if (mapping) {
+		CAM_DBG(CAM_SMMU, "find ion_fd %d i_ino %lu", ion_fd, i_ino);
+		return mapping;
 	}
 
 	CAM_ERR(CAM_SMMU, "Error: Cannot find entry by index %d, fd %d i_ino %lu",
@@ -1267,13 +1386,10 @@ static struct cam_dma_buff_info *cam_smmu_find_mapping_by_dma_buf(int idx,
 		return NULL;
 	}
 
-	list_for_each_entry(mapping,
-			&iommu_cb_set.cb_info[idx].smmu_buf_kernel_list,
-			list) {
-		if (mapping->buf == buf) {
-			CAM_DBG(CAM_SMMU, "find dma_buf %pK", buf);
-			return mapping;
-		}
+	mapping = cam_smmu_lookup_kernel_mapping(idx, buf);
+	if (mapping) {
+		CAM_DBG(CAM_SMMU, "find dma_buf %pK", buf);
+		return mapping;
 	}
 
 	CAM_ERR(CAM_SMMU, "Error: Cannot find entry by index %d", idx);
@@ -2273,6 +2389,7 @@ static int cam_smmu_map_buffer_validate(struct dma_buf *buf,
 		goto err_alloc;
 	}
 
+	RB_CLEAR_NODE(&(*mapping_info)->iova_node);
 	(*mapping_info)->buf = buf;
 	(*mapping_info)->attach = attach;
 	(*mapping_info)->table = table;
@@ -2341,8 +2458,7 @@ static int cam_smmu_map_buffer_and_add_to_list(int idx, int ion_fd,
 	mapping_info->is_internal = is_internal;
 	CAM_GET_TIMESTAMP(mapping_info->ts);
 	/* add to the list */
-	list_add(&mapping_info->list,
-		&iommu_cb_set.cb_info[idx].smmu_buf_list);
+	cam_smmu_add_user_mapping(idx, mapping_info);
 
 	CAM_DBG(CAM_SMMU, "fd %d i_ino %lu dmabuf %pK", ion_fd, mapping_info->i_ino, buf);
 
@@ -2373,8 +2489,7 @@ static int cam_smmu_map_kernel_buffer_and_add_to_list(int idx,
 	CAM_GET_TIMESTAMP(mapping_info->ts);
 
 	/* add to the list */
-	list_add(&mapping_info->list,
-		&iommu_cb_set.cb_info[idx].smmu_buf_kernel_list);
+	cam_smmu_add_kernel_mapping(idx, mapping_info);
 
 	CAM_DBG(CAM_SMMU, "fd %d i_ino %lu dmabuf %pK",
 		mapping_info->ion_fd, mapping_info->i_ino, buf);
@@ -2468,7 +2583,7 @@ static int cam_smmu_unmap_buf_and_remove_from_list(
 
 	mapping_info->buf = NULL;
 
-	list_del_init(&mapping_info->list);
+	cam_smmu_remove_mapping(idx, mapping_info);
 
 	/* free one buffer */
 	kfree(mapping_info);
@@ -2484,14 +2599,12 @@ static enum cam_smmu_buf_state cam_smmu_check_fd_in_list(int idx,
 
 	i_ino = file_inode(dmabuf->file)->i_ino;
 
-	list_for_each_entry(mapping,
-		&iommu_cb_set.cb_info[idx].smmu_buf_list, list) {
-		if ((mapping->ion_fd == ion_fd) && (mapping->i_ino == i_ino)) {
-			*paddr_ptr = mapping->paddr;
-			*len_ptr = mapping->len;
-			*ts_mapping = &mapping->ts;
-			return CAM_SMMU_BUFF_EXIST;
-		}
+	mapping = cam_smmu_lookup_user_mapping(idx, ion_fd, i_ino);
+	if (mapping) {
+		*paddr_ptr = mapping->paddr;
+		*len_ptr = mapping->len;
+		*ts_mapping = &mapping->ts;
+		return CAM_SMMU_BUFF_EXIST;
 	}
 
 	return CAM_SMMU_BUFF_NOT_EXIST;
@@ -2506,15 +2619,13 @@ static enum cam_smmu_buf_state cam_smmu_user_reuse_fd_in_list(int idx,
 
 	i_ino = file_inode(dmabuf->file)->i_ino;
 
-	list_for_each_entry(mapping,
-		&iommu_cb_set.cb_info[idx].smmu_buf_list, list) {
-		if ((mapping->ion_fd == ion_fd) && (mapping->i_ino == i_ino)) {
-			*paddr_ptr = mapping->paddr;
-			*len_ptr = mapping->len;
-			*ts_mapping = &mapping->ts;
-			mapping->ref_count++;
-			return CAM_SMMU_BUFF_EXIST;
-		}
+	mapping = cam_smmu_lookup_user_mapping(idx, ion_fd, i_ino);
+	if (mapping) {
+		*paddr_ptr = mapping->paddr;
+		*len_ptr = mapping->len;
+		*ts_mapping = &mapping->ts;
+		mapping->ref_count++;
+		return CAM_SMMU_BUFF_EXIST;
 	}
 
 	return CAM_SMMU_BUFF_NOT_EXIST;
@@ -2525,13 +2636,11 @@ static enum cam_smmu_buf_state cam_smmu_check_dma_buf_in_list(int idx,
 {
 	struct cam_dma_buff_info *mapping;
 
-	list_for_each_entry(mapping,
-		&iommu_cb_set.cb_info[idx].smmu_buf_kernel_list, list) {
-		if (mapping->buf == buf) {
-			*paddr_ptr = mapping->paddr;
-			*len_ptr = mapping->len;
-			return CAM_SMMU_BUFF_EXIST;
-		}
+	mapping = cam_smmu_lookup_kernel_mapping(idx, buf);
+	if (mapping) {
+		*paddr_ptr = mapping->paddr;
+		*len_ptr = mapping->len;
+		return CAM_SMMU_BUFF_EXIST;
 	}
 
 	return CAM_SMMU_BUFF_NOT_EXIST;
@@ -2745,7 +2854,7 @@ static int cam_smmu_alloc_scratch_buffer_add_to_list(int idx,
 		(void *)mapping_info->paddr,
 		mapping_info->len, mapping_info->phys_len);
 
-	list_add(&mapping_info->list, &iommu_cb_set.cb_info[idx].smmu_buf_list);
+	cam_smmu_add_user_mapping(idx, mapping_info);
 
 	*virt_addr = (dma_addr_t)iova;
 
@@ -2806,7 +2915,7 @@ static int cam_smmu_free_scratch_buffer_remove_from_list(
 			get_order(mapping_info->phys_len));
 	sg_free_table(mapping_info->table);
 	kfree(mapping_info->table);
-	list_del_init(&mapping_info->list);
+	cam_smmu_remove_mapping(idx, mapping_info);
 
 	kfree(mapping_info);
 	mapping_info = NULL;
@@ -53,22 +53,17 @@ static int cam_sync_create_util(
 {
 	int rc;
 	long idx;
-	bool bit;
 	struct sync_table_row *row = NULL;
 
-	do {
-		idx = find_first_zero_bit(sync_dev->bitmap, CAM_SYNC_MAX_OBJS);
-		if (idx >= CAM_SYNC_MAX_OBJS) {
-			CAM_ERR(CAM_SYNC,
-				"Error: Unable to create sync idx = %d sync name = %s reached max!",
-				idx, name);
-			cam_sync_print_fence_table();
-			return -ENOMEM;
-		}
+	if (cam_sync_util_find_and_set_empty_row(sync_dev, &idx)) {
+		CAM_ERR(CAM_SYNC,
+			"Error: Unable to create sync obj name = %s reached max!",
+			name);
+		cam_sync_print_fence_table();
+		return -ENOMEM;
+	}
 
-		CAM_DBG(CAM_SYNC, "Index location available at idx: %ld", idx);
-		bit = test_and_set_bit(idx, sync_dev->bitmap);
-	} while (bit);
+	CAM_DBG(CAM_SYNC, "Index location available at idx: %ld", idx);
 
 	spin_lock_bh(&sync_dev->row_spinlocks[idx]);
 	rc = cam_sync_init_row(sync_dev->sync_table, idx, name,
@@ -122,8 +117,8 @@ int cam_sync_create(int32_t *sync_obj, const char *name)
 	return cam_sync_create_util(sync_obj, name, NULL);
 }
 
-int cam_sync_register_callback(sync_callback cb_func,
-	void *userdata, int32_t sync_obj)
+static int cam_sync_register_callback_util(sync_callback cb_func,
+	void *userdata, int32_t sync_obj, bool inline_cb)
 {
 	struct sync_callback_info *sync_cb;
 	struct sync_table_row *row = NULL;
@@ -155,7 +150,7 @@ int cam_sync_register_callback(sync_callback cb_func,
 		(row->state == CAM_SYNC_STATE_SIGNALED_ERROR) ||
 		(row->state == CAM_SYNC_STATE_SIGNALED_CANCEL)) &&
 		(!row->remaining)) {
-		if (trigger_cb_without_switch) {
+		if (trigger_cb_without_switch || inline_cb) {
 			CAM_DBG(CAM_SYNC, "Invoke callback for sync object:%s[%d]",
 				row->name,
 				sync_obj);
@@ -185,6 +180,7 @@ int cam_sync_register_callback(sync_callback cb_func,
 	sync_cb->callback_func = cb_func;
 	sync_cb->cb_data = userdata;
 	sync_cb->sync_obj = sync_obj;
+	sync_cb->inline_cb = inline_cb;
 	INIT_WORK(&sync_cb->cb_dispatch_work, cam_sync_util_cb_dispatch);
 	list_add_tail(&sync_cb->list, &row->callback_list);
 	spin_unlock_bh(&sync_dev->row_spinlocks[sync_obj]);
@@ -192,6 +188,20 @@ int cam_sync_register_callback(sync_callback cb_func,
 	return 0;
 }
 
+int cam_sync_register_callback(sync_callback cb_func,
+	void *userdata, int32_t sync_obj)
+{
+	return cam_sync_register_callback_util(cb_func, userdata, sync_obj,
+		false);
+}
+
+int cam_sync_register_inline_callback(sync_callback cb_func,
+	void *userdata, int32_t sync_obj)
+{
+	return cam_sync_register_callback_util(cb_func, userdata, sync_obj,
+		true);
+}
+
 int cam_sync_deregister_callback(sync_callback cb_func,
 	void *userdata, int32_t sync_obj)
 {
@@ -265,6 +275,7 @@ static void cam_sync_signal_parent_util(int32_t status,
 	int rc;
 	struct sync_table_row *parent_row = NULL;
 	struct sync_parent_info *parent_info, *temp_parent_info;
+	struct list_head inline_cbs;
 
 	/*
 	 * Now iterate over all parents of this object and if they too need to
@@ -288,12 +299,14 @@ static void cam_sync_signal_parent_util(int32_t status,
 			continue;
 		}
 
+		INIT_LIST_HEAD(&inline_cbs);
 		if (!parent_row->remaining)
 			cam_sync_util_dispatch_signaled_cb(
 				parent_info->sync_id, parent_row->state,
-				event_cause);
+				event_cause, &inline_cbs);
 
 		spin_unlock_bh(&sync_dev->row_spinlocks[parent_info->sync_id]);
+		cam_sync_util_run_inline_cbs(&inline_cbs);
 		list_del_init(&parent_info->list);
 		kfree(parent_info);
 	}
@@ -340,6 +353,7 @@ int cam_sync_signal(int32_t sync_obj, uint32_t status, uint32_t event_cause)
 {
 	struct sync_table_row *row = NULL;
 	struct list_head parents_list;
+	struct list_head inline_cbs;
 	int rc = 0;
 
 	if (sync_obj >= CAM_SYNC_MAX_OBJS || sync_obj <= 0) {
@@ -378,12 +392,15 @@ int cam_sync_signal(int32_t sync_obj, uint32_t status, uint32_t event_cause)
 				row->dma_fence_info.dma_fence_fd, row->name, sync_obj);
 	}
 
-	cam_sync_util_dispatch_signaled_cb(sync_obj, status, event_cause);
+	INIT_LIST_HEAD(&inline_cbs);
+	cam_sync_util_dispatch_signaled_cb(sync_obj, status, event_cause,
+		&inline_cbs);
 
 	/* copy parent list to local and release child lock */
 	INIT_LIST_HEAD(&parents_list);
 	list_splice_init(&row->parents_list, &parents_list);
 	spin_unlock_bh(&sync_dev->row_spinlocks[sync_obj]);
+	cam_sync_util_run_inline_cbs(&inline_cbs);
 
 	if (list_empty(&parents_list))
 		return 0;
@@ -397,7 +414,6 @@ int cam_sync_merge(int32_t *sync_obj, uint32_t num_objs, int32_t *merged_obj)
 {
 	int rc;
 	long idx = 0;
-	bool bit;
 	int i = 0;
 
 	if (!sync_obj || !merged_obj) {
@@ -424,12 +440,8 @@ int cam_sync_merge(int32_t *sync_obj, uint32_t num_objs, int32_t *merged_obj)
 			return rc;
 		}
 	}
-	do {
-		idx = find_first_zero_bit(sync_dev->bitmap, CAM_SYNC_MAX_OBJS);
-		if (idx >= CAM_SYNC_MAX_OBJS)
-			return -ENOMEM;
-		bit = test_and_set_bit(idx, sync_dev->bitmap);
-	} while (bit);
+	if (cam_sync_util_find_and_set_empty_row(sync_dev, &idx))
+		return -ENOMEM;
 
 	spin_lock_bh(&sync_dev->row_spinlocks[idx]);
 	rc = cam_sync_init_group_object(sync_dev->sync_table,
@@ -868,6 +880,7 @@ static int cam_sync_dma_fence_cb(
 	int32_t status = CAM_SYNC_STATE_SIGNALED_SUCCESS;
 	struct sync_table_row *row = NULL;
 	struct list_head parents_list;
+	struct list_head inline_cbs;
 
 	if (!signal_sync_obj) {
 		CAM_ERR(CAM_SYNC, "Invalid signal info args");
@@ -922,11 +935,13 @@ static int cam_sync_dma_fence_cb(
 
 	row->state = status;
 
-	cam_sync_util_dispatch_signaled_cb(sync_obj, status, 0);
+	INIT_LIST_HEAD(&inline_cbs);
+	cam_sync_util_dispatch_signaled_cb(sync_obj, status, 0, &inline_cbs);
 
 	INIT_LIST_HEAD(&parents_list);
 	list_splice_init(&row->parents_list, &parents_list);
 	spin_unlock_bh(&sync_dev->row_spinlocks[sync_obj]);
+	cam_sync_util_run_inline_cbs(&inline_cbs);
 
 	if (list_empty(&parents_list))
 		return 0;
@@ -1955,6 +1970,7 @@ static int cam_sync_component_bind(struct device *dev,
 	 * always
 	 */
 	set_bit(0, sync_dev->bitmap);
+	atomic_set(&sync_dev->alloc_hint, 1);
 
 	sync_dev->work_queue = alloc_workqueue(CAM_SYNC_WORKQUEUE_NAME,
 		WQ_HIGHPRI | WQ_UNBOUND, 1);
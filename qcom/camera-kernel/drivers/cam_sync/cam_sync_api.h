@@ -50,6 +50,28 @@ int cam_sync_create(int32_t *sync_obj, const char *name);
 int cam_sync_register_callback(sync_callback cb_func,
 	void *userdata, int32_t sync_obj);
 
+/**
+ * @brief: Registers a callback that is invoked directly from the context
+ *         signaling the sync object, skipping the workqueue hop. That is
+ *         the caller of cam_sync_signal, which may be in softirq context,
+ *         or the dma fence callback, which runs with the dma fence lock
+ *         held and interrupts disabled. If the object is already signaled
+ *         the callback runs from this call instead.
+ *         The callback must be irq-safe, must not sleep and must not
+ *         re-enter cam_sync or the dma fence for the same object.
+ *
+ * @param cb_func:  Pointer to callback to be registered
+ * @param userdata: Opaque pointer which will be passed back with callback.
+ * @param sync_obj: int referencing the sync object.
+ *
+ * @return Status of operation. Zero in case of success.
+ * -EINVAL will be returned if userdata is invalid.
+ * -ENOMEM will be returned if cb_func is invalid.
+ *
+ */
+int cam_sync_register_inline_callback(sync_callback cb_func,
+	void *userdata, int32_t sync_obj);
+
 /**
  * @brief: De-registers a callback with a sync object
  *
@@ -102,6 +102,8 @@ struct sync_child_info {
  * @status             : Status with which callback will be invoked in client
  * @sync_obj           : Sync id of the object for which callback is registered
  * @workq_scheduled_ts : workqueue scheduled timestamp
+ * @inline_cb          : Callback is invoked in the signaling context instead
+ *                       of the workqueue
  * @cb_dispatch_work   : Work representing the call dispatch
  * @list               : List member used to append this node to a linked list
  */
@@ -111,6 +113,7 @@ struct sync_callback_info {
 	int status;
 	int32_t sync_obj;
 	ktime_t workq_scheduled_ts;
+	bool inline_cb;
 	struct work_struct cb_dispatch_work;
 	struct list_head list;
 };
@@ -159,6 +162,7 @@ struct sync_dma_fence_info {
  * @ref_cnt            : ref count of the number of usage of the fence.
  * @ext_fence_mask     : Mask to indicate associated external fence types
  * @dma_fence_info     : dma fence info if associated
+ * @create_ts          : Time at which the object was created
  */
 struct sync_table_row {
 	char name[CAM_SYNC_OBJ_NAME_LEN];
@@ -176,6 +180,7 @@ struct sync_table_row {
 	atomic_t ref_cnt;
 	unsigned long ext_fence_mask;
 	struct sync_dma_fence_info dma_fence_info;
+	ktime_t create_ts;
 };
 
 /**
@@ -205,6 +210,7 @@ struct cam_signalable_info {
  * @work_queue      : Work queue used for dispatching kernel callbacks
  * @cam_sync_eventq : Event queue used to dispatch user payloads to user space
  * @bitmap          : Bitmap representation of all sync objects
+ * @alloc_hint      : Row at which the search for a free row starts
  * @params          : Parameters for synx call back registration
  * @version         : version support
  */
@@ -220,6 +226,7 @@ struct sync_device {
 	struct v4l2_fh *cam_sync_eventq;
 	spinlock_t cam_sync_eventq_lock;
 	DECLARE_BITMAP(bitmap, CAM_SYNC_MAX_OBJS);
+	atomic_t alloc_hint;
 #if IS_REACHABLE(CONFIG_MSM_GLOBAL_SYNX)
 	struct synx_register_params params;
 #endif
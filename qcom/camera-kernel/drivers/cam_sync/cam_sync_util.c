@@ -11,20 +11,25 @@
 int cam_sync_util_find_and_set_empty_row(struct sync_device *sync_dev,
 	long *idx)
 {
-	int rc = 0;
-
-	mutex_lock(&sync_dev->table_lock);
-
-	*idx = find_first_zero_bit(sync_dev->bitmap, CAM_SYNC_MAX_OBJS);
-
-	if (*idx < CAM_SYNC_MAX_OBJS)
-		set_bit(*idx, sync_dev->bitmap);
-	else
-		rc = -1;
+	long hint;
+
+	do {
+		hint = atomic_read(&sync_dev->alloc_hint);
+		if (hint <= 0 || hint >= CAM_SYNC_MAX_OBJS)
+			hint = 1;
+
+		*idx = find_next_zero_bit(sync_dev->bitmap, CAM_SYNC_MAX_OBJS,
+			hint);
+		if (*idx >= CAM_SYNC_MAX_OBJS) {
+			*idx = find_first_zero_bit(sync_dev->bitmap, hint);
+			if (*idx >= hint)
+				return -ENOMEM;
+		}
+	} while (test_and_set_bit(*idx, sync_dev->bitmap));
 
-	mutex_unlock(&sync_dev->table_lock);
+	atomic_set(&sync_dev->alloc_hint, *idx + 1);
 
-	return rc;
+	return 0;
 }
 
 int cam_sync_init_row(struct sync_table_row *table,
@@ -48,6 +53,7 @@ int cam_sync_init_row(struct sync_table_row *table,
 	init_completion(&row->signaled);
 	INIT_LIST_HEAD(&row->callback_list);
 	INIT_LIST_HEAD(&row->user_payload_list);
+	row->create_ts = ktime_get();
 	CAM_DBG(CAM_SYNC,
 		"row name:%s sync_id:%i [idx:%u] row_state:%u ",
 		row->name, row->sync_id, idx, row->state);
@@ -323,8 +329,20 @@ void cam_sync_util_cb_dispatch(struct work_struct *cb_dispatch_work)
 	kfree(cb_info);
 }
 
+void cam_sync_util_run_inline_cbs(struct list_head *inline_cbs)
+{
+	struct sync_callback_info *sync_cb, *temp_sync_cb;
+
+	list_for_each_entry_safe(sync_cb, temp_sync_cb, inline_cbs, list) {
+		list_del_init(&sync_cb->list);
+		sync_cb->callback_func(sync_cb->sync_obj, sync_cb->status,
+			sync_cb->cb_data);
+		kfree(sync_cb);
+	}
+}
+
 void cam_sync_util_dispatch_signaled_cb(int32_t sync_obj,
-	uint32_t status, uint32_t event_cause)
+	uint32_t status, uint32_t event_cause, struct list_head *inline_cbs)
 {
 	struct sync_callback_info  *sync_cb;
 	struct sync_user_payload   *payload_info;
@@ -340,10 +358,18 @@ void cam_sync_util_dispatch_signaled_cb(int32_t sync_obj,
 		return;
 	}
 
+	trace_cam_sync_signal(sync_obj, status,
+		ktime_to_ns(ktime_sub(ktime_get(), signalable_row->create_ts)));
+
 	/* Dispatch kernel callbacks if any were registered earlier */
 	list_for_each_entry_safe(sync_cb,
 		temp_sync_cb, &signalable_row->callback_list, list) {
 		sync_cb->status = status;
+		if (sync_cb->inline_cb) {
+			list_move_tail(&sync_cb->list, inline_cbs);
+			continue;
+		}
+
 		list_del_init(&sync_cb->list);
 		queue_work(sync_dev->work_queue,
 			&sync_cb->cb_dispatch_work);
@@ -33,7 +33,8 @@ struct cam_sync_check_for_dma_release {
 
 /**
  * @brief: Finds an empty row in the sync table and sets its corresponding bit
- * in the bit array
+ * in the bit array. Lockless, the search starts after the last row handed
+ * out so freed rows are not reused right away.
  *
  * @param sync_dev : Pointer to the sync device instance
  * @param idx      : Pointer to an long containing the index found in the bit
@@ -103,11 +104,24 @@ void cam_sync_util_cb_dispatch(struct work_struct *cb_dispatch_work);
  * @sync_obj    : Sync object that is signaled
  * @status      : Status of the signaled object
  * @evt_param   : Event paramaeter
+ * @inline_cbs  : Callbacks registered to run inline are moved here, for
+ *                the caller to run once it drops the row lock
  *
  * @return None
  */
 void cam_sync_util_dispatch_signaled_cb(int32_t sync_obj,
-	uint32_t status, uint32_t evt_param);
+	uint32_t status, uint32_t evt_param, struct list_head *inline_cbs);
+
+/**
+ * @brief: Function to invoke the inline callbacks collected by
+ *         cam_sync_util_dispatch_signaled_cb. Must be called without
+ *         the row lock held.
+ *
+ * @inline_cbs  : List of callbacks to invoke, emptied on return
+ *
+ * @return None
+ */
+void cam_sync_util_run_inline_cbs(struct list_head *inline_cbs);
 
 /**
  * @brief: Function to send V4L event to user space
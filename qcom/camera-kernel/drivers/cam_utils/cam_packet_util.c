@@ -348,8 +348,67 @@ static int cam_packet_util_get_patch_iova(
 	return rc;
 }
 
-int cam_packet_util_process_patches(struct cam_packet *packet,
-	int32_t iommu_hdl, int32_t sec_mmu_hdl, bool exp_mem)
+static int cam_packet_util_get_cached_patch_iova(
+	struct cam_packet_iova_cache *cache,
+	int32_t hdl, uint32_t buf_hdl, dma_addr_t *iova,
+	size_t *buf_size, uint32_t *flags)
+{
+	struct cam_packet_iova_cache_entry *entry;
+	uint32_t gen = 0;
+	int rc;
+
+	entry = &cache->entries[CAM_MEM_MGR_GET_HDL_IDX(buf_hdl) %
+		CAM_PACKET_IOVA_CACHE_SIZE];
+
+	/* An invalid handle is left to cam_mem_get_io_buf to report */
+	if (!cam_mem_get_buf_gen(buf_hdl, &gen) && (entry->gen == gen) &&
+		(entry->buf_hdl == buf_hdl) && (entry->mmu_hdl == hdl)) {
+		*iova = entry->iova;
+		*buf_size = entry->buf_size;
+		*flags = entry->flags;
+		cache->hits++;
+		return 0;
+	}
+
+	cache->misses++;
+	rc = cam_mem_get_io_buf(buf_hdl, hdl, iova, buf_size, flags);
+	if (rc < 0) {
+		CAM_ERR(CAM_UTIL,
+			"unable to get iova for src_hdl: 0x%x",
+			buf_hdl);
+		return rc;
+	}
+
+	/*
+	 * The generation is read before the lookup, so a release racing with
+	 * it leaves a stale generation here and the entry is never hit.
+	 */
+	if (gen) {
+		entry->buf_hdl = buf_hdl;
+		entry->mmu_hdl = hdl;
+		entry->gen = gen;
+		entry->iova = *iova;
+		entry->buf_size = *buf_size;
+		entry->flags = *flags;
+	}
+
+	return rc;
+}
+
+void cam_packet_util_iova_cache_reset(struct cam_packet_iova_cache *cache)
+{
+	if (!cache)
+		return;
+
+	CAM_DBG(CAM_UTIL, "IOVA cache hits: %llu misses: %llu",
+		cache->hits, cache->misses);
+
+	memset(cache, 0, sizeof(*cache));
+}
+
+static int cam_packet_util_patch_packet(struct cam_packet *packet,
+	int32_t iommu_hdl, int32_t sec_mmu_hdl, bool exp_mem,
+	struct cam_packet_iova_cache *cache)
 {
 	struct cam_patch_desc *patch_desc = NULL;
 	dma_addr_t iova_addr;
@@ -365,8 +424,9 @@ int cam_packet_util_process_patches(struct cam_packet *packet,
 	struct cam_patch_unique_src_buf_tbl
 		tbl[CAM_UNIQUE_SRC_HDL_MAX];
 
-	memset(tbl, 0, CAM_UNIQUE_SRC_HDL_MAX *
-		sizeof(struct cam_patch_unique_src_buf_tbl));
+	if (!cache)
+		memset(tbl, 0, CAM_UNIQUE_SRC_HDL_MAX *
+			sizeof(struct cam_patch_unique_src_buf_tbl));
 
 	/* process patch descriptor */
 	patch_desc = (struct cam_patch_desc *)
@@ -380,8 +440,14 @@ int cam_packet_util_process_patches(struct cam_packet *packet,
 		hdl = cam_mem_is_secure_buf(patch_desc[i].src_buf_hdl) ?
 			sec_mmu_hdl : iommu_hdl;
 
-		rc = cam_packet_util_get_patch_iova(&tbl[0], hdl,
-			patch_desc[i].src_buf_hdl, &iova_addr, &src_buf_size, &flags);
+		if (cache)
+			rc = cam_packet_util_get_cached_patch_iova(cache, hdl,
+				patch_desc[i].src_buf_hdl, &iova_addr, &src_buf_size,
+				&flags);
+		else
+			rc = cam_packet_util_get_patch_iova(&tbl[0], hdl,
+				patch_desc[i].src_buf_hdl, &iova_addr, &src_buf_size,
+				&flags);
 		if (rc) {
 			CAM_ERR(CAM_UTIL,
 				"get_iova failed for patch[%d], src_buf_hdl: 0x%x: rc: %d",
@@ -449,6 +515,21 @@ int cam_packet_util_process_patches(struct cam_packet *packet,
 	return rc;
 }
 
+int cam_packet_util_process_patches(struct cam_packet *packet,
+	int32_t iommu_hdl, int32_t sec_mmu_hdl, bool exp_mem)
+{
+	return cam_packet_util_patch_packet(packet, iommu_hdl, sec_mmu_hdl,
+		exp_mem, NULL);
+}
+
+int cam_packet_util_process_patches_cached(struct cam_packet *packet,
+	int32_t iommu_hdl, int32_t sec_mmu_hdl, bool exp_mem,
+	struct cam_packet_iova_cache *cache)
+{
+	return cam_packet_util_patch_packet(packet, iommu_hdl, sec_mmu_hdl,
+		exp_mem, cache);
+}
+
 void cam_packet_util_dump_io_bufs(struct cam_packet *packet,
 	int32_t iommu_hdl, int32_t sec_mmu_hdl,
 	struct cam_hw_dump_pf_args *pf_args, bool res_id_support)
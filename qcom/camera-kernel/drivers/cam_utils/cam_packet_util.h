@@ -28,6 +28,42 @@ struct cam_kmd_buf_info {
 	uint32_t   used_bytes;
 };
 
+#define CAM_PACKET_IOVA_CACHE_SIZE 64
+
+/**
+ * @brief                  Cached IOVA of a patch source buffer
+ *
+ * @buf_hdl:               Memory handle of the buffer
+ * @mmu_hdl:               IOMMU handle the IOVA belongs to
+ * @gen:                   Generation of the buffer when it was cached
+ * @iova:                  IOVA of the buffer
+ * @buf_size:              Size of the buffer
+ * @flags:                 Flags the buffer was allocated with
+ *
+ */
+struct cam_packet_iova_cache_entry {
+	int32_t     buf_hdl;
+	int32_t     mmu_hdl;
+	uint32_t    gen;
+	dma_addr_t  iova;
+	size_t      buf_size;
+	uint32_t    flags;
+};
+
+/**
+ * @brief                  Per context cache of patch source buffer IOVAs
+ *
+ * @entries:               Cache entries, indexed by buffer slot
+ * @hits:                  Number of lookups served from the cache
+ * @misses:                Number of lookups that went to the mem manager
+ *
+ */
+struct cam_packet_iova_cache {
+	struct cam_packet_iova_cache_entry entries[CAM_PACKET_IOVA_CACHE_SIZE];
+	uint64_t                           hits;
+	uint64_t                           misses;
+};
+
 /* Generic Cmd Buffer blob callback function type */
 typedef int (*cam_packet_generic_blob_handler)(void *user_data,
 	uint32_t blob_type, uint32_t blob_size, uint8_t *blob_data);
@@ -134,6 +170,41 @@ void cam_packet_util_dump_patch_info(struct cam_packet *packet,
 int cam_packet_util_process_patches(struct cam_packet *packet,
 	int32_t iommu_hdl, int32_t sec_mmu_hdl, bool exp_mem);
 
+/**
+ * cam_packet_util_process_patches_cached()
+ *
+ * @brief:              Same as cam_packet_util_process_patches(), but the
+ *                      source buffer IOVAs are looked up in a cache owned
+ *                      by the caller, which persists across packets.
+ *                      Entries are validated against the buffer generation
+ *                      so released buffers are never patched in. The
+ *                      caller must serialize calls that share a cache.
+ *
+ * @packet:             Input packet containing Command Buffers and Patches
+ * @iommu_hdl:          IOMMU handle of the HW Device that received the packet
+ * @sec_iommu_hdl:      Secure IOMMU handle of the HW Device that
+ *                      received the packet
+ * @exp_mem:            Boolean to know if patched address is in expanded memory range
+ *                      or within default 32-bit address space.
+ * @cache:              IOVA cache of the context
+ *
+ * @return:             0: Success
+ *                      Negative: Failure
+ */
+int cam_packet_util_process_patches_cached(struct cam_packet *packet,
+	int32_t iommu_hdl, int32_t sec_mmu_hdl, bool exp_mem,
+	struct cam_packet_iova_cache *cache);
+
+/**
+ * cam_packet_util_iova_cache_reset()
+ *
+ * @brief:              Drop all entries and counters of an IOVA cache
+ *
+ * @cache:              IOVA cache to reset
+ *
+ */
+void cam_packet_util_iova_cache_reset(struct cam_packet_iova_cache *cache);
+
 /**
  * cam_packet_util_dump_io_bufs()
  *
@@ -402,6 +402,26 @@ TRACE_EVENT(cam_cdm_cb,
 	)
 );
 
+TRACE_EVENT(cam_sync_signal,
+	TP_PROTO(int32_t sync_obj, uint32_t status, uint64_t latency_ns),
+	TP_ARGS(sync_obj, status, latency_ns),
+	TP_STRUCT__entry(
+		__field(int32_t, sync_obj)
+		__field(uint32_t, status)
+		__field(uint64_t, latency_ns)
+	),
+	TP_fast_assign(
+		__entry->sync_obj   = sync_obj;
+		__entry->status     = status;
+		__entry->latency_ns = latency_ns;
+	),
+	TP_printk(
+		"sync_obj=%d status=%u create_to_signal=%llu ns",
+			__entry->sync_obj, __entry->status,
+			__entry->latency_ns
+	)
+);
+
 #endif /* _CAM_TRACE_H */
 
 /* This part must be outside protection */
@@ -9252,6 +9252,10 @@ static int ipa3_pre_init(const struct ipa3_plat_drv_res *resource_p,
 	ipa3_ctx->stats.num_sort_tasklet_sched[2] = 0;
 	ipa3_ctx->stats.num_of_times_wq_reschd = 0;
 	ipa3_ctx->stats.page_recycle_cnt_in_tasklet = 0;
+	memset(ipa3_ctx->stats.page_recycle_scan_hist, 0,
+		sizeof(ipa3_ctx->stats.page_recycle_scan_hist));
+	memset(ipa3_ctx->stats.page_recycle_lat_hist, 0,
+		sizeof(ipa3_ctx->stats.page_recycle_lat_hist));
 	ipa3_ctx->skip_uc_pipe_reset = resource_p->skip_uc_pipe_reset;
 	ipa3_ctx->tethered_flow_control = resource_p->tethered_flow_control;
 	ipa3_ctx->ee = resource_p->ee;
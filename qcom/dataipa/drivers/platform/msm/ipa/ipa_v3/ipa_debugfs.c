@@ -1683,6 +1683,43 @@ static ssize_t ipa3_read_page_recycle_stats(struct file *file,
 	return simple_read_from_buffer(ubuf, count, ppos, dbg_buff, cnt);
 }
 
+static ssize_t ipa3_read_page_recycle_hist(struct file *file,
+		char __user *ubuf, size_t count, loff_t *ppos)
+{
+	int nbytes;
+	int cnt = 0, i = 0;
+	const int last = IPA_PAGE_RECYCLE_HIST_MAX - 1;
+
+	/* Bucket i holds values below 2^i, the last one is open ended */
+	for (i = 0; i < last; i++) {
+		nbytes = scnprintf(
+			dbg_buff + cnt, IPA_MAX_MSG_LEN - cnt,
+			"COMMON : Recycle scan length < %lu =%llu\n",
+			BIT(i), ipa3_ctx->stats.page_recycle_scan_hist[i]);
+		cnt += nbytes;
+	}
+	nbytes = scnprintf(
+		dbg_buff + cnt, IPA_MAX_MSG_LEN - cnt,
+		"COMMON : Recycle scan length >= %lu =%llu\n",
+		BIT(last - 1), ipa3_ctx->stats.page_recycle_scan_hist[last]);
+	cnt += nbytes;
+
+	for (i = 0; i < last; i++) {
+		nbytes = scnprintf(
+			dbg_buff + cnt, IPA_MAX_MSG_LEN - cnt,
+			"COMMON : Recycle latency < %lu us =%llu\n",
+			BIT(i), ipa3_ctx->stats.page_recycle_lat_hist[i]);
+		cnt += nbytes;
+	}
+	nbytes = scnprintf(
+		dbg_buff + cnt, IPA_MAX_MSG_LEN - cnt,
+		"COMMON : Recycle latency >= %lu us =%llu\n",
+		BIT(last - 1), ipa3_ctx->stats.page_recycle_lat_hist[last]);
+	cnt += nbytes;
+
+	return simple_read_from_buffer(ubuf, count, ppos, dbg_buff, cnt);
+}
+
 static ssize_t ipa3_read_lan_coal_stats(
 	struct file *file,
 	char __user *ubuf,
@@ -3546,6 +3583,10 @@ static const struct ipa3_debugfs_file debugfs_files[] = {
 		"page_recycle_stats", IPA_READ_ONLY_MODE, NULL, {
 			.read = ipa3_read_page_recycle_stats,
 		}
+	}, {
+		"page_recycle_hist", IPA_READ_ONLY_MODE, NULL, {
+			.read = ipa3_read_page_recycle_hist,
+		}
 	}, {
 		"lan_coal_stats", IPA_READ_ONLY_MODE, NULL, {
 			.read = ipa3_read_lan_coal_stats,
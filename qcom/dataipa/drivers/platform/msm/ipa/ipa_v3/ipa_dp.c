@@ -96,8 +96,6 @@
 
 #define IPA_APPS_BW_FOR_PM 700
 
-#define IPA_SEND_MAX_DESC (20)
-
 #define IPA_EOT_THRESH 32
 
 #define IPA_QMAP_ID_BYTE 0
@@ -1369,6 +1367,115 @@ fail_setup:
 	return result;
 }
 
+static inline void ipa3_page_recycle_hist(u64 *hist, u64 val)
+{
+	hist[min_t(u32, fls64(val), IPA_PAGE_RECYCLE_HIST_MAX - 1)]++;
+}
+
+/**
+ * ipa3_page_recycle_put() - put a page back on the recycle ring
+ * @repl: recycle ring of the pipe
+ * @rx_pkt: wrapper of the page
+ * @is_free: the page is known to be unreferenced by the stack
+ *
+ * The ring is kept in the order pages were handed back, so the pages most
+ * likely to have been released by the stack are at the head. Pages that
+ * are already free go straight to the head. The caller holds the common
+ * sys spinlock.
+ */
+void ipa3_page_recycle_put(struct ipa3_page_repl_ctx *repl,
+	struct ipa3_rx_pkt_wrapper *rx_pkt, bool is_free)
+{
+	rx_pkt->recycle_ts = ktime_get();
+	if (is_free)
+		list_add(&rx_pkt->link, &repl->page_repl_head);
+	else
+		list_add_tail(&rx_pkt->link, &repl->page_repl_head);
+}
+
+/**
+ * ipa3_page_recycle_get() - take a reusable page off the recycle ring
+ * @repl: recycle ring of the pipe
+ * @budget: maximum number of ring entries to inspect
+ * @scanned: [out] number of ring entries inspected
+ * @lat_hist: histogram the time the page spent on the ring is recorded in
+ *
+ * Pages still held by the stack are rotated to the tail as they are seen,
+ * so the next call starts at pages it has not looked at yet instead of
+ * rescanning the same busy ones. The caller holds the common sys spinlock.
+ *
+ * Return: wrapper with an extra page reference taken, or NULL
+ */
+struct ipa3_rx_pkt_wrapper *ipa3_page_recycle_get(
+	struct ipa3_page_repl_ctx *repl, u32 budget, u32 *scanned,
+	u64 *lat_hist)
+{
+	struct ipa3_rx_pkt_wrapper *rx_pkt;
+	u32 i;
+
+	budget = min_t(u32, budget, repl->capacity);
+	for (i = 0; i < budget; i++) {
+		rx_pkt = list_first_entry_or_null(&repl->page_repl_head,
+			struct ipa3_rx_pkt_wrapper, link);
+		if (!rx_pkt)
+			break;
+
+		if (page_ref_count(rx_pkt->page_data.page) == 1) {
+			/* Found a free page. */
+			page_ref_inc(rx_pkt->page_data.page);
+			list_del_init(&rx_pkt->link);
+			ipa3_page_recycle_hist(lat_hist,
+				ktime_us_delta(ktime_get(), rx_pkt->recycle_ts));
+			*scanned = i + 1;
+			return rx_pkt;
+		}
+
+		list_move_tail(&rx_pkt->link, &repl->page_repl_head);
+	}
+
+	*scanned = i;
+	return NULL;
+}
+
+/**
+ * ipa3_page_recycle_sweep() - gather reusable pages at the ring head
+ * @repl: recycle ring of the pipe
+ * @want: stop once this many free pages were found
+ * @scan_hist: histogram the number of ring entries inspected is recorded in
+ *
+ * Does at most one pass over the ring, rotating busy pages to the tail.
+ * The caller holds the common sys spinlock.
+ *
+ * Return: number of free pages moved to the head
+ */
+u32 ipa3_page_recycle_sweep(struct ipa3_page_repl_ctx *repl, u32 want,
+	u64 *scan_hist)
+{
+	struct ipa3_rx_pkt_wrapper *rx_pkt;
+	LIST_HEAD(found_head);
+	u32 found = 0;
+	u32 i;
+
+	for (i = 0; i < repl->capacity && found < want; i++) {
+		rx_pkt = list_first_entry_or_null(&repl->page_repl_head,
+			struct ipa3_rx_pkt_wrapper, link);
+		if (!rx_pkt)
+			break;
+
+		if (page_ref_count(rx_pkt->page_data.page) == 1) {
+			list_move_tail(&rx_pkt->link, &found_head);
+			found++;
+		} else {
+			list_move_tail(&rx_pkt->link, &repl->page_repl_head);
+		}
+	}
+
+	list_splice(&found_head, &repl->page_repl_head);
+	ipa3_page_recycle_hist(scan_hist, i);
+
+	return found;
+}
+
 static void ipa3_schd_freepage_work(struct work_struct *work)
 {
 	struct delayed_work *dwork;
@@ -1385,26 +1492,14 @@ static void ipa3_schd_freepage_work(struct work_struct *work)
 static void ipa3_tasklet_find_freepage(unsigned long data)
 {
 	struct ipa3_sys_context *sys;
-	struct ipa3_rx_pkt_wrapper *rx_pkt = NULL;
-	struct ipa3_rx_pkt_wrapper *tmp = NULL;
-	struct page *cur_page;
 	int found_free_page = 0;
-	struct list_head temp_head;
 
 	sys = (struct ipa3_sys_context *)data;
 
-	INIT_LIST_HEAD(&temp_head);
 	spin_lock_bh(&sys->common_sys->spinlock);
-	list_for_each_entry_safe(rx_pkt, tmp,
-		&sys->page_recycle_repl->page_repl_head, link) {
-		cur_page = rx_pkt->page_data.page;
-		if (page_ref_count(cur_page) == 1) {
-			/* Found a free page. */
-			list_del_init(&rx_pkt->link);
-			list_add(&rx_pkt->link, &temp_head);
-			found_free_page++;
-		}
-	}
+	/* One replenish batch is enough, the rest is found on demand */
+	found_free_page = ipa3_page_recycle_sweep(sys->page_recycle_repl,
+		IPA_REPL_XFER_MAX, ipa3_ctx->stats.page_recycle_scan_hist);
 	if (!found_free_page) {
 		/*Not found free page rescheduling tasklet after 2msec*/
 		IPADBG_LOW("Scheduling WQ not found free pages\n");
@@ -1414,7 +1509,6 @@ static void ipa3_tasklet_find_freepage(unsigned long data)
 				msecs_to_jiffies(ipa3_ctx->page_wq_reschd_time));
 	} else {
 		/*Allow to use pre-allocated buffers*/
-		list_splice(&temp_head, &sys->page_recycle_repl->page_repl_head);
 		ipa3_ctx->stats.page_recycle_cnt_in_tasklet += found_free_page;
 		IPADBG_LOW("found free pages count = %d\n", found_free_page);
 		ipa3_ctx->free_page_task_scheduled = false;
@@ -2715,8 +2809,7 @@ static void ipa3_replenish_rx_page_cache(struct ipa3_sys_context *sys)
 		}
 		INIT_LIST_HEAD(&rx_pkt->link);
 		rx_pkt->sys = sys;
-		list_add_tail(&rx_pkt->link,
-			&sys->page_recycle_repl->page_repl_head);
+		ipa3_page_recycle_put(sys->page_recycle_repl, rx_pkt, true);
 	}
 	atomic_set(&sys->common_sys->page_avilable, 1);
 
@@ -2794,27 +2887,18 @@ static struct ipa3_rx_pkt_wrapper * ipa3_get_free_page
 )
 {
 	struct ipa3_rx_pkt_wrapper *rx_pkt = NULL;
-	struct ipa3_rx_pkt_wrapper *tmp = NULL;
-	struct page *cur_page;
-	int i = 0;
+	u32 scanned = 0;
 	u8 LOOP_THRESHOLD = ipa3_ctx->page_poll_threshold;
 
 	spin_lock_bh(&sys->common_sys->spinlock);
-	list_for_each_entry_safe(rx_pkt, tmp,
-		&sys->page_recycle_repl->page_repl_head, link) {
-		if (i == LOOP_THRESHOLD)
-			break;
-		cur_page = rx_pkt->page_data.page;
-		if (page_ref_count(cur_page) == 1) {
-			/* Found a free page. */
-			page_ref_inc(cur_page);
-			list_del_init(&rx_pkt->link);
-			++ipa3_ctx->stats.page_recycle_cnt[stats_i][i];
-			sys->common_sys->napi_sort_page_thrshld_cnt = 0;
-			spin_unlock_bh(&sys->common_sys->spinlock);
-			return rx_pkt;
-		}
-		i++;
+	rx_pkt = ipa3_page_recycle_get(sys->page_recycle_repl, LOOP_THRESHOLD,
+		&scanned, ipa3_ctx->stats.page_recycle_lat_hist);
+	ipa3_page_recycle_hist(ipa3_ctx->stats.page_recycle_scan_hist, scanned);
+	if (rx_pkt) {
+		++ipa3_ctx->stats.page_recycle_cnt[stats_i][scanned - 1];
+		sys->common_sys->napi_sort_page_thrshld_cnt = 0;
+		spin_unlock_bh(&sys->common_sys->spinlock);
+		return rx_pkt;
 	}
 	spin_unlock_bh(&sys->common_sys->spinlock);
 	IPADBG_LOW("napi_sort_page_thrshld_cnt = %d ipa_max_napi_sort_page_thrshld = %d\n",
@@ -3675,8 +3759,8 @@ static void free_rx_page(void *chan_user_data, void *xfer_user_data)
 		page_ref_dec(rx_pkt->page_data.page);
 		spin_lock_bh(&rx_pkt->sys->common_sys->spinlock);
 		/* Add the element to head. */
-		list_add(&rx_pkt->link,
-			&rx_pkt->sys->page_recycle_repl->page_repl_head);
+		ipa3_page_recycle_put(rx_pkt->sys->page_recycle_repl, rx_pkt,
+			true);
 		spin_unlock_bh(&rx_pkt->sys->common_sys->spinlock);
 	} else {
 		dma_unmap_page(ipa3_ctx->pdev, rx_pkt->page_data.dma_addr,
@@ -5321,8 +5405,8 @@ static struct sk_buff *handle_page_completion(struct gsi_chan_xfer_notify
 			init_page_count(rx_page.page);
 			spin_lock_bh(&rx_pkt->sys->common_sys->spinlock);
 			/* Add the element to head. */
-			list_add(&rx_pkt->link,
-				&rx_pkt->sys->page_recycle_repl->page_repl_head);
+			ipa3_page_recycle_put(rx_pkt->sys->page_recycle_repl,
+				rx_pkt, true);
 			spin_unlock_bh(&rx_pkt->sys->common_sys->spinlock);
 		} else {
 			dma_unmap_page(ipa3_ctx->pdev, rx_page.dma_addr,
@@ -5353,8 +5437,9 @@ static struct sk_buff *handle_page_completion(struct gsi_chan_xfer_notify
 					init_page_count(rx_page.page);
 					spin_lock_bh(&rx_pkt->sys->common_sys->spinlock);
 					/* Add the element to head. */
-					list_add(&rx_pkt->link,
-						&rx_pkt->sys->page_recycle_repl->page_repl_head);
+					ipa3_page_recycle_put(
+						rx_pkt->sys->page_recycle_repl,
+						rx_pkt, true);
 					spin_unlock_bh(&rx_pkt->sys->common_sys->spinlock);
 				} else {
 					dma_unmap_page(ipa3_ctx->pdev, rx_page.dma_addr,
@@ -5377,8 +5462,9 @@ static struct sk_buff *handle_page_completion(struct gsi_chan_xfer_notify
 			} else {
 				spin_lock_bh(&rx_pkt->sys->common_sys->spinlock);
 				/* Add the element back to tail. */
-				list_add_tail(&rx_pkt->link,
-					&rx_pkt->sys->page_recycle_repl->page_repl_head);
+				ipa3_page_recycle_put(
+					rx_pkt->sys->page_recycle_repl,
+					rx_pkt, false);
 				spin_unlock_bh(&rx_pkt->sys->common_sys->spinlock);
 				dma_sync_single_for_cpu(ipa3_ctx->pdev,
 					rx_page.dma_addr,
@@ -129,9 +129,14 @@ enum {
 
 #define IPA_WAN_AGGR_PKT_CNT 1
 
+#define IPA_SEND_MAX_DESC (20)
+
 #define IPA_PAGE_POLL_DEFAULT_THRESHOLD 15
 #define IPA_PAGE_POLL_THRESHOLD_MAX 30
 
+/* log2 buckets for the page recycle scan length and latency histograms */
+#define IPA_PAGE_RECYCLE_HIST_MAX 16
+
 #define NTN3_CLIENTS_NUM 2
 
 #define IPA_MAX_NAPI_SORT_PAGE_THRSHLD 3
@@ -1359,6 +1364,7 @@ struct ipa3_desc {
  * @link: linked to the Rx packets on that pipe
  * @len: fixed allocated skb length (i.e. times of page size)
  * @data_len: how many bytes are copied into skb's flat buffer
+ * @recycle_ts: when the page was last put back on the recycle ring
  */
 struct ipa3_rx_pkt_wrapper {
 	struct list_head link;
@@ -1370,6 +1376,7 @@ struct ipa3_rx_pkt_wrapper {
 	u32 data_len;
 	struct work_struct work;
 	struct ipa3_sys_context *sys;
+	ktime_t recycle_ts;
 };
 
 /**
@@ -1633,6 +1640,8 @@ struct ipa3_stats {
 	u64 num_sort_tasklet_sched[3];
 	u64 num_of_times_wq_reschd;
 	u64 page_recycle_cnt_in_tasklet;
+	u64 page_recycle_scan_hist[IPA_PAGE_RECYCLE_HIST_MAX];
+	u64 page_recycle_lat_hist[IPA_PAGE_RECYCLE_HIST_MAX];
 	u32 ttl_cnt;
 };
 
@@ -3200,6 +3209,16 @@ int ipa3_setup_tput_pipe(void);
 
 int ipa3_setup_sys_pipe(struct ipa_sys_connect_params *sys_in, u32 *clnt_hdl);
 
+void ipa3_page_recycle_put(struct ipa3_page_repl_ctx *repl,
+	struct ipa3_rx_pkt_wrapper *rx_pkt, bool is_free);
+
+struct ipa3_rx_pkt_wrapper *ipa3_page_recycle_get(
+	struct ipa3_page_repl_ctx *repl, u32 budget, u32 *scanned,
+	u64 *lat_hist);
+
+u32 ipa3_page_recycle_sweep(struct ipa3_page_repl_ctx *repl, u32 want,
+	u64 *scan_hist);
+
 int ipa3_teardown_sys_pipe(u32 clnt_hdl);
 
 int ipa3_connect_wdi_pipe(struct ipa_wdi_in_params *in,
@@ -37,7 +37,16 @@
 
 #define IPA_NAT_MAX_NUM_OF_INIT_CMD_DESC 4
 #define IPA_IPV6CT_MAX_NUM_OF_INIT_CMD_DESC 3
-#define IPA_MAX_NUM_OF_TABLE_DMA_CMD_DESC 5
+/*
+ * Maximum number of table writes accepted in one TABLE_DMA ioctl. Each
+ * write becomes one immediate command, and up to two more are needed
+ * for the pipeline clear and the coalescing close. All of them go out
+ * as one ipa3_send() chain, so the total is bounded by
+ * IPA_SEND_MAX_DESC and, at runtime, by the APPS_CMD_PROD ipa_if_tlv.
+ */
+#define IPA_TABLE_DMA_CMD_EXTRA_DESC 2
+#define IPA_MAX_NUM_OF_TABLE_DMA_CMD_ENTRIES \
+	(IPA_SEND_MAX_DESC - IPA_TABLE_DMA_CMD_EXTRA_DESC)
 
 /*
  * The base table max entries is limited by index into table 13 bits number.
@@ -1927,6 +1936,28 @@ static int ipa3_table_validate_table_dma_one(
 }
 
 
+/* Max TABLE_DMA entries per command, less the descriptors it adds */
+static u32 ipa3_table_dma_cmd_max_entries(void)
+{
+	const struct ipa_gsi_ep_config *gsi_ep_cfg;
+	u32 max_desc = IPA_SEND_MAX_DESC;
+	u32 tlv;
+
+	gsi_ep_cfg = ipa3_get_gsi_ep_info(IPA_CLIENT_APPS_CMD_PROD);
+	if (gsi_ep_cfg) {
+		tlv = gsi_ep_cfg->ipa_if_tlv;
+		if (gsi_ep_cfg->prefetch_mode == GSI_SMART_PRE_FETCH ||
+			gsi_ep_cfg->prefetch_mode == GSI_FREE_PRE_FETCH)
+			tlv -= gsi_ep_cfg->prefetch_threshold;
+		max_desc = min(max_desc, tlv);
+	}
+
+	if (max_desc <= IPA_TABLE_DMA_CMD_EXTRA_DESC)
+		return 0;
+
+	return max_desc - IPA_TABLE_DMA_CMD_EXTRA_DESC;
+}
+
 /**
  * ipa3_table_dma_cmd() - Post TABLE_DMA command to IPA HW
  * @dma:	[in] initialization command attributes
@@ -1943,8 +1974,8 @@ int ipa3_table_dma_cmd(
 	enum ipahal_imm_cmd_name cmd_name = IPA_IMM_CMD_NAT_DMA;
 
 	struct ipahal_imm_cmd_table_dma cmd;
-	struct ipahal_imm_cmd_pyld *cmd_pyld[IPA_MAX_NUM_OF_TABLE_DMA_CMD_DESC];
-	struct ipa3_desc desc[IPA_MAX_NUM_OF_TABLE_DMA_CMD_DESC];
+	struct ipahal_imm_cmd_pyld **cmd_pyld = NULL;
+	struct ipa3_desc *desc = NULL;
 
 	uint8_t cnt, num_cmd = 0;
 
@@ -1952,7 +1983,6 @@ int ipa3_table_dma_cmd(
 	int i;
 	struct ipahal_reg_valmask valmask;
 	struct ipahal_imm_cmd_register_write reg_write_coal_close;
-	int max_dma_table_cmds = IPA_MAX_NUM_OF_TABLE_DMA_CMD_DESC;
 
 	IPADBG("In\n");
 
@@ -1975,19 +2005,10 @@ int ipa3_table_dma_cmd(
 	IPADBG("nmi(%s)\n", ipa3_nat_mem_in_as_str(dma->mem_type));
 
 	memset(&cmd, 0, sizeof(cmd));
-	memset(cmd_pyld, 0, sizeof(cmd_pyld));
-	memset(desc, 0, sizeof(desc));
-
-	/**
-	 * We use a descriptor for closing coalsceing endpoint
-	 * by immediate command. So, DMA entries should be less than
-	 * IPA_MAX_NUM_OF_TABLE_DMA_CMD_DESC - 1 to overcome
-	 * buffer overflow of ipa3_desc array.
-	 */
-	if (ipa3_get_ep_mapping(IPA_CLIENT_APPS_WAN_COAL_CONS) != -1)
-		max_dma_table_cmds -= 1;
 
-	if (!dma->entries || dma->entries > (max_dma_table_cmds - 1)) {
+	if (!dma->entries ||
+		dma->entries > IPA_MAX_NUM_OF_TABLE_DMA_CMD_ENTRIES ||
+		dma->entries > ipa3_table_dma_cmd_max_entries()) {
 		IPAERR_RL("Invalid number of entries %d\n",
 			dma->entries);
 		result = -EPERM;
@@ -2006,6 +2027,20 @@ int ipa3_table_dma_cmd(
 		}
 	}
 
+	/*
+	 * One descriptor per table write, plus one for the NO-OP
+	 * pipeline clear and one for closing the coalescing endpoint.
+	 */
+	cmd_pyld = kcalloc(dma->entries + IPA_TABLE_DMA_CMD_EXTRA_DESC,
+		sizeof(*cmd_pyld), GFP_KERNEL);
+	desc = kcalloc(dma->entries + IPA_TABLE_DMA_CMD_EXTRA_DESC,
+		sizeof(*desc), GFP_KERNEL);
+
+	if (!cmd_pyld || !desc) {
+		result = -ENOMEM;
+		goto free_desc;
+	}
+
 	/* IC to close the coal frame before HPS Clear if coal is enabled */
 	if (ipa3_get_ep_mapping(IPA_CLIENT_APPS_WAN_COAL_CONS) != -1
 		&& !ipa3_ctx->ulso_wa) {
@@ -2088,6 +2123,10 @@ destroy_imm_cmd:
 	for (cnt = 0; cnt < num_cmd; ++cnt)
 		ipahal_destroy_imm_cmd(cmd_pyld[cnt]);
 
+free_desc:
+	kfree(desc);
+	kfree(cmd_pyld);
+
 bail:
 	IPADBG("Out\n");
 
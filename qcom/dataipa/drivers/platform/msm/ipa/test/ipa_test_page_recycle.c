@@ -0,0 +1,270 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ */
+
+#include "ipa_ut_framework.h"
+#include "ipa_i.h"
+#include <linux/mm.h>
+
+/**
+ * Page recycle ring suite
+ * Runs the RX page recycle ring helpers on a private ring of pages, with
+ * the references the network stack would hold simulated by hand, so no
+ * pipe or traffic is needed.
+ */
+
+#define IPA_TEST_PAGE_RECYCLE_NUM 128
+#define IPA_TEST_PAGE_RECYCLE_STUCK 32
+
+struct ipa_test_page_recycle_ctx {
+	struct ipa3_page_repl_ctx repl;
+	struct ipa3_rx_pkt_wrapper *pkts[IPA_TEST_PAGE_RECYCLE_NUM];
+	/* keeps the test out of the live ipa3_ctx histograms */
+	u64 lat_hist[IPA_PAGE_RECYCLE_HIST_MAX];
+	u64 scan_hist[IPA_PAGE_RECYCLE_HIST_MAX];
+};
+
+/* Put every page back on the ring as free, in index order */
+static void ipa_test_page_recycle_reset(struct ipa_test_page_recycle_ctx *ctx)
+{
+	int i;
+
+	INIT_LIST_HEAD(&ctx->repl.page_repl_head);
+	for (i = IPA_TEST_PAGE_RECYCLE_NUM - 1; i >= 0; i--) {
+		init_page_count(ctx->pkts[i]->page_data.page);
+		INIT_LIST_HEAD(&ctx->pkts[i]->link);
+		ipa3_page_recycle_put(&ctx->repl, ctx->pkts[i], true);
+	}
+}
+
+/* Hand page @i to the "stack": it stays on the ring but is referenced */
+static void ipa_test_page_recycle_hold(struct ipa_test_page_recycle_ctx *ctx,
+	int i)
+{
+	list_del_init(&ctx->pkts[i]->link);
+	page_ref_inc(ctx->pkts[i]->page_data.page);
+	ipa3_page_recycle_put(&ctx->repl, ctx->pkts[i], false);
+}
+
+static void ipa_test_page_recycle_release(
+	struct ipa_test_page_recycle_ctx *ctx, int i)
+{
+	page_ref_dec(ctx->pkts[i]->page_data.page);
+}
+
+static int ipa_test_page_recycle_suite_setup(void **ppriv)
+{
+	struct ipa_test_page_recycle_ctx *ctx;
+	int i;
+
+	IPA_UT_DBG("Start Setup\n");
+
+	ctx = kzalloc(sizeof(*ctx), GFP_KERNEL);
+	if (!ctx)
+		return -ENOMEM;
+
+	ctx->repl.capacity = IPA_TEST_PAGE_RECYCLE_NUM;
+	for (i = 0; i < IPA_TEST_PAGE_RECYCLE_NUM; i++) {
+		ctx->pkts[i] = kzalloc(sizeof(*ctx->pkts[i]), GFP_KERNEL);
+		if (!ctx->pkts[i])
+			goto fail;
+
+		ctx->pkts[i]->page_data.page = alloc_page(GFP_KERNEL);
+		if (!ctx->pkts[i]->page_data.page) {
+			kfree(ctx->pkts[i]);
+			ctx->pkts[i] = NULL;
+			goto fail;
+		}
+
+		/* data_len is not used by the ring, it tags the page index */
+		ctx->pkts[i]->data_len = i;
+	}
+
+	*ppriv = ctx;
+	return 0;
+
+fail:
+	while (--i >= 0) {
+		__free_page(ctx->pkts[i]->page_data.page);
+		kfree(ctx->pkts[i]);
+	}
+	kfree(ctx);
+	return -ENOMEM;
+}
+
+static int ipa_test_page_recycle_teardown(void *priv)
+{
+	struct ipa_test_page_recycle_ctx *ctx = priv;
+	int i;
+
+	IPA_UT_DBG("Start Teardown\n");
+
+	for (i = 0; i < IPA_TEST_PAGE_RECYCLE_NUM; i++) {
+		init_page_count(ctx->pkts[i]->page_data.page);
+		__free_page(ctx->pkts[i]->page_data.page);
+		kfree(ctx->pkts[i]);
+	}
+	kfree(ctx);
+
+	return 0;
+}
+
+/*
+ * All pages are handed to the stack and only every fourth one is
+ * released. Exactly the released pages must come back, each once.
+ */
+static int ipa_test_page_recycle_reuse(void *priv)
+{
+	struct ipa_test_page_recycle_ctx *ctx = priv;
+	struct ipa3_rx_pkt_wrapper *rx_pkt;
+	DECLARE_BITMAP(seen, IPA_TEST_PAGE_RECYCLE_NUM);
+	u32 scanned;
+	int found = 0;
+	int i;
+
+	ipa_test_page_recycle_reset(ctx);
+	bitmap_zero(seen, IPA_TEST_PAGE_RECYCLE_NUM);
+
+	for (i = 0; i < IPA_TEST_PAGE_RECYCLE_NUM; i++)
+		ipa_test_page_recycle_hold(ctx, i);
+
+	for (i = 0; i < IPA_TEST_PAGE_RECYCLE_NUM; i += 4)
+		ipa_test_page_recycle_release(ctx, i);
+
+	while ((rx_pkt = ipa3_page_recycle_get(&ctx->repl,
+		IPA_TEST_PAGE_RECYCLE_NUM, &scanned, ctx->lat_hist))) {
+		i = rx_pkt->data_len;
+		if (i % 4) {
+			IPA_UT_LOG("page %d recycled while still held\n", i);
+			IPA_UT_TEST_FAIL_REPORT("busy page recycled");
+			return -EFAULT;
+		}
+
+		if (test_and_set_bit(i, seen)) {
+			IPA_UT_LOG("page %d recycled twice\n", i);
+			IPA_UT_TEST_FAIL_REPORT("page recycled twice");
+			return -EFAULT;
+		}
+
+		found++;
+	}
+
+	if (found != IPA_TEST_PAGE_RECYCLE_NUM / 4) {
+		IPA_UT_LOG("recycled %d pages, expected %d\n",
+			found, IPA_TEST_PAGE_RECYCLE_NUM / 4);
+		IPA_UT_TEST_FAIL_REPORT("wrong number of pages recycled");
+		return -EFAULT;
+	}
+
+	return 0;
+}
+
+/*
+ * The oldest pages stay held, as if parked in a slow socket, while all
+ * later ones are released. A scan that restarts at the ring head every
+ * time would pay for the held pages on each lookup, and would never get
+ * past them once there are more than the poll threshold. The rotating
+ * ring must only pay for them once per pass.
+ */
+static int ipa_test_page_recycle_scan_cost(void *priv)
+{
+	struct ipa_test_page_recycle_ctx *ctx = priv;
+	struct ipa3_rx_pkt_wrapper *rx_pkt;
+	const int want = IPA_TEST_PAGE_RECYCLE_NUM -
+		IPA_TEST_PAGE_RECYCLE_STUCK;
+	u32 scanned, total = 0, calls = 0;
+	int found = 0;
+	int i;
+
+	ipa_test_page_recycle_reset(ctx);
+
+	for (i = 0; i < IPA_TEST_PAGE_RECYCLE_NUM; i++)
+		ipa_test_page_recycle_hold(ctx, i);
+
+	for (i = IPA_TEST_PAGE_RECYCLE_STUCK; i < IPA_TEST_PAGE_RECYCLE_NUM; i++)
+		ipa_test_page_recycle_release(ctx, i);
+
+	/* Bounded so a regression fails instead of spinning */
+	while (found < want && calls < 4 * IPA_TEST_PAGE_RECYCLE_NUM) {
+		rx_pkt = ipa3_page_recycle_get(&ctx->repl,
+			IPA_PAGE_POLL_DEFAULT_THRESHOLD, &scanned,
+			ctx->lat_hist);
+		total += scanned;
+		calls++;
+		if (rx_pkt)
+			found++;
+	}
+
+	IPA_UT_LOG("recycled %d pages in %u lookups, %u entries scanned\n",
+		found, calls, total);
+
+	if (found != want) {
+		IPA_UT_TEST_FAIL_REPORT("free pages behind held ones not found");
+		return -EFAULT;
+	}
+
+	if (total > IPA_TEST_PAGE_RECYCLE_NUM + IPA_TEST_PAGE_RECYCLE_STUCK) {
+		IPA_UT_TEST_FAIL_REPORT("held pages rescanned");
+		return -EFAULT;
+	}
+
+	return 0;
+}
+
+/* A sweep must gather up to the requested number of free pages at the head */
+static int ipa_test_page_recycle_sweep(void *priv)
+{
+	struct ipa_test_page_recycle_ctx *ctx = priv;
+	struct ipa3_rx_pkt_wrapper *rx_pkt;
+	const u32 want = 8;
+	u32 found, n = 0;
+	int i;
+
+	ipa_test_page_recycle_reset(ctx);
+
+	for (i = 0; i < IPA_TEST_PAGE_RECYCLE_NUM; i++)
+		ipa_test_page_recycle_hold(ctx, i);
+
+	/* Release a few pages towards the end of the ring */
+	for (i = IPA_TEST_PAGE_RECYCLE_NUM - 3 * want;
+		i < IPA_TEST_PAGE_RECYCLE_NUM; i += 2)
+		ipa_test_page_recycle_release(ctx, i);
+
+	found = ipa3_page_recycle_sweep(&ctx->repl, want, ctx->scan_hist);
+	if (found != want) {
+		IPA_UT_LOG("sweep found %u pages, expected %u\n", found, want);
+		IPA_UT_TEST_FAIL_REPORT("sweep miscounted");
+		return -EFAULT;
+	}
+
+	list_for_each_entry(rx_pkt, &ctx->repl.page_repl_head, link) {
+		if (n++ == want)
+			break;
+
+		if (page_ref_count(rx_pkt->page_data.page) != 1) {
+			IPA_UT_LOG("held page %u at ring head\n",
+				rx_pkt->data_len);
+			IPA_UT_TEST_FAIL_REPORT("sweep left held page at head");
+			return -EFAULT;
+		}
+	}
+
+	return 0;
+}
+
+/* Suite definition block */
+IPA_UT_DEFINE_SUITE_START(page_recycle, "RX page recycle ring",
+	ipa_test_page_recycle_suite_setup, ipa_test_page_recycle_teardown)
+{
+	IPA_UT_ADD_TEST(reuse, "Only released pages are recycled",
+		ipa_test_page_recycle_reuse, true, IPA_HW_v4_0, IPA_HW_MAX),
+
+	IPA_UT_ADD_TEST(scan_cost, "Held pages are not rescanned",
+		ipa_test_page_recycle_scan_cost, true, IPA_HW_v4_0,
+		IPA_HW_MAX),
+
+	IPA_UT_ADD_TEST(sweep, "Sweep gathers free pages at the head",
+		ipa_test_page_recycle_sweep, true, IPA_HW_v4_0, IPA_HW_MAX),
+
+} IPA_UT_DEFINE_SUITE_END(page_recycle);
@@ -168,6 +168,45 @@ int ipa_nat_add_ipv4_rule(uint32_t table_handle,
 int ipa_nat_del_ipv4_rule(uint32_t table_handle,
 				uint32_t rule_handle);
 
+/**
+ * ipa_nat_add_ipv4_rules() - to insert a batch of new ipv4 rules
+ * @table_handle: [in] handle of ipv4 nat table
+ * @rules: [in] Array of new rules
+ * @num_rules: [in] Number of rules in the array
+ * @rule_handles: [out] Return the handle to each rule
+ * @num_added: [out] Number of rules inserted
+ *
+ * To insert new ipv4 nat rules into ipv4 nat table, with the
+ * table updates posted to hw in as few commands as possible. On
+ * failure, the first num_added rules are inserted and the rest are
+ * not.
+ *
+ * Returns:	0  On Success, negative on failure
+ */
+int ipa_nat_add_ipv4_rules(uint32_t table_handle,
+				const ipa_nat_ipv4_rule *rules,
+				uint32_t num_rules,
+				uint32_t *rule_handles,
+				uint32_t *num_added);
+
+/**
+ * ipa_nat_del_ipv4_rules() - to delete a batch of ipv4 nat rules
+ * @table_handle: [in] handle of ipv4 nat table
+ * @rule_handles: [in] Array of ipv4 nat rule handles
+ * @num_rules: [in] Number of handles in the array
+ * @num_deleted: [out] Number of rules deleted
+ *
+ * To delete ipv4 nat rules from ipv4 nat table, with the table
+ * updates posted to hw in as few commands as possible. On failure,
+ * the first num_deleted rules are deleted and the rest are not.
+ *
+ * Returns:	0  On Success, negative on failure
+ */
+int ipa_nat_del_ipv4_rules(uint32_t table_handle,
+				const uint32_t *rule_handles,
+				uint32_t num_rules,
+				uint32_t *num_deleted);
+
 
 /**
  * ipa_nat_query_timestamp() - to query timestamp
@@ -102,6 +102,8 @@ typedef enum {
 	NATI_TRIG_GOTO_DDR   =  9,
 	NATI_TRIG_GOTO_SRAM  = 10,
 	NATI_TRIG_GET_TSTAMP = 11,
+	NATI_TRIG_ADD_RULES  = 12,
+	NATI_TRIG_DEL_RULES  = 13,
 
 	NATI_TRIG_LAST
 } ipa_nati_trigger;
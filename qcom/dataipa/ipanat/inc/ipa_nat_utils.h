@@ -68,6 +68,7 @@
 #include <string.h>
 #include <syslog.h>
 #include <time.h>
+#include <stdbool.h>
 #include <linux/msm_ipa.h>
 
 #ifndef FALSE
@@ -81,6 +82,18 @@
 #define MAX_DMA_ENTRIES_FOR_ADD 4
 #define MAX_DMA_ENTRIES_FOR_DEL 3
 
+/*
+ * The most table writes one IPA_IOC_TABLE_DMA_CMD may carry when
+ * batching rule adds and deletes. The kernel sends them, plus two
+ * commands of its own, as one chain of at most 20 descriptors, and
+ * less when the command pipe's ring is smaller. Kernels predating
+ * batch support, or whose ring can't hold a full batch, reject more
+ * than IPA_DMA_ENTRIES_LEGACY_MAX, in which case the batch is
+ * re-posted in pieces no larger than that.
+ */
+#define IPA_DMA_ENTRIES_BATCH_MAX  18
+#define IPA_DMA_ENTRIES_LEGACY_MAX 3
+
 #if !defined(MSM_IPA_TESTS) && !defined(FEATURE_IPA_ANDROID)
 #ifdef USE_GLIB
 #include <glib.h>
@@ -116,6 +129,38 @@ void ipa_descriptor_close(
 void ipa_read_debug_info(
 	const char* debug_file_path);
 
+/*
+ * Host memory mode runs the library without IPA hardware: tables live
+ * in process memory, and table DMA commands are applied to them
+ * directly. It is meant for validating and benchmarking the table
+ * logic in the test harness, and only supports DDR based IPv4 NAT.
+ */
+void ipa_nat_set_host_mem_mode(
+	bool enable );
+
+bool ipa_nat_in_host_mem_mode(void);
+
+void* ipa_nat_host_mem_alloc(
+	const char* name,
+	size_t      size );
+
+void ipa_nat_host_mem_free(
+	void* addr );
+
+/*
+ * All ioctls taking a pointer argument go through here, so that they
+ * can be serviced in host memory mode and so that table DMA commands
+ * can be counted.
+ */
+int ipa_nat_ioctl(
+	int           fd,
+	unsigned long req,
+	void*         arg );
+
+void ipa_nat_get_dma_cmd_stats(
+	uint64_t* cmds_ptr,
+	uint64_t* entries_ptr );
+
 static inline char* prep_ioc_nat_dma_cmd_4print(
 	struct ipa_ioc_nat_dma_cmd* cmd_ptr,
 	char*                       buf_ptr,
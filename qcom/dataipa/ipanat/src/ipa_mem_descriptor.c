@@ -75,7 +75,7 @@ static int AllocateMemory(
 
 	memset(&desc->nat_sram_info, 0, sizeof(desc->nat_sram_info));
 
-	ret = ioctl(
+	ret = ipa_nat_ioctl(
 		ipa_fd,
 		IPA_IOC_GET_NAT_IN_SRAM_INFO,
 		&desc->nat_sram_info);
@@ -109,7 +109,7 @@ static int AllocateMemory(
 
 	cmd.size = desc->orig_rqst_size;
 
-	ret = ioctl(ipa_fd, desc->allocate_ioctl_num, &cmd);
+	ret = ipa_nat_ioctl(ipa_fd, desc->allocate_ioctl_num, &cmd);
 
 	if (ret)
 	{
@@ -139,6 +139,22 @@ static int MapMemory(
 
 	IPADBG("In\n");
 
+	if ( ipa_nat_in_host_mem_mode() )
+	{
+		desc->mmap_size = desc->orig_rqst_size;
+
+		desc->mmap_addr = desc->base_addr =
+			ipa_nat_host_mem_alloc(desc->name, desc->mmap_size);
+
+		if ( desc->base_addr == NULL )
+		{
+			IPAERR("Unable to allocate host memory for %s\n", desc->name);
+			ret = -ENOMEM;
+		}
+
+		goto bail;
+	}
+
 	ipa_dev_dir_path_len =
 		strlcpy(device_full_path, IPA_DEV_DIR, IPA_RESOURCE_NAME_MAX);
 
@@ -259,7 +275,7 @@ static int DeallocateMemory(
 		IPA_NAT_MEM_IN_SRAM       :
 		IPA_NAT_MEM_IN_DDR;
 
-	ret = ioctl(ipa_fd, desc->delete_ioctl_num, &cmd);
+	ret = ipa_nat_ioctl(ipa_fd, desc->delete_ioctl_num, &cmd);
 
 	if (ret)
 	{
@@ -348,11 +364,18 @@ int ipa_mem_descriptor_delete(
 
 	desc->valid = FALSE;
 
+	if ( ipa_nat_in_host_mem_mode() )
+	{
+		ipa_nat_host_mem_free(desc->mmap_addr);
+	}
+	else
+	{
 #ifndef IPA_ON_R3PC
-	munmap(desc->mmap_addr, desc->mmap_size);
+		munmap(desc->mmap_addr, desc->mmap_size);
 #else
-	munmap(desc->mmap_addr, IPA_DEVICE_MMAP_MEM_SIZE);
+		munmap(desc->mmap_addr, IPA_DEVICE_MMAP_MEM_SIZE);
 #endif
+	}
 
 	ret = DeallocateMemory(desc, ipa_fd);
 
@@ -789,7 +789,7 @@ static int ipa_nati_create_table(
 	base_addr = nat_table->mem_desc.base_addr;
 
 #ifdef IPA_ON_R3PC
-	ret = ioctl(nat_cache_ptr->ipa_desc->fd,
+	ret = ipa_nat_ioctl(nat_cache_ptr->ipa_desc->fd,
 				IPA_IOC_GET_NAT_OFFSET,
 				&nat_mem_offset);
 	if (ret) {
@@ -900,7 +900,7 @@ static int ipa_nati_post_ipv4_init_cmd(
 
 	IPADBG("%s\n", ipa_ioc_v4_nat_init_as_str(&cmd, buf, sizeof(buf)));
 
-	ret = ioctl(nat_cache_ptr->ipa_desc->fd, IPA_IOC_V4_INIT_NAT, &cmd);
+	ret = ipa_nat_ioctl(nat_cache_ptr->ipa_desc->fd, IPA_IOC_V4_INIT_NAT, &cmd);
 
 	if (ret) {
 		IPAERR("unable to post init cmd Error: %d IPA fd %d\n",
@@ -1078,6 +1078,90 @@ static uint16_t src_hash(
 	return hash;
 }
 
+/**
+ * ipa_nati_calc_tbl_index() - Find a rule's slot in the ipv4 base table
+ * @nat_cache_ptr: [in] the cache the table lives in
+ * @nat_table: [in] the table
+ * @clnt_rule: [in] the rule
+ *
+ * Returns: >0 index into ipv4 base table
+ */
+static uint16_t ipa_nati_calc_tbl_index(
+	struct ipa_nat_cache*           nat_cache_ptr,
+	struct ipa_nat_ip4_table_cache* nat_table,
+	const ipa_nat_ipv4_rule*        clnt_rule)
+{
+	uint16_t index;
+
+	/* src_only */
+	if (clnt_rule->src_only) {
+		index = dst_hash(
+			nat_cache_ptr,
+			pdns[clnt_rule->pdn_index].public_ip,
+			clnt_rule->target_ip,
+			clnt_rule->target_port,
+			clnt_rule->public_port,
+			clnt_rule->protocol,
+			nat_table->table.table_entries - 1) + Hash_token;
+		index = (index & (nat_table->table.table_entries - 1));
+		if (index == 0) {
+			index = nat_table->table.table_entries - 1;
+		}
+		Hash_token++;
+	} else {
+		index = dst_hash(
+			nat_cache_ptr,
+			pdns[clnt_rule->pdn_index].public_ip,
+			clnt_rule->target_ip,
+			clnt_rule->target_port,
+			clnt_rule->public_port,
+			clnt_rule->protocol,
+			nat_table->table.table_entries - 1);
+	}
+
+	return index;
+}
+
+/**
+ * ipa_nati_calc_indx_tbl_index() - Find a rule's slot in the ipv4 index table
+ * @nat_table: [in] the table
+ * @clnt_rule: [in] the rule
+ *
+ * Returns: >0 index into ipv4 index table
+ */
+static uint16_t ipa_nati_calc_indx_tbl_index(
+	struct ipa_nat_ip4_table_cache* nat_table,
+	const ipa_nat_ipv4_rule*        clnt_rule)
+{
+	uint16_t index;
+
+	/* dst_only */
+	if (clnt_rule->dst_only) {
+		index =
+			src_hash(clnt_rule->private_ip,
+					 clnt_rule->private_port,
+					 clnt_rule->target_ip,
+					 clnt_rule->target_port,
+					 clnt_rule->protocol,
+					 nat_table->table.table_entries - 1) + Hash_token;
+		index = (index & (nat_table->table.table_entries - 1));
+		if (index == 0) {
+			index = nat_table->table.table_entries - 1;
+		}
+		Hash_token++;
+	} else {
+		index =
+			src_hash(clnt_rule->private_ip,
+					 clnt_rule->private_port,
+					 clnt_rule->target_ip,
+					 clnt_rule->target_port,
+					 clnt_rule->protocol,
+					 nat_table->table.table_entries - 1);
+	}
+
+	return index;
+}
+
 static int ipa_nati_post_ipv4_dma_cmd(
 	struct ipa_nat_cache*       nat_cache_ptr,
 	struct ipa_ioc_nat_dma_cmd* cmd)
@@ -1091,7 +1175,7 @@ static int ipa_nati_post_ipv4_dma_cmd(
 
 	IPADBG("%s\n", prep_ioc_nat_dma_cmd_4print(cmd, buf, sizeof(buf)));
 
-	if (ioctl(nat_cache_ptr->ipa_desc->fd, IPA_IOC_TABLE_DMA_CMD, cmd)) {
+	if (ipa_nat_ioctl(nat_cache_ptr->ipa_desc->fd, IPA_IOC_TABLE_DMA_CMD, cmd)) {
 		IPAERR("ioctl (IPA_IOC_TABLE_DMA_CMD) on fd %d has failed\n",
 			   nat_cache_ptr->ipa_desc->fd);
 		ret = -EIO;
@@ -1134,7 +1218,7 @@ int ipa_nati_modify_pdn(
 	if (entry->public_ip == 0)
 		IPADBG("PDN %d public ip will be set  to 0\n", entry->pdn_index);
 
-	ret = ioctl(nat_cache_ptr->ipa_desc->fd, IPA_IOC_NAT_MODIFY_PDN, entry);
+	ret = ipa_nat_ioctl(nat_cache_ptr->ipa_desc->fd, IPA_IOC_NAT_MODIFY_PDN, entry);
 
 	if ( ret ) {
 		IPAERR("unable to call modify pdn icotl\nindex %d, ip 0x%X, src_metdata 0x%X, dst_metadata 0x%X IPA fd %d\n",
@@ -1624,254 +1708,821 @@ bail:
 	return ret;
 }
 
-int ipa_NATI_add_ipv4_rule(
-	uint32_t                 tbl_hdl,
-	const ipa_nat_ipv4_rule* clnt_rule,
-	uint32_t*                rule_hdl)
+/*
+ * ----------------------------------------------------------------------------
+ * Private helpers for batched rule add/delete
+ * ----------------------------------------------------------------------------
+ *
+ * The enable bit of an added rule, and the links that chain rules
+ * together, are only written by the IPA when it runs the table dma
+ * command. Until the command is posted, the cpu's view of a table is
+ * stale for any chain the pending commands touch. Hence, a batch
+ * keeps the slots it has touched, and is posted (ie. flushed) before
+ * a rule that would read one of them is placed.
+ */
+#define BATCH_TBL  0
+#define BATCH_INDX 1
+
+/*
+ * Enough for the worst case, a batch of deletes: three base table
+ * slots and four index table slots per rule...
+ */
+#define IPA_NAT_BATCH_MAX_TOUCHED (IPA_DMA_ENTRIES_BATCH_MAX * 4)
+
+typedef struct
 {
-	uint32_t cmd_sz =
-		sizeof(struct ipa_ioc_nat_dma_cmd) +
-		(MAX_DMA_ENTRIES_FOR_ADD * sizeof(struct ipa_ioc_nat_dma_one));
-	char cmd_buf[cmd_sz];
-	struct ipa_ioc_nat_dma_cmd* cmd =
-		(struct ipa_ioc_nat_dma_cmd*) cmd_buf;
+	uint32_t           rule_num;  /* position in the caller's array */
+	uint32_t           dma_end;   /* cmd->entries with this rule's commands */
+	uint16_t           tbl_index;
+	uint16_t           indx_index;
+	ipa_table_iterator tbl_iter;  /* delete only */
+	ipa_table_iterator indx_iter; /* delete only */
+} ipa_nati_batch_rule;
 
-	enum ipa3_nat_mem_in            nmi;
-	struct ipa_nat_cache*           nat_cache_ptr;
-	struct ipa_nat_ip4_table_cache* nat_table;
-	struct ipa_nat_rule*            rule;
+typedef struct
+{
+	struct ipa_ioc_nat_dma_cmd* cmd;
+	uint32_t                    max_entries;
+	ipa_nati_batch_rule         rules[IPA_DMA_ENTRIES_BATCH_MAX];
+	uint32_t                    num_rules;
+	uint16_t                    touched[2][IPA_NAT_BATCH_MAX_TOUCHED];
+	uint32_t                    num_touched[2];
+	bool                        tbl_tail_pending;
+} ipa_nati_dma_batch;
 
-	uint16_t new_entry_index;
-	uint16_t new_index_tbl_entry_index;
-	uint32_t new_entry_handle;
-	char     buf[1024];
+/*
+ * Set when the kernel refuses a batch bigger than the per rule
+ * maximum (ie. it predates batching)...
+ */
+static bool dma_batch_unsupported = false;
 
-	int ret = 0;
+static void ipa_nati_dma_batch_reset(
+	ipa_nati_dma_batch* batch)
+{
+	batch->cmd->entries    = 0;
+	batch->max_entries     =
+		( dma_batch_unsupported ) ?
+		IPA_DMA_ENTRIES_LEGACY_MAX :
+		IPA_DMA_ENTRIES_BATCH_MAX;
+	batch->num_rules       = 0;
+	batch->num_touched[BATCH_TBL]  = 0;
+	batch->num_touched[BATCH_INDX] = 0;
+	batch->tbl_tail_pending = false;
+}
 
-	IPADBG("In\n");
+static bool ipa_nati_dma_batch_full(
+	ipa_nati_dma_batch* batch,
+	uint32_t            entries_needed)
+{
+	/*
+	 * An empty batch always takes the next rule, even one that needs
+	 * more than the legacy maximum...
+	 */
+	return
+		batch->num_rules > 0 &&
+		( batch->num_rules == IPA_DMA_ENTRIES_BATCH_MAX ||
+		  batch->cmd->entries + entries_needed > batch->max_entries );
+}
 
-	memset(cmd_buf, 0, sizeof(cmd_buf));
+static bool ipa_nati_dma_batch_touched(
+	ipa_nati_dma_batch* batch,
+	uint32_t            sub,
+	uint16_t            index)
+{
+	uint32_t i;
 
-	if ( ! VALID_TBL_HDL(tbl_hdl) ||
-		 ! clnt_rule ||
-		 ! rule_hdl )
+	if ( VALID_INDEX(index) )
 	{
-		IPAERR("Bad arg: tbl_hdl(0x%08X) and/or clnt_rule(%p) and/or rule_hdl(%p)\n",
-			   tbl_hdl, clnt_rule, rule_hdl);
-		ret = -EINVAL;
-		goto done;
+		for ( i = 0; i < batch->num_touched[sub]; i++ )
+		{
+			if ( batch->touched[sub][i] == index )
+			{
+				return true;
+			}
+		}
 	}
 
-	*rule_hdl = 0;
+	return false;
+}
 
-	IPADBG("tbl_hdl(0x%08X)\n", tbl_hdl);
+static void ipa_nati_dma_batch_touch(
+	ipa_nati_dma_batch* batch,
+	uint32_t            sub,
+	uint16_t            index)
+{
+	if ( VALID_INDEX(index) &&
+		 batch->num_touched[sub] < IPA_NAT_BATCH_MAX_TOUCHED )
+	{
+		batch->touched[sub][batch->num_touched[sub]++] = index;
+	}
+}
 
-	BREAK_TBL_HDL(tbl_hdl, nmi, tbl_hdl);
+/*
+ * Post a batch's dma commands.  If the kernel won't take the whole
+ * batch, fall back to posting it a few rules at a time.  A rule's
+ * commands are never split across two posts, so a rule that alone
+ * needs more than IPA_DMA_ENTRIES_LEGACY_MAX goes out by itself,
+ * exactly as the per rule api would send it.
+ *
+ * On return, *num_posted holds how many of the batch's rules, from
+ * the front, made it to the IPA.  On a failure part way through the
+ * fallback, those are committed and the rest are not.
+ */
+static int ipa_nati_post_ipv4_dma_batch(
+	struct ipa_nat_cache* nat_cache_ptr,
+	ipa_nati_dma_batch*   batch,
+	uint32_t*             num_posted)
+{
+	uint32_t cmd_sz =
+		sizeof(struct ipa_ioc_nat_dma_cmd) +
+		(MAX_DMA_ENTRIES_FOR_ADD * sizeof(struct ipa_ioc_nat_dma_one));
+	char chunk_buf[cmd_sz];
+	struct ipa_ioc_nat_dma_cmd* chunk =
+		(struct ipa_ioc_nat_dma_cmd*) chunk_buf;
 
-	if ( ! IPA_VALID_NAT_MEM_IN(nmi) ) {
-		IPAERR("Bad cache type argument passed\n");
-		ret = -EINVAL;
-		goto done;
-	}
+	uint32_t first = 0, first_rule = 0, end, i;
 
-	IPADBG("tbl_hdl(0x%08X) nmi(%s) %s\n",
-		   tbl_hdl,
-		   ipa3_nat_mem_in_as_str(nmi),
-		   prep_nat_ipv4_rule_4print(clnt_rule, buf, sizeof(buf)));
+	int ret = 0;
 
-	nat_cache_ptr = &ipv4_nat_cache[nmi];
+	IPADBG("In\n");
 
-	nat_table = &nat_cache_ptr->ip4_tbl[tbl_hdl - 1];
+	*num_posted = 0;
 
-	if (clnt_rule->protocol == IPAHAL_NAT_INVALID_PROTOCOL) {
-		IPAERR("invalid parameter protocol=%d\n", clnt_rule->protocol);
-		ret = -EINVAL;
-		goto done;
+	if ( batch->cmd->entries == 0 )
+	{
+		goto bail;
 	}
 
-	/*
-	 * Verify that the rule's PDN is valid
-	 */
-	if (clnt_rule->pdn_index >= IPA_MAX_PDN_NUM ||
-		pdns[clnt_rule->pdn_index].public_ip == 0) {
-		IPAERR("invalid parameters, pdn index %d, public ip = 0x%X\n",
-			   clnt_rule->pdn_index, pdns[clnt_rule->pdn_index].public_ip);
-		ret = -EINVAL;
-		goto done;
-	}
+	ret = ipa_nati_post_ipv4_dma_cmd(nat_cache_ptr, batch->cmd);
 
-	if (pthread_mutex_lock(&nat_mutex)) {
-		IPAERR("unable to lock the nat mutex\n");
-		ret = -EINVAL;
-		goto done;
+	if ( ret == 0 )
+	{
+		*num_posted = batch->num_rules;
+		goto bail;
 	}
 
-	if (! nat_table->mem_desc.valid) {
-		IPAERR("invalid table handle %d\n", tbl_hdl);
-		ret = -EINVAL;
-		goto unlock;
+	if ( batch->cmd->entries <= IPA_DMA_ENTRIES_LEGACY_MAX ||
+		 batch->num_rules < 2 )
+	{
+		goto bail;
 	}
 
-	/* src_only */
-	if (clnt_rule->src_only) {
-		new_entry_index = dst_hash(
-			nat_cache_ptr,
-			pdns[clnt_rule->pdn_index].public_ip,
-			clnt_rule->target_ip,
-			clnt_rule->target_port,
-			clnt_rule->public_port,
-			clnt_rule->protocol,
-			nat_table->table.table_entries - 1) + Hash_token;
-		new_entry_index = (new_entry_index & (nat_table->table.table_entries - 1));
-		if (new_entry_index == 0) {
-			new_entry_index = nat_table->table.table_entries - 1;
+	IPAINFO("Batch of %u dma entries refused...falling back to %u per command\n",
+			batch->cmd->entries, IPA_DMA_ENTRIES_LEGACY_MAX);
+
+	memset(chunk_buf, 0, sizeof(chunk_buf));
+
+	/*
+	 * Each pass posts rules [first_rule, i) once rule i no longer
+	 * fits beside them, and the final pass posts whatever is left.
+	 * Every chunk holds at least one whole rule...
+	 */
+	for ( i = 0; i <= batch->num_rules; i++ )
+	{
+		if ( i < batch->num_rules )
+		{
+			end = batch->rules[i].dma_end;
+
+			if ( i == first_rule || end - first <= IPA_DMA_ENTRIES_LEGACY_MAX )
+			{
+				continue;
+			}
 		}
-		Hash_token++;
-	} else {
-	new_entry_index = dst_hash(
-		nat_cache_ptr,
-		pdns[clnt_rule->pdn_index].public_ip,
-		clnt_rule->target_ip,
-		clnt_rule->target_port,
-		clnt_rule->public_port,
-		clnt_rule->protocol,
-		nat_table->table.table_entries - 1);
-	}
 
-	ret = ipa_table_add_entry(
-		&nat_table->table,
-		(void*) clnt_rule,
-		&new_entry_index,
-		&new_entry_handle,
-		cmd);
+		chunk->entries = batch->rules[i - 1].dma_end - first;
 
-	if (ret) {
-		IPAERR("Failed to add a new NAT entry\n");
-		goto unlock;
-	}
+		memcpy(chunk->dma,
+			   &batch->cmd->dma[first],
+			   chunk->entries * sizeof(struct ipa_ioc_nat_dma_one));
 
-	/* dst_only */
-	if (clnt_rule->dst_only) {
-		new_index_tbl_entry_index =
-			src_hash(clnt_rule->private_ip,
-				 clnt_rule->private_port,
-				 clnt_rule->target_ip,
-				 clnt_rule->target_port,
-				 clnt_rule->protocol,
-				 nat_table->table.table_entries - 1) + Hash_token;
-		new_index_tbl_entry_index = (new_index_tbl_entry_index & (nat_table->table.table_entries - 1));
-		if (new_index_tbl_entry_index == 0) {
-			new_index_tbl_entry_index = nat_table->table.table_entries - 1;
+		ret = ipa_nati_post_ipv4_dma_cmd(nat_cache_ptr, chunk);
+
+		if ( ret )
+		{
+			goto bail;
 		}
-		Hash_token++;
-	} else {
-	new_index_tbl_entry_index =
-		src_hash(clnt_rule->private_ip,
-				 clnt_rule->private_port,
-				 clnt_rule->target_ip,
-				 clnt_rule->target_port,
-				 clnt_rule->protocol,
-				 nat_table->table.table_entries - 1);
-	}
-	ret = ipa_table_add_entry(
-		&nat_table->index_table,
-		(void*) &new_entry_index,
-		&new_index_tbl_entry_index,
-		NULL,
-		cmd);
 
-	if (ret) {
-		IPAERR("failed to add a new NAT index entry\n");
-		goto fail_add_index_entry;
-	}
+		dma_batch_unsupported = true;
 
-	rule = ipa_table_get_entry_by_index(
-		&nat_table->table,
-		new_entry_index);
+		*num_posted = i;
 
-	if (rule == NULL) {
-		IPAERR("Failed to retrieve the entry in index %d for NAT table with handle=%d\n",
-			   new_entry_index, tbl_hdl);
-		ret = -EPERM;
-		goto bail;
+		first      = batch->rules[i - 1].dma_end;
+		first_rule = i;
 	}
 
-	rule->indx_tbl_entry = new_index_tbl_entry_index;
+bail:
+	IPADBG("Out\n");
 
-	rule->redirect   = clnt_rule->redirect;
-	rule->enable     = clnt_rule->enable;
-	rule->time_stamp = clnt_rule->time_stamp;
+	return ret;
+}
 
-	IPADBG("new entry:%d, new index entry: %d\n",
-		   new_entry_index, new_index_tbl_entry_index);
+/*
+ * Post the pending adds.  When the post fails, the rules that didn't
+ * make it to the IPA are backed out of the cpu's copy of the tables;
+ * those that did are kept and counted as done.
+ */
+static int ipa_nati_flush_add_batch(
+	struct ipa_nat_cache*           nat_cache_ptr,
+	struct ipa_nat_ip4_table_cache* nat_table,
+	ipa_nati_dma_batch*             batch,
+	uint32_t*                       rule_hdls,
+	uint32_t*                       num_done)
+{
+	ipa_nati_batch_rule* pend;
+	uint32_t             num_posted, i;
+	int                  ret;
 
-	IPADBG("rule_hdl(0x%08X) -> %s\n",
-		   new_entry_handle,
-		   prep_nat_rule_4print(rule, buf, sizeof(buf)));
+	IPADBG("In\n");
 
-	ret = ipa_nati_post_ipv4_dma_cmd(nat_cache_ptr, cmd);
+	ret = ipa_nati_post_ipv4_dma_batch(nat_cache_ptr, batch, &num_posted);
 
-	if (ret) {
+	if ( ret )
+	{
 		IPAERR("unable to post dma command\n");
-		goto bail;
-	}
 
-	if (pthread_mutex_unlock(&nat_mutex)) {
-		IPAERR("unable to unlock the nat mutex\n");
-		ret = -EPERM;
-		goto done;
+		for ( i = batch->num_rules; i > num_posted; i-- )
+		{
+			pend = &batch->rules[i - 1];
+
+			ipa_table_erase_entry(&nat_table->index_table, pend->indx_index);
+			ipa_table_erase_entry(&nat_table->table, pend->tbl_index);
+
+			rule_hdls[pend->rule_num] = 0;
+		}
 	}
 
-	*rule_hdl = new_entry_handle;
+	*num_done += num_posted;
 
-	IPADBG("rule_hdl value(%u)\n", *rule_hdl);
+	ipa_nati_dma_batch_reset(batch);
 
-	goto done;
+	IPADBG("Out\n");
+
+	return ret;
+}
+
+/*
+ * Find the base and index table entries of the rule to be deleted.
+ */
+static int ipa_nati_init_del_iterators(
+	struct ipa_nat_ip4_table_cache* nat_table,
+	uint32_t                        tbl_hdl,
+	uint32_t                        rule_hdl,
+	ipa_table_iterator*             table_iterator,
+	ipa_table_iterator*             index_table_iterator)
+{
+	struct ipa_nat_rule*          table_rule;
+	struct ipa_nat_indx_tbl_rule* index_table_rule;
+
+	uint16_t index;
+	char     buf[1024];
+	int      ret;
+
+	ret = ipa_table_get_entry(
+		&nat_table->table,
+		rule_hdl,
+		(void**) &table_rule,
+		&index);
+
+	if (ret) {
+		IPAERR("Unable to retrive the entry with rule_hdl=%u\n", rule_hdl);
+		goto bail;
+	}
+
+	IPADBG("rule_hdl(0x%08X) -> %s\n",
+		   rule_hdl,
+		   prep_nat_rule_4print(table_rule, buf, sizeof(buf)));
+
+	ret = ipa_table_iterator_init(
+		table_iterator,
+		&nat_table->table,
+		table_rule,
+		index);
+
+	if (ret) {
+		IPAERR("Unable to create iterator which points to the "
+			   "entry %u in NAT table with handle=0x%08X\n",
+			   index, tbl_hdl);
+		goto bail;
+	}
+
+	index = table_rule->indx_tbl_entry;
+
+	index_table_rule = (struct ipa_nat_indx_tbl_rule*)
+		ipa_table_get_entry_by_index(&nat_table->index_table, index);
+
+	if (index_table_rule == NULL) {
+		IPAERR("Unable to retrieve the entry in index %u "
+			   "in NAT index table with handle=0x%08X\n",
+			   index, tbl_hdl);
+		ret = -EPERM;
+		goto bail;
+	}
+
+	ret = ipa_table_iterator_init(
+		index_table_iterator,
+		&nat_table->index_table,
+		index_table_rule,
+		index);
+
+	if (ret) {
+		IPAERR("Unable to create iterator which points to the "
+			   "entry %u in NAT index table with handle=0x%08X\n",
+			   index, tbl_hdl);
+		goto bail;
+	}
+
+bail:
+	return ret;
+}
+
+/*
+ * Add the dma commands that delete a rule.  Leaves the index table
+ * iterator on the entry that is to be removed from the cpu's copy.
+ */
+static int ipa_nati_create_del_cmds(
+	struct ipa_nat_ip4_table_cache* nat_table,
+	ipa_table_iterator*             table_iterator,
+	ipa_table_iterator*             index_table_iterator,
+	struct ipa_ioc_nat_dma_cmd*     cmd)
+{
+	int ret = 0;
+
+	ipa_table_create_delete_command(
+		&nat_table->index_table,
+		cmd,
+		index_table_iterator);
+
+	if (ipa_table_iterator_is_head_with_tail(index_table_iterator)) {
+
+		ipa_nati_copy_second_index_entry_to_head(
+			nat_table, index_table_iterator, cmd);
+		/*
+		 * Iterate to the next entry which should be deleted
+		 */
+		ret = ipa_table_iterator_next(
+			index_table_iterator, &nat_table->index_table);
+
+		if (ret) {
+			IPAERR("Unable to move the iterator to the next entry "
+				   "(points to the entry %u in NAT index table)\n",
+				   index_table_iterator->curr_index);
+			goto bail;
+		}
+	}
+
+	ipa_table_create_delete_command(
+		&nat_table->table,
+		cmd,
+		table_iterator);
+
+bail:
+	return ret;
+}
+
+/*
+ * Remove a deleted rule from the cpu's copy of the tables.  Only to
+ * be done once its dma commands have been posted.
+ */
+static void ipa_nati_del_rule_entries(
+	struct ipa_nat_ip4_table_cache* nat_table,
+	ipa_table_iterator*             table_iterator,
+	ipa_table_iterator*             index_table_iterator)
+{
+	if (! ipa_table_iterator_is_head_with_tail(table_iterator)) {
+		/* The entry can be deleted */
+		uint8_t is_prev_empty =
+			(table_iterator->prev_entry != NULL &&
+			 ((struct ipa_nat_rule*)table_iterator->prev_entry)->protocol ==
+			 IPAHAL_NAT_INVALID_PROTOCOL);
+
+		ipa_table_delete_entry(
+			&nat_table->table, table_iterator, is_prev_empty);
+	}
+
+	ipa_table_delete_entry(
+		&nat_table->index_table,
+		index_table_iterator,
+		FALSE);
+
+	if (index_table_iterator->curr_index >= nat_table->index_table.table_entries)
+		nat_table->index_expn_table_meta[
+			index_table_iterator->curr_index - nat_table->index_table.table_entries].
+			prev_index = IPA_TABLE_INVALID_ENTRY;
+}
+
+/*
+ * Check (or, when record is true, record) the slots that deleting
+ * the rule in pend would touch...
+ */
+static bool ipa_nati_dma_batch_del_touches(
+	ipa_nati_dma_batch*  batch,
+	ipa_nati_batch_rule* pend,
+	bool                 record)
+{
+	uint16_t tbl_idx[] = {
+		pend->tbl_iter.prev_index,
+		pend->tbl_iter.curr_index,
+		pend->tbl_iter.next_index,
+	};
+	uint16_t indx_idx[] = {
+		pend->indx_iter.prev_index,
+		pend->indx_iter.curr_index,
+		pend->indx_iter.next_index,
+		IPA_TABLE_INVALID_ENTRY,
+	};
+	uint32_t i;
+
+	/*
+	 * The second entry of the chain gets copied to the head, and the
+	 * one after it relinked...
+	 */
+	if ( ipa_table_iterator_is_head_with_tail(&pend->indx_iter) )
+	{
+		indx_idx[3] = index_table_entry_get_next_index(pend->indx_iter.next_entry);
+	}
+
+	for ( i = 0; i < sizeof(tbl_idx) / sizeof(tbl_idx[0]); i++ )
+	{
+		if ( record )
+			ipa_nati_dma_batch_touch(batch, BATCH_TBL, tbl_idx[i]);
+		else if ( ipa_nati_dma_batch_touched(batch, BATCH_TBL, tbl_idx[i]) )
+			return true;
+	}
+
+	for ( i = 0; i < sizeof(indx_idx) / sizeof(indx_idx[0]); i++ )
+	{
+		if ( record )
+			ipa_nati_dma_batch_touch(batch, BATCH_INDX, indx_idx[i]);
+		else if ( ipa_nati_dma_batch_touched(batch, BATCH_INDX, indx_idx[i]) )
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Post the pending deletes, then remove them from the cpu's copy of
+ * the tables...
+ */
+static int ipa_nati_flush_del_batch(
+	struct ipa_nat_cache*           nat_cache_ptr,
+	struct ipa_nat_ip4_table_cache* nat_table,
+	ipa_nati_dma_batch*             batch,
+	uint32_t*                       num_done)
+{
+	uint32_t num_posted, i;
+	int      ret;
+
+	IPADBG("In\n");
+
+	ret = ipa_nati_post_ipv4_dma_batch(nat_cache_ptr, batch, &num_posted);
+
+	if ( ret )
+	{
+		IPAERR("Unable to post dma command\n");
+	}
+
+	/*
+	 * Rules whose commands reached the IPA are gone from the
+	 * hardware's view, so drop them from the cpu's too, even if a
+	 * later chunk failed...
+	 */
+	for ( i = 0; i < num_posted; i++ )
+	{
+		ipa_nati_del_rule_entries(
+			nat_table,
+			&batch->rules[i].tbl_iter,
+			&batch->rules[i].indx_iter);
+	}
+
+	*num_done += num_posted;
+
+	ipa_nati_dma_batch_reset(batch);
+
+	IPADBG("Out\n");
+
+	return ret;
+}
+
+int ipa_NATI_add_ipv4_rule(
+	uint32_t                 tbl_hdl,
+	const ipa_nat_ipv4_rule* clnt_rule,
+	uint32_t*                rule_hdl)
+{
+	uint32_t cmd_sz =
+		sizeof(struct ipa_ioc_nat_dma_cmd) +
+		(MAX_DMA_ENTRIES_FOR_ADD * sizeof(struct ipa_ioc_nat_dma_one));
+	char cmd_buf[cmd_sz];
+	struct ipa_ioc_nat_dma_cmd* cmd =
+		(struct ipa_ioc_nat_dma_cmd*) cmd_buf;
+
+	enum ipa3_nat_mem_in            nmi;
+	struct ipa_nat_cache*           nat_cache_ptr;
+	struct ipa_nat_ip4_table_cache* nat_table;
+	struct ipa_nat_rule*            rule;
+
+	uint16_t new_entry_index;
+	uint16_t new_index_tbl_entry_index;
+	uint32_t new_entry_handle;
+	char     buf[1024];
+
+	int ret = 0;
+
+	IPADBG("In\n");
+
+	memset(cmd_buf, 0, sizeof(cmd_buf));
+
+	if ( ! VALID_TBL_HDL(tbl_hdl) ||
+		 ! clnt_rule ||
+		 ! rule_hdl )
+	{
+		IPAERR("Bad arg: tbl_hdl(0x%08X) and/or clnt_rule(%p) and/or rule_hdl(%p)\n",
+			   tbl_hdl, clnt_rule, rule_hdl);
+		ret = -EINVAL;
+		goto done;
+	}
+
+	*rule_hdl = 0;
+
+	IPADBG("tbl_hdl(0x%08X)\n", tbl_hdl);
+
+	BREAK_TBL_HDL(tbl_hdl, nmi, tbl_hdl);
+
+	if ( ! IPA_VALID_NAT_MEM_IN(nmi) ) {
+		IPAERR("Bad cache type argument passed\n");
+		ret = -EINVAL;
+		goto done;
+	}
+
+	IPADBG("tbl_hdl(0x%08X) nmi(%s) %s\n",
+		   tbl_hdl,
+		   ipa3_nat_mem_in_as_str(nmi),
+		   prep_nat_ipv4_rule_4print(clnt_rule, buf, sizeof(buf)));
+
+	nat_cache_ptr = &ipv4_nat_cache[nmi];
+
+	nat_table = &nat_cache_ptr->ip4_tbl[tbl_hdl - 1];
+
+	if (clnt_rule->protocol == IPAHAL_NAT_INVALID_PROTOCOL) {
+		IPAERR("invalid parameter protocol=%d\n", clnt_rule->protocol);
+		ret = -EINVAL;
+		goto done;
+	}
+
+	/*
+	 * Verify that the rule's PDN is valid
+	 */
+	if (clnt_rule->pdn_index >= IPA_MAX_PDN_NUM ||
+		pdns[clnt_rule->pdn_index].public_ip == 0) {
+		IPAERR("invalid parameters, pdn index %d, public ip = 0x%X\n",
+			   clnt_rule->pdn_index, pdns[clnt_rule->pdn_index].public_ip);
+		ret = -EINVAL;
+		goto done;
+	}
+
+	if (pthread_mutex_lock(&nat_mutex)) {
+		IPAERR("unable to lock the nat mutex\n");
+		ret = -EINVAL;
+		goto done;
+	}
+
+	if (! nat_table->mem_desc.valid) {
+		IPAERR("invalid table handle %d\n", tbl_hdl);
+		ret = -EINVAL;
+		goto unlock;
+	}
+
+	new_entry_index =
+		ipa_nati_calc_tbl_index(nat_cache_ptr, nat_table, clnt_rule);
+
+	ret = ipa_table_add_entry(
+		&nat_table->table,
+		(void*) clnt_rule,
+		&new_entry_index,
+		&new_entry_handle,
+		cmd);
+
+	if (ret) {
+		IPAERR("Failed to add a new NAT entry\n");
+		goto unlock;
+	}
+
+	new_index_tbl_entry_index =
+		ipa_nati_calc_indx_tbl_index(nat_table, clnt_rule);
+
+	ret = ipa_table_add_entry(
+		&nat_table->index_table,
+		(void*) &new_entry_index,
+		&new_index_tbl_entry_index,
+		NULL,
+		cmd);
+
+	if (ret) {
+		IPAERR("failed to add a new NAT index entry\n");
+		goto fail_add_index_entry;
+	}
+
+	rule = ipa_table_get_entry_by_index(
+		&nat_table->table,
+		new_entry_index);
+
+	if (rule == NULL) {
+		IPAERR("Failed to retrieve the entry in index %d for NAT table with handle=%d\n",
+			   new_entry_index, tbl_hdl);
+		ret = -EPERM;
+		goto bail;
+	}
+
+	rule->indx_tbl_entry = new_index_tbl_entry_index;
+
+	rule->redirect   = clnt_rule->redirect;
+	rule->enable     = clnt_rule->enable;
+	rule->time_stamp = clnt_rule->time_stamp;
+
+	IPADBG("new entry:%d, new index entry: %d\n",
+		   new_entry_index, new_index_tbl_entry_index);
+
+	IPADBG("rule_hdl(0x%08X) -> %s\n",
+		   new_entry_handle,
+		   prep_nat_rule_4print(rule, buf, sizeof(buf)));
+
+	ret = ipa_nati_post_ipv4_dma_cmd(nat_cache_ptr, cmd);
+
+	if (ret) {
+		IPAERR("unable to post dma command\n");
+		goto bail;
+	}
+
+	if (pthread_mutex_unlock(&nat_mutex)) {
+		IPAERR("unable to unlock the nat mutex\n");
+		ret = -EPERM;
+		goto done;
+	}
+
+	*rule_hdl = new_entry_handle;
+
+	IPADBG("rule_hdl value(%u)\n", *rule_hdl);
+
+	goto done;
 
 bail:
 	ipa_table_erase_entry(&nat_table->index_table, new_index_tbl_entry_index);
 
-fail_add_index_entry:
-	ipa_table_erase_entry(&nat_table->table, new_entry_index);
+fail_add_index_entry:
+	ipa_table_erase_entry(&nat_table->table, new_entry_index);
+
+unlock:
+	if (pthread_mutex_unlock(&nat_mutex))
+		IPAERR("unable to unlock the nat mutex\n");
+done:
+	IPADBG("Out\n");
+
+	return ret;
+}
+
+int ipa_NATI_del_ipv4_rule(
+	uint32_t tbl_hdl,
+	uint32_t rule_hdl )
+{
+	uint32_t cmd_sz =
+		sizeof(struct ipa_ioc_nat_dma_cmd) +
+		(MAX_DMA_ENTRIES_FOR_DEL * sizeof(struct ipa_ioc_nat_dma_one));
+	char cmd_buf[cmd_sz];
+	struct ipa_ioc_nat_dma_cmd* cmd =
+		(struct ipa_ioc_nat_dma_cmd*) cmd_buf;
+
+	enum ipa3_nat_mem_in            nmi;
+	struct ipa_nat_cache*           nat_cache_ptr;
+	struct ipa_nat_ip4_table_cache* nat_table;
+
+	ipa_table_iterator table_iterator;
+	ipa_table_iterator index_table_iterator;
+
+	int ret = 0;
+
+	IPADBG("In\n");
+
+	memset(cmd_buf, 0, sizeof(cmd_buf));
+
+	IPADBG("tbl_hdl(0x%08X) rule_hdl(%u)\n", tbl_hdl, rule_hdl);
+
+	BREAK_TBL_HDL(tbl_hdl, nmi, tbl_hdl);
+
+	if ( ! IPA_VALID_NAT_MEM_IN(nmi) ) {
+		IPAERR("Bad cache type argument passed\n");
+		ret = -EINVAL;
+		goto done;
+	}
+
+	IPADBG("nmi(%s)\n", ipa3_nat_mem_in_as_str(nmi));
+
+	nat_cache_ptr = &ipv4_nat_cache[nmi];
+
+	nat_table = &nat_cache_ptr->ip4_tbl[tbl_hdl - 1];
+
+	if (pthread_mutex_lock(&nat_mutex)) {
+		IPAERR("Unable to lock the nat mutex\n");
+		ret = -EINVAL;
+		goto done;
+	}
+
+	if (! nat_table->mem_desc.valid) {
+		IPAERR("Invalid table handle 0x%08X\n", tbl_hdl);
+		ret = -EINVAL;
+		goto unlock;
+	}
+
+	ret = ipa_nati_init_del_iterators(
+		nat_table,
+		tbl_hdl,
+		rule_hdl,
+		&table_iterator,
+		&index_table_iterator);
+
+	if (ret) {
+		goto unlock;
+	}
+
+	ret = ipa_nati_create_del_cmds(
+		nat_table,
+		&table_iterator,
+		&index_table_iterator,
+		cmd);
+
+	if (ret) {
+		goto unlock;
+	}
+
+	ret = ipa_nati_post_ipv4_dma_cmd(nat_cache_ptr, cmd);
+
+	if (ret) {
+		IPAERR("Unable to post dma command\n");
+		goto unlock;
+	}
+
+	ipa_nati_del_rule_entries(
+		nat_table,
+		&table_iterator,
+		&index_table_iterator);
 
 unlock:
-	if (pthread_mutex_unlock(&nat_mutex))
-		IPAERR("unable to unlock the nat mutex\n");
+	if (pthread_mutex_unlock(&nat_mutex)) {
+		IPAERR("Unable to unlock the nat mutex\n");
+		ret = (ret) ? ret : -EPERM;
+	}
+
 done:
 	IPADBG("Out\n");
 
 	return ret;
 }
 
-int ipa_NATI_del_ipv4_rule(
-	uint32_t tbl_hdl,
-	uint32_t rule_hdl )
+int ipa_NATI_add_ipv4_rules(
+	uint32_t                 tbl_hdl,
+	const ipa_nat_ipv4_rule* clnt_rules,
+	uint32_t                 num_rules,
+	uint32_t*                rule_hdls,
+	uint32_t*                num_done)
 {
 	uint32_t cmd_sz =
 		sizeof(struct ipa_ioc_nat_dma_cmd) +
-		(MAX_DMA_ENTRIES_FOR_DEL * sizeof(struct ipa_ioc_nat_dma_one));
+		(IPA_DMA_ENTRIES_BATCH_MAX * sizeof(struct ipa_ioc_nat_dma_one));
 	char cmd_buf[cmd_sz];
-	struct ipa_ioc_nat_dma_cmd* cmd =
-		(struct ipa_ioc_nat_dma_cmd*) cmd_buf;
+
+	ipa_nati_dma_batch batch;
 
 	enum ipa3_nat_mem_in            nmi;
 	struct ipa_nat_cache*           nat_cache_ptr;
 	struct ipa_nat_ip4_table_cache* nat_table;
-	struct ipa_nat_rule*            table_rule;
-	struct ipa_nat_indx_tbl_rule*   index_table_rule;
-
-	ipa_table_iterator table_iterator;
-	ipa_table_iterator index_table_iterator;
+	const ipa_nat_ipv4_rule*        clnt_rule;
+	struct ipa_nat_rule*            rule;
+	ipa_nati_batch_rule*            pend;
 
-	uint16_t index;
+	uint16_t tbl_bucket, indx_bucket;
+	uint16_t new_entry_index;
+	uint16_t new_index_tbl_entry_index;
+	uint32_t new_entry_handle;
+	uint32_t dma_start, i;
+	bool     tbl_tail;
 	char     buf[1024];
-	int      ret = 0;
+
+	int ret = 0, flush_ret;
 
 	IPADBG("In\n");
 
-	memset(cmd_buf, 0, sizeof(cmd_buf));
+	if ( ! VALID_TBL_HDL(tbl_hdl) ||
+		 ! clnt_rules ||
+		 ! rule_hdls ||
+		 ! num_done )
+	{
+		IPAERR("Bad arg: tbl_hdl(0x%08X) and/or clnt_rules(%p) and/or "
+			   "rule_hdls(%p) and/or num_done(%p)\n",
+			   tbl_hdl, clnt_rules, rule_hdls, num_done);
+		ret = -EINVAL;
+		goto done;
+	}
 
-	IPADBG("tbl_hdl(0x%08X) rule_hdl(%u)\n", tbl_hdl, rule_hdl);
+	*num_done = 0;
 
 	BREAK_TBL_HDL(tbl_hdl, nmi, tbl_hdl);
 
@@ -1881,133 +2532,319 @@ int ipa_NATI_del_ipv4_rule(
 		goto done;
 	}
 
-	IPADBG("nmi(%s)\n", ipa3_nat_mem_in_as_str(nmi));
+	IPADBG("tbl_hdl(0x%08X) nmi(%s) num_rules(%u)\n",
+		   tbl_hdl, ipa3_nat_mem_in_as_str(nmi), num_rules);
 
 	nat_cache_ptr = &ipv4_nat_cache[nmi];
 
 	nat_table = &nat_cache_ptr->ip4_tbl[tbl_hdl - 1];
 
+	memset(cmd_buf, 0, sizeof(cmd_buf));
+
+	batch.cmd = (struct ipa_ioc_nat_dma_cmd*) cmd_buf;
+
+	ipa_nati_dma_batch_reset(&batch);
+
 	if (pthread_mutex_lock(&nat_mutex)) {
-		IPAERR("Unable to lock the nat mutex\n");
+		IPAERR("unable to lock the nat mutex\n");
 		ret = -EINVAL;
 		goto done;
 	}
 
 	if (! nat_table->mem_desc.valid) {
-		IPAERR("Invalid table handle 0x%08X\n", tbl_hdl);
+		IPAERR("invalid table handle %d\n", tbl_hdl);
 		ret = -EINVAL;
 		goto unlock;
 	}
 
-	ret = ipa_table_get_entry(
-		&nat_table->table,
-		rule_hdl,
-		(void**) &table_rule,
-		&index);
+	for ( i = 0; i < num_rules; i++ ) {
 
-	if (ret) {
-		IPAERR("Unable to retrive the entry with rule_hdl=%u\n", rule_hdl);
-		goto unlock;
+		clnt_rule = &clnt_rules[i];
+
+		rule_hdls[i] = 0;
+
+		IPADBG("%s\n", prep_nat_ipv4_rule_4print(clnt_rule, buf, sizeof(buf)));
+
+		if (clnt_rule->protocol == IPAHAL_NAT_INVALID_PROTOCOL) {
+			IPAERR("invalid parameter protocol=%d\n", clnt_rule->protocol);
+			ret = -EINVAL;
+			break;
+		}
+
+		if (clnt_rule->pdn_index >= IPA_MAX_PDN_NUM ||
+			pdns[clnt_rule->pdn_index].public_ip == 0) {
+			IPAERR("invalid parameters, pdn index %d, public ip = 0x%X\n",
+				   clnt_rule->pdn_index, pdns[clnt_rule->pdn_index].public_ip);
+			ret = -EINVAL;
+			break;
+		}
+
+		new_entry_index = tbl_bucket =
+			ipa_nati_calc_tbl_index(nat_cache_ptr, nat_table, clnt_rule);
+
+		new_index_tbl_entry_index = indx_bucket =
+			ipa_nati_calc_indx_tbl_index(nat_table, clnt_rule);
+
+		/*
+		 * An occupied bucket means the rule goes into the
+		 * expansion table, where a pending tail's slot still
+		 * looks free...
+		 */
+		tbl_tail = table_entry_is_valid(
+			ipa_table_get_entry_by_index(&nat_table->table, tbl_bucket));
+
+		if ( ipa_nati_dma_batch_full(&batch, MAX_DMA_ENTRIES_FOR_ADD) ||
+			 ipa_nati_dma_batch_touched(&batch, BATCH_TBL, tbl_bucket) ||
+			 ipa_nati_dma_batch_touched(&batch, BATCH_INDX, indx_bucket) ||
+			 ( tbl_tail && batch.tbl_tail_pending ) )
+		{
+			ret = ipa_nati_flush_add_batch(
+				nat_cache_ptr, nat_table, &batch, rule_hdls, num_done);
+
+			if (ret) {
+				goto unlock;
+			}
+
+			tbl_tail = table_entry_is_valid(
+				ipa_table_get_entry_by_index(&nat_table->table, tbl_bucket));
+		}
+
+		dma_start = batch.cmd->entries;
+
+		ret = ipa_table_add_entry(
+			&nat_table->table,
+			(void*) clnt_rule,
+			&new_entry_index,
+			&new_entry_handle,
+			batch.cmd);
+
+		if (ret) {
+			IPAERR("Failed to add a new NAT entry\n");
+			batch.cmd->entries = dma_start;
+			break;
+		}
+
+		ret = ipa_table_add_entry(
+			&nat_table->index_table,
+			(void*) &new_entry_index,
+			&new_index_tbl_entry_index,
+			NULL,
+			batch.cmd);
+
+		if (ret) {
+			IPAERR("failed to add a new NAT index entry\n");
+			ipa_table_erase_entry(&nat_table->table, new_entry_index);
+			batch.cmd->entries = dma_start;
+			break;
+		}
+
+		rule = ipa_table_get_entry_by_index(
+			&nat_table->table,
+			new_entry_index);
+
+		if (rule == NULL) {
+			IPAERR("Failed to retrieve the entry in index %d for NAT table with handle=%d\n",
+				   new_entry_index, tbl_hdl);
+			ipa_table_erase_entry(&nat_table->index_table, new_index_tbl_entry_index);
+			ipa_table_erase_entry(&nat_table->table, new_entry_index);
+			batch.cmd->entries = dma_start;
+			ret = -EPERM;
+			break;
+		}
+
+		rule->indx_tbl_entry = new_index_tbl_entry_index;
+
+		rule->redirect   = clnt_rule->redirect;
+		rule->enable     = clnt_rule->enable;
+		rule->time_stamp = clnt_rule->time_stamp;
+
+		IPADBG("new entry:%d, new index entry: %d\n",
+			   new_entry_index, new_index_tbl_entry_index);
+
+		pend = &batch.rules[batch.num_rules++];
+
+		pend->rule_num   = i;
+		pend->dma_end    = batch.cmd->entries;
+		pend->tbl_index  = new_entry_index;
+		pend->indx_index = new_index_tbl_entry_index;
+
+		ipa_nati_dma_batch_touch(&batch, BATCH_TBL, tbl_bucket);
+		ipa_nati_dma_batch_touch(&batch, BATCH_INDX, indx_bucket);
+
+		batch.tbl_tail_pending |= tbl_tail;
+
+		rule_hdls[i] = new_entry_handle;
 	}
 
-	IPADBG("rule_hdl(0x%08X) -> %s\n",
-		   rule_hdl,
-		   prep_nat_rule_4print(table_rule, buf, sizeof(buf)));
+	/*
+	 * Rules placed before any failure above are good, so post them
+	 * regardless...
+	 */
+	flush_ret = ipa_nati_flush_add_batch(
+		nat_cache_ptr, nat_table, &batch, rule_hdls, num_done);
 
-	ret = ipa_table_iterator_init(
-		&table_iterator,
-		&nat_table->table,
-		table_rule,
-		index);
+	ret = (ret) ? ret : flush_ret;
 
-	if (ret) {
-		IPAERR("Unable to create iterator which points to the "
-			   "entry %u in NAT table with handle=0x%08X\n",
-			   index, tbl_hdl);
-		goto unlock;
+	IPADBG("num_done(%u) of num_rules(%u)\n", *num_done, num_rules);
+
+unlock:
+	if (pthread_mutex_unlock(&nat_mutex)) {
+		IPAERR("unable to unlock the nat mutex\n");
+		ret = (ret) ? ret : -EPERM;
 	}
 
-	index = table_rule->indx_tbl_entry;
+done:
+	IPADBG("Out\n");
 
-	index_table_rule = (struct ipa_nat_indx_tbl_rule*)
-		ipa_table_get_entry_by_index(&nat_table->index_table, index);
+	return ret;
+}
 
-	if (index_table_rule == NULL) {
-		IPAERR("Unable to retrieve the entry in index %u "
-			   "in NAT index table with handle=0x%08X\n",
-			   index, tbl_hdl);
-		ret = -EPERM;
-		goto unlock;
+int ipa_NATI_del_ipv4_rules(
+	uint32_t        tbl_hdl,
+	const uint32_t* rule_hdls,
+	uint32_t        num_rules,
+	uint32_t*       num_done)
+{
+	uint32_t cmd_sz =
+		sizeof(struct ipa_ioc_nat_dma_cmd) +
+		(IPA_DMA_ENTRIES_BATCH_MAX * sizeof(struct ipa_ioc_nat_dma_one));
+	char cmd_buf[cmd_sz];
+
+	ipa_nati_dma_batch batch;
+
+	enum ipa3_nat_mem_in            nmi;
+	struct ipa_nat_cache*           nat_cache_ptr;
+	struct ipa_nat_ip4_table_cache* nat_table;
+	ipa_nati_batch_rule*            pend;
+
+	uint32_t dma_start, i;
+
+	int ret = 0, flush_ret;
+
+	IPADBG("In\n");
+
+	if ( ! VALID_TBL_HDL(tbl_hdl) ||
+		 ! rule_hdls ||
+		 ! num_done )
+	{
+		IPAERR("Bad arg: tbl_hdl(0x%08X) and/or rule_hdls(%p) and/or num_done(%p)\n",
+			   tbl_hdl, rule_hdls, num_done);
+		ret = -EINVAL;
+		goto done;
 	}
 
-	ret = ipa_table_iterator_init(
-		&index_table_iterator,
-		&nat_table->index_table,
-		index_table_rule,
-		index);
+	*num_done = 0;
 
-	if (ret) {
-		IPAERR("Unable to create iterator which points to the "
-			   "entry %u in NAT index table with handle=0x%08X\n",
-			   index, tbl_hdl);
+	BREAK_TBL_HDL(tbl_hdl, nmi, tbl_hdl);
+
+	if ( ! IPA_VALID_NAT_MEM_IN(nmi) ) {
+		IPAERR("Bad cache type argument passed\n");
+		ret = -EINVAL;
+		goto done;
+	}
+
+	IPADBG("tbl_hdl(0x%08X) nmi(%s) num_rules(%u)\n",
+		   tbl_hdl, ipa3_nat_mem_in_as_str(nmi), num_rules);
+
+	nat_cache_ptr = &ipv4_nat_cache[nmi];
+
+	nat_table = &nat_cache_ptr->ip4_tbl[tbl_hdl - 1];
+
+	memset(cmd_buf, 0, sizeof(cmd_buf));
+
+	batch.cmd = (struct ipa_ioc_nat_dma_cmd*) cmd_buf;
+
+	ipa_nati_dma_batch_reset(&batch);
+
+	if (pthread_mutex_lock(&nat_mutex)) {
+		IPAERR("Unable to lock the nat mutex\n");
+		ret = -EINVAL;
+		goto done;
+	}
+
+	if (! nat_table->mem_desc.valid) {
+		IPAERR("Invalid table handle 0x%08X\n", tbl_hdl);
+		ret = -EINVAL;
 		goto unlock;
 	}
 
-	ipa_table_create_delete_command(
-		&nat_table->index_table,
-		cmd,
-		&index_table_iterator);
+	for ( i = 0; i < num_rules; i++ ) {
 
-	if (ipa_table_iterator_is_head_with_tail(&index_table_iterator)) {
+		IPADBG("rule_hdl(%u)\n", rule_hdls[i]);
 
-		ipa_nati_copy_second_index_entry_to_head(
-			nat_table, &index_table_iterator, cmd);
-		/*
-		 * Iterate to the next entry which should be deleted
-		 */
-		ret = ipa_table_iterator_next(
-			&index_table_iterator, &nat_table->index_table);
+		if ( ipa_nati_dma_batch_full(&batch, MAX_DMA_ENTRIES_FOR_DEL) ) {
+
+			ret = ipa_nati_flush_del_batch(
+				nat_cache_ptr, nat_table, &batch, num_done);
+
+			if (ret) {
+				goto unlock;
+			}
+		}
+
+		pend = &batch.rules[batch.num_rules];
+
+		ret = ipa_nati_init_del_iterators(
+			nat_table,
+			tbl_hdl,
+			rule_hdls[i],
+			&pend->tbl_iter,
+			&pend->indx_iter);
+
+		if ( ret == 0 && ipa_nati_dma_batch_del_touches(&batch, pend, false) ) {
+			/*
+			 * Shares a chain link with a pending delete, so its
+			 * view of the chain is stale. Post what's pending, then
+			 * take another look...
+			 */
+			ret = ipa_nati_flush_del_batch(
+				nat_cache_ptr, nat_table, &batch, num_done);
+
+			if (ret) {
+				goto unlock;
+			}
+
+			pend = &batch.rules[0];
+
+			ret = ipa_nati_init_del_iterators(
+				nat_table,
+				tbl_hdl,
+				rule_hdls[i],
+				&pend->tbl_iter,
+				&pend->indx_iter);
+		}
 
 		if (ret) {
-			IPAERR("Unable to move the iterator to the next entry "
-				   "(points to the entry %u in NAT index table)\n",
-				   index);
-			goto unlock;
+			break;
 		}
-	}
 
-	ipa_table_create_delete_command(
-		&nat_table->table,
-		cmd,
-		&table_iterator);
+		dma_start = batch.cmd->entries;
 
-	ret = ipa_nati_post_ipv4_dma_cmd(nat_cache_ptr, cmd);
+		ret = ipa_nati_create_del_cmds(
+			nat_table,
+			&pend->tbl_iter,
+			&pend->indx_iter,
+			batch.cmd);
 
-	if (ret) {
-		IPAERR("Unable to post dma command\n");
-		goto unlock;
-	}
+		if (ret) {
+			batch.cmd->entries = dma_start;
+			break;
+		}
 
-	if (! ipa_table_iterator_is_head_with_tail(&table_iterator)) {
-		/* The entry can be deleted */
-		uint8_t is_prev_empty =
-			(table_iterator.prev_entry != NULL &&
-			 ((struct ipa_nat_rule*)table_iterator.prev_entry)->protocol ==
-			 IPAHAL_NAT_INVALID_PROTOCOL);
+		ipa_nati_dma_batch_del_touches(&batch, pend, true);
 
-		ipa_table_delete_entry(
-			&nat_table->table, &table_iterator, is_prev_empty);
+		pend->rule_num = i;
+		pend->dma_end  = batch.cmd->entries;
+
+		batch.num_rules++;
 	}
 
-	ipa_table_delete_entry(
-		&nat_table->index_table,
-		&index_table_iterator,
-		FALSE);
+	flush_ret = ipa_nati_flush_del_batch(
+		nat_cache_ptr, nat_table, &batch, num_done);
 
-	if (index_table_iterator.curr_index >= nat_table->index_table.table_entries)
-		nat_table->index_expn_table_meta[
-			index_table_iterator.curr_index - nat_table->index_table.table_entries].
-			prev_index = IPA_TABLE_INVALID_ENTRY;
+	ret = (ret) ? ret : flush_ret;
+
+	IPADBG("num_done(%u) of num_rules(%u)\n", *num_done, num_rules);
 
 unlock:
 	if (pthread_mutex_unlock(&nat_mutex)) {
@@ -2053,7 +2890,7 @@ int ipa_nati_get_sram_size(
 
 	memset(&nat_sram_info, 0, sizeof(nat_sram_info));
 
-	ret = ioctl(nat_cache_ptr->ipa_desc->fd,
+	ret = ipa_nat_ioctl(nat_cache_ptr->ipa_desc->fd,
 				IPA_IOC_GET_NAT_IN_SRAM_INFO,
 				&nat_sram_info);
 
@@ -26,14 +26,208 @@
  * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
  * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
-#include <map>
-#include <iterator>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
 
 #include "ipa_nat_utils.h"
 
 #include "ipa_nat_map.h"
 
-static std::map<uint32_t, uint32_t> map_array[MAP_NUM_MAX];
+/*
+ * Each map is an open addressing hash table using linear probing.
+ *
+ * Slots live in one flat array, so an add, find, or delete touches a
+ * run of adjacent slots rather than chasing tree node pointers, and
+ * no allocation is done per key. Deletes shift the following entries
+ * of the probe run back into the hole, so no tombstones are needed
+ * and lookups never degrade under heavy add/delete churn.
+ *
+ * The table doubles when it becomes more than three quarters full.
+ * A clear empties the table but keeps its slots, so a map sized once
+ * for a NAT table does not allocate again for that table's lifetime.
+ */
+#define MAP_MIN_SLOTS       64
+#define MAP_MAX_LOAD(slots) (((slots) / 4) * 3)
+
+typedef struct
+{
+	uint32_t key;
+	uint32_t val;
+	uint32_t used;
+} ipa_nat_map_slot;
+
+typedef struct
+{
+	ipa_nat_map_slot* slots;
+	uint32_t          mask;
+	uint32_t          count;
+} ipa_nat_flat_map;
+
+static ipa_nat_flat_map map_array[MAP_NUM_MAX];
+
+/*
+ * Rule handles are small, mostly sequential integers. Mix all of the
+ * key's bits into the low order ones before masking, so runs of
+ * handles spread across the table rather than forming one long probe
+ * run.
+ */
+static inline uint32_t ipa_nat_map_hash(
+	uint32_t key )
+{
+	key ^= key >> 16;
+	key *= 0x85EBCA6B;
+	key ^= key >> 13;
+	key *= 0xC2B2AE35;
+	key ^= key >> 16;
+
+	return key;
+}
+
+static uint32_t ipa_nat_map_slots_for(
+	uint32_t num_keys )
+{
+	uint32_t slots = MAP_MIN_SLOTS;
+
+	while ( MAP_MAX_LOAD(slots) < num_keys && slots < 0x80000000 )
+	{
+		slots <<= 1;
+	}
+
+	return slots;
+}
+
+/*
+ * Returns the slot holding key or, when key is absent, the empty slot
+ * that ends its probe run.
+ */
+static ipa_nat_map_slot* ipa_nat_map_lookup(
+	ipa_nat_flat_map* map_ptr,
+	uint32_t          key )
+{
+	uint32_t i = ipa_nat_map_hash(key) & map_ptr->mask;
+
+	while ( map_ptr->slots[i].used && map_ptr->slots[i].key != key )
+	{
+		i = (i + 1) & map_ptr->mask;
+	}
+
+	return &map_ptr->slots[i];
+}
+
+static int ipa_nat_map_resize(
+	ipa_nat_flat_map* map_ptr,
+	uint32_t          num_slots )
+{
+	ipa_nat_flat_map  new_map;
+	ipa_nat_map_slot* slot_ptr;
+	uint32_t          i;
+
+	new_map.slots =
+		(ipa_nat_map_slot*) calloc(num_slots, sizeof(ipa_nat_map_slot));
+
+	if ( ! new_map.slots )
+	{
+		IPAERR("Unable to allocate %u map slots\n", num_slots);
+		return -1;
+	}
+
+	new_map.mask  = num_slots - 1;
+	new_map.count = map_ptr->count;
+
+	if ( map_ptr->slots )
+	{
+		for ( i = 0; i <= map_ptr->mask; i++ )
+		{
+			if ( map_ptr->slots[i].used )
+			{
+				slot_ptr  = ipa_nat_map_lookup(&new_map, map_ptr->slots[i].key);
+				*slot_ptr = map_ptr->slots[i];
+			}
+		}
+
+		free(map_ptr->slots);
+	}
+
+	*map_ptr = new_map;
+
+	return 0;
+}
+
+/*
+ * Empty the slot and close the hole by moving later entries of the
+ * same probe run back, so every remaining key stays reachable from
+ * its home slot.
+ */
+static void ipa_nat_map_remove_slot(
+	ipa_nat_flat_map* map_ptr,
+	uint32_t          hole )
+{
+	uint32_t i = hole;
+	uint32_t home;
+
+	for ( ;; )
+	{
+		i = (i + 1) & map_ptr->mask;
+
+		if ( ! map_ptr->slots[i].used )
+		{
+			break;
+		}
+
+		home = ipa_nat_map_hash(map_ptr->slots[i].key) & map_ptr->mask;
+
+		/*
+		 * The entry may move back only if its home slot does not lie
+		 * cyclically within (hole, i].
+		 */
+		if ( ((i - home) & map_ptr->mask) >= ((i - hole) & map_ptr->mask) )
+		{
+			map_ptr->slots[hole] = map_ptr->slots[i];
+			hole = i;
+		}
+	}
+
+	map_ptr->slots[hole].used = 0;
+	map_ptr->count--;
+}
+
+/******************************************************************************/
+
+int ipa_nat_map_reserve(
+	ipa_which_map which,
+	uint32_t      num_keys )
+{
+	ipa_nat_flat_map* map_ptr;
+	uint32_t          num_slots;
+
+	int ret_val = 0;
+
+	IPADBG("In\n");
+
+	if ( ! VALID_IPA_USE_MAP(which) )
+	{
+		IPAERR("Bad arg which(%u)\n", which);
+		ret_val = -1;
+		goto bail;
+	}
+
+	map_ptr   = &map_array[which];
+	num_slots = ipa_nat_map_slots_for(num_keys);
+
+	IPADBG("[%s] num_keys(%u) -> num_slots(%u)\n",
+		   ipa_which_map_as_str(which), num_keys, num_slots);
+
+	if ( ! map_ptr->slots || num_slots > map_ptr->mask + 1 )
+	{
+		ret_val = ipa_nat_map_resize(map_ptr, num_slots);
+	}
+
+bail:
+	IPADBG("Out\n");
+
+	return ret_val;
+}
 
 /******************************************************************************/
 
@@ -42,9 +236,10 @@ int ipa_nat_map_add(
 	uint32_t      key,
 	uint32_t      val )
 {
-	int ret_val = 0;
+	ipa_nat_flat_map* map_ptr;
+	ipa_nat_map_slot* slot_ptr;
 
-	std::pair<std::map<uint32_t, uint32_t>::iterator, bool> ret;
+	int ret_val = 0;
 
 	IPADBG("In\n");
 
@@ -58,15 +253,38 @@ int ipa_nat_map_add(
 	IPADBG("[%s] key(%u) -> val(%u)\n",
 		   ipa_which_map_as_str(which), key, val);
 
-	ret = map_array[which].insert(std::pair<uint32_t, uint32_t>(key, val));
+	map_ptr = &map_array[which];
 
-	if ( ret.second == false )
+	if ( ! map_ptr->slots
+		 ||
+		 map_ptr->count + 1 > MAP_MAX_LOAD(map_ptr->mask + 1) )
+	{
+		ret_val = ipa_nat_map_resize(
+			map_ptr,
+			ipa_nat_map_slots_for(map_ptr->count + 1));
+
+		if ( ret_val )
+		{
+			goto bail;
+		}
+	}
+
+	slot_ptr = ipa_nat_map_lookup(map_ptr, key);
+
+	if ( slot_ptr->used )
 	{
 		IPAERR("[%s] key(%u) already exists in map\n",
 			   ipa_which_map_as_str(which),
 			   key);
 		ret_val = -1;
 	}
+	else
+	{
+		slot_ptr->key  = key;
+		slot_ptr->val  = val;
+		slot_ptr->used = 1;
+		map_ptr->count++;
+	}
 
 bail:
 	IPADBG("Out\n");
@@ -81,9 +299,10 @@ int ipa_nat_map_find(
 	uint32_t      key,
 	uint32_t*     val_ptr )
 {
-	int ret_val = 0;
+	ipa_nat_flat_map* map_ptr;
+	ipa_nat_map_slot* slot_ptr = NULL;
 
-	std::map<uint32_t, uint32_t>::iterator it;
+	int ret_val = 0;
 
 	IPADBG("In\n");
 
@@ -97,9 +316,14 @@ int ipa_nat_map_find(
 	IPADBG("[%s] key(%u)\n",
 		   ipa_which_map_as_str(which), key);
 
-	it = map_array[which].find(key);
+	map_ptr = &map_array[which];
 
-	if ( it == map_array[which].end() )
+	if ( map_ptr->slots )
+	{
+		slot_ptr = ipa_nat_map_lookup(map_ptr, key);
+	}
+
+	if ( ! slot_ptr || ! slot_ptr->used )
 	{
 		IPAERR("[%s] key(%u) not found in map\n",
 			   ipa_which_map_as_str(which),
@@ -110,7 +334,7 @@ int ipa_nat_map_find(
 	{
 		if ( val_ptr )
 		{
-			*val_ptr = it->second;
+			*val_ptr = slot_ptr->val;
 			IPADBG("[%s] key(%u) -> val(%u)\n",
 				   ipa_which_map_as_str(which),
 				   key, *val_ptr);
@@ -130,9 +354,10 @@ int ipa_nat_map_del(
 	uint32_t      key,
 	uint32_t*     val_ptr )
 {
-	int ret_val = 0;
+	ipa_nat_flat_map* map_ptr;
+	ipa_nat_map_slot* slot_ptr = NULL;
 
-	std::map<uint32_t, uint32_t>::iterator it;
+	int ret_val = 0;
 
 	IPADBG("In\n");
 
@@ -146,9 +371,14 @@ int ipa_nat_map_del(
 	IPADBG("[%s] key(%u)\n",
 		   ipa_which_map_as_str(which), key);
 
-	it = map_array[which].find(key);
+	map_ptr = &map_array[which];
 
-	if ( it == map_array[which].end() )
+	if ( map_ptr->slots )
+	{
+		slot_ptr = ipa_nat_map_lookup(map_ptr, key);
+	}
+
+	if ( ! slot_ptr || ! slot_ptr->used )
 	{
 		IPAERR("[%s] key(%u) not found in map\n",
 			   ipa_which_map_as_str(which),
@@ -159,12 +389,12 @@ int ipa_nat_map_del(
 	{
 		if ( val_ptr )
 		{
-			*val_ptr = it->second;
+			*val_ptr = slot_ptr->val;
 			IPADBG("[%s] key(%u) -> val(%u)\n",
 				   ipa_which_map_as_str(which),
 				   key, *val_ptr);
 		}
-		map_array[which].erase(it);
+		ipa_nat_map_remove_slot(map_ptr, slot_ptr - map_ptr->slots);
 	}
 
 bail:
@@ -176,6 +406,8 @@ bail:
 int ipa_nat_map_clear(
 	ipa_which_map which )
 {
+	ipa_nat_flat_map* map_ptr;
+
 	int ret_val = 0;
 
 	IPADBG("In\n");
@@ -187,7 +419,15 @@ int ipa_nat_map_clear(
 		goto bail;
 	}
 
-	map_array[which].clear();
+	map_ptr = &map_array[which];
+
+	if ( map_ptr->slots )
+	{
+		memset(map_ptr->slots, 0,
+			   (map_ptr->mask + 1) * sizeof(ipa_nat_map_slot));
+	}
+
+	map_ptr->count = 0;
 
 bail:
 	IPADBG("Out\n");
@@ -195,10 +435,19 @@ bail:
 	return ret_val;
 }
 
+static bool ipa_nat_map_slot_lt(
+	const ipa_nat_map_slot& a,
+	const ipa_nat_map_slot& b )
+{
+	return a.key < b.key;
+}
+
 int ipa_nat_map_dump(
 	ipa_which_map which )
 {
-	std::map<uint32_t, uint32_t>::iterator it;
+	ipa_nat_flat_map* map_ptr;
+	ipa_nat_map_slot* sorted = NULL;
+	uint32_t          i, cnt;
 
 	int ret_val = 0;
 
@@ -211,19 +460,49 @@ int ipa_nat_map_dump(
 		goto bail;
 	}
 
+	map_ptr = &map_array[which];
+
 	printf("Dumping: %s\n", ipa_which_map_as_str(which));
 
-	for ( it  = map_array[which].begin();
-		  it != map_array[which].end();
-		  it++ )
+	if ( ! map_ptr->count )
+	{
+		goto bail;
+	}
+
+	/*
+	 * Dump in key order, as callers comparing dumps expect...
+	 */
+	sorted = (ipa_nat_map_slot*)
+		malloc(map_ptr->count * sizeof(ipa_nat_map_slot));
+
+	if ( ! sorted )
+	{
+		IPAERR("Unable to allocate dump buffer\n");
+		ret_val = -1;
+		goto bail;
+	}
+
+	for ( i = cnt = 0; i <= map_ptr->mask; i++ )
+	{
+		if ( map_ptr->slots[i].used )
+		{
+			sorted[cnt++] = map_ptr->slots[i];
+		}
+	}
+
+	std::sort(sorted, sorted + cnt, ipa_nat_map_slot_lt);
+
+	for ( i = 0; i < cnt; i++ )
 	{
 		printf("  Key[%u|0x%08X] -> Value[%u|0x%08X]\n",
-			   it->first,
-			   it->first,
-			   it->second,
-			   it->second);
+			   sorted[i].key,
+			   sorted[i].key,
+			   sorted[i].val,
+			   sorted[i].val);
 	}
 
+	free(sorted);
+
 bail:
 	IPADBG("Out\n");
 
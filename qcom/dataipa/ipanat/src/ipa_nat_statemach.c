@@ -434,6 +434,77 @@ int ipa_nati_del_ipv4_rule(
 	return ret;
 }
 
+int ipa_nati_add_ipv4_rules(
+	uint32_t                 tbl_hdl,
+	const ipa_nat_ipv4_rule* clnt_rules,
+	uint32_t                 num_rules,
+	uint32_t*                rule_hdls,
+	uint32_t*                num_added )
+{
+	arb_t* args[] = {
+		(arb_t*)(arb_t)tbl_hdl,
+		(arb_t*) clnt_rules,
+		(arb_t*)(arb_t)num_rules,
+		(arb_t*) rule_hdls,
+		(arb_t*) num_added,
+	};
+
+	int ret;
+
+	IPADBG("In\n");
+
+	*num_added = 0;
+
+	ret = ipa_nati_statemach(&nati_obj, NATI_TRIG_ADD_RULES, args);
+
+	/*
+	 * The count is what tells of a failure part way through...
+	 */
+	if ( ret == 0 && *num_added != num_rules )
+	{
+		ret = -EIO;
+	}
+
+	IPADBG("num_added(%u) of num_rules(%u)\n", *num_added, num_rules);
+
+	IPADBG("Out\n");
+
+	return ret;
+}
+
+int ipa_nati_del_ipv4_rules(
+	uint32_t        tbl_hdl,
+	const uint32_t* rule_hdls,
+	uint32_t        num_rules,
+	uint32_t*       num_deleted )
+{
+	arb_t* args[] = {
+		(arb_t*)(arb_t)tbl_hdl,
+		(arb_t*) rule_hdls,
+		(arb_t*)(arb_t)num_rules,
+		(arb_t*) num_deleted,
+	};
+
+	int ret;
+
+	IPADBG("In\n");
+
+	*num_deleted = 0;
+
+	ret = ipa_nati_statemach(&nati_obj, NATI_TRIG_DEL_RULES, args);
+
+	if ( ret == 0 && *num_deleted != num_rules )
+	{
+		ret = -EIO;
+	}
+
+	IPADBG("num_deleted(%u) of num_rules(%u)\n", *num_deleted, num_rules);
+
+	IPADBG("Out\n");
+
+	return ret;
+}
+
 int ipa_nati_query_timestamp(
 	uint32_t  tbl_hdl,
 	uint32_t  rule_hdl,
@@ -1151,6 +1222,17 @@ static int _smAddSramAndDdrTbl(
 
 			if ( ret == 0 )
 			{
+				/*
+				 * Rules migrate between the two tables via the maps,
+				 * so size them up front to avoid rehashing while
+				 * rules are being added. Maps grow on demand, so a
+				 * failure here is not fatal...
+				 */
+				ipa_nat_map_reserve(nati_obj_ptr->map_pairs[SRAM_SUB].orig2new_map, number_of_entries);
+				ipa_nat_map_reserve(nati_obj_ptr->map_pairs[SRAM_SUB].new2orig_map, number_of_entries);
+				ipa_nat_map_reserve(nati_obj_ptr->map_pairs[DDR_SUB].orig2new_map,  number_of_entries);
+				ipa_nat_map_reserve(nati_obj_ptr->map_pairs[DDR_SUB].new2orig_map,  number_of_entries);
+
 				/*
 				 * The following will tell the IPA to change focus to
 				 * SRAM...
@@ -1912,6 +1994,249 @@ static int _smDelRuleHybrid(
 	return ret;
 }
 
+/******************************************************************************/
+/*
+ * FUNCTION: _smAddRulesToTbl
+ *
+ * PARAMS:
+ *
+ *   nati_obj_ptr (IN) A pointer to an initialized nati object
+ *
+ *   trigger      (IN) The trigger to run through the state machine
+ *
+ *   arb_data_ptr (IN) Whatever you like
+ *
+ * DESCRIPTION:
+ *
+ *   The following will cause the addtion of a batch of NAT rules
+ *   into the table, with their table updates coalesced into as few
+ *   dma commands as possible.
+ *
+ * RETURNS:
+ *
+ *   zero on success, otherwise non-zero
+ */
+static int _smAddRulesToTbl(
+	ipa_nati_obj*    nati_obj_ptr,
+	ipa_nati_trigger trigger,
+	arb_t*           arb_data_ptr )
+{
+	arb_t** args = arb_data_ptr;
+
+	uint32_t           tbl_hdl    = (uint32_t)           args[0];
+	ipa_nat_ipv4_rule* clnt_rules = (ipa_nat_ipv4_rule*) args[1];
+	uint32_t           num_rules  = (uint32_t)           args[2];
+	uint32_t*          rule_hdls  = (uint32_t*)          args[3];
+	uint32_t*          num_added  = (uint32_t*)          args[4];
+
+	uint32_t* cnt_ptr;
+	uint32_t  i;
+
+	int ret;
+
+	IPADBG("In\n");
+
+	IPADBG("tbl_hdl(0x%08X) clnt_rules_ptr(%p) num_rules(%u)\n",
+		   tbl_hdl, clnt_rules, num_rules);
+
+	for ( i = 0; i < num_rules; i++ )
+	{
+		clnt_rules[i].redirect = clnt_rules[i].enable = clnt_rules[i].time_stamp = 0;
+	}
+
+	ret = ipa_NATI_add_ipv4_rules(
+		tbl_hdl, clnt_rules, num_rules, rule_hdls, num_added);
+
+	cnt_ptr = CHOOSE_CNTR();
+
+	(*cnt_ptr) += *num_added;
+
+	IPADBG("Out\n");
+
+	return ret;
+}
+
+/******************************************************************************/
+/*
+ * FUNCTION: _smDelRulesFromTbl
+ *
+ * PARAMS:
+ *
+ *   nati_obj_ptr (IN) A pointer to an initialized nati object
+ *
+ *   trigger      (IN) The trigger to run through the state machine
+ *
+ *   arb_data_ptr (IN) Whatever you like
+ *
+ * DESCRIPTION:
+ *
+ *   The following will cause the deletion of a batch of NAT rules
+ *   from the table, with their table updates coalesced into as few
+ *   dma commands as possible.
+ *
+ * RETURNS:
+ *
+ *   zero on success, otherwise non-zero
+ */
+static int _smDelRulesFromTbl(
+	ipa_nati_obj*    nati_obj_ptr,
+	ipa_nati_trigger trigger,
+	arb_t*           arb_data_ptr )
+{
+	arb_t** args = arb_data_ptr;
+
+	uint32_t  tbl_hdl     = (uint32_t)  args[0];
+	uint32_t* rule_hdls   = (uint32_t*) args[1];
+	uint32_t  num_rules   = (uint32_t)  args[2];
+	uint32_t* num_deleted = (uint32_t*) args[3];
+
+	uint32_t* cnt_ptr;
+
+	int ret;
+
+	IPADBG("In\n");
+
+	IPADBG("tbl_hdl(0x%08X) rule_hdls_ptr(%p) num_rules(%u)\n",
+		   tbl_hdl, rule_hdls, num_rules);
+
+	ret = ipa_NATI_del_ipv4_rules(
+		tbl_hdl, rule_hdls, num_rules, num_deleted);
+
+	cnt_ptr = CHOOSE_CNTR();
+
+	(*cnt_ptr) -= *num_deleted;
+
+	IPADBG("Out\n");
+
+	return ret;
+}
+
+/******************************************************************************/
+/*
+ * FUNCTION: _smAddRulesHybrid
+ *
+ * PARAMS:
+ *
+ *   nati_obj_ptr (IN) A pointer to an initialized nati object
+ *
+ *   trigger      (IN) The trigger to run through the state machine
+ *
+ *   arb_data_ptr (IN) Whatever you like
+ *
+ * DESCRIPTION:
+ *
+ *   The following will cause the addition of a batch of NAT rules
+ *   into either the SRAM or DDR based table.
+ *
+ *   Any rule in the batch can be the one that fills SRAM and causes
+ *   a table switch, hence the rules are added one at a time.
+ *
+ * RETURNS:
+ *
+ *   zero on success, otherwise non-zero
+ */
+static int _smAddRulesHybrid(
+	ipa_nati_obj*    nati_obj_ptr,
+	ipa_nati_trigger trigger,
+	arb_t*           arb_data_ptr )
+{
+	arb_t** args = arb_data_ptr;
+
+	uint32_t           tbl_hdl    = (uint32_t)           args[0];
+	ipa_nat_ipv4_rule* clnt_rules = (ipa_nat_ipv4_rule*) args[1];
+	uint32_t           num_rules  = (uint32_t)           args[2];
+	uint32_t*          rule_hdls  = (uint32_t*)          args[3];
+	uint32_t*          num_added  = (uint32_t*)          args[4];
+
+	uint32_t i;
+
+	int ret = 0;
+
+	IPADBG("In\n");
+
+	for ( i = 0; i < num_rules && ret == 0; i++ )
+	{
+		arb_t* rule_args[] = {
+			(arb_t*)(arb_t)tbl_hdl,
+			(arb_t*) &clnt_rules[i],
+			(arb_t*) &rule_hdls[i],
+		};
+
+		ret = _smAddRuleHybrid(nati_obj_ptr, NATI_TRIG_ADD_RULE, rule_args);
+
+		if ( ret == 0 )
+		{
+			(*num_added)++;
+		}
+	}
+
+	IPADBG("Out\n");
+
+	return ret;
+}
+
+/******************************************************************************/
+/*
+ * FUNCTION: _smDelRulesHybrid
+ *
+ * PARAMS:
+ *
+ *   nati_obj_ptr (IN) A pointer to an initialized nati object
+ *
+ *   trigger      (IN) The trigger to run through the state machine
+ *
+ *   arb_data_ptr (IN) Whatever you like
+ *
+ * DESCRIPTION:
+ *
+ *   The following will cause the deletion of a batch of NAT rules
+ *   from either the SRAM or DDR based table.
+ *
+ *   Any rule in the batch can be the one that causes a switch back
+ *   to SRAM, hence the rules are deleted one at a time.
+ *
+ * RETURNS:
+ *
+ *   zero on success, otherwise non-zero
+ */
+static int _smDelRulesHybrid(
+	ipa_nati_obj*    nati_obj_ptr,
+	ipa_nati_trigger trigger,
+	arb_t*           arb_data_ptr )
+{
+	arb_t** args = arb_data_ptr;
+
+	uint32_t  tbl_hdl     = (uint32_t)  args[0];
+	uint32_t* rule_hdls   = (uint32_t*) args[1];
+	uint32_t  num_rules   = (uint32_t)  args[2];
+	uint32_t* num_deleted = (uint32_t*) args[3];
+
+	uint32_t i;
+
+	int ret = 0;
+
+	IPADBG("In\n");
+
+	for ( i = 0; i < num_rules && ret == 0; i++ )
+	{
+		arb_t* rule_args[] = {
+			(arb_t*)(arb_t)tbl_hdl,
+			(arb_t*)(arb_t)rule_hdls[i],
+		};
+
+		ret = _smDelRuleHybrid(nati_obj_ptr, NATI_TRIG_DEL_RULE, rule_args);
+
+		if ( ret == 0 )
+		{
+			(*num_deleted)++;
+		}
+	}
+
+	IPADBG("Out\n");
+
+	return ret;
+}
+
 /******************************************************************************/
 /*
  * FUNCTION: _smGoToDdr
@@ -2468,6 +2793,8 @@ _state_mach_tbl[NATI_STATE_LAST+1][NATI_TRIG_LAST+1] =
 		SM_ROW( NATI_STATE_NULL,       NATI_TRIG_GOTO_DDR,   _smUndef ),
 		SM_ROW( NATI_STATE_NULL,       NATI_TRIG_GOTO_SRAM,  _smUndef ),
 		SM_ROW( NATI_STATE_NULL,       NATI_TRIG_GET_TSTAMP, _smUndef ),
+		SM_ROW( NATI_STATE_NULL,       NATI_TRIG_ADD_RULES,  _smUndef ),
+		SM_ROW( NATI_STATE_NULL,       NATI_TRIG_DEL_RULES,  _smUndef ),
 		SM_ROW( NATI_STATE_NULL,       NATI_TRIG_LAST,       _smUndef ),
 	},
 
@@ -2484,6 +2811,8 @@ _state_mach_tbl[NATI_STATE_LAST+1][NATI_TRIG_LAST+1] =
 		SM_ROW( NATI_STATE_DDR_ONLY,   NATI_TRIG_GOTO_DDR,   _smUndef ),
 		SM_ROW( NATI_STATE_DDR_ONLY,   NATI_TRIG_GOTO_SRAM,  _smUndef ),
 		SM_ROW( NATI_STATE_DDR_ONLY,   NATI_TRIG_GET_TSTAMP, _smGetTmStmp ),
+		SM_ROW( NATI_STATE_DDR_ONLY,   NATI_TRIG_ADD_RULES,  _smAddRulesToTbl ),
+		SM_ROW( NATI_STATE_DDR_ONLY,   NATI_TRIG_DEL_RULES,  _smDelRulesFromTbl ),
 		SM_ROW( NATI_STATE_DDR_ONLY,   NATI_TRIG_LAST,       _smUndef ),
 	},
 
@@ -2500,6 +2829,8 @@ _state_mach_tbl[NATI_STATE_LAST+1][NATI_TRIG_LAST+1] =
 		SM_ROW( NATI_STATE_SRAM_ONLY,  NATI_TRIG_GOTO_DDR,   _smUndef ),
 		SM_ROW( NATI_STATE_SRAM_ONLY,  NATI_TRIG_GOTO_SRAM,  _smUndef ),
 		SM_ROW( NATI_STATE_SRAM_ONLY,  NATI_TRIG_GET_TSTAMP, _smGetTmStmp ),
+		SM_ROW( NATI_STATE_SRAM_ONLY,  NATI_TRIG_ADD_RULES,  _smAddRulesToTbl ),
+		SM_ROW( NATI_STATE_SRAM_ONLY,  NATI_TRIG_DEL_RULES,  _smDelRulesFromTbl ),
 		SM_ROW( NATI_STATE_SRAM_ONLY,  NATI_TRIG_LAST,       _smUndef ),
 	},
 
@@ -2516,6 +2847,8 @@ _state_mach_tbl[NATI_STATE_LAST+1][NATI_TRIG_LAST+1] =
 		SM_ROW( NATI_STATE_HYBRID,     NATI_TRIG_GOTO_DDR,   _smGoToDdr ),
 		SM_ROW( NATI_STATE_HYBRID,     NATI_TRIG_GOTO_SRAM,  _smGoToSram ),
 		SM_ROW( NATI_STATE_HYBRID,     NATI_TRIG_GET_TSTAMP, _smGetTmStmpHybrid ),
+		SM_ROW( NATI_STATE_HYBRID,     NATI_TRIG_ADD_RULES,  _smAddRulesHybrid ),
+		SM_ROW( NATI_STATE_HYBRID,     NATI_TRIG_DEL_RULES,  _smDelRulesHybrid ),
 		SM_ROW( NATI_STATE_HYBRID,     NATI_TRIG_LAST,       _smUndef ),
 	},
 
@@ -2532,6 +2865,8 @@ _state_mach_tbl[NATI_STATE_LAST+1][NATI_TRIG_LAST+1] =
 		SM_ROW( NATI_STATE_HYBRID_DDR, NATI_TRIG_GOTO_DDR,   _smGoToDdr ),
 		SM_ROW( NATI_STATE_HYBRID_DDR, NATI_TRIG_GOTO_SRAM,  _smGoToSram ),
 		SM_ROW( NATI_STATE_HYBRID_DDR, NATI_TRIG_GET_TSTAMP, _smGetTmStmpHybrid ),
+		SM_ROW( NATI_STATE_HYBRID_DDR, NATI_TRIG_ADD_RULES,  _smAddRulesHybrid ),
+		SM_ROW( NATI_STATE_HYBRID_DDR, NATI_TRIG_DEL_RULES,  _smDelRulesHybrid ),
 		SM_ROW( NATI_STATE_HYBRID_DDR, NATI_TRIG_LAST,       _smUndef ),
 	},
 
@@ -2548,6 +2883,8 @@ _state_mach_tbl[NATI_STATE_LAST+1][NATI_TRIG_LAST+1] =
 		SM_ROW( NATI_STATE_LAST,       NATI_TRIG_GOTO_DDR,   _smUndef ),
 		SM_ROW( NATI_STATE_LAST,       NATI_TRIG_GOTO_SRAM,  _smUndef ),
 		SM_ROW( NATI_STATE_LAST,       NATI_TRIG_GET_TSTAMP, _smUndef ),
+		SM_ROW( NATI_STATE_LAST,       NATI_TRIG_ADD_RULES,  _smUndef ),
+		SM_ROW( NATI_STATE_LAST,       NATI_TRIG_DEL_RULES,  _smUndef ),
 		SM_ROW( NATI_STATE_LAST,       NATI_TRIG_LAST,       _smUndef ),
 	},
 };
@@ -27,6 +27,7 @@
  * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include "ipa_nat_utils.h"
+#include "ipa_table.h"
 #include <sys/ioctl.h>
 #include <errno.h>
 #include <fcntl.h>
@@ -37,6 +38,8 @@
 
 static char dbg_buff[IPA_MAX_MSG_LEN];
 
+static bool host_mem_mode;
+
 #if !defined(MSM_IPA_TESTS) && !defined(USE_GLIB) && !defined(FEATURE_IPA_ANDROID)
 size_t strlcpy(char* dst, const char* src, size_t size)
 {
@@ -69,15 +72,18 @@ ipa_descriptor* ipa_descriptor_open(void)
 		goto bail;
 	}
 
-	desc_ptr->fd = open(IPA_DEV_NAME, O_RDONLY);
+	/*
+	 * In host memory mode, there is no device to open...
+	 */
+	desc_ptr->fd = ( host_mem_mode ) ? -1 : open(IPA_DEV_NAME, O_RDONLY);
 
-	if (desc_ptr->fd < 0)
+	if (desc_ptr->fd < 0 && ! host_mem_mode)
 	{
 		IPAERR("Unable to open ipa device\n");
 		goto free;
 	}
 
-	res = ioctl(desc_ptr->fd, IPA_IOC_GET_HW_VERSION, &desc_ptr->ver);
+	res = ipa_nat_ioctl(desc_ptr->fd, IPA_IOC_GET_HW_VERSION, &desc_ptr->ver);
 
 	if (res == 0)
 	{
@@ -213,3 +219,236 @@ int currTimeAs(
 bail:
 	return ret;
 }
+
+/*
+ * ----------------------------------------------------------------------------
+ * Host memory mode and ioctl funnel
+ * ----------------------------------------------------------------------------
+ */
+#define IPA_HOST_MEM_MAX_REGIONS 2
+
+typedef struct
+{
+	char   name[IPA_RESOURCE_NAME_MAX];
+	void*  addr;
+	size_t size;
+} ipa_host_mem_region;
+
+static ipa_host_mem_region host_mem_regions[IPA_HOST_MEM_MAX_REGIONS];
+
+/*
+ * Offsets, into the NAT region, of the tables addressed by
+ * IPA_NAT_BASE_TBL through IPA_NAT_INDEX_EXPN_TBL. Set by the v4 init
+ * command...
+ */
+static uint32_t host_nat_tbl_offsets[4];
+
+static uint64_t dma_cmd_cnt;
+static uint64_t dma_entry_cnt;
+
+void ipa_nat_set_host_mem_mode(
+	bool enable )
+{
+	host_mem_mode = enable;
+}
+
+bool ipa_nat_in_host_mem_mode(void)
+{
+	return host_mem_mode;
+}
+
+void* ipa_nat_host_mem_alloc(
+	const char* name,
+	size_t      size )
+{
+	uint32_t i;
+
+	for ( i = 0; i < IPA_HOST_MEM_MAX_REGIONS; i++ )
+	{
+		if ( host_mem_regions[i].addr == NULL )
+		{
+			host_mem_regions[i].addr = calloc(1, size);
+
+			if ( host_mem_regions[i].addr )
+			{
+				strlcpy(host_mem_regions[i].name, name, IPA_RESOURCE_NAME_MAX);
+				host_mem_regions[i].size = size;
+			}
+
+			return host_mem_regions[i].addr;
+		}
+	}
+
+	IPAERR("No free host memory region for %s\n", name);
+
+	return NULL;
+}
+
+void ipa_nat_host_mem_free(
+	void* addr )
+{
+	uint32_t i;
+
+	for ( i = 0; i < IPA_HOST_MEM_MAX_REGIONS; i++ )
+	{
+		if ( addr && host_mem_regions[i].addr == addr )
+		{
+			free(addr);
+			memset(&host_mem_regions[i], 0, sizeof(host_mem_regions[i]));
+		}
+	}
+}
+
+static ipa_host_mem_region* host_mem_find(
+	const char* name )
+{
+	uint32_t i;
+
+	for ( i = 0; i < IPA_HOST_MEM_MAX_REGIONS; i++ )
+	{
+		if ( host_mem_regions[i].addr &&
+			 ! strcmp(host_mem_regions[i].name, name) )
+		{
+			return &host_mem_regions[i];
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Do what the IPA would do with a table DMA command: write each
+ * entry's 16 bit datum at its offset into the addressed table.
+ */
+static int host_table_dma_cmd(
+	struct ipa_ioc_nat_dma_cmd* cmd )
+{
+	ipa_host_mem_region* region = host_mem_find(IPA_NAT_DEV_NAME);
+	uint64_t             off;
+	uint32_t             i;
+
+	if ( ! region )
+	{
+		IPAERR("No NAT table in host memory\n");
+		return -1;
+	}
+
+	for ( i = 0; i < cmd->entries; i++ )
+	{
+		if ( cmd->dma[i].table_index != 0 ||
+			 cmd->dma[i].base_addr > IPA_NAT_INDEX_EXPN_TBL )
+		{
+			IPAERR("Unsupported table_index(%u) base_addr(%u)\n",
+				   cmd->dma[i].table_index, cmd->dma[i].base_addr);
+			return -1;
+		}
+
+		off =
+			(uint64_t) host_nat_tbl_offsets[cmd->dma[i].base_addr] +
+			cmd->dma[i].offset;
+
+		if ( off + sizeof(uint16_t) > region->size )
+		{
+			IPAERR("Offset(0x%08X) beyond table\n", cmd->dma[i].offset);
+			return -1;
+		}
+
+		memcpy((uint8_t*) region->addr + off,
+			   &cmd->dma[i].data,
+			   sizeof(uint16_t));
+	}
+
+	return 0;
+}
+
+static int host_ioctl(
+	int           fd,
+	unsigned long req,
+	void*         arg )
+{
+	struct ipa_ioc_v4_nat_init* init_ptr;
+
+	switch ( req )
+	{
+	case IPA_IOC_GET_HW_VERSION:
+		*(enum ipa_hw_type*) arg = IPA_HW_v4_5;
+		return 0;
+
+	case IPA_IOC_ALLOC_NAT_TABLE:
+		((struct ipa_ioc_nat_ipv6ct_table_alloc*) arg)->offset = 0;
+		return 0;
+
+	case IPA_IOC_V4_INIT_NAT:
+		init_ptr = (struct ipa_ioc_v4_nat_init*) arg;
+		host_nat_tbl_offsets[IPA_NAT_BASE_TBL]       = init_ptr->ipv4_rules_offset;
+		host_nat_tbl_offsets[IPA_NAT_EXPN_TBL]       = init_ptr->expn_rules_offset;
+		host_nat_tbl_offsets[IPA_NAT_INDX_TBL]       = init_ptr->index_offset;
+		host_nat_tbl_offsets[IPA_NAT_INDEX_EXPN_TBL] = init_ptr->index_expn_offset;
+		return 0;
+
+	case IPA_IOC_DEL_NAT_TABLE:
+	case IPA_IOC_NAT_MODIFY_PDN:
+		return 0;
+
+	case IPA_IOC_TABLE_DMA_CMD:
+		return host_table_dma_cmd((struct ipa_ioc_nat_dma_cmd*) arg);
+
+	default:
+		/*
+		 * Including IPA_IOC_GET_NAT_IN_SRAM_INFO: there is no SRAM...
+		 */
+		errno = ENOTTY;
+		return -1;
+	}
+}
+
+int ipa_nat_ioctl(
+	int           fd,
+	unsigned long req,
+	void*         arg )
+{
+	struct ipa_ioc_nat_dma_cmd* cmd_ptr;
+
+	if ( req == IPA_IOC_TABLE_DMA_CMD )
+	{
+		cmd_ptr = (struct ipa_ioc_nat_dma_cmd*) arg;
+
+		/*
+		 * Mirror the kernel's limit (IPA_SEND_MAX_DESC less the two
+		 * descriptors it adds), and the error it returns, so that
+		 * batching problems show up in host memory mode too...
+		 */
+		if ( host_mem_mode &&
+			 ( cmd_ptr->entries == 0 ||
+			   cmd_ptr->entries > IPA_DMA_ENTRIES_BATCH_MAX ) )
+		{
+			errno = EFAULT;
+			return -1;
+		}
+
+		dma_cmd_cnt++;
+		dma_entry_cnt += cmd_ptr->entries;
+	}
+
+	if ( host_mem_mode )
+	{
+		return host_ioctl(fd, req, arg);
+	}
+
+	return ioctl(fd, req, arg);
+}
+
+void ipa_nat_get_dma_cmd_stats(
+	uint64_t* cmds_ptr,
+	uint64_t* entries_ptr )
+{
+	if ( cmds_ptr )
+	{
+		*cmds_ptr = dma_cmd_cnt;
+	}
+
+	if ( entries_ptr )
+	{
+		*entries_ptr = dma_entry_cnt;
+	}
+}
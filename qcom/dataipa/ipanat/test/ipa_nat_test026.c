@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of The Linux Foundation nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*=========================================================================*/
+/*!
+	@file
+	ipa_nat_test026.c
+
+	@brief
+	Verify the following scenario:
+	1. Fill a rule handle map with many live keys
+	2. Churn it with random deletes, adds, and finds, checking
+	   every value returned
+	3. Report the add/find/delete rate achieved
+*/
+/*===========================================================================*/
+
+#include "ipa_nat_test.h"
+#include "ipa_nat_map.h"
+
+#define CHURN_LIVE_KEYS  (128 * 1024)
+#define CHURN_ROUNDS     (1024 * 1024)
+
+int ipa_nat_test026(
+	const char* nat_mem_type,
+	u32 pub_ip_add,
+	int total_entries,
+	u32 tbl_hdl,
+	int sep,
+	void* arb_data_ptr)
+{
+	u32*     keys;
+	u32      next_key = 1;
+	u32      i, j, val;
+	uint64_t start, stop, ops;
+
+	int ret = 0;
+
+	IPADBG("In\n");
+
+	keys = malloc(CHURN_LIVE_KEYS * sizeof(u32));
+
+	if ( ! keys )
+	{
+		IPAERR("Unable to allocate key array\n");
+		return -1;
+	}
+
+	ipa_nat_map_clear(MAP_NUM_99);
+
+	currTimeAs(TimeAsNanSecs, &start);
+
+	/*
+	 * Rule handles are handed out roughly in sequence, so mimic that
+	 * when filling the map...
+	 */
+	for ( i = 0; i < CHURN_LIVE_KEYS && ret == 0; i++ )
+	{
+		keys[i] = next_key++;
+		ret = ipa_nat_map_add(MAP_NUM_99, keys[i], i);
+	}
+
+	ops = i;
+
+	/*
+	 * Now replace random connections while looking up random live
+	 * ones, as the connection tracking daemon does...
+	 */
+	for ( i = 0; i < CHURN_ROUNDS && ret == 0; i++ )
+	{
+		j = rand() % CHURN_LIVE_KEYS;
+
+		ret = ipa_nat_map_del(MAP_NUM_99, keys[j], &val);
+
+		if ( ret == 0 && val != j )
+		{
+			IPAERR("del key(%u) returned val(%u), expected (%u)\n",
+				   keys[j], val, j);
+			ret = -1;
+		}
+
+		if ( ret == 0 )
+		{
+			keys[j] = next_key++;
+			ret = ipa_nat_map_add(MAP_NUM_99, keys[j], j);
+		}
+
+		if ( ret == 0 )
+		{
+			j = rand() % CHURN_LIVE_KEYS;
+
+			ret = ipa_nat_map_find(MAP_NUM_99, keys[j], &val);
+
+			if ( ret == 0 && val != j )
+			{
+				IPAERR("find key(%u) returned val(%u), expected (%u)\n",
+					   keys[j], val, j);
+				ret = -1;
+			}
+		}
+
+		ops += 3;
+	}
+
+	currTimeAs(TimeAsNanSecs, &stop);
+
+	/*
+	 * Finally, make sure every live key is still reachable...
+	 */
+	for ( i = 0; i < CHURN_LIVE_KEYS && ret == 0; i++ )
+	{
+		ret = ipa_nat_map_find(MAP_NUM_99, keys[i], &val);
+
+		if ( ret == 0 && val != i )
+		{
+			IPAERR("final find key(%u) returned val(%u), expected (%u)\n",
+				   keys[i], val, i);
+			ret = -1;
+		}
+	}
+
+	ipa_nat_map_clear(MAP_NUM_99);
+
+	free(keys);
+
+	CHECK_ERR(ret);
+
+	IPAINFO("Map churn: %llu ops with %u live keys in %llu usecs, %llu ops/sec\n",
+			(unsigned long long) ops,
+			CHURN_LIVE_KEYS,
+			(unsigned long long) ((stop - start) / 1000),
+			(unsigned long long)
+			((stop > start) ? (ops * 1000000000ULL) / (stop - start) : 0));
+
+	IPADBG("Out\n");
+
+	return 0;
+}
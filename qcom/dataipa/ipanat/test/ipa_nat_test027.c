@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of The Linux Foundation nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*=========================================================================*/
+/*!
+	@file
+	ipa_nat_test027.c
+
+	@brief
+	Verify the following scenario:
+	1. Add ipv4 table
+	2. Add, then delete, a set of rules one rule at a time
+	3. Add, then delete, the same rules as one batch
+	4. Check the table after each step, and report the table dma
+	   commands posted and the time taken by each approach
+	5. Delete ipv4 table
+*/
+/*=========================================================================*/
+
+#include "ipa_nat_test.h"
+
+/*
+ * A table validation failure leaves ret alone, hence...
+ */
+#define FAIL_TO(lbl) \
+	{ ret = (ret) ? ret : -1; goto lbl; }
+
+static u32 filled_ents(
+	u32 tbl_hdl )
+{
+	ipa_nati_tbl_stats nstats, istats;
+
+	if ( ipa_nati_ipv4_tbl_stats(tbl_hdl, &nstats, &istats) )
+	{
+		return (u32) -1;
+	}
+
+	return nstats.tot_base_ents_filled + nstats.tot_expn_ents_filled;
+}
+
+int ipa_nat_test027(
+	const char* nat_mem_type,
+	u32 pub_ip_add,
+	int total_entries,
+	u32 tbl_hdl,
+	int sep,
+	void* arb_data_ptr)
+{
+	int* tbl_hdl_ptr = (int*) arb_data_ptr;
+
+	ipa_nat_ipv4_rule* rules;
+	u32*               rule_hdls;
+	u32                num_rules = total_entries / 2;
+	u32                i, num_done, ents_before, ents_mid;
+
+	uint64_t start, stop;
+	uint64_t cmds[3], entries[3], usecs[4];
+
+	int ret;
+
+	IPADBG("In\n");
+
+	rules     = calloc(num_rules, sizeof(ipa_nat_ipv4_rule));
+	rule_hdls = calloc(num_rules, sizeof(u32));
+
+	if ( ! rules || ! rule_hdls )
+	{
+		IPAERR("Unable to allocate rule arrays\n");
+		free(rules);
+		free(rule_hdls);
+		return -1;
+	}
+
+	for ( i = 0; i < num_rules; i++ )
+	{
+		rules[i].target_ip    = RAN_ADDR;
+		rules[i].target_port  = RAN_PORT;
+		rules[i].private_ip   = RAN_ADDR;
+		rules[i].private_port = RAN_PORT;
+		rules[i].protocol     = IPPROTO_TCP;
+		rules[i].public_port  = RAN_PORT;
+	}
+
+	if ( sep )
+	{
+		ret = ipa_nat_add_ipv4_tbl(pub_ip_add, nat_mem_type, total_entries, &tbl_hdl);
+		CHECK_ERR_TBL_ACTION(ret, tbl_hdl, FAIL_TO(bail));
+	}
+
+	ents_before = filled_ents(tbl_hdl);
+
+	/*
+	 * One rule at a time...
+	 */
+	ipa_nat_get_dma_cmd_stats(&cmds[0], &entries[0]);
+
+	currTimeAs(TimeAsMicSecs, &start);
+
+	for ( i = 0, ret = 0; i < num_rules && ret == 0; i++ )
+	{
+		ret = ipa_nat_add_ipv4_rule(tbl_hdl, &rules[i], &rule_hdls[i]);
+	}
+
+	currTimeAs(TimeAsMicSecs, &stop);
+
+	usecs[0] = stop - start;
+
+	CHECK_ERR_TBL_ACTION(ret, tbl_hdl, FAIL_TO(del_tbl));
+
+	currTimeAs(TimeAsMicSecs, &start);
+
+	for ( i = 0; i < num_rules && ret == 0; i++ )
+	{
+		ret = ipa_nat_del_ipv4_rule(tbl_hdl, rule_hdls[i]);
+	}
+
+	currTimeAs(TimeAsMicSecs, &stop);
+
+	usecs[1] = stop - start;
+
+	CHECK_ERR_TBL_ACTION(ret, tbl_hdl, FAIL_TO(del_tbl));
+
+	/*
+	 * Now the same rules as one batch...
+	 */
+	ents_mid = filled_ents(tbl_hdl);
+
+	ipa_nat_get_dma_cmd_stats(&cmds[1], &entries[1]);
+
+	currTimeAs(TimeAsMicSecs, &start);
+
+	ret = ipa_nat_add_ipv4_rules(tbl_hdl, rules, num_rules, rule_hdls, &num_done);
+
+	currTimeAs(TimeAsMicSecs, &stop);
+
+	usecs[2] = stop - start;
+
+	CHECK_ERR_TBL_ACTION(ret, tbl_hdl, FAIL_TO(del_tbl));
+
+	if ( num_done != num_rules ||
+		 filled_ents(tbl_hdl) != ents_mid + num_rules )
+	{
+		IPAERR("Batch add: num_done(%u) entries(%u), expected (%u) (%u)\n",
+			   num_done, filled_ents(tbl_hdl),
+			   num_rules, ents_mid + num_rules);
+		ret = -1;
+		goto del_tbl;
+	}
+
+	currTimeAs(TimeAsMicSecs, &start);
+
+	ret = ipa_nat_del_ipv4_rules(tbl_hdl, rule_hdls, num_rules, &num_done);
+
+	currTimeAs(TimeAsMicSecs, &stop);
+
+	usecs[3] = stop - start;
+
+	CHECK_ERR_TBL_ACTION(ret, tbl_hdl, FAIL_TO(del_tbl));
+
+	/*
+	 * A deleted chain head lingers while other tests' rules hang off
+	 * it, so only an initially empty table must end up empty...
+	 */
+	if ( num_done != num_rules ||
+		 ( ents_before == 0 && filled_ents(tbl_hdl) != 0 ) )
+	{
+		IPAERR("Batch delete: num_done(%u) entries(%u), expected (%u) (%u)\n",
+			   num_done, filled_ents(tbl_hdl), num_rules, ents_before);
+		ret = -1;
+		goto del_tbl;
+	}
+
+	ipa_nat_get_dma_cmd_stats(&cmds[2], &entries[2]);
+
+	IPAINFO("%u rules one at a time: %llu dma cmds (%llu entries), "
+			"add %llu usecs, delete %llu usecs\n",
+			num_rules,
+			(unsigned long long) (cmds[1] - cmds[0]),
+			(unsigned long long) (entries[1] - entries[0]),
+			(unsigned long long) usecs[0],
+			(unsigned long long) usecs[1]);
+
+	IPAINFO("%u rules batched:        %llu dma cmds (%llu entries), "
+			"add %llu usecs, delete %llu usecs\n",
+			num_rules,
+			(unsigned long long) (cmds[2] - cmds[1]),
+			(unsigned long long) (entries[2] - entries[1]),
+			(unsigned long long) usecs[2],
+			(unsigned long long) usecs[3]);
+
+del_tbl:
+	if ( sep )
+	{
+		if ( ipa_nat_del_ipv4_tbl(tbl_hdl) )
+		{
+			ret = (ret) ? ret : -1;
+		}
+		*tbl_hdl_ptr = 0;
+	}
+
+bail:
+	free(rules);
+	free(rule_hdls);
+
+	CHECK_ERR(ret);
+
+	IPADBG("Out\n");
+
+	return 0;
+}
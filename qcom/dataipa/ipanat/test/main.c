@@ -309,7 +309,7 @@ _dispUsage(
 	const char* progNamePtr )
 {
 	printf(
-		"Usage: %s [-d -r N -i N -e N -m mt]\n"
+		"Usage: %s [-d -r N -i N -e N -m mt -H]\n"
 		"Where:\n"
 		"  -d     Each test is discrete (create table, add rules, destroy table)\n"
 		"         If not specified, only one table create and destroy for all tests\n"
@@ -318,7 +318,9 @@ _dispUsage(
 		"  -e N   Where N is the number of entries in the NAT\n"
 		"  -m mt  Where mt is the type of memory to use for the NAT\n"
 		"         Legal mt's: DDR, SRAM, or HYBRID (ie. use SRAM and DDR)\n"
-		"  -g M-N Run tests M through N only\n",
+		"  -g M-N Run tests M through N only\n"
+		"  -H     Run against tables in host memory rather than the IPA\n"
+		"         (DDR only)\n",
 		progNamePtr);
 
 	fflush(stdout);
@@ -351,6 +353,8 @@ static NatTests nt_array[] = {
 	NAT_TEST_ENTRY(ipa_nat_test023, IPA_NAT_TEST_PRE_COND_TE, 0),
 	NAT_TEST_ENTRY(ipa_nat_test024, IPA_NAT_TEST_PRE_COND_TE, 0),
 	NAT_TEST_ENTRY(ipa_nat_test025, IPA_NAT_TEST_PRE_COND_TE, 0),
+	NAT_TEST_ENTRY(ipa_nat_test026, 1, 0),
+	NAT_TEST_ENTRY(ipa_nat_test027, IPA_NAT_TEST_PRE_COND_TE, 0),
 	/*
 	 * Add new tests just above this comment. Keep the following two
 	 * at the end...
@@ -386,7 +390,7 @@ int main(
 
 	IPADBG("Testing user space nat driver\n");
 
-	while ( (c = getopt(argc, argv, "dr:i:e:m:h:g:?")) != -1 )
+	while ( (c = getopt(argc, argv, "dr:i:e:m:h:g:H?")) != -1 )
 	{
 		switch (c)
 		{
@@ -423,6 +427,9 @@ int main(
 				exit(0);
 			}
 			break;
+		case 'H':
+			ipa_nat_set_host_mem_mode(true);
+			break;
 		case '?':
 		default:
 			_dispUsage(basename(argv[0]));
@@ -431,6 +438,13 @@ int main(
 		}
 	}
 
+	if ( ipa_nat_in_host_mem_mode() && ! strcasesame(nat_mem_type, "DDR") )
+	{
+		fprintf(stderr, "Illegal: -H with -m %s\n", nat_mem_type);
+		_dispUsage(basename(argv[0]));
+		exit(0);
+	}
+
 	srand(time(&t));
 
 	pub_ip_addr = RAN_ADDR;
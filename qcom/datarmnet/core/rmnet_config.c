@@ -239,11 +239,11 @@ static int rmnet_newlink(struct net *src_net, struct net_device *dev,
 		if (data[IFLA_RMNET_UL_AGG_STATE_ID])
 			state = nla_get_u8(data[IFLA_RMNET_UL_AGG_STATE_ID]);
 
-		rmnet_map_update_ul_agg_config(&port->agg_state[state],
-					       agg_params->agg_size,
-					       agg_params->agg_count,
-					       agg_params->agg_features,
-					       agg_params->agg_time);
+		rmnet_map_update_port_ul_agg_config(port, state,
+						    agg_params->agg_size,
+						    agg_params->agg_count,
+						    agg_params->agg_features,
+						    agg_params->agg_time);
 	}
 
 	return 0;
@@ -449,11 +449,11 @@ static int rmnet_changelink(struct net_device *dev, struct nlattr *tb[],
 		if (data[IFLA_RMNET_UL_AGG_STATE_ID])
 			state = nla_get_u8(data[IFLA_RMNET_UL_AGG_STATE_ID]);
 
-		rmnet_map_update_ul_agg_config(&port->agg_state[state],
-					       agg_params->agg_size,
-					       agg_params->agg_count,
-					       agg_params->agg_features,
-					       agg_params->agg_time);
+		rmnet_map_update_port_ul_agg_config(port, state,
+						    agg_params->agg_size,
+						    agg_params->agg_count,
+						    agg_params->agg_features,
+						    agg_params->agg_time);
 	}
 
 	return rc;
@@ -59,6 +59,22 @@ struct rmnet_agg_stats {
 	u64 ul_agg_alloc;
 };
 
+/* Reasons a per-CPU UL aggregate was shipped */
+enum {
+	RMNET_AGG_FLUSH_SIZE,
+	RMNET_AGG_FLUSH_COUNT,
+	RMNET_AGG_FLUSH_AGE,
+	RMNET_AGG_FLUSH_TIMER,
+	RMNET_AGG_FLUSH_FLOW,
+	RMNET_AGG_FLUSH_OTHER,
+	RMNET_AGG_FLUSH_MAX,
+};
+
+struct rmnet_agg_pcpu_stats {
+	u64 lock_contended;
+	u64 flush[RMNET_AGG_FLUSH_MAX];
+};
+
 struct rmnet_port_priv_stats {
 	u64 dl_hdr_last_qmap_vers;
 	u64 dl_hdr_last_ep_id;
@@ -76,6 +92,9 @@ struct rmnet_port_priv_stats {
 	u64 dl_chain_stat[7];
 	u64 dl_frag_stat_1;
 	u64 dl_frag_stat[5];
+	/* Summed over the per-CPU UL aggregation contexts when read */
+	u64 ul_agg_pcpu_contended;
+	u64 ul_agg_pcpu_flush[RMNET_AGG_FLUSH_MAX];
 };
 
 struct rmnet_egress_agg_params {
@@ -91,6 +110,11 @@ enum {
 	RMNET_MAX_AGG_STATE,
 };
 
+/* Flow hash buckets tracking which per-CPU aggregates hold packets of a
+ * flow.
+ */
+#define RMNET_AGG_FLOW_SLOTS 256
+
 struct rmnet_aggregation_state {
 	struct rmnet_egress_agg_params params;
 	struct timespec64 agg_time;
@@ -107,6 +131,16 @@ struct rmnet_aggregation_state {
 	struct list_head agg_list;
 	struct rmnet_agg_page *agg_head;
 	struct rmnet_agg_stats *stats;
+	/* Only set for the per-CPU contexts */
+	struct rmnet_agg_pcpu_stats *pcpu_stats;
+	/* Flow slots with a packet in agg_skb, only used per-CPU */
+	DECLARE_BITMAP(agg_flows, RMNET_AGG_FLOW_SLOTS);
+};
+
+struct rmnet_agg_pcpu {
+	struct rmnet_aggregation_state state;
+	struct rmnet_agg_stats agg_stats;
+	struct rmnet_agg_pcpu_stats pcpu_stats;
 };
 
 
@@ -129,6 +163,8 @@ struct rmnet_port {
 	void *rmnet_perf;
 
 	struct rmnet_aggregation_state agg_state[RMNET_MAX_AGG_STATE];
+	/* Per-CPU contexts used by the default state with RMNET_PCPU_AGG */
+	struct rmnet_agg_pcpu __percpu *agg_pcpu;
 
 	void *qmi_info;
 
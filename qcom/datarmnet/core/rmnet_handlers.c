@@ -370,14 +370,12 @@ static int rmnet_map_egress_handler(struct sk_buff *skb,
 	if (port->data_format & RMNET_INGRESS_FORMAT_PS)
 		qmi_rmnet_work_maybe_restart(port);
 
-	state = &port->agg_state[(low_latency) ? RMNET_LL_AGG_STATE :
-				 RMNET_DEFAULT_AGG_STATE];
+	state = rmnet_map_tx_agg_state(port, low_latency);
 
 	if (csum_type &&
 	    (skb_shinfo(skb)->gso_type & (SKB_GSO_UDP_L4 | SKB_GSO_TCPV4 | SKB_GSO_TCPV6)) &&
 	     skb_shinfo(skb)->gso_size) {
-		spin_lock_bh(&state->agg_lock);
-		rmnet_map_send_agg_skb(state);
+		rmnet_map_tx_agg_flush(port, skb, low_latency);
 
 		if (rmnet_map_add_tso_header(skb, port, orig_dev))
 			return -EINVAL;
@@ -279,6 +279,16 @@ void rmnet_map_tx_aggregate_init(struct rmnet_port *port);
 void rmnet_map_tx_aggregate_exit(struct rmnet_port *port);
 void rmnet_map_update_ul_agg_config(struct rmnet_aggregation_state *state,
 				    u16 size, u8 count, u8 features, u32 time);
+void rmnet_map_update_port_ul_agg_config(struct rmnet_port *port, u8 id,
+					 u16 size, u8 count, u8 features,
+					 u32 time);
+struct rmnet_aggregation_state *
+rmnet_map_tx_agg_state(struct rmnet_port *port, bool low_latency);
+void rmnet_map_tx_agg_flush(struct rmnet_port *port, struct sk_buff *skb,
+			    bool low_latency);
+void rmnet_map_tx_agg_pcpu_stats(struct rmnet_port *port,
+				 struct rmnet_port_priv_stats *stats);
+void rmnet_map_tx_agg_pcpu_stats_reset(struct rmnet_port *port);
 void rmnet_map_dl_hdr_notify_v2(struct rmnet_port *port,
 				struct rmnet_map_dl_ind_hdr *dl_hdr,
 				struct rmnet_map_control_command_header *qcmd);
@@ -28,6 +28,9 @@
 #define RMNET_MAP_DEAGGR_SPACING  64
 #define RMNET_MAP_DEAGGR_HEADROOM (RMNET_MAP_DEAGGR_SPACING / 2)
 
+/* The per-CPU contexts are all locked at once, nested in the shared one */
+static struct lock_class_key rmnet_agg_pcpu_lock_key;
+
 struct rmnet_map_coal_metadata {
 	void *ip_header;
 	void *trans_header;
@@ -1231,6 +1234,9 @@ int rmnet_map_process_next_hdr_packet(struct sk_buff *skb,
 long rmnet_agg_time_limit __read_mostly = 1000000L;
 long rmnet_agg_bypass_time __read_mostly = 10000000L;
 
+#define RMNET_AGG_POOL_PAGES 512
+#define RMNET_AGG_PCPU_POOL_PAGES 64
+
 int rmnet_map_tx_agg_skip(struct sk_buff *skb, int offset)
 {
 	u8 *packet_start = skb->data + offset;
@@ -1270,10 +1276,14 @@ static void rmnet_map_flush_tx_packet_work(struct work_struct *work)
 	if (likely(state->agg_state == -EINPROGRESS)) {
 		/* Buffer may have already been shipped out */
 		if (likely(state->agg_skb)) {
+			if (state->pcpu_stats)
+				state->pcpu_stats->flush[RMNET_AGG_FLUSH_TIMER]++;
+
 			skb = state->agg_skb;
 			state->agg_skb = NULL;
 			state->agg_count = 0;
 			memset(&state->agg_time, 0, sizeof(state->agg_time));
+			bitmap_zero(state->agg_flows, RMNET_AGG_FLOW_SLOTS);
 		}
 		state->agg_state = 0;
 	}
@@ -1400,9 +1410,14 @@ __rmnet_alloc_agg_pages(struct rmnet_aggregation_state *state)
 static void rmnet_alloc_agg_pages(struct rmnet_aggregation_state *state)
 {
 	struct rmnet_agg_page *agg_page = NULL;
+	int nr_pages = RMNET_AGG_POOL_PAGES;
 	int i = 0;
 
-	for (i = 0; i < 512; i++) {
+	/* Every CPU gets its own pool, so keep each one small */
+	if (state->pcpu_stats)
+		nr_pages = RMNET_AGG_PCPU_POOL_PAGES;
+
+	for (i = 0; i < nr_pages; i++) {
 		agg_page = __rmnet_alloc_agg_pages(state);
 
 		if (agg_page)
@@ -1437,24 +1452,143 @@ rmnet_map_build_skb(struct rmnet_aggregation_state *state)
 	return skb;
 }
 
-void rmnet_map_send_agg_skb(struct rmnet_aggregation_state *state)
+/* Ship the pending aggregate, if any, without dropping agg_lock */
+static bool __rmnet_map_send_agg_skb(struct rmnet_aggregation_state *state)
 {
 	struct sk_buff *agg_skb;
 
-	if (!state->agg_skb) {
-		spin_unlock_bh(&state->agg_lock);
-		return;
-	}
+	if (!state->agg_skb)
+		return false;
 
 	agg_skb = state->agg_skb;
 	/* Reset the aggregation state */
 	state->agg_skb = NULL;
 	state->agg_count = 0;
 	memset(&state->agg_time, 0, sizeof(state->agg_time));
+	bitmap_zero(state->agg_flows, RMNET_AGG_FLOW_SLOTS);
 	state->agg_state = 0;
 	state->send_agg_skb(agg_skb);
+	return true;
+}
+
+void rmnet_map_send_agg_skb(struct rmnet_aggregation_state *state)
+{
+	bool sent = __rmnet_map_send_agg_skb(state);
+
 	spin_unlock_bh(&state->agg_lock);
-	hrtimer_cancel(&state->hrtimer);
+	if (sent)
+		hrtimer_cancel(&state->hrtimer);
+}
+
+static bool rmnet_map_agg_pcpu_on(struct rmnet_port *port)
+{
+	struct rmnet_aggregation_state *state;
+
+	state = &port->agg_state[RMNET_DEFAULT_AGG_STATE];
+	return port->agg_pcpu &&
+	       (state->params.agg_features & RMNET_PCPU_AGG);
+}
+
+/* Returns the aggregation context the current CPU should use. Callers run
+ * in the transmit path with BHs disabled, so the CPU cannot change under
+ * them.
+ */
+struct rmnet_aggregation_state *
+rmnet_map_tx_agg_state(struct rmnet_port *port, bool low_latency)
+{
+	if (low_latency)
+		return &port->agg_state[RMNET_LL_AGG_STATE];
+
+	if (rmnet_map_agg_pcpu_on(port))
+		return &this_cpu_ptr(port->agg_pcpu)->state;
+
+	return &port->agg_state[RMNET_DEFAULT_AGG_STATE];
+}
+
+static void rmnet_map_agg_lock(struct rmnet_aggregation_state *state)
+{
+	if (state->pcpu_stats) {
+		if (spin_trylock_bh(&state->agg_lock))
+			return;
+
+		state->pcpu_stats->lock_contended++;
+	}
+
+	spin_lock_bh(&state->agg_lock);
+}
+
+/* The per-CPU mode only flips with every default context locked (see
+ * rmnet_map_update_port_ul_agg_config()). Once the context picked before
+ * taking its lock is locked, make sure it is still the one to use.
+ */
+static bool rmnet_map_agg_state_stale(struct rmnet_port *port,
+				      struct rmnet_aggregation_state *state,
+				      bool low_latency)
+{
+	if (likely(state == rmnet_map_tx_agg_state(port, low_latency)))
+		return false;
+
+	spin_unlock_bh(&state->agg_lock);
+	return true;
+}
+
+static u32 rmnet_map_agg_flow_slot(struct sk_buff *skb)
+{
+	return skb_get_hash(skb) & (RMNET_AGG_FLOW_SLOTS - 1);
+}
+
+/* MAP requires packets of a flow to leave in order. Ship every aggregate
+ * pending on another CPU that holds a packet of the flow before this CPU
+ * queues anything newer for it. Each context tracks its own flows, so
+ * CPUs aggregating the same flow at once can't hide each other.
+ */
+static void rmnet_map_agg_flow_sync(struct rmnet_port *port, u32 slot)
+{
+	struct rmnet_aggregation_state *state;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		if (cpu == smp_processor_id())
+			continue;
+
+		state = &per_cpu_ptr(port->agg_pcpu, cpu)->state;
+		if (!test_bit(slot, state->agg_flows))
+			continue;
+
+		spin_lock_bh(&state->agg_lock);
+		if (!state->agg_skb || !test_bit(slot, state->agg_flows)) {
+			spin_unlock_bh(&state->agg_lock);
+			continue;
+		}
+
+		state->pcpu_stats->flush[RMNET_AGG_FLUSH_FLOW]++;
+		rmnet_map_send_agg_skb(state);
+	}
+}
+
+static void rmnet_map_agg_flush_stat(struct rmnet_aggregation_state *state,
+				     int reason)
+{
+	if (state->pcpu_stats && state->agg_skb)
+		state->pcpu_stats->flush[reason]++;
+}
+
+void rmnet_map_tx_agg_flush(struct rmnet_port *port, struct sk_buff *skb,
+			    bool low_latency)
+{
+	struct rmnet_aggregation_state *state;
+
+retry:
+	state = rmnet_map_tx_agg_state(port, low_latency);
+	if (state->pcpu_stats)
+		rmnet_map_agg_flow_sync(port, rmnet_map_agg_flow_slot(skb));
+
+	spin_lock_bh(&state->agg_lock);
+	if (rmnet_map_agg_state_stale(port, state, low_latency))
+		goto retry;
+
+	rmnet_map_agg_flush_stat(state, RMNET_AGG_FLUSH_OTHER);
+	rmnet_map_send_agg_skb(state);
 }
 
 void rmnet_map_tx_aggregate(struct sk_buff *skb, struct rmnet_port *port,
@@ -1462,19 +1596,29 @@ void rmnet_map_tx_aggregate(struct sk_buff *skb, struct rmnet_port *port,
 {
 	struct rmnet_aggregation_state *state;
 	struct timespec64 diff, last;
+	u32 slot = 0;
+	int reason;
 	int size;
 
-	state = &port->agg_state[(low_latency) ? RMNET_LL_AGG_STATE :
-						 RMNET_DEFAULT_AGG_STATE];
+retry:
+	state = rmnet_map_tx_agg_state(port, low_latency);
+	if (state->pcpu_stats) {
+		slot = rmnet_map_agg_flow_slot(skb);
+		rmnet_map_agg_flow_sync(port, slot);
+	}
 
 new_packet:
-	spin_lock_bh(&state->agg_lock);
+	rmnet_map_agg_lock(state);
+	if (rmnet_map_agg_state_stale(port, state, low_latency))
+		goto retry;
+
 	memcpy(&last, &state->agg_last, sizeof(last));
 	ktime_get_real_ts64(&state->agg_last);
 
 	if ((port->data_format & RMNET_EGRESS_FORMAT_PRIORITY) &&
 	    (RMNET_LLM(skb->priority) || RMNET_APS_LLB(skb->priority))) {
 		/* Send out any aggregated SKBs we have */
+		rmnet_map_agg_flush_stat(state, RMNET_AGG_FLUSH_OTHER);
 		rmnet_map_send_agg_skb(state);
 		/* Send out the priority SKB. Not holding agg_lock anymore */
 		skb->protocol = htons(ETH_P_MAP);
@@ -1519,9 +1663,17 @@ new_packet:
 	diff = timespec64_sub(state->agg_last, state->agg_time);
 	size = skb_tailroom(state->agg_skb);
 
-	if (skb->len > size ||
-	    state->agg_count >= state->params.agg_count ||
-	    diff.tv_sec > 0 || diff.tv_nsec > rmnet_agg_time_limit) {
+	if (skb->len > size)
+		reason = RMNET_AGG_FLUSH_SIZE;
+	else if (state->agg_count >= state->params.agg_count)
+		reason = RMNET_AGG_FLUSH_COUNT;
+	else if (diff.tv_sec > 0 || diff.tv_nsec > rmnet_agg_time_limit)
+		reason = RMNET_AGG_FLUSH_AGE;
+	else
+		reason = RMNET_AGG_FLUSH_MAX;
+
+	if (reason != RMNET_AGG_FLUSH_MAX) {
+		rmnet_map_agg_flush_stat(state, reason);
 		rmnet_map_send_agg_skb(state);
 		goto new_packet;
 	}
@@ -1531,6 +1683,9 @@ new_packet:
 	dev_kfree_skb_any(skb);
 
 schedule:
+	if (state->pcpu_stats)
+		__set_bit(slot, state->agg_flows);
+
 	if (state->agg_state != -EINPROGRESS) {
 		state->agg_state = -EINPROGRESS;
 		hrtimer_start(&state->hrtimer,
@@ -1540,10 +1695,10 @@ schedule:
 	spin_unlock_bh(&state->agg_lock);
 }
 
-void rmnet_map_update_ul_agg_config(struct rmnet_aggregation_state *state,
-				    u16 size, u8 count, u8 features, u32 time)
+static void
+__rmnet_map_update_ul_agg_config(struct rmnet_aggregation_state *state,
+				 u16 size, u8 count, u8 features, u32 time)
 {
-	spin_lock_bh(&state->agg_lock);
 	state->params.agg_count = count;
 	state->params.agg_time = time;
 	state->params.agg_size = size;
@@ -1555,7 +1710,7 @@ void rmnet_map_update_ul_agg_config(struct rmnet_aggregation_state *state,
 	 * size is lesser than PAGE_SIZE.
 	 */
 	if (size < PAGE_SIZE)
-		goto done;
+		return;
 
 	state->agg_size_order = get_order(size);
 
@@ -1563,72 +1718,206 @@ void rmnet_map_update_ul_agg_config(struct rmnet_aggregation_state *state,
 	size -= SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
 	state->params.agg_size = size;
 
-	if (state->params.agg_features == RMNET_PAGE_RECYCLE)
+	/* Pages are only recycled by the contexts that are actually in use
+	 * for this configuration.
+	 */
+	if ((features & RMNET_PAGE_RECYCLE) &&
+	    !!state->pcpu_stats == !!(features & RMNET_PCPU_AGG))
 		rmnet_alloc_agg_pages(state);
+}
 
-done:
+void rmnet_map_update_ul_agg_config(struct rmnet_aggregation_state *state,
+				    u16 size, u8 count, u8 features, u32 time)
+{
+	spin_lock_bh(&state->agg_lock);
+	__rmnet_map_update_ul_agg_config(state, size, count, features, time);
 	spin_unlock_bh(&state->agg_lock);
 }
 
-void rmnet_map_tx_aggregate_init(struct rmnet_port *port)
+void rmnet_map_update_port_ul_agg_config(struct rmnet_port *port, u8 id,
+					 u16 size, u8 count, u8 features,
+					 u32 time)
 {
-	unsigned int i;
+	struct rmnet_aggregation_state *shared = &port->agg_state[id];
+	struct rmnet_aggregation_state *state;
+	int cpu;
 
+	if (id != RMNET_DEFAULT_AGG_STATE || !port->agg_pcpu) {
+		rmnet_map_update_ul_agg_config(shared, size, count, features,
+					       time);
+		return;
+	}
 
-	for (i = RMNET_DEFAULT_AGG_STATE; i < RMNET_MAX_AGG_STATE; i++) {
-		struct rmnet_aggregation_state *state = &port->agg_state[i];
+	/* RMNET_PCPU_AGG decides between the shared and the per-CPU
+	 * contexts. Lock all of them, ship what they hold and only then
+	 * flip it, so nothing aggregated under the old mode can still be
+	 * pending once the new one takes a packet. Transmits that picked a
+	 * context under the old mode notice once they get its lock.
+	 */
+	spin_lock_bh(&shared->agg_lock);
+	for_each_possible_cpu(cpu)
+		spin_lock_nest_lock(&per_cpu_ptr(port->agg_pcpu,
+						 cpu)->state.agg_lock,
+				    &shared->agg_lock);
+
+	__rmnet_map_send_agg_skb(shared);
+	for_each_possible_cpu(cpu)
+		__rmnet_map_send_agg_skb(&per_cpu_ptr(port->agg_pcpu,
+						      cpu)->state);
+
+	for_each_possible_cpu(cpu) {
+		state = &per_cpu_ptr(port->agg_pcpu, cpu)->state;
+
+		__rmnet_map_update_ul_agg_config(state, size, count, features,
+						 time);
+	}
+	__rmnet_map_update_ul_agg_config(shared, size, count, features, time);
 
-		spin_lock_init(&state->agg_lock);
-		INIT_LIST_HEAD(&state->agg_list);
-		hrtimer_init(&state->hrtimer, CLOCK_MONOTONIC,
-			     HRTIMER_MODE_REL);
-		state->hrtimer.function = rmnet_map_flush_tx_packet_queue;
-		INIT_WORK(&state->agg_wq, rmnet_map_flush_tx_packet_work);
-		state->stats = &port->stats.agg;
+	for_each_possible_cpu(cpu)
+		spin_unlock(&per_cpu_ptr(port->agg_pcpu, cpu)->state.agg_lock);
+	spin_unlock_bh(&shared->agg_lock);
 
-		/* Since PAGE_SIZE - 1 is specified here, no pages are
-		 * pre-allocated. This is done to reduce memory usage in cases
-		 * where UL aggregation is disabled.
-		 * Additionally, the features flag is also set to 0.
-		 */
-		rmnet_map_update_ul_agg_config(state, PAGE_SIZE - 1, 20, 0,
-					       3000000);
+	hrtimer_cancel(&shared->hrtimer);
+	for_each_possible_cpu(cpu) {
+		state = &per_cpu_ptr(port->agg_pcpu, cpu)->state;
+
+		hrtimer_cancel(&state->hrtimer);
 	}
+}
+
+static void rmnet_map_tx_agg_state_init(struct rmnet_aggregation_state *state,
+					struct rmnet_agg_stats *stats,
+					struct rmnet_agg_pcpu_stats *pcpu_stats)
+{
+	spin_lock_init(&state->agg_lock);
+	INIT_LIST_HEAD(&state->agg_list);
+	hrtimer_init(&state->hrtimer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	state->hrtimer.function = rmnet_map_flush_tx_packet_queue;
+	INIT_WORK(&state->agg_wq, rmnet_map_flush_tx_packet_work);
+	state->stats = stats;
+	state->pcpu_stats = pcpu_stats;
+
+	/* Since PAGE_SIZE - 1 is specified here, no pages are
+	 * pre-allocated. This is done to reduce memory usage in cases
+	 * where UL aggregation is disabled.
+	 * Additionally, the features flag is also set to 0.
+	 */
+	rmnet_map_update_ul_agg_config(state, PAGE_SIZE - 1, 20, 0, 3000000);
+}
+
+static void rmnet_map_tx_agg_state_cancel(struct rmnet_aggregation_state *state)
+{
+	hrtimer_cancel(&state->hrtimer);
+	cancel_work_sync(&state->agg_wq);
+}
+
+static void rmnet_map_tx_agg_state_exit(struct rmnet_aggregation_state *state)
+{
+	spin_lock_bh(&state->agg_lock);
+	if (state->agg_state == -EINPROGRESS) {
+		if (state->agg_skb) {
+			kfree_skb(state->agg_skb);
+			state->agg_skb = NULL;
+			state->agg_count = 0;
+			memset(&state->agg_time, 0, sizeof(state->agg_time));
+			bitmap_zero(state->agg_flows, RMNET_AGG_FLOW_SLOTS);
+		}
+
+		state->agg_state = 0;
+	}
+
+	rmnet_free_agg_pages(state);
+	spin_unlock_bh(&state->agg_lock);
+}
+
+void rmnet_map_tx_aggregate_init(struct rmnet_port *port)
+{
+	unsigned int i;
+	int cpu;
+
+	for (i = RMNET_DEFAULT_AGG_STATE; i < RMNET_MAX_AGG_STATE; i++)
+		rmnet_map_tx_agg_state_init(&port->agg_state[i],
+					    &port->stats.agg, NULL);
 
 	/* Set delivery functions for each aggregation state */
 	port->agg_state[RMNET_DEFAULT_AGG_STATE].send_agg_skb = dev_queue_xmit;
 	port->agg_state[RMNET_LL_AGG_STATE].send_agg_skb = rmnet_ll_send_skb;
+
+	/* Without the per-CPU contexts RMNET_PCPU_AGG is simply ignored */
+	port->agg_pcpu = alloc_percpu(struct rmnet_agg_pcpu);
+	if (!port->agg_pcpu)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		struct rmnet_agg_pcpu *pcpu = per_cpu_ptr(port->agg_pcpu, cpu);
+
+		rmnet_map_tx_agg_state_init(&pcpu->state, &pcpu->agg_stats,
+					    &pcpu->pcpu_stats);
+		lockdep_set_class(&pcpu->state.agg_lock,
+				  &rmnet_agg_pcpu_lock_key);
+		pcpu->state.send_agg_skb = dev_queue_xmit;
+	}
 }
 
 void rmnet_map_tx_aggregate_exit(struct rmnet_port *port)
 {
 	unsigned int i;
+	int cpu;
 
-	for (i = RMNET_DEFAULT_AGG_STATE; i < RMNET_MAX_AGG_STATE; i++) {
-		struct rmnet_aggregation_state *state = &port->agg_state[i];
+	for (i = RMNET_DEFAULT_AGG_STATE; i < RMNET_MAX_AGG_STATE; i++)
+		rmnet_map_tx_agg_state_cancel(&port->agg_state[i]);
 
-		hrtimer_cancel(&state->hrtimer);
-		cancel_work_sync(&state->agg_wq);
+	if (port->agg_pcpu) {
+		for_each_possible_cpu(cpu)
+			rmnet_map_tx_agg_state_cancel(&per_cpu_ptr(port->agg_pcpu,
+								   cpu)->state);
 	}
 
-	for (i = RMNET_DEFAULT_AGG_STATE; i < RMNET_MAX_AGG_STATE; i++) {
-		struct rmnet_aggregation_state *state = &port->agg_state[i];
+	for (i = RMNET_DEFAULT_AGG_STATE; i < RMNET_MAX_AGG_STATE; i++)
+		rmnet_map_tx_agg_state_exit(&port->agg_state[i]);
 
-		spin_lock_bh(&state->agg_lock);
-		if (state->agg_state == -EINPROGRESS) {
-			if (state->agg_skb) {
-				kfree_skb(state->agg_skb);
-				state->agg_skb = NULL;
-				state->agg_count = 0;
-				memset(&state->agg_time, 0,
-				       sizeof(state->agg_time));
-			}
+	if (port->agg_pcpu) {
+		for_each_possible_cpu(cpu)
+			rmnet_map_tx_agg_state_exit(&per_cpu_ptr(port->agg_pcpu,
+								 cpu)->state);
 
-			state->agg_state = 0;
-		}
+		free_percpu(port->agg_pcpu);
+		port->agg_pcpu = NULL;
+	}
+}
 
-		rmnet_free_agg_pages(state);
-		spin_unlock_bh(&state->agg_lock);
+void rmnet_map_tx_agg_pcpu_stats(struct rmnet_port *port,
+				 struct rmnet_port_priv_stats *stats)
+{
+	int cpu, i;
+
+	if (!port->agg_pcpu)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		struct rmnet_agg_pcpu *pcpu = per_cpu_ptr(port->agg_pcpu, cpu);
+
+		stats->agg.ul_agg_reuse += pcpu->agg_stats.ul_agg_reuse;
+		stats->agg.ul_agg_alloc += pcpu->agg_stats.ul_agg_alloc;
+		stats->ul_agg_pcpu_contended +=
+			pcpu->pcpu_stats.lock_contended;
+		for (i = 0; i < RMNET_AGG_FLUSH_MAX; i++)
+			stats->ul_agg_pcpu_flush[i] += pcpu->pcpu_stats.flush[i];
+	}
+}
+
+void rmnet_map_tx_agg_pcpu_stats_reset(struct rmnet_port *port)
+{
+	int cpu;
+
+	if (!port->agg_pcpu)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		struct rmnet_agg_pcpu *pcpu = per_cpu_ptr(port->agg_pcpu, cpu);
+
+		memset(&pcpu->agg_stats, 0, sizeof(pcpu->agg_stats));
+		memset(&pcpu->pcpu_stats, 0, sizeof(pcpu->pcpu_stats));
 	}
 }
 
@@ -1654,6 +1943,20 @@ void rmnet_map_tx_qmap_cmd(struct sk_buff *qmap_skb, u8 ch, bool flush)
 	if (!(port->data_format & RMNET_EGRESS_FORMAT_AGGREGATION))
 		goto send;
 
+	if (ch == RMNET_DEFAULT_AGG_STATE && rmnet_map_agg_pcpu_on(port)) {
+		struct rmnet_aggregation_state *pcpu_state;
+		int cpu;
+
+		for_each_possible_cpu(cpu) {
+			pcpu_state = &per_cpu_ptr(port->agg_pcpu, cpu)->state;
+
+			spin_lock_bh(&pcpu_state->agg_lock);
+			rmnet_map_agg_flush_stat(pcpu_state,
+						 RMNET_AGG_FLUSH_OTHER);
+			rmnet_map_send_agg_skb(pcpu_state);
+		}
+	}
+
 	spin_lock_bh(&state->agg_lock);
 	if (state->agg_skb) {
 		agg_skb = state->agg_skb;
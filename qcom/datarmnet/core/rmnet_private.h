@@ -41,6 +41,7 @@ RMNET_INGRESS_FORMAT_DL_MARKER_V2)
 
 /* UL Aggregation parameters */
 #define RMNET_PAGE_RECYCLE                      BIT(0)
+#define RMNET_PCPU_AGG                          BIT(2)
 
 /* Replace skb->dev to a virtual rmnet device and pass up the stack */
 #define RMNET_EPMODE_VND (1)
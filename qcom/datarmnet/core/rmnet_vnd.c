@@ -572,6 +572,13 @@ static const char rmnet_port_gstrings_stats[][ETH_GSTRING_LEN] = {
 	"DL chaining frags [8-11]",
 	"DL chaining frags [12-15]",
 	"DL chaining frags = 16",
+	"UL agg pcpu lock contended",
+	"UL agg pcpu flush size",
+	"UL agg pcpu flush count",
+	"UL agg pcpu flush age",
+	"UL agg pcpu flush timer",
+	"UL agg pcpu flush flow move",
+	"UL agg pcpu flush other",
 };
 
 static const char rmnet_ll_gstrings_stats[][ETH_GSTRING_LEN] = {
@@ -659,6 +666,8 @@ static void rmnet_get_ethtool_stats(struct net_device *dev,
 	off += ARRAY_SIZE(rmnet_gstrings_stats);
 	memcpy(data + off, stp,
 	       ARRAY_SIZE(rmnet_port_gstrings_stats) * sizeof(u64));
+	rmnet_map_tx_agg_pcpu_stats(port,
+				    (struct rmnet_port_priv_stats *)(data + off));
 	off += ARRAY_SIZE(rmnet_port_gstrings_stats);
 	memcpy(data + off, llp,
 	       ARRAY_SIZE(rmnet_ll_gstrings_stats) * sizeof(u64));
@@ -684,6 +693,7 @@ static int rmnet_stats_reset(struct net_device *dev)
 	stp = &port->stats;
 
 	memset(stp, 0, sizeof(*stp));
+	rmnet_map_tx_agg_pcpu_stats_reset(port);
 
 	st = &priv->stats;
 
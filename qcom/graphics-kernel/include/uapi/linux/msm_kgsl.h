@@ -2121,4 +2121,40 @@ struct kgsl_recurring_command {
 #define IOCTL_KGSL_RECURRING_COMMAND \
 	_IOWR(KGSL_IOC_TYPE, 0x5F, struct kgsl_recurring_command)
 
+/**
+ * struct kgsl_timeline_signal_wait - Argument for
+ * IOCTL_KGSL_TIMELINE_SIGNAL_WAIT
+ * @signals: Address of an array of &struct kgsl_timeline_val entries to signal
+ * @signals_count: Number of entries in @signals
+ * @signals_size: Size of each entry in @signals
+ * @waits: Address of an array of &struct kgsl_timeline_val entries to wait on
+ * @waits_count: Number of entries in @waits
+ * @waits_size: Size of each entry in @waits
+ * @tv_sec: Number of seconds to wait for the signal
+ * @tv_nsec: Number of nanoseconds to wait for the signal
+ * @flags: One of KGSL_TIMELINE_WAIT_ALL or KGSL_TIMELINE_WAIT_ANY
+ *
+ * Signal every timeline in @signals and then wait for the timelines in @waits
+ * in a single call. All the timelines are looked up before any of them is
+ * signaled, so an invalid identifier fails the call without side effects.
+ * If a non zero count is passed with a zero size, both sizes are set to the
+ * size of &struct kgsl_timeline_val and -EAGAIN is returned.
+ */
+struct kgsl_timeline_signal_wait {
+	__u64 signals;
+	__u32 signals_count;
+	__u32 signals_size;
+	__u64 waits;
+	__u32 waits_count;
+	__u32 waits_size;
+	__s64 tv_sec;
+	__s64 tv_nsec;
+	__u32 flags;
+/* private: padding for 64 bit compatibility */
+	__u32 padding;
+};
+
+#define IOCTL_KGSL_TIMELINE_SIGNAL_WAIT \
+	_IOWR(KGSL_IOC_TYPE, 0x60, struct kgsl_timeline_signal_wait)
+
 #endif /* _UAPI_MSM_KGSL_H */
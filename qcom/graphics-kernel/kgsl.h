@@ -515,6 +515,8 @@ long kgsl_ioctl_timeline_signal(struct kgsl_device_private *dev_priv,
 		unsigned int cmd, void *data);
 long kgsl_ioctl_timeline_destroy(struct kgsl_device_private *dev_priv,
 		unsigned int cmd, void *data);
+long kgsl_ioctl_timeline_signal_wait(struct kgsl_device_private *dev_priv,
+		unsigned int cmd, void *data);
 long kgsl_ioctl_get_fault_report(struct kgsl_device_private *dev_priv,
 		unsigned int cmd, void *data);
 long kgsl_ioctl_recurring_command(struct kgsl_device_private *dev_priv,
@@ -369,6 +369,8 @@ static const struct kgsl_ioctl kgsl_compat_ioctl_funcs[] = {
 			kgsl_ioctl_timeline_signal),
 	KGSL_IOCTL_FUNC(IOCTL_KGSL_TIMELINE_DESTROY,
 			kgsl_ioctl_timeline_destroy),
+	KGSL_IOCTL_FUNC(IOCTL_KGSL_TIMELINE_SIGNAL_WAIT,
+			kgsl_ioctl_timeline_signal_wait),
 	KGSL_IOCTL_FUNC(IOCTL_KGSL_GET_FAULT_REPORT,
 			kgsl_ioctl_get_fault_report),
 	KGSL_IOCTL_FUNC(IOCTL_KGSL_RECURRING_COMMAND,
@@ -93,6 +93,7 @@ DEFINE_DEBUGFS_ATTRIBUTE(_reserved_fops,
 					kgsl_pool_reserved_get, NULL, "%llu\n");
 DEFINE_DEBUGFS_ATTRIBUTE(_page_count_fops,
 					kgsl_pool_page_count_get, NULL, "%llu\n");
+DEFINE_SHOW_ATTRIBUTE(kgsl_pool_magazine);
 
 void kgsl_pool_init_debugfs(struct dentry *pool_debugfs,
 					char *name, void *pool)
@@ -119,6 +120,12 @@ void kgsl_pool_init_debugfs(struct dentry *pool_debugfs,
 
 	WARN((IS_ERR_OR_NULL(dentry)),
 		"Unable to create 'count' file for %s\n", name);
+
+	dentry = debugfs_create_file("magazine", 0444,
+		pool_debugfs, pool, &kgsl_pool_magazine_fops);
+
+	WARN((IS_ERR_OR_NULL(dentry)),
+		"Unable to create 'magazine' file for %s\n", name);
 }
 
 void kgsl_device_debugfs_init(struct kgsl_device *device)
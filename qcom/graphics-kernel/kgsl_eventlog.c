@@ -3,11 +3,16 @@
  * Copyright (c) 2021, The Linux Foundation. All rights reserved.
  */
 
+#include <linux/debugfs.h>
+#include <linux/irq_work.h>
+#include <linux/math64.h>
+#include <linux/poll.h>
 #include <linux/sched.h>
 #include <linux/sched/clock.h>
 #include <linux/slab.h>
-#include <linux/spinlock.h>
+#include <linux/uaccess.h>
 
+#include "kgsl_debugfs.h"
 #include "kgsl_device.h"
 #include "kgsl_eventlog.h"
 #include "kgsl_util.h"
@@ -15,6 +20,10 @@
 #define EVENTLOG_SIZE (SZ_64K + SZ_32K)
 #define MAGIC 0xabbaabba
 #define LOG_FENCE_NAME_LEN 74
+/* Largest record (header included) that the streaming reader will copy */
+#define EVENTLOG_RECORD_MAX 128
+/* Records start on, and are padded to, this many bytes */
+#define EVENTLOG_SLOT sizeof(u32)
 
 /*
  * This an internal event used to skip empty space at the bottom of the
@@ -30,9 +39,29 @@
 #define LOG_TIMELINE_FENCE_ALLOC_EVENT 7
 #define LOG_TIMELINE_FENCE_RELEASE_EVENT 8
 
-static spinlock_t lock;
 static void *kgsl_eventlog;
-static int eventlog_wptr;
+
+/*
+ * Writers reserve records by advancing a logical write pointer with a
+ * cmpxchg. The logical pointer never wraps: the offset in the ringbuffer is
+ * eventlog_wptr % EVENTLOG_SIZE and a wrap moves it to the start of the next
+ * EVENTLOG_SIZE sized lap.
+ */
+static atomic64_t eventlog_wptr;
+/*
+ * One byte per EVENTLOG_SLOT of the ringbuffer. Once a record is complete its
+ * writer stamps every slot it covers with the low bits of (lap + 1), the slot
+ * it starts in last. A reader knows that the record at a logical position is
+ * ready when that slot carries the reader's lap, without waiting for any other
+ * writer. Every slot is stamped once per lap, so unless the reader has been
+ * overrun (see eventlog_overrun()) a slot holds either this lap or the last.
+ */
+static u8 *eventlog_seq;
+
+static DECLARE_WAIT_QUEUE_HEAD(eventlog_wq);
+static struct irq_work eventlog_irq_work;
+static struct dentry *eventlog_debugfs;
+static bool eventlog_shutdown;
 
 struct kgsl_log_header {
 	u32 magic;
@@ -42,6 +71,26 @@ struct kgsl_log_header {
 	u32 size;
 };
 
+static u8 *eventlog_seq_slot(s64 pos, u8 *lap)
+{
+	u32 offset;
+
+	*lap = (u8) (div_u64_rem(pos, EVENTLOG_SIZE, &offset) + 1);
+	return &eventlog_seq[offset / EVENTLOG_SLOT];
+}
+
+/* Publish the complete @len byte record at logical position @pos */
+static void eventlog_publish(s64 pos, u32 len)
+{
+	u8 lap;
+	u8 *seq = eventlog_seq_slot(pos, &lap);
+
+	memset(seq + 1, lap, len / EVENTLOG_SLOT - 1);
+
+	/* Order the record contents before the publish */
+	smp_store_release(seq, lap);
+}
+
 /* Add a marker to skip the rest of the eventlog and start over fresh */
 static void add_skip_header(u32 offset)
 {
@@ -54,28 +103,41 @@ static void add_skip_header(u32 offset)
 	header->size = EVENTLOG_SIZE - sizeof(*header) - offset;
 }
 
-static void *kgsl_eventlog_alloc(u32 eventid, u32 size)
+/*
+ * Reserve a record and return its payload. The record's logical position and
+ * reserved length are stored in @pos and @len for kgsl_eventlog_commit().
+ */
+static void *kgsl_eventlog_alloc(u32 eventid, u32 size, s64 *pos, u32 *len)
 {
 	struct kgsl_log_header *header;
-	u32 datasize = size + sizeof(*header);
-	unsigned long flags;
-	void *data;
+	u32 datasize = ALIGN(size + sizeof(*header), EVENTLOG_SLOT);
+	s64 old, new;
+	u32 offset;
+	bool wrap;
 
 	if (!kgsl_eventlog)
 		return NULL;
 
-	spin_lock_irqsave(&lock, flags);
-	if (eventlog_wptr + datasize > (EVENTLOG_SIZE - sizeof(*header))) {
-		add_skip_header(eventlog_wptr);
-		eventlog_wptr = datasize;
-		data = kgsl_eventlog;
-	} else {
-		data = kgsl_eventlog + eventlog_wptr;
-		eventlog_wptr += datasize;
+	old = atomic64_read(&eventlog_wptr);
+	do {
+		u64 lap = div_u64_rem(old, EVENTLOG_SIZE, &offset);
+
+		wrap = (offset + datasize > (EVENTLOG_SIZE - sizeof(*header)));
+		if (wrap)
+			new = (lap + 1) * EVENTLOG_SIZE + datasize;
+		else
+			new = old + datasize;
+	} while (!atomic64_try_cmpxchg(&eventlog_wptr, &old, new));
+
+	if (wrap) {
+		add_skip_header(offset);
+		eventlog_publish(old, EVENTLOG_SIZE - offset);
+		offset = 0;
 	}
-	spin_unlock_irqrestore(&lock, flags);
 
-	header = data;
+	*pos = new - datasize;
+	*len = datasize;
+	header = kgsl_eventlog + offset;
 
 	header->magic = MAGIC;
 	header->time = local_clock();
@@ -83,28 +145,242 @@ static void *kgsl_eventlog_alloc(u32 eventid, u32 size)
 	header->eventid = eventid;
 	header->size = size;
 
-	return data + sizeof(*header);
+	return (void *) header + sizeof(*header);
+}
+
+/*
+ * Mark the @len byte record at @pos, returned by kgsl_eventlog_alloc(), as
+ * complete. Each record is published on its own, so a slow writer only holds
+ * back the readers that have reached its record. The length is not read back
+ * from the header, other writers may have lapped the ring and reused it.
+ */
+static void kgsl_eventlog_commit(s64 pos, u32 len)
+{
+	eventlog_publish(pos, len);
+
+	if (wq_has_sleeper(&eventlog_wq))
+		irq_work_queue(&eventlog_irq_work);
+}
+
+static void eventlog_wakeup(struct irq_work *work)
+{
+	wake_up_interruptible(&eventlog_wq);
+}
+
+/* Return true if the record at @pos may have been overwritten by a writer */
+static bool eventlog_overrun(s64 pos)
+{
+	/* Order the record reads before checking the write pointer */
+	smp_rmb();
+
+	return atomic64_read(&eventlog_wptr) > pos + EVENTLOG_SIZE;
+}
+
+/*
+ * Return > 0 if the record at @pos is published, 0 if it isn't yet and < 0 if
+ * a later lap has already reused its slot.
+ */
+static int eventlog_ready(s64 pos)
+{
+	u8 lap;
+	u8 *seq;
+
+	if (eventlog_overrun(pos))
+		return -1;
+
+	seq = eventlog_seq_slot(pos, &lap);
+	return smp_load_acquire(seq) == lap;
+}
+
+static s64 eventlog_lap_end(s64 pos)
+{
+	u32 offset;
+
+	div_u64_rem(pos, EVENTLOG_SIZE, &offset);
+	return pos - offset + EVENTLOG_SIZE;
 }
 
+/*
+ * Copy the published records from @pos on to @buf, in order, stopping at the
+ * first one that is still being written. Records that were overwritten before
+ * they could be read are dropped and the reader jumps forward to the next
+ * record to be reserved.
+ */
+static ssize_t eventlog_copy_records(s64 *pos, char __user *buf, size_t count)
+{
+	u8 record[EVENTLOG_RECORD_MAX];
+	struct kgsl_log_header *header = (struct kgsl_log_header *) record;
+	size_t copied = 0;
+
+	while (copied < count) {
+		int ready = eventlog_ready(*pos);
+		u32 offset, len;
+
+		if (!ready)
+			break;
+
+		if (ready < 0) {
+			*pos = atomic64_read(&eventlog_wptr);
+			continue;
+		}
+
+		div_u64_rem(*pos, EVENTLOG_SIZE, &offset);
+		memcpy(header, kgsl_eventlog + offset, sizeof(*header));
+
+		if (eventlog_overrun(*pos)) {
+			*pos = atomic64_read(&eventlog_wptr);
+			continue;
+		}
+
+		if (header->eventid == LOG_SKIP) {
+			*pos = eventlog_lap_end(*pos);
+			continue;
+		}
+
+		len = sizeof(*header) + header->size;
+		if (len > sizeof(record)) {
+			*pos = atomic64_read(&eventlog_wptr);
+			continue;
+		}
+
+		memcpy(record + sizeof(*header),
+			kgsl_eventlog + offset + sizeof(*header), header->size);
+
+		if (eventlog_overrun(*pos)) {
+			*pos = atomic64_read(&eventlog_wptr);
+			continue;
+		}
+
+		if (len > count - copied)
+			break;
+
+		if (copy_to_user(buf + copied, record, len))
+			return copied ? copied : -EFAULT;
+
+		copied += len;
+		*pos += ALIGN(len, EVENTLOG_SLOT);
+	}
+
+	/* The next record is ready but does not fit in @buf */
+	if (!copied && eventlog_ready(*pos) > 0)
+		return -EINVAL;
+
+	return copied;
+}
+
+static int eventlog_open(struct inode *inode, struct file *file)
+{
+	s64 *pos = kmalloc(sizeof(*pos), GFP_KERNEL);
+
+	if (!pos)
+		return -ENOMEM;
+
+	/* Stream the records logged from now on */
+	*pos = atomic64_read(&eventlog_wptr);
+	file->private_data = pos;
+
+	return 0;
+}
+
+static int eventlog_release(struct inode *inode, struct file *file)
+{
+	kfree(file->private_data);
+	return 0;
+}
+
+static ssize_t eventlog_read(struct file *file, char __user *buf,
+		size_t count, loff_t *ppos)
+{
+	s64 *pos = file->private_data;
+	ssize_t ret;
+
+	do {
+		if (file->f_flags & O_NONBLOCK) {
+			if (!eventlog_ready(*pos))
+				return -EAGAIN;
+		} else {
+			ret = wait_event_interruptible(eventlog_wq,
+				READ_ONCE(eventlog_shutdown) ||
+				eventlog_ready(*pos));
+			if (ret)
+				return ret;
+		}
+
+		if (READ_ONCE(eventlog_shutdown))
+			return 0;
+
+		ret = eventlog_copy_records(pos, buf, count);
+	} while (!ret);
+
+	return ret;
+}
+
+static __poll_t eventlog_poll(struct file *file, poll_table *wait)
+{
+	s64 *pos = file->private_data;
+
+	poll_wait(file, &eventlog_wq, wait);
+
+	if (READ_ONCE(eventlog_shutdown))
+		return EPOLLHUP;
+
+	if (eventlog_ready(*pos))
+		return EPOLLIN | EPOLLRDNORM;
+
+	return 0;
+}
+
+static const struct file_operations eventlog_fops = {
+	.owner = THIS_MODULE,
+	.open = eventlog_open,
+	.release = eventlog_release,
+	.read = eventlog_read,
+	.poll = eventlog_poll,
+	.llseek = no_llseek,
+};
+
 void kgsl_eventlog_init(void)
 {
+	struct dentry *debugfs_dir = kgsl_get_debugfs_dir();
+
 	kgsl_eventlog = kzalloc(EVENTLOG_SIZE, GFP_KERNEL);
-	eventlog_wptr = 0;
+	eventlog_seq = kzalloc(EVENTLOG_SIZE / EVENTLOG_SLOT, GFP_KERNEL);
+	if (!eventlog_seq) {
+		kfree(kgsl_eventlog);
+		kgsl_eventlog = NULL;
+	}
+	atomic64_set(&eventlog_wptr, 0);
+	eventlog_shutdown = false;
 
-	spin_lock_init(&lock);
+	init_irq_work(&eventlog_irq_work, eventlog_wakeup);
 
 	kgsl_add_to_minidump("KGSL_EVENTLOG", (u64) kgsl_eventlog,
 				__pa(kgsl_eventlog), EVENTLOG_SIZE);
+
+	if (kgsl_eventlog && !IS_ERR_OR_NULL(debugfs_dir))
+		eventlog_debugfs = debugfs_create_file("eventlog", 0444,
+			debugfs_dir, NULL, &eventlog_fops);
 }
 
 void kgsl_eventlog_exit(void)
 {
+	/* Kick out any blocked readers before the buffer goes away */
+	WRITE_ONCE(eventlog_shutdown, true);
+	wake_up_interruptible_all(&eventlog_wq);
+
+	debugfs_remove(eventlog_debugfs);
+	eventlog_debugfs = NULL;
+
+	irq_work_sync(&eventlog_irq_work);
+
 	kgsl_remove_from_minidump("KGSL_EVENTLOG", (u64) kgsl_eventlog,
 				__pa(kgsl_eventlog), EVENTLOG_SIZE);
 
 	kfree(kgsl_eventlog);
 	kgsl_eventlog = NULL;
-	eventlog_wptr = 0;
+	kfree(eventlog_seq);
+	eventlog_seq = NULL;
+	atomic64_set(&eventlog_wptr, 0);
 }
 
 void log_kgsl_fire_event(u32 id, u32 ts, u32 type, u32 age)
@@ -115,8 +391,10 @@ void log_kgsl_fire_event(u32 id, u32 ts, u32 type, u32 age)
 		u32 type;
 		u32 age;
 	} *entry;
+	s64 pos;
+	u32 len;
 
-	entry = kgsl_eventlog_alloc(LOG_FIRE_EVENT, sizeof(*entry));
+	entry = kgsl_eventlog_alloc(LOG_FIRE_EVENT, sizeof(*entry), &pos, &len);
 	if (!entry)
 		return;
 
@@ -124,6 +402,8 @@ void log_kgsl_fire_event(u32 id, u32 ts, u32 type, u32 age)
 	entry->ts = ts;
 	entry->type = type;
 	entry->age = age;
+
+	kgsl_eventlog_commit(pos, len);
 }
 
 void log_kgsl_cmdbatch_submitted_event(u32 id, u32 ts, u32 prio, u64 flags)
@@ -134,8 +414,10 @@ void log_kgsl_cmdbatch_submitted_event(u32 id, u32 ts, u32 prio, u64 flags)
 		u32 prio;
 		u64 flags;
 	} *entry;
+	s64 pos;
+	u32 len;
 
-	entry = kgsl_eventlog_alloc(LOG_CMDBATCH_SUBMITTED_EVENT, sizeof(*entry));
+	entry = kgsl_eventlog_alloc(LOG_CMDBATCH_SUBMITTED_EVENT, sizeof(*entry), &pos, &len);
 	if (!entry)
 		return;
 
@@ -143,6 +425,8 @@ void log_kgsl_cmdbatch_submitted_event(u32 id, u32 ts, u32 prio, u64 flags)
 	entry->ts = ts;
 	entry->prio = prio;
 	entry->flags = flags;
+
+	kgsl_eventlog_commit(pos, len);
 }
 
 void log_kgsl_cmdbatch_retired_event(u32 id, u32 ts, u32 prio, u64 flags,
@@ -156,8 +440,10 @@ void log_kgsl_cmdbatch_retired_event(u32 id, u32 ts, u32 prio, u64 flags,
 		u64 start;
 		u64 retire;
 	} *entry;
+	s64 pos;
+	u32 len;
 
-	entry = kgsl_eventlog_alloc(LOG_CMDBATCH_RETIRED_EVENT, sizeof(*entry));
+	entry = kgsl_eventlog_alloc(LOG_CMDBATCH_RETIRED_EVENT, sizeof(*entry), &pos, &len);
 	if (!entry)
 		return;
 
@@ -167,6 +453,8 @@ void log_kgsl_cmdbatch_retired_event(u32 id, u32 ts, u32 prio, u64 flags,
 	entry->flags = flags;
 	entry->start = start;
 	entry->retire = retire;
+
+	kgsl_eventlog_commit(pos, len);
 }
 
 void log_kgsl_syncpoint_fence_event(u32 id, char *fence_name)
@@ -175,14 +463,18 @@ void log_kgsl_syncpoint_fence_event(u32 id, char *fence_name)
 		u32 id;
 		char name[LOG_FENCE_NAME_LEN];
 	} *entry;
+	s64 pos;
+	u32 len;
 
-	entry = kgsl_eventlog_alloc(LOG_SYNCPOINT_FENCE_EVENT, sizeof(*entry));
+	entry = kgsl_eventlog_alloc(LOG_SYNCPOINT_FENCE_EVENT, sizeof(*entry), &pos, &len);
 	if (!entry)
 		return;
 
 	entry->id = id;
 	memset(entry->name, 0, sizeof(entry->name));
 	strlcpy(entry->name, fence_name, sizeof(entry->name));
+
+	kgsl_eventlog_commit(pos, len);
 }
 
 void log_kgsl_syncpoint_fence_expire_event(u32 id, char *fence_name)
@@ -191,14 +483,18 @@ void log_kgsl_syncpoint_fence_expire_event(u32 id, char *fence_name)
 		u32 id;
 		char name[LOG_FENCE_NAME_LEN];
 	} *entry;
+	s64 pos;
+	u32 len;
 
-	entry = kgsl_eventlog_alloc(LOG_SYNCPOINT_FENCE_EXPIRE_EVENT, sizeof(*entry));
+	entry = kgsl_eventlog_alloc(LOG_SYNCPOINT_FENCE_EXPIRE_EVENT, sizeof(*entry), &pos, &len);
 	if (!entry)
 		return;
 
 	entry->id = id;
 	memset(entry->name, 0, sizeof(entry->name));
 	strlcpy(entry->name, fence_name, sizeof(entry->name));
+
+	kgsl_eventlog_commit(pos, len);
 }
 
 void log_kgsl_timeline_fence_alloc_event(u32 id, u64 seqno)
@@ -207,13 +503,17 @@ void log_kgsl_timeline_fence_alloc_event(u32 id, u64 seqno)
 		u32 id;
 		u64 seqno;
 	} *entry;
+	s64 pos;
+	u32 len;
 
-	entry = kgsl_eventlog_alloc(LOG_TIMELINE_FENCE_ALLOC_EVENT, sizeof(*entry));
+	entry = kgsl_eventlog_alloc(LOG_TIMELINE_FENCE_ALLOC_EVENT, sizeof(*entry), &pos, &len);
 	if (!entry)
 		return;
 
 	entry->id = id;
 	entry->seqno = seqno;
+
+	kgsl_eventlog_commit(pos, len);
 }
 
 void log_kgsl_timeline_fence_release_event(u32 id, u64 seqno)
@@ -222,11 +522,15 @@ void log_kgsl_timeline_fence_release_event(u32 id, u64 seqno)
 		u32 id;
 		u64 seqno;
 	} *entry;
+	s64 pos;
+	u32 len;
 
-	entry = kgsl_eventlog_alloc(LOG_TIMELINE_FENCE_RELEASE_EVENT, sizeof(*entry));
+	entry = kgsl_eventlog_alloc(LOG_TIMELINE_FENCE_RELEASE_EVENT, sizeof(*entry), &pos, &len);
 	if (!entry)
 		return;
 
 	entry->id = id;
 	entry->seqno = seqno;
+
+	kgsl_eventlog_commit(pos, len);
 }
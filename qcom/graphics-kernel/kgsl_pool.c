@@ -9,7 +9,9 @@
 #include <linux/highmem.h>
 #include <linux/mempool.h>
 #include <linux/of.h>
+#include <linux/percpu.h>
 #include <linux/scatterlist.h>
+#include <linux/seq_file.h>
 
 #include "kgsl_debugfs.h"
 #include "kgsl_device.h"
@@ -17,6 +19,34 @@
 #include "kgsl_sharedmem.h"
 #include "kgsl_trace.h"
 
+/* Default per-CPU magazine budget in PAGE_SIZE units for each pool */
+#define KGSL_POOL_MAG_PAGES 64
+/* Maximum number of entries a per-CPU magazine can hold */
+#define KGSL_POOL_MAG_MAX 64
+/* Pages taken from a pool per lock acquisition by the bulk allocator */
+#define KGSL_POOL_BULK_BATCH 256
+
+/**
+ * struct kgsl_pool_magazine - Per-CPU cache of pages in front of a pool
+ * @lock: Spinlock for the magazine. Only contended when the magazine is
+ * drained from another CPU by the shrinker or at exit
+ * @count: Number of pages currently held in @pages
+ * @pages: Stack of cached pages
+ * @hits: Number of allocations served from the magazine
+ * @misses: Number of allocations that found the magazine empty
+ * @refills: Number of batch refills from the shared pool
+ * @drains: Number of batch drains to the shared pool
+ */
+struct kgsl_pool_magazine {
+	spinlock_t lock;
+	unsigned int count;
+	struct page *pages[KGSL_POOL_MAG_MAX];
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long refills;
+	unsigned long drains;
+};
+
 #ifdef CONFIG_QCOM_KGSL_SORT_POOL
 
 struct kgsl_pool_page_entry {
@@ -37,6 +67,9 @@ static struct kmem_cache *addr_page_cache;
  * @mempool: Mempool to pre-allocate tracking structs for pages in this pool
  * @debug_root: Pointer to the debugfs root for this pool
  * @max_pages: Limit on number of pages this pool can hold
+ * @magazines: Per-CPU page caches in front of the pool
+ * @mag_size: Number of pages each per-CPU magazine can hold
+ * @mag_batch: Number of pages moved on a magazine refill or drain
  */
 struct kgsl_page_pool {
 	unsigned int pool_order;
@@ -47,6 +80,9 @@ struct kgsl_page_pool {
 	mempool_t *mempool;
 	struct dentry *debug_root;
 	unsigned int max_pages;
+	struct kgsl_pool_magazine __percpu *magazines;
+	unsigned int mag_size;
+	unsigned int mag_batch;
 };
 
 static void *_pool_entry_alloc(gfp_t gfp_mask, void *arg)
@@ -59,19 +95,33 @@ static void _pool_entry_free(void *element, void *arg)
 	return kmem_cache_free(addr_page_cache, element);
 }
 
-static int
-__kgsl_pool_add_page(struct kgsl_page_pool *pool, struct page *p)
+static struct kgsl_pool_page_entry *
+__kgsl_pool_entry_alloc(struct kgsl_page_pool *pool)
 {
-	struct rb_node **node, *parent = NULL;
-	struct kgsl_pool_page_entry *new_page, *entry;
 	gfp_t gfp_mask = GFP_KERNEL & ~__GFP_DIRECT_RECLAIM;
 
-	new_page = pool->mempool ? mempool_alloc(pool->mempool, gfp_mask) :
+	return pool->mempool ? mempool_alloc(pool->mempool, gfp_mask) :
 			kmem_cache_alloc(addr_page_cache, gfp_mask);
-	if (new_page == NULL)
-		return -ENOMEM;
+}
+
+static void
+__kgsl_pool_entry_free(struct kgsl_page_pool *pool,
+		struct kgsl_pool_page_entry *entry)
+{
+	if (pool->mempool)
+		mempool_free(entry, pool->mempool);
+	else
+		kmem_cache_free(addr_page_cache, entry);
+}
+
+/* Link a page into the pool rbtree. Must be called with list_lock held */
+static void
+__kgsl_pool_insert_page(struct kgsl_page_pool *pool,
+		struct kgsl_pool_page_entry *new_page, struct page *p)
+{
+	struct rb_node **node, *parent = NULL;
+	struct kgsl_pool_page_entry *entry;
 
-	spin_lock(&pool->list_lock);
 	node = &pool->pool_rbtree.rb_node;
 	new_page->physaddr = page_to_phys(p);
 	new_page->page = p;
@@ -89,11 +139,60 @@ __kgsl_pool_add_page(struct kgsl_page_pool *pool, struct page *p)
 	rb_link_node(&new_page->node, parent, node);
 	rb_insert_color(&new_page->node, &pool->pool_rbtree);
 	pool->page_count++;
+}
+
+static int
+__kgsl_pool_add_page(struct kgsl_page_pool *pool, struct page *p)
+{
+	struct kgsl_pool_page_entry *new_page;
+
+	new_page = __kgsl_pool_entry_alloc(pool);
+	if (new_page == NULL)
+		return -ENOMEM;
+
+	spin_lock(&pool->list_lock);
+	__kgsl_pool_insert_page(pool, new_page, p);
 	spin_unlock(&pool->list_lock);
 
 	return 0;
 }
 
+/*
+ * Add up to @count pages to the pool while it is below max_pages. Returns
+ * the number of pages added; the caller owns the remainder. The tracking
+ * entries are allocated up front so that the pool lock is only taken once.
+ */
+static unsigned int
+__kgsl_pool_add_pages(struct kgsl_page_pool *pool, struct page **pages,
+		unsigned int count)
+{
+	struct kgsl_pool_page_entry *entries[KGSL_POOL_MAG_MAX];
+	unsigned int i, n, added;
+
+	count = min_t(unsigned int, count, ARRAY_SIZE(entries));
+
+	for (n = 0; n < count; n++) {
+		entries[n] = __kgsl_pool_entry_alloc(pool);
+		if (!entries[n])
+			break;
+	}
+
+	spin_lock(&pool->list_lock);
+	for (i = 0; i < n; i++) {
+		if (pool->page_count >= pool->max_pages)
+			break;
+
+		__kgsl_pool_insert_page(pool, entries[i], pages[i]);
+	}
+	spin_unlock(&pool->list_lock);
+
+	/* Hand back the entries of pages that didn't fit */
+	for (added = i; i < n; i++)
+		__kgsl_pool_entry_free(pool, entries[i]);
+
+	return added;
+}
+
 static struct page *
 __kgsl_pool_get_page(struct kgsl_page_pool *pool)
 {
@@ -108,10 +207,7 @@ __kgsl_pool_get_page(struct kgsl_page_pool *pool)
 	entry = rb_entry(node, struct kgsl_pool_page_entry, node);
 	p = entry->page;
 	rb_erase(&entry->node, &pool->pool_rbtree);
-	if (pool->mempool)
-		mempool_free(entry, pool->mempool);
-	else
-		kmem_cache_free(addr_page_cache, entry);
+	__kgsl_pool_entry_free(pool, entry);
 	pool->page_count--;
 	return p;
 }
@@ -146,6 +242,9 @@ static void kgsl_destroy_page_pool(struct kgsl_page_pool *pool)
  * @page_list: List of pages held/reserved in this pool
  * @debug_root: Pointer to the debugfs root for this pool
  * @max_pages: Limit on number of pages this pool can hold
+ * @magazines: Per-CPU page caches in front of the pool
+ * @mag_size: Number of pages each per-CPU magazine can hold
+ * @mag_batch: Number of pages moved on a magazine refill or drain
  */
 struct kgsl_page_pool {
 	unsigned int pool_order;
@@ -155,6 +254,9 @@ struct kgsl_page_pool {
 	struct list_head page_list;
 	struct dentry *debug_root;
 	unsigned int max_pages;
+	struct kgsl_pool_magazine __percpu *magazines;
+	unsigned int mag_size;
+	unsigned int mag_batch;
 };
 
 static int
@@ -168,6 +270,29 @@ __kgsl_pool_add_page(struct kgsl_page_pool *pool, struct page *p)
 	return 0;
 }
 
+/*
+ * Add up to @count pages to the pool while it is below max_pages. Returns
+ * the number of pages added; the caller owns the remainder.
+ */
+static unsigned int
+__kgsl_pool_add_pages(struct kgsl_page_pool *pool, struct page **pages,
+		unsigned int count)
+{
+	unsigned int i;
+
+	spin_lock(&pool->list_lock);
+	for (i = 0; i < count; i++) {
+		if (pool->page_count >= pool->max_pages)
+			break;
+
+		list_add_tail(&pages[i]->lru, &pool->page_list);
+		pool->page_count++;
+	}
+	spin_unlock(&pool->list_lock);
+
+	return i;
+}
+
 static struct page *
 __kgsl_pool_get_page(struct kgsl_page_pool *pool)
 {
@@ -270,6 +395,157 @@ _kgsl_pool_get_page(struct kgsl_page_pool *pool)
 	return p;
 }
 
+/* Return the number of pages held in the per-CPU magazines of a pool */
+static unsigned int kgsl_pool_magazine_count(struct kgsl_page_pool *pool)
+{
+	unsigned int count = 0;
+	int cpu;
+
+	if (!pool->magazines)
+		return 0;
+
+	for_each_possible_cpu(cpu)
+		count += READ_ONCE(per_cpu_ptr(pool->magazines, cpu)->count);
+
+	return count;
+}
+
+/*
+ * Move pages from a magazine back to the shared pool with a single lock
+ * acquisition. Pages that don't fit under max_pages go back to the system.
+ */
+static void kgsl_pool_magazine_flush(struct kgsl_page_pool *pool,
+		struct page **pages, unsigned int count)
+{
+	unsigned int i, added;
+
+	added = __kgsl_pool_add_pages(pool, pages, count);
+	if (added)
+		trace_kgsl_pool_add_page(pool->pool_order, pool->page_count);
+
+	for (i = added; i < count; i++) {
+		mod_node_page_state(page_pgdat(pages[i]),
+				NR_KERNEL_MISC_RECLAIMABLE,
+				-(1 << pool->pool_order));
+		__free_pages(pages[i], pool->pool_order);
+		trace_kgsl_pool_free_page(pool->pool_order);
+	}
+}
+
+/*
+ * Returns a page from the magazine of the current CPU. An empty magazine is
+ * refilled from the shared pool in one batch so that the pool lock is only
+ * taken once every mag_batch allocations.
+ */
+static struct page *
+kgsl_pool_magazine_get_page(struct kgsl_page_pool *pool)
+{
+	struct kgsl_pool_magazine *mag;
+	struct page *p;
+
+	if (!pool->magazines)
+		return _kgsl_pool_get_page(pool);
+
+	/*
+	 * Getting migrated after picking the magazine is harmless. The
+	 * magazine lock keeps it consistent and it stays uncontended
+	 * unless the shrinker is draining it.
+	 */
+	mag = raw_cpu_ptr(pool->magazines);
+
+	spin_lock(&mag->lock);
+	if (mag->count) {
+		mag->hits++;
+	} else {
+		mag->misses++;
+
+		spin_lock(&pool->list_lock);
+		while (mag->count < pool->mag_batch) {
+			p = __kgsl_pool_get_page(pool);
+			if (!p)
+				break;
+
+			mag->pages[mag->count++] = p;
+		}
+		spin_unlock(&pool->list_lock);
+
+		if (!mag->count) {
+			spin_unlock(&mag->lock);
+			return NULL;
+		}
+
+		mag->refills++;
+	}
+
+	p = mag->pages[--mag->count];
+	spin_unlock(&mag->lock);
+
+	trace_kgsl_pool_get_page(pool->pool_order, pool->page_count);
+	mod_node_page_state(page_pgdat(p), NR_KERNEL_MISC_RECLAIMABLE,
+			-(1 << pool->pool_order));
+	return p;
+}
+
+/*
+ * Adds a page to the magazine of the current CPU. A full magazine drains
+ * its oldest mag_batch pages to the shared pool first.
+ */
+static void
+kgsl_pool_magazine_put_page(struct kgsl_page_pool *pool, struct page *p)
+{
+	struct kgsl_pool_magazine *mag;
+
+	if (!pool->magazines) {
+		_kgsl_pool_add_page(pool, p);
+		return;
+	}
+
+	/* Same sanity check as _kgsl_pool_add_page() */
+	if (WARN_ON(unlikely(page_count(p) > 1))) {
+		__free_pages(p, pool->pool_order);
+		return;
+	}
+
+	mod_node_page_state(page_pgdat(p), NR_KERNEL_MISC_RECLAIMABLE,
+			(1 << pool->pool_order));
+
+	mag = raw_cpu_ptr(pool->magazines);
+
+	spin_lock(&mag->lock);
+	if (mag->count == pool->mag_size) {
+		kgsl_pool_magazine_flush(pool, mag->pages, pool->mag_batch);
+		mag->count -= pool->mag_batch;
+		memmove(mag->pages, &mag->pages[pool->mag_batch],
+			mag->count * sizeof(*mag->pages));
+		mag->drains++;
+	}
+
+	mag->pages[mag->count++] = p;
+	spin_unlock(&mag->lock);
+}
+
+/* Return the pages cached in every per-CPU magazine to the shared pool */
+static void kgsl_pool_drain_magazines(struct kgsl_page_pool *pool)
+{
+	int cpu;
+
+	if (!pool->magazines)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		struct kgsl_pool_magazine *mag =
+			per_cpu_ptr(pool->magazines, cpu);
+
+		spin_lock(&mag->lock);
+		if (mag->count) {
+			kgsl_pool_magazine_flush(pool, mag->pages, mag->count);
+			mag->count = 0;
+			mag->drains++;
+		}
+		spin_unlock(&mag->lock);
+	}
+}
+
 int kgsl_pool_size_total(void)
 {
 	int i;
@@ -281,6 +557,29 @@ int kgsl_pool_size_total(void)
 		spin_lock(&kgsl_pool->list_lock);
 		total += kgsl_pool->page_count * (1 << kgsl_pool->pool_order);
 		spin_unlock(&kgsl_pool->list_lock);
+
+		total += kgsl_pool_magazine_count(kgsl_pool) *
+				(1 << kgsl_pool->pool_order);
+	}
+
+	return total;
+}
+
+/*
+ * Lockless version of kgsl_pool_size_total() for the free path where an
+ * approximate total is good enough to enforce kgsl_pool_max_pages.
+ */
+static int kgsl_pool_size_estimate(void)
+{
+	int i;
+	int total = 0;
+
+	for (i = 0; i < kgsl_num_pools; i++) {
+		struct kgsl_page_pool *pool = &kgsl_pools[i];
+
+		total += (READ_ONCE(pool->page_count) +
+			kgsl_pool_magazine_count(pool)) *
+				(1 << pool->pool_order);
 	}
 
 	return total;
@@ -300,6 +599,10 @@ static unsigned long kgsl_pool_size_nonreserved(void)
 			total += (pool->page_count - pool->reserved_pages) *
 					(1 << pool->pool_order);
 		spin_unlock(&pool->list_lock);
+
+		/* Pages cached in the magazines are never reserved */
+		total += kgsl_pool_magazine_count(pool) *
+				(1 << pool->pool_order);
 	}
 
 	return total;
@@ -380,6 +683,9 @@ kgsl_pool_reduce(int target_pages, bool exit)
 	int i, ret;
 	unsigned long pcount = 0;
 
+	for (i = 0; i < kgsl_num_pools; i++)
+		kgsl_pool_drain_magazines(&kgsl_pools[i]);
+
 	for (i = (kgsl_num_pools - 1); i >= 0; i--) {
 		if (target_pages <= 0)
 			return pcount;
@@ -504,7 +810,7 @@ int kgsl_pool_alloc_page(int *page_size, struct page **pages,
 	}
 
 	pool_idx = kgsl_get_pool_index(order);
-	page = _kgsl_pool_get_page(pool);
+	page = kgsl_pool_magazine_get_page(pool);
 
 	/* Allocate a new page if not allocated from pool */
 	if (page == NULL) {
@@ -542,6 +848,63 @@ eagain:
 	return -EAGAIN;
 }
 
+int kgsl_pool_alloc_pages_bulk(struct page **pages, unsigned int count,
+		struct device *dev)
+{
+	struct kgsl_page_pool *pool = _kgsl_get_pool_from_order(0);
+	unsigned int i, filled = 0;
+
+	if (!pages || !count)
+		return -EINVAL;
+
+	while (pool && filled < count) {
+		unsigned int batch = min_t(unsigned int, count - filled,
+				KGSL_POOL_BULK_BATCH);
+		unsigned int start = filled;
+
+		spin_lock(&pool->list_lock);
+		while (filled - start < batch) {
+			struct page *p = __kgsl_pool_get_page(pool);
+
+			if (!p)
+				break;
+
+			pages[filled++] = p;
+		}
+		spin_unlock(&pool->list_lock);
+
+		if (filled == start)
+			break;
+
+		trace_kgsl_pool_get_page(0, pool->page_count);
+
+		for (i = start; i < filled; i++)
+			mod_node_page_state(page_pgdat(pages[i]),
+				NR_KERNEL_MISC_RECLAIMABLE, -1);
+
+		/* Pool ran dry in the middle of this batch */
+		if (filled - start < batch)
+			break;
+	}
+
+	/* Get whatever the pool couldn't provide from the system */
+	if (filled < count) {
+		unsigned long ret;
+
+		ret = alloc_pages_bulk_array(kgsl_gfp_mask(0), count - filled,
+				&pages[filled]);
+		if (ret)
+			trace_kgsl_pool_alloc_page_system(0);
+
+		filled += ret;
+	}
+
+	for (i = 0; i < filled; i++)
+		kgsl_zero_page(pages[i], 0, dev);
+
+	return filled;
+}
+
 void kgsl_pool_free_page(struct page *page)
 {
 	struct kgsl_page_pool *pool;
@@ -553,10 +916,10 @@ void kgsl_pool_free_page(struct page *page)
 	page_order = compound_order(page);
 
 	if (!kgsl_pool_max_pages ||
-			(kgsl_pool_size_total() < kgsl_pool_max_pages)) {
+			(kgsl_pool_size_estimate() < kgsl_pool_max_pages)) {
 		pool = _kgsl_get_pool_from_order(page_order);
 		if (pool != NULL  && (pool->page_count < pool->max_pages)) {
-			_kgsl_pool_add_page(pool, page);
+			kgsl_pool_magazine_put_page(pool, page);
 			return;
 		}
 	}
@@ -614,6 +977,70 @@ int kgsl_pool_page_count_get(void *data, u64 *val)
 	return 0;
 }
 
+int kgsl_pool_magazine_show(struct seq_file *s, void *unused)
+{
+	struct kgsl_page_pool *pool = s->private;
+	int cpu;
+
+	seq_printf(s, "size: %u batch: %u\n", pool->mag_size, pool->mag_batch);
+
+	if (!pool->magazines)
+		return 0;
+
+	seq_puts(s, "cpu    count       hits     misses    refills     drains\n");
+
+	for_each_possible_cpu(cpu) {
+		struct kgsl_pool_magazine *mag =
+			per_cpu_ptr(pool->magazines, cpu);
+		unsigned long hits, misses, refills, drains;
+		unsigned int count;
+
+		spin_lock(&mag->lock);
+		count = mag->count;
+		hits = mag->hits;
+		misses = mag->misses;
+		refills = mag->refills;
+		drains = mag->drains;
+		spin_unlock(&mag->lock);
+
+		seq_printf(s, "%3d %8u %10lu %10lu %10lu %10lu\n", cpu, count,
+			hits, misses, refills, drains);
+	}
+
+	return 0;
+}
+
+static void kgsl_pool_magazine_init(struct kgsl_page_pool *pool,
+		struct device_node *node)
+{
+	u32 budget = KGSL_POOL_MAG_PAGES;
+	int cpu;
+
+	/* Per-CPU budget is in PAGE_SIZE units, 0 disables the magazines */
+	of_property_read_u32(node, "qcom,mempool-percpu-pages", &budget);
+
+	pool->mag_size = min_t(u32, budget >> pool->pool_order,
+			KGSL_POOL_MAG_MAX);
+
+	/* A single entry magazine would drain on every other free */
+	if (pool->mag_size < 2) {
+		pool->mag_size = 0;
+		return;
+	}
+
+	pool->mag_batch = pool->mag_size / 2;
+
+	pool->magazines = alloc_percpu(struct kgsl_pool_magazine);
+	if (!pool->magazines) {
+		pool->mag_size = 0;
+		pool->mag_batch = 0;
+		return;
+	}
+
+	for_each_possible_cpu(cpu)
+		spin_lock_init(&per_cpu_ptr(pool->magazines, cpu)->lock);
+}
+
 static void kgsl_pool_reserve_pages(struct kgsl_page_pool *pool,
 		struct device_node *node)
 {
@@ -672,6 +1099,8 @@ static int kgsl_of_parse_mempool(struct kgsl_page_pool *pool,
 
 	kgsl_pool_reserve_pages(pool, node);
 
+	kgsl_pool_magazine_init(pool, node);
+
 	snprintf(name, sizeof(name), "%d_order", (pool->pool_order));
 	kgsl_pool_init_debugfs(pool->debug_root, name, (void *) pool);
 
@@ -721,8 +1150,10 @@ void kgsl_exit_page_pools(void)
 	unregister_shrinker(&kgsl_pool_shrinker);
 
 	/* Destroy helper structures */
-	for (i = 0; i < kgsl_num_pools; i++)
+	for (i = 0; i < kgsl_num_pools; i++) {
 		kgsl_destroy_page_pool(&kgsl_pools[i]);
+		free_percpu(kgsl_pools[i].magazines);
+	}
 
 	/* Destroy the kmem cache */
 	kgsl_pool_cache_destroy();
@@ -6,6 +6,8 @@
 #ifndef __KGSL_POOL_H
 #define __KGSL_POOL_H
 
+struct seq_file;
+
 #ifdef CONFIG_QCOM_KGSL_USE_SHMEM
 static inline void kgsl_probe_page_pools(void) { }
 static inline void kgsl_exit_page_pools(void) { }
@@ -28,6 +30,17 @@ static inline int kgsl_pool_size_total(void)
 {
 	return 0;
 }
+
+static inline int kgsl_pool_alloc_pages_bulk(struct page **pages,
+		unsigned int count, struct device *dev)
+{
+	return 0;
+}
+
+static inline int kgsl_pool_magazine_show(struct seq_file *s, void *unused)
+{
+	return 0;
+}
 #else
 /**
  * kgsl_pool_free_page - Frees the page and adds it back to pool/system memory
@@ -58,6 +71,20 @@ int kgsl_pool_alloc_page(int *page_size, struct page **pages,
 			unsigned int pages_len, unsigned int *align,
 			struct device *dev);
 
+/**
+ * kgsl_pool_alloc_pages_bulk - Allocate a batch of PAGE_SIZE pages
+ * @pages: Array to hold the allocated pages. Unused entries must be NULL
+ * @count: Number of pages to allocate
+ * @dev: Device to sync the zeroed pages for
+ *
+ * Fill @pages from the zero order pool taking the pool lock once per batch
+ * and get the remainder from the kernel bulk page allocator. Return the
+ * number of pages allocated which may be less than @count, or a negative
+ * value on failure.
+ */
+int kgsl_pool_alloc_pages_bulk(struct page **pages, unsigned int count,
+		struct device *dev);
+
 /**
  * kgsl_pool_free_pages - Free pages in an pages array
  * @pages: pointer to an array of page structs
@@ -73,6 +100,13 @@ void kgsl_pool_free_pages(struct page **pages, unsigned int page_count);
 int kgsl_pool_reserved_get(void *data, u64 *val);
 int kgsl_pool_page_count_get(void *data, u64 *val);
 
+/**
+ * kgsl_pool_magazine_show - Print the per-CPU magazine counters of a pool
+ * @s: seq_file whose private data is the pool
+ * @unused: Unused
+ */
+int kgsl_pool_magazine_show(struct seq_file *s, void *unused);
+
 /**
  * kgsl_pool_size_total - Return the number of pages in all kgsl page pools
  */
@@ -1016,6 +1016,13 @@ static int kgsl_alloc_page(int *page_size, struct page **pages,
 	return 1;
 }
 
+/* Pages are read one at a time through the shmem mapping */
+static int kgsl_alloc_pages_bulk(struct page **pages, unsigned int count,
+			struct device *dev)
+{
+	return 0;
+}
+
 static int kgsl_memdesc_file_setup(struct kgsl_memdesc *memdesc, uint64_t size)
 {
 	int ret;
@@ -1061,6 +1068,15 @@ static int kgsl_alloc_page(int *page_size, struct page **pages,
 			pages_len, align, dev);
 }
 
+static int kgsl_alloc_pages_bulk(struct page **pages, unsigned int count,
+			struct device *dev)
+{
+	if (fatal_signal_pending(current))
+		return -ENOMEM;
+
+	return kgsl_pool_alloc_pages_bulk(pages, count, dev);
+}
+
 static int kgsl_memdesc_file_setup(struct kgsl_memdesc *memdesc, uint64_t size)
 {
 	return 0;
@@ -1123,6 +1139,9 @@ gfp_t kgsl_gfp_mask(int page_order)
 	return gfp_mask;
 }
 
+/* Minimum number of PAGE_SIZE pages to use the bulk allocator for */
+#define KGSL_ALLOC_BULK_MIN_PAGES 16
+
 static int _kgsl_alloc_pages(struct kgsl_memdesc *memdesc,
 		u64 size, struct page ***pages, struct device *dev)
 {
@@ -1147,8 +1166,18 @@ static int _kgsl_alloc_pages(struct kgsl_memdesc *memdesc,
 	page_size = kgsl_get_page_size(len, align);
 
 	while (len) {
-		int ret = kgsl_alloc_page(&page_size, &local[count],
-			npages, &align, count, memdesc->shmem_filp, dev);
+		int ret = 0;
+
+		/* Once down to PAGE_SIZE pages get the rest in batches */
+		if (page_size == PAGE_SIZE &&
+			(len >> PAGE_SHIFT) >= KGSL_ALLOC_BULK_MIN_PAGES)
+			ret = kgsl_alloc_pages_bulk(&local[count],
+				len >> PAGE_SHIFT, dev);
+
+		if (!ret)
+			ret = kgsl_alloc_page(&page_size, &local[count],
+				npages, &align, count, memdesc->shmem_filp,
+				dev);
 
 		if (ret == -EAGAIN)
 			continue;
@@ -1175,7 +1204,7 @@ static int _kgsl_alloc_pages(struct kgsl_memdesc *memdesc,
 
 		count += ret;
 		npages -= ret;
-		len -= page_size;
+		len -= (u64) ret << PAGE_SHIFT;
 
 		page_size = kgsl_get_page_size(len, align);
 	}
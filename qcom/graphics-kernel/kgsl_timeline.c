@@ -7,6 +7,7 @@
 #include <linux/file.h>
 #include <linux/list.h>
 #include <linux/kref.h>
+#include <linux/rbtree.h>
 #include <linux/sync_file.h>
 
 #include "kgsl_device.h"
@@ -18,15 +19,41 @@
 struct kgsl_timeline_fence {
 	struct dma_fence base;
 	struct kgsl_timeline *timeline;
-	struct list_head node;
+	/** @node: Node in the seqno sorted fence tree of the timeline */
+	struct rb_node node;
+	/** @list: Node for lists of fences pulled out of the tree to signal */
+	struct list_head list;
 };
 
+/*
+ * Wrap @fences in a dma-fence-array that takes ownership of the array. Return
+ * NULL if the fence array couldn't be allocated.
+ */
+static struct dma_fence *kgsl_timeline_fence_array(struct dma_fence **fences,
+		u32 count, bool any)
+{
+	struct dma_fence_array *array;
+
+	/* No need for a fence array for only one fence */
+	if (count == 1) {
+		struct dma_fence *fence = fences[0];
+
+		kfree(fences);
+		return fence;
+	}
+
+	array = dma_fence_array_create(count, fences,
+		dma_fence_context_alloc(1), 0, any);
+
+	return array ? &array->base : NULL;
+}
+
 struct dma_fence *kgsl_timelines_to_fence_array(struct kgsl_device *device,
 		u64 timelines, u32 count, u64 usize, bool any)
 {
 	void __user *uptr = u64_to_user_ptr(timelines);
-	struct dma_fence_array *array;
 	struct dma_fence **fences;
+	struct dma_fence *fence;
 	int i, ret = 0;
 
 	if (!count || count > INT_MAX)
@@ -69,19 +96,9 @@ struct dma_fence *kgsl_timelines_to_fence_array(struct kgsl_device *device,
 		uptr += usize;
 	}
 
-	/* No need for a fence array for only one fence */
-	if (count == 1) {
-		struct dma_fence *fence = fences[0];
-
-		kfree(fences);
+	fence = kgsl_timeline_fence_array(fences, count, any);
+	if (fence)
 		return fence;
-	}
-
-	array = dma_fence_array_create(count, fences,
-		dma_fence_context_alloc(1), 0, any);
-
-	if (array)
-		return &array->base;
 
 	ret = -ENOMEM;
 err:
@@ -99,11 +116,12 @@ void kgsl_timeline_destroy(struct kref *kref)
 	struct kgsl_timeline *timeline = container_of(kref,
 		struct kgsl_timeline, ref);
 
-	WARN_ON(!list_empty(&timeline->fences));
+	WARN_ON(!RB_EMPTY_ROOT(&timeline->fences.rb_root));
 
 	trace_kgsl_timeline_destroy(timeline->id);
 
-	kfree(timeline);
+	/* kgsl_timeline_by_id() may still be looking at it under RCU */
+	kfree_rcu(timeline, rcu);
 }
 
 struct kgsl_timeline *kgsl_timeline_get(struct kgsl_timeline *timeline)
@@ -141,7 +159,7 @@ static struct kgsl_timeline *kgsl_timeline_alloc(struct kgsl_device_private *dev
 
 	timeline->context = dma_fence_context_alloc(1);
 	timeline->id = id;
-	INIT_LIST_HEAD(&timeline->fences);
+	timeline->fences = RB_ROOT_CACHED;
 	timeline->value = initial;
 	timeline->dev_priv = dev_priv;
 
@@ -167,18 +185,14 @@ static void timeline_fence_release(struct dma_fence *fence)
 {
 	struct kgsl_timeline_fence *f = to_timeline_fence(fence);
 	struct kgsl_timeline *timeline = f->timeline;
-	struct kgsl_timeline_fence *cur, *temp;
 	unsigned long flags;
 
 	spin_lock_irqsave(&timeline->fence_lock, flags);
 
-	/* If the fence is still on the active list, remove it */
-	list_for_each_entry_safe(cur, temp, &timeline->fences, node) {
-		if (f != cur)
-			continue;
-
-		list_del_init(&f->node);
-		break;
+	/* If the fence is still in the active tree, remove it */
+	if (!RB_EMPTY_NODE(&f->node)) {
+		rb_erase_cached(&f->node, &timeline->fences);
+		RB_CLEAR_NODE(&f->node);
 	}
 	spin_unlock_irqrestore(&timeline->fence_lock, flags);
 	trace_kgsl_timeline_fence_release(f->timeline->id, fence->seqno);
@@ -239,22 +253,57 @@ static const struct dma_fence_ops timeline_fence_ops = {
 static void kgsl_timeline_add_fence(struct kgsl_timeline *timeline,
 		struct kgsl_timeline_fence *fence)
 {
+	struct rb_node **node, *parent = NULL;
 	struct kgsl_timeline_fence *entry;
+	bool leftmost = true;
 	unsigned long flags;
 
 	spin_lock_irqsave(&timeline->fence_lock, flags);
-	list_for_each_entry(entry, &timeline->fences, node) {
+	node = &timeline->fences.rb_root.rb_node;
+
+	/* Fences with the same seqno stay in the order they were added */
+	while (*node) {
+		parent = *node;
+		entry = rb_entry(parent, struct kgsl_timeline_fence, node);
+
 		if (fence->base.seqno < entry->base.seqno) {
-			list_add_tail(&fence->node, &entry->node);
-			spin_unlock_irqrestore(&timeline->fence_lock, flags);
-			return;
+			node = &parent->rb_left;
+		} else {
+			node = &parent->rb_right;
+			leftmost = false;
 		}
 	}
 
-	list_add_tail(&fence->node, &timeline->fences);
+	rb_link_node(&fence->node, parent, node);
+	rb_insert_color_cached(&fence->node, &timeline->fences, leftmost);
 	spin_unlock_irqrestore(&timeline->fence_lock, flags);
 }
 
+/*
+ * Pull the fences with a seqno up to @seqno out of the tree and return the
+ * ones that are still alive on @list with a reference held.
+ */
+static void kgsl_timeline_pop_fences(struct kgsl_timeline *timeline,
+		u64 seqno, struct list_head *list)
+{
+	struct rb_node *node;
+
+	while ((node = rb_first_cached(&timeline->fences))) {
+		struct kgsl_timeline_fence *fence = rb_entry(node,
+			struct kgsl_timeline_fence, node);
+
+		if (fence->base.seqno > seqno)
+			break;
+
+		rb_erase_cached(node, &timeline->fences);
+		RB_CLEAR_NODE(node);
+
+		/* A dying fence will be freed without needing a signal */
+		if (kref_get_unless_zero(&fence->base.refcount))
+			list_add_tail(&fence->list, list);
+	}
+}
+
 void kgsl_timeline_signal(struct kgsl_timeline *timeline, u64 seqno)
 {
 	struct kgsl_timeline_fence *fence, *tmp;
@@ -272,13 +321,10 @@ void kgsl_timeline_signal(struct kgsl_timeline *timeline, u64 seqno)
 	timeline->value = seqno;
 
 	spin_lock(&timeline->fence_lock);
-	list_for_each_entry_safe(fence, tmp, &timeline->fences, node)
-		if (timeline_fence_signaled(&fence->base) &&
-				kref_get_unless_zero(&fence->base.refcount))
-			list_move(&fence->node, &temp);
+	kgsl_timeline_pop_fences(timeline, seqno, &temp);
 	spin_unlock(&timeline->fence_lock);
 
-	list_for_each_entry_safe(fence, tmp, &temp, node) {
+	list_for_each_entry_safe(fence, tmp, &temp, list) {
 		dma_fence_signal_locked(&fence->base);
 		dma_fence_put(&fence->base);
 	}
@@ -305,7 +351,8 @@ struct dma_fence *kgsl_timeline_fence_alloc(struct kgsl_timeline *timeline,
 	dma_fence_init(&fence->base, &timeline_fence_ops,
 		&timeline->lock, timeline->context, seqno);
 
-	INIT_LIST_HEAD(&fence->node);
+	RB_CLEAR_NODE(&fence->node);
+	INIT_LIST_HEAD(&fence->list);
 
 	/*
 	 * Once fence is checked as not signaled, allow it to be added
@@ -343,20 +390,57 @@ long kgsl_ioctl_timeline_create(struct kgsl_device_private *dev_priv,
 	return 0;
 }
 
+/* Look up a timeline and get a reference to it. Call under rcu_read_lock() */
+static struct kgsl_timeline *kgsl_timeline_by_id_rcu(struct kgsl_device *device,
+		u32 id)
+{
+	struct kgsl_timeline *timeline = idr_find(&device->timelines, id);
+
+	if (timeline && kref_get_unless_zero(&timeline->ref))
+		return timeline;
+
+	return NULL;
+}
+
 struct kgsl_timeline *kgsl_timeline_by_id(struct kgsl_device *device,
 		u32 id)
 {
 	struct kgsl_timeline *timeline;
-	int ret = 0;
 
-	spin_lock(&device->timelines_lock);
-	timeline = idr_find(&device->timelines, id);
+	rcu_read_lock();
+	timeline = kgsl_timeline_by_id_rcu(device, id);
+	rcu_read_unlock();
 
-	if (timeline)
-		ret = kref_get_unless_zero(&timeline->ref);
-	spin_unlock(&device->timelines_lock);
+	return timeline;
+}
+
+/* Wait for @fence for up to @tv_sec seconds and @tv_nsec nanoseconds */
+static long kgsl_timeline_fence_wait(struct dma_fence *fence, s64 tv_sec,
+		s64 tv_nsec)
+{
+	unsigned long timeout;
+	signed long ret;
 
-	return ret ? timeline : NULL;
+	if (tv_sec >= KTIME_SEC_MAX)
+		timeout = MAX_SCHEDULE_TIMEOUT;
+	else {
+		ktime_t time = ktime_set(tv_sec, tv_nsec);
+
+		timeout = msecs_to_jiffies(ktime_to_ms(time));
+	}
+
+	/* secs.nsecs to jiffies */
+	if (!timeout)
+		return dma_fence_is_signaled(fence) ? 0 : -EBUSY;
+
+	ret = dma_fence_wait_timeout(fence, true, timeout);
+
+	if (!ret)
+		ret = -ETIMEDOUT;
+	else if (ret > 0)
+		ret = 0;
+
+	return ret;
 }
 
 long kgsl_ioctl_timeline_wait(struct kgsl_device_private *dev_priv,
@@ -365,7 +449,6 @@ long kgsl_ioctl_timeline_wait(struct kgsl_device_private *dev_priv,
 	struct kgsl_device *device = dev_priv->device;
 	struct kgsl_timeline_wait *param = data;
 	struct dma_fence *fence;
-	unsigned long timeout;
 	signed long ret;
 
 	if (param->flags != KGSL_TIMELINE_WAIT_ANY &&
@@ -382,27 +465,9 @@ long kgsl_ioctl_timeline_wait(struct kgsl_device_private *dev_priv,
 	if (IS_ERR(fence))
 		return PTR_ERR(fence);
 
-	if (param->tv_sec >= KTIME_SEC_MAX)
-		timeout = MAX_SCHEDULE_TIMEOUT;
-	else {
-		ktime_t time = ktime_set(param->tv_sec, param->tv_nsec);
-
-		timeout = msecs_to_jiffies(ktime_to_ms(time));
-	}
-
 	trace_kgsl_timeline_wait(param->flags, param->tv_sec, param->tv_nsec);
 
-	/* secs.nsecs to jiffies */
-	if (!timeout)
-		ret = dma_fence_is_signaled(fence) ? 0 : -EBUSY;
-	else {
-		ret = dma_fence_wait_timeout(fence, true, timeout);
-
-		if (!ret)
-			ret = -ETIMEDOUT;
-		else if (ret > 0)
-			ret = 0;
-	}
+	ret = kgsl_timeline_fence_wait(fence, param->tv_sec, param->tv_nsec);
 
 	dma_fence_put(fence);
 
@@ -549,14 +614,11 @@ long kgsl_ioctl_timeline_destroy(struct kgsl_device_private *dev_priv,
 	INIT_LIST_HEAD(&temp);
 
 	spin_lock(&timeline->fence_lock);
-	list_for_each_entry_safe(fence, tmp, &timeline->fences, node)
-		if (!kref_get_unless_zero(&fence->base.refcount))
-			list_del_init(&fence->node);
-	list_replace_init(&timeline->fences, &temp);
+	kgsl_timeline_pop_fences(timeline, U64_MAX, &temp);
 	spin_unlock(&timeline->fence_lock);
 
 	spin_lock_irq(&timeline->lock);
-	list_for_each_entry_safe(fence, tmp, &temp, node) {
+	list_for_each_entry_safe(fence, tmp, &temp, list) {
 		dma_fence_set_error(&fence->base, -ENOENT);
 		dma_fence_signal_locked(&fence->base);
 		dma_fence_put(&fence->base);
@@ -567,3 +629,150 @@ long kgsl_ioctl_timeline_destroy(struct kgsl_device_private *dev_priv,
 
 	return 0;
 }
+
+/* Copy @count &struct kgsl_timeline_val entries of @usize bytes each */
+static int kgsl_timeline_vals_copy(struct kgsl_timeline_val *vals, u64 timelines,
+		u32 count, u32 usize)
+{
+	void __user *uptr = u64_to_user_ptr(timelines);
+	u32 i;
+
+	for (i = 0; i < count; i++) {
+		if (copy_struct_from_user(&vals[i], sizeof(vals[i]), uptr, usize))
+			return -EFAULT;
+
+		if (vals[i].padding)
+			return -EINVAL;
+
+		uptr += usize;
+	}
+
+	return 0;
+}
+
+long kgsl_ioctl_timeline_signal_wait(struct kgsl_device_private *dev_priv,
+		unsigned int cmd, void *data)
+{
+	struct kgsl_device *device = dev_priv->device;
+	struct kgsl_timeline_signal_wait *param = data;
+	struct kgsl_timeline **timelines = NULL;
+	struct kgsl_timeline_val *vals = NULL;
+	struct dma_fence **fences = NULL;
+	struct dma_fence *fence;
+	u32 i, total;
+	long ret;
+
+	if ((param->signals_count && !param->signals_size) ||
+		(param->waits_count && !param->waits_size)) {
+		param->signals_size = sizeof(struct kgsl_timeline_val);
+		param->waits_size = sizeof(struct kgsl_timeline_val);
+		return -EAGAIN;
+	}
+
+	if (param->padding)
+		return -EINVAL;
+
+	if (param->waits_count && param->flags != KGSL_TIMELINE_WAIT_ANY &&
+		param->flags != KGSL_TIMELINE_WAIT_ALL)
+		return -EINVAL;
+
+	if (param->signals_count > INT_MAX ||
+		param->waits_count > INT_MAX - param->signals_count)
+		return -EINVAL;
+
+	total = param->signals_count + param->waits_count;
+	if (!total)
+		return -EINVAL;
+
+	vals = kvcalloc(total, sizeof(*vals), GFP_KERNEL);
+	timelines = kvcalloc(total, sizeof(*timelines), GFP_KERNEL);
+	if (!vals || !timelines) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	ret = kgsl_timeline_vals_copy(vals, param->signals,
+		param->signals_count, param->signals_size);
+	if (ret)
+		goto out;
+
+	ret = kgsl_timeline_vals_copy(&vals[param->signals_count], param->waits,
+		param->waits_count, param->waits_size);
+	if (ret)
+		goto out;
+
+	/* Resolve every timeline up front in a single RCU read section */
+	rcu_read_lock();
+	for (i = 0; i < total; i++) {
+		timelines[i] = kgsl_timeline_by_id_rcu(device,
+			vals[i].timeline);
+		if (!timelines[i])
+			break;
+	}
+	rcu_read_unlock();
+
+	if (i < total) {
+		ret = -ENODEV;
+		goto out;
+	}
+
+	for (i = 0; i < param->signals_count; i++)
+		kgsl_timeline_signal(timelines[i], vals[i].seqno);
+
+	if (!param->waits_count)
+		goto out;
+
+	fences = kcalloc(param->waits_count, sizeof(*fences),
+		GFP_KERNEL | __GFP_NORETRY | __GFP_NOWARN);
+	if (!fences) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < param->waits_count; i++) {
+		u32 index = param->signals_count + i;
+
+		fences[i] = kgsl_timeline_fence_alloc(timelines[index],
+			vals[index].seqno);
+		if (IS_ERR(fences[i])) {
+			ret = PTR_ERR(fences[i]);
+			goto out;
+		}
+	}
+
+	fence = kgsl_timeline_fence_array(fences, param->waits_count,
+		(param->flags == KGSL_TIMELINE_WAIT_ANY));
+	if (!fence) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	/* The fence array owns the fences now */
+	fences = NULL;
+
+	trace_kgsl_timeline_wait(param->flags, param->tv_sec, param->tv_nsec);
+
+	ret = kgsl_timeline_fence_wait(fence, param->tv_sec, param->tv_nsec);
+
+	dma_fence_put(fence);
+
+out:
+	if (fences) {
+		for (i = 0; i < param->waits_count; i++) {
+			if (!IS_ERR_OR_NULL(fences[i]))
+				dma_fence_put(fences[i]);
+		}
+
+		kfree(fences);
+	}
+
+	if (timelines) {
+		for (i = 0; i < total; i++)
+			kgsl_timeline_put(timelines[i]);
+	}
+
+	kvfree(timelines);
+	kvfree(vals);
+
+	return ret;
+}
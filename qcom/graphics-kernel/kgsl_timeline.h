@@ -22,12 +22,14 @@ struct kgsl_timeline {
 	spinlock_t lock;
 	/** @ref: Reference count for the struct */
 	struct kref ref;
-	/** @fences: sorted list of active fences */
-	struct list_head fences;
+	/** @fences: Tree of active fences sorted by seqno */
+	struct rb_root_cached fences;
 	/** @name: Name of the timeline for debugging */
 	const char name[32];
 	/** @dev_priv: pointer to the owning device instance */
 	struct kgsl_device_private *dev_priv;
+	/** @rcu: RCU head to free the timeline after lockless lookups finish */
+	struct rcu_head rcu;
 };
 
 /**
@@ -65,6 +65,28 @@
 void hw_fence_ipcc_trigger_signal(struct hw_fence_driver_data *drv_data,
 	u32 tx_client_id, u32 rx_client_id, u32 signal_id);
 
+/**
+ * hw_fence_ipcc_sw_loopback_init() - Initialize the software loopback of the ipc signals.
+ * @drv_data: driver data.
+ *
+ * When drv_data->ipc_sw_loopback is set, hw_fence_ipcc_trigger_signal() does not write to the
+ * ipcc; signals sent by this driver to its own loopback clients are processed in software instead,
+ * which allows to exercise the queues and signal paths without the fence controller.
+ * Signals always take the software loopback when the ipcc registers are not mapped.
+ */
+void hw_fence_ipcc_sw_loopback_init(struct hw_fence_driver_data *drv_data);
+
+/**
+ * hw_fence_ipcc_sw_init() - Initialize the ipc data of the driver without an ipcc.
+ * @drv_data: driver data.
+ *
+ * This API is used with the software fence controller in place of mapping and enabling the ipcc;
+ * it initializes the ipc clients mapping and enables the software loopback of the ipc signals.
+ *
+ * Return: 0 on success or negative errno (-EINVAL)
+ */
+int hw_fence_ipcc_sw_init(struct hw_fence_driver_data *drv_data);
+
 /**
  * hw_fence_ipcc_enable_signaling() - Enable ipcc signaling for hw-fence driver.
  * @drv_data: driver data.
@@ -13,6 +13,7 @@
 #include <linux/soc/qcom/msm_hw_fence.h>
 #include <linux/dma-fence-array.h>
 #include <linux/slab.h>
+#include <linux/workqueue.h>
 
 /* Add define only for platforms that support IPCC in dpu-hw */
 #define HW_DPU_IPCC 1
@@ -24,6 +25,18 @@
 #define HW_FENCE_HASH_A_MULT	4969 /* a multiplier for Hash algorithm */
 #define HW_FENCE_HASH_C_MULT	907  /* c multiplier for Hash algorithm */
 
+/*
+ * Number of slots probed from each of the two home buckets of a fence before the lookup falls
+ * back to walking the whole table
+ */
+#define HW_FENCE_HASH_MAX_PROBE	16
+
+/* Buckets of the probe length histogram: 0, 1, 2-3, 4-7, ..., and everything past the window */
+#define HW_FENCE_HASH_PROBE_HIST	(ilog2(2 * HW_FENCE_HASH_MAX_PROBE) + 2)
+
+/* Max number of rx queue payloads that are written with a single index update and ipc signal */
+#define HW_FENCE_SIGNAL_BATCH_MAX	8
+
 /* number of queues per type (i.e. ctrl or client queues) */
 #define HW_FENCE_CTRL_QUEUES	2 /* Rx and Tx Queues */
 #define HW_FENCE_CLIENT_QUEUES	2 /* Rx and Tx Queues */
@@ -236,6 +249,66 @@ struct msm_hw_fence_dbg_data {
 	u64 lock_wake_cnt;
 };
 
+/**
+ * struct hw_fence_hash_stats - Statistics of the hw-fences table lookups
+ *
+ * @overflow: number of reserved hw-fences that did not fit in their bounded probe window, while
+ *            non-zero the lookups of missing fences walk the whole table
+ * @overflow_map: table entries counted in @overflow, cleared when the entry is unreserved
+ * @insert_probes: histogram of the probe length of fence creations
+ * @lookup_probes: histogram of the probe length of fence finds and destroys
+ * @lookup_misses: number of finds and destroys that did not find the fence
+ *
+ * Histograms and miss counts are updated without locking and are approximate. The occupancy is
+ * not tracked here, since fences can be released by paths other than a destroy lookup; the
+ * debugfs node counts the valid entries of the table instead.
+ */
+struct hw_fence_hash_stats {
+	atomic_t overflow;
+	unsigned long *overflow_map;
+	u64 insert_probes[HW_FENCE_HASH_PROBE_HIST];
+	u64 lookup_probes[HW_FENCE_HASH_PROBE_HIST];
+	u64 lookup_misses;
+};
+
+/**
+ * struct hw_fence_signal_stats - Statistics of the client queues updates and ipc signals
+ *
+ * @payloads: number of payloads written to the client queues
+ * @queue_updates: number of write-index updates of the client queues
+ * @ipc_signals: number of ipc signals triggered by this driver
+ * @ipc_sw_loopback: number of ipc signals that were looped back in software
+ */
+struct hw_fence_signal_stats {
+	atomic64_t payloads;
+	atomic64_t queue_updates;
+	atomic64_t ipc_signals;
+	atomic64_t ipc_sw_loopback;
+};
+
+/**
+ * struct hw_fence_sw_ctrl - Software emulation of the fence controller
+ *
+ * @thread: kthread that consumes the client tx queues, in place of the fence controller
+ * @wait_queue: wait queue where @thread waits for ipc signals to the fence controller
+ * @pending: set when an ipc signal was sent while the software fence controller is enabled
+ * @mem: memory allocated in place of the carved-out memory
+ * @mem_size: size of @mem
+ * @signaled: number of hw-fences signaled by the software fence controller
+ * @latency_total: sum of the qtime ticks from the tx queue write to the signal of the hw-fences
+ * @latency_max: max qtime ticks from the tx queue write to the signal of a hw-fence
+ */
+struct hw_fence_sw_ctrl {
+	struct task_struct *thread;
+	wait_queue_head_t wait_queue;
+	atomic_t pending;
+	void *mem;
+	size_t mem_size;
+	u64 signaled;
+	u64 latency_total;
+	u64 latency_max;
+};
+
 /**
  * struct hw_fence_client_queue_size_desc - Structure holding client queue properties for a client.
  *
@@ -270,6 +343,7 @@ struct hw_fence_client_queue_size_desc {
  * @clients_num: number of supported hw fence clients (configured based on device-tree)
  * @hw_fences_tbl: pointer to the hw-fences table
  * @hw_fences_tbl_cnt: number of elements in the hw-fence table
+ * @hash_stats: occupancy and probe length statistics of the hw-fence table
  * @client_lock_tbl: pointer to the per-client locks table
  * @client_lock_tbl_cnt: number of elements in the locks table
  * @hw_fences_mem_desc: memory descriptor for the hw-fence table
@@ -294,6 +368,14 @@ struct hw_fence_client_queue_size_desc {
  * @ipcc_client_vid: ipcc client virtual-id for this driver
  * @ipcc_client_pid: ipcc client physical-id for this driver
  * @ipc_clients_table: table with the ipcc mapping for each client of this driver
+ * @ipc_sw_loopback: flag to indicate that ipc signals to this driver are processed in software
+ *                   instead of being written to the ipcc
+ * @ipc_sw_loopback_mask: mask of the loopback clients pending to be processed in software
+ * @ipc_sw_loopback_work: work that processes the software loopback signals
+ * @signal_stats: counters of the client queues updates and ipc signals
+ * @sw_ctrl_enabled: flag to indicate that the fence controller, the ipcc and the carved-out memory
+ *                   are emulated in software
+ * @sw_ctrl: software fence controller state
  * @qtime_reg_base: qtimer register base address
  * @qtime_io_mem: qtimer io mem map
  * @qtime_size: qtimer io mem map size
@@ -326,6 +408,7 @@ struct hw_fence_driver_data {
 	/* HW Fences Table VA */
 	struct msm_hw_fence *hw_fences_tbl;
 	u32 hw_fences_tbl_cnt;
+	struct hw_fence_hash_stats hash_stats;
 
 	/* Table with a Per-Client Lock */
 	u64 *client_lock_tbl;
@@ -367,6 +450,16 @@ struct hw_fence_driver_data {
 	/* table with mapping of ipc client for each hw-fence client */
 	struct hw_fence_client_ipc_map *ipc_clients_table;
 
+	/* software loopback of the ipc signals */
+	bool ipc_sw_loopback;
+	atomic64_t ipc_sw_loopback_mask;
+	struct work_struct ipc_sw_loopback_work;
+	struct hw_fence_signal_stats signal_stats;
+
+	/* software fence controller */
+	bool sw_ctrl_enabled;
+	struct hw_fence_sw_ctrl sw_ctrl;
+
 	/* qtime reg */
 	phys_addr_t qtime_reg_base;
 	void __iomem *qtime_io_mem;
@@ -421,6 +514,21 @@ struct msm_hw_fence_queue_payload {
 	u32 reserve;
 };
 
+/**
+ * struct hw_fence_signal_batch - rx queue payloads of a client pending to be signaled.
+ * @client: client that receives the payloads, NULL if the batch is empty
+ * @count: number of valid entries in @payloads
+ * @payloads: payloads to write to the rx queue of @client
+ *
+ * A batch lets a caller that signals several fences write all of them to the client rx queue
+ * with a single write-index update followed by a single ipc signal.
+ */
+struct hw_fence_signal_batch {
+	struct msm_hw_fence_client *client;
+	u32 count;
+	struct msm_hw_fence_queue_payload payloads[HW_FENCE_SIGNAL_BATCH_MAX];
+};
+
 /**
  * struct msm_hw_fence - structure holding each hw fence data.
  * @valid: field updated when a hw-fence is reserved. True if hw-fence is in use
@@ -485,19 +593,27 @@ int hw_fence_destroy_with_hash(struct hw_fence_driver_data *drv_data,
 	struct msm_hw_fence_client *hw_fence_client, u64 hash);
 int hw_fence_process_fence_array(struct hw_fence_driver_data *drv_data,
 	struct msm_hw_fence_client *hw_fence_client,
-	struct dma_fence_array *array, u64 *hash_join_fence, u64 client_data);
+	struct dma_fence_array *array, u64 *hash_join_fence, u64 client_data,
+	struct hw_fence_signal_batch *batch);
 int hw_fence_process_fence(struct hw_fence_driver_data *drv_data,
 	struct msm_hw_fence_client *hw_fence_client, struct dma_fence *fence, u64 *hash,
-	u64 client_data);
+	u64 client_data, struct hw_fence_signal_batch *batch);
 int hw_fence_update_queue(struct hw_fence_driver_data *drv_data,
 	struct msm_hw_fence_client *hw_fence_client, u64 ctxt_id, u64 seqno, u64 hash,
 	u64 flags, u64 client_data, u32 error, int queue_type);
+int hw_fence_update_queue_batch(struct hw_fence_driver_data *drv_data,
+	struct msm_hw_fence_client *hw_fence_client,
+	const struct msm_hw_fence_queue_payload *payloads, u32 count, int queue_type);
+void hw_fence_signal_batch_flush(struct hw_fence_driver_data *drv_data,
+	struct hw_fence_signal_batch *batch);
+void hw_fence_signal_fence(struct hw_fence_driver_data *drv_data, u64 hash, u32 error,
+	struct hw_fence_signal_batch *batch);
 inline u64 hw_fence_get_qtime(struct hw_fence_driver_data *drv_data);
 int hw_fence_read_queue(struct msm_hw_fence_client *hw_fence_client,
 	struct msm_hw_fence_queue_payload *payload, int queue_type);
 int hw_fence_register_wait_client(struct hw_fence_driver_data *drv_data,
 	struct dma_fence *fence, struct msm_hw_fence_client *hw_fence_client, u64 context,
-	u64 seqno, u64 *hash, u64 client_data);
+	u64 seqno, u64 *hash, u64 client_data, struct hw_fence_signal_batch *batch);
 struct msm_hw_fence *msm_hw_fence_find(struct hw_fence_driver_data *drv_data,
 	struct msm_hw_fence_client *hw_fence_client,
 	u64 context, u64 seqno, u64 *hash);
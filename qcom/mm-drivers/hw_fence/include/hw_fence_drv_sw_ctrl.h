@@ -0,0 +1,46 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ */
+
+#ifndef __HW_FENCE_DRV_SW_CTRL_H
+#define __HW_FENCE_DRV_SW_CTRL_H
+
+/**
+ * hw_fence_sw_ctrl_alloc_mem() - Allocates the memory used in place of the carved-out memory.
+ * @drv_data: driver data.
+ *
+ * The memory is a plain kernel allocation that is not shared with any VM, so the driver is
+ * ready to be used as soon as the allocation succeeds.
+ *
+ * Return: 0 on success or negative errno (-ENOMEM)
+ */
+int hw_fence_sw_ctrl_alloc_mem(struct hw_fence_driver_data *drv_data);
+
+/**
+ * hw_fence_sw_ctrl_init() - Starts the software fence controller.
+ * @drv_data: driver data.
+ *
+ * The software fence controller is a kthread that, every time an ipc signal is sent, consumes the
+ * tx queues of the registered clients and signals the hw-fences written to them, the same way
+ * the fence controller does.
+ *
+ * Return: 0 on success or negative errno
+ */
+int hw_fence_sw_ctrl_init(struct hw_fence_driver_data *drv_data);
+
+/**
+ * hw_fence_sw_ctrl_deinit() - Stops the software fence controller and releases its memory.
+ * @drv_data: driver data.
+ */
+void hw_fence_sw_ctrl_deinit(struct hw_fence_driver_data *drv_data);
+
+/**
+ * hw_fence_sw_ctrl_kick() - Wakes up the software fence controller.
+ * @drv_data: driver data.
+ *
+ * This is the software equivalent of an ipc signal to the fence controller.
+ */
+void hw_fence_sw_ctrl_kick(struct hw_fence_driver_data *drv_data);
+
+#endif /* __HW_FENCE_DRV_SW_CTRL_H */
@@ -345,7 +345,7 @@ static ssize_t hw_fence_dbg_tx_and_signal_clients_wr(struct file *file,
 		/**********************************************/
 		/* use same context and seqno that src client used to create fence */
 		ret = hw_fence_register_wait_client(drv_data, NULL, hw_fence_client_dst, context,
-			seqno, &hash, 0);
+			seqno, &hash, 0, NULL);
 		if (ret) {
 			HWFNC_ERR("failed to register for wait\n");
 			return -EINVAL;
@@ -692,6 +692,135 @@ exit:
 	return len;
 }
 
+/* Number of equally sized regions of the table reported by the occupancy histogram */
+#define HW_FENCE_DEBUG_OCCUPANCY_REGIONS 16
+
+/**
+ * hw_fence_dbg_hash_stats_rd() - debugfs read to dump the hw-fences table lookup statistics.
+ * @file: file handler.
+ * @user_buf: user buffer content for debugfs.
+ * @user_buf_size: size of the user buffer.
+ * @ppos: position offset of the user buffer.
+ *
+ * This debugfs dumps the occupancy of the hw-fences table, split in equally sized regions along
+ * with the longest run of consecutive valid entries, and the histograms of the number of probes
+ * that the creation and the look-up of the hw-fences needed.
+ */
+static ssize_t hw_fence_dbg_hash_stats_rd(struct file *file, char __user *user_buf,
+	size_t user_buf_size, loff_t *ppos)
+{
+	u32 regions[HW_FENCE_DEBUG_OCCUPANCY_REGIONS] = {0};
+	struct hw_fence_driver_data *drv_data;
+	struct hw_fence_hash_stats *stats;
+	u32 i, valid = 0, run = 0, max_run = 0, region_size;
+	int len = 0, max_size = SZ_4K;
+	char *buf;
+	ssize_t ret;
+
+	if (!file || !file->private_data) {
+		HWFNC_ERR("unexpected data %d\n", file);
+		return -EINVAL;
+	}
+	drv_data = file->private_data;
+	stats = &drv_data->hash_stats;
+
+	if (!drv_data->hw_fences_tbl || !drv_data->hw_fences_tbl_cnt) {
+		HWFNC_ERR("Failed to dump stats: Null fence table\n");
+		return -EINVAL;
+	}
+
+	buf = kzalloc(max_size, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	region_size = DIV_ROUND_UP(drv_data->hw_fences_tbl_cnt, HW_FENCE_DEBUG_OCCUPANCY_REGIONS);
+
+	for (i = 0; i < drv_data->hw_fences_tbl_cnt; i++) {
+		if (!drv_data->hw_fences_tbl[i].valid) {
+			run = 0;
+			continue;
+		}
+
+		valid++;
+		regions[i / region_size]++;
+		max_run = max(max_run, ++run);
+	}
+
+	len += scnprintf(buf + len, max_size - len,
+		"entries:%u valid:%u overflow:%d max_run:%u misses:%llu\n",
+		drv_data->hw_fences_tbl_cnt, valid, atomic_read(&stats->overflow), max_run,
+		stats->lookup_misses);
+
+	len += scnprintf(buf + len, max_size - len, "occupancy per %u entries:\n", region_size);
+	for (i = 0; i < HW_FENCE_DEBUG_OCCUPANCY_REGIONS; i++)
+		len += scnprintf(buf + len, max_size - len, "  [%5u] %u\n", i * region_size,
+			regions[i]);
+
+	len += scnprintf(buf + len, max_size - len, "probes     insert     lookup\n");
+	for (i = 0; i < HW_FENCE_HASH_PROBE_HIST; i++) {
+		if (i == HW_FENCE_HASH_PROBE_HIST - 1)
+			len += scnprintf(buf + len, max_size - len, "  >=%-4u",
+				2 * HW_FENCE_HASH_MAX_PROBE);
+		else
+			len += scnprintf(buf + len, max_size - len, "  <%-5u", 1 << i);
+
+		len += scnprintf(buf + len, max_size - len, " %10llu %10llu\n",
+			stats->insert_probes[i], stats->lookup_probes[i]);
+	}
+
+	ret = simple_read_from_buffer(user_buf, user_buf_size, ppos, buf, len);
+	kfree(buf);
+
+	return ret;
+}
+
+/**
+ * hw_fence_dbg_signal_stats_rd() - debugfs read to dump the queues updates and ipc signals stats.
+ * @file: file handler.
+ * @user_buf: user buffer content for debugfs.
+ * @user_buf_size: size of the user buffer.
+ * @ppos: position offset of the user buffer.
+ *
+ * This debugfs dumps the number of payloads written to the client queues, the number of
+ * write-index updates that published them and the number of ipc signals sent by the driver,
+ * which allows to measure how well the signals of the fences are batched. With the software
+ * fence controller it also dumps the number of hw-fences it signaled and the latency from the
+ * tx queue write to the signal.
+ */
+static ssize_t hw_fence_dbg_signal_stats_rd(struct file *file, char __user *user_buf,
+	size_t user_buf_size, loff_t *ppos)
+{
+	struct hw_fence_driver_data *drv_data;
+	struct hw_fence_signal_stats *stats;
+	struct hw_fence_sw_ctrl *sw_ctrl;
+	char buf[320];
+	int len;
+
+	if (!file || !file->private_data) {
+		HWFNC_ERR("unexpected data %d\n", file);
+		return -EINVAL;
+	}
+	drv_data = file->private_data;
+	stats = &drv_data->signal_stats;
+
+	len = scnprintf(buf, sizeof(buf),
+		"payloads:%lld queue_updates:%lld ipc_signals:%lld sw_loopback:%lld (%s)\n",
+		atomic64_read(&stats->payloads), atomic64_read(&stats->queue_updates),
+		atomic64_read(&stats->ipc_signals), atomic64_read(&stats->ipc_sw_loopback),
+		drv_data->ipc_sw_loopback ? "on" : "off");
+
+	if (drv_data->sw_ctrl_enabled) {
+		sw_ctrl = &drv_data->sw_ctrl;
+		len += scnprintf(buf + len, sizeof(buf) - len,
+			"sw_ctrl signaled:%llu latency avg:%llu max:%llu qtime ticks\n",
+			sw_ctrl->signaled,
+			sw_ctrl->signaled ? div64_u64(sw_ctrl->latency_total, sw_ctrl->signaled) : 0,
+			sw_ctrl->latency_max);
+	}
+
+	return simple_read_from_buffer(user_buf, user_buf_size, ppos, buf, len);
+}
+
 /**
  * hw_fence_dbg_dump_table_wr() - debugfs write to control the dump of the hw-fences table.
  * @file: file handler.
@@ -782,6 +911,7 @@ static ssize_t hw_fence_dbg_create_join_fence(struct file *file,
 	int num_fences = 3;
 	struct dma_fence **fences = NULL;
 	spinlock_t **fences_lock = NULL;
+	struct msm_hw_fence_queue_payload *payloads = NULL;
 
 	if (!file || !file->private_data) {
 		HWFNC_ERR("unexpected data %d\n", file);
@@ -841,7 +971,13 @@ static ssize_t hw_fence_dbg_create_join_fence(struct file *file,
 		return -EINVAL;
 	}
 
-	/* create hw fence and write to tx queue for each dma fence */
+	payloads = kcalloc(num_fences, sizeof(*payloads), GFP_KERNEL);
+	if (!payloads) {
+		count = -ENOMEM;
+		goto error;
+	}
+
+	/* create hw fence for each dma fence */
 	for (i = 0; i < num_fences; i++) {
 		params.fence = fences[i];
 		params.handle = &hash;
@@ -853,12 +989,15 @@ static ssize_t hw_fence_dbg_create_join_fence(struct file *file,
 			goto error;
 		}
 
-		/* Write to Tx queue */
-		hw_fence_update_queue(drv_data, hw_fence_client, client_info_src->dma_context,
-			hw_fence_dbg_seqno + i, hash, 0, 0, 0,
-			HW_FENCE_TX_QUEUE - 1);
+		payloads[i].ctxt_id = client_info_src->dma_context;
+		payloads[i].seqno = hw_fence_dbg_seqno + i;
+		payloads[i].hash = hash;
 	}
 
+	/* Write all the fences to the Tx queue at once */
+	hw_fence_update_queue_batch(drv_data, hw_fence_client, payloads, num_fences,
+		HW_FENCE_TX_QUEUE - 1);
+
 	/* wait on the fence array */
 	fence_array_fence = &fence_array->base;
 	msm_hw_fence_wait_update_v2(client_info_dst->client_handle, &fence_array_fence, NULL, NULL,
@@ -887,6 +1026,7 @@ error:
 	 * from the fence-array release api
 	 */
 	kfree(fences_lock);
+	kfree(payloads);
 
 	return count;
 }
@@ -950,6 +1090,16 @@ static const struct file_operations hw_fence_dump_table_fops = {
 	.read = hw_fence_dbg_dump_table_rd,
 };
 
+static const struct file_operations hw_fence_hash_stats_fops = {
+	.open = simple_open,
+	.read = hw_fence_dbg_hash_stats_rd,
+};
+
+static const struct file_operations hw_fence_signal_stats_fops = {
+	.open = simple_open,
+	.read = hw_fence_dbg_signal_stats_rd,
+};
+
 static const struct file_operations hw_fence_dump_queues_fops = {
 	.open = simple_open,
 	.write = hw_fence_dbg_dump_queues_wr,
@@ -1003,6 +1153,13 @@ int hw_fence_debug_debugfs_register(struct hw_fence_driver_data *drv_data)
 		&hw_fence_dump_table_fops);
 	debugfs_create_file("hw_fence_dump_queues", 0600, debugfs_root, drv_data,
 		&hw_fence_dump_queues_fops);
+	debugfs_create_file("hw_fence_hash_stats", 0400, debugfs_root, drv_data,
+		&hw_fence_hash_stats_fops);
+	debugfs_create_file("hw_fence_signal_stats", 0400, debugfs_root, drv_data,
+		&hw_fence_signal_stats_fops);
+	/* loopback cannot be turned off when the ipcc is emulated in software */
+	debugfs_create_bool("ipc_sw_loopback", drv_data->ipcc_io_mem ? 0600 : 0400, debugfs_root,
+		&drv_data->ipc_sw_loopback);
 	debugfs_create_file("hw_sync", 0600, debugfs_root, NULL, &hw_sync_debugfs_fops);
 	debugfs_create_u64("hw_fence_lock_wake_cnt", 0600, debugfs_root,
 		&drv_data->debugfs_data.lock_wake_cnt);
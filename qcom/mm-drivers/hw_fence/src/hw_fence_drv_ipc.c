@@ -8,6 +8,7 @@
 #include "hw_fence_drv_utils.h"
 #include "hw_fence_drv_ipc.h"
 #include "hw_fence_drv_debug.h"
+#include "hw_fence_drv_sw_ctrl.h"
 
 /*
  * Max size of base table with ipc mappings, with one mapping per client type with configurable
@@ -264,12 +265,92 @@ static inline char *_get_ipc_virt_client_name(u32 client_id)
 	return "UNKNOWN_VID";
 }
 
+/**
+ * _hw_fence_ipcc_get_loopback_id() - Returns the loopback client that the ipc signal from this
+ *		driver to itself is meant for, or a negative errno if the signal has no loopback client.
+ */
+static int _hw_fence_ipcc_get_loopback_id(struct hw_fence_driver_data *drv_data,
+	u32 rx_client_vid, u32 signal_id)
+{
+	struct hw_fence_client_ipc_map *map;
+	int client_id;
+
+	if (rx_client_vid != drv_data->ipcc_client_vid || !drv_data->ipc_clients_table)
+		return -EINVAL;
+
+	for (client_id = 0; client_id < drv_data->clients_num; client_id++) {
+		map = &drv_data->ipc_clients_table[client_id];
+		if (map->ipc_client_id_virt != rx_client_vid || map->ipc_signal_id != signal_id)
+			continue;
+
+		if (client_id >= HW_FENCE_CLIENT_ID_CTL0 && client_id <= HW_FENCE_CLIENT_ID_CTL5)
+			return HW_FENCE_LOOPBACK_DPU_CTL_0 + (client_id - HW_FENCE_CLIENT_ID_CTL0);
+#if IS_ENABLED(CONFIG_DEBUG_FS)
+		if (client_id >= HW_FENCE_CLIENT_ID_VAL0 && client_id <= HW_FENCE_CLIENT_ID_VAL6)
+			return HW_FENCE_LOOPBACK_VAL_0 + (client_id - HW_FENCE_CLIENT_ID_VAL0);
+#endif /* CONFIG_DEBUG_FS */
+	}
+
+	return -EINVAL;
+}
+
+static void _hw_fence_ipcc_sw_loopback_work(struct work_struct *work)
+{
+	struct hw_fence_driver_data *drv_data = container_of(work, struct hw_fence_driver_data,
+		ipc_sw_loopback_work);
+	u64 db_flags;
+
+	db_flags = atomic64_xchg(&drv_data->ipc_sw_loopback_mask, 0);
+	if (db_flags)
+		hw_fence_utils_process_doorbell_mask(drv_data, db_flags);
+}
+
+void hw_fence_ipcc_sw_loopback_init(struct hw_fence_driver_data *drv_data)
+{
+	atomic64_set(&drv_data->ipc_sw_loopback_mask, 0);
+	INIT_WORK(&drv_data->ipc_sw_loopback_work, _hw_fence_ipcc_sw_loopback_work);
+}
+
+/*
+ * Software loopback of an ipc signal, the signal is not written to the ipcc and, when it targets
+ * a loopback client of this driver, it is processed from a work the same way as a doorbell.
+ * Signals queued before the work runs are coalesced, like in the ipcc.
+ */
+static void _hw_fence_ipcc_sw_loopback(struct hw_fence_driver_data *drv_data,
+	u32 rx_client_vid, u32 signal_id)
+{
+	int loopback_id;
+
+	atomic64_inc(&drv_data->signal_stats.ipc_sw_loopback);
+
+	loopback_id = _hw_fence_ipcc_get_loopback_id(drv_data, rx_client_vid, signal_id);
+	HWFNC_DBG_IRQ("sw loopback to %s (%d) signal_id:%d loopback_id:%d\n",
+		_get_ipc_virt_client_name(rx_client_vid), rx_client_vid, signal_id, loopback_id);
+	if (loopback_id < 0)
+		return;
+
+	atomic64_or(BIT_ULL(loopback_id), &drv_data->ipc_sw_loopback_mask);
+	schedule_work(&drv_data->ipc_sw_loopback_work);
+}
+
 void hw_fence_ipcc_trigger_signal(struct hw_fence_driver_data *drv_data,
 	u32 tx_client_pid, u32 rx_client_vid, u32 signal_id)
 {
 	void __iomem *ptr;
 	u32 val;
 
+	atomic64_inc(&drv_data->signal_stats.ipc_signals);
+
+	/* the software fence controller consumes the tx queues on every signal */
+	if (drv_data->sw_ctrl_enabled)
+		hw_fence_sw_ctrl_kick(drv_data);
+
+	/* without ipcc registers there is nothing to write, loopback regardless of the knob */
+	if (drv_data->ipc_sw_loopback || !drv_data->ipcc_io_mem) {
+		_hw_fence_ipcc_sw_loopback(drv_data, rx_client_vid, signal_id);
+		return;
+	}
+
 	/* Send signal */
 	ptr = IPC_PROTOCOLp_CLIENTc_SEND(drv_data->ipcc_io_mem, drv_data->protocol_id,
 		tx_client_pid);
@@ -373,6 +454,27 @@ static int _hw_fence_ipcc_hwrev_init(struct hw_fence_driver_data *drv_data, u32
 	return ret;
 }
 
+int hw_fence_ipcc_sw_init(struct hw_fence_driver_data *drv_data)
+{
+	u32 val;
+	int ret;
+
+	/* without ipcc registers to read, default to the targets with apps-only ipc clients */
+	ret = of_property_read_u32(drv_data->dev->of_node, "qcom,hw-fence-ipc-ver", &val);
+	if (ret || !val)
+		val = HW_FENCE_IPCC_HW_REV_170;
+
+	if (_hw_fence_ipcc_hwrev_init(drv_data, val)) {
+		HWFNC_ERR("ipcc protocol id not supported\n");
+		return -EINVAL;
+	}
+
+	drv_data->ipc_sw_loopback = true;
+	HWFNC_DBG_INIT("ipcc emulated in software ver:0x%x\n", val);
+
+	return 0;
+}
+
 int hw_fence_ipcc_enable_signaling(struct hw_fence_driver_data *drv_data)
 {
 	void __iomem *ptr;
@@ -437,6 +539,10 @@ int hw_fence_ipcc_enable_dpu_signaling(struct hw_fence_driver_data *drv_data)
 		return -1;
 	}
 
+	/* no ipcc registers to program when the ipc signals are emulated */
+	if (drv_data->sw_ctrl_enabled)
+		return 0;
+
 	HWFNC_DBG_H("ipcc_io_mem:0x%lx\n", (u64)drv_data->ipcc_io_mem);
 
 	HWFNC_DBG_H("Initialize dpu signals\n");
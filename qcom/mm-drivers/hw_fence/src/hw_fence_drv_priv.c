@@ -3,6 +3,7 @@
  * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
  */
 
+#include <linux/hash.h>
 #include <linux/uaccess.h>
 #include <linux/of_platform.h>
 #include <linux/of_address.h>
@@ -11,6 +12,7 @@
 #include "hw_fence_drv_utils.h"
 #include "hw_fence_drv_ipc.h"
 #include "hw_fence_drv_debug.h"
+#include "hw_fence_drv_sw_ctrl.h"
 
 /* Global atomic lock */
 #define GLOBAL_ATOMIC_STORE(drv_data, lock, val) global_atomic_store(drv_data, lock, val)
@@ -18,6 +20,10 @@
 inline u64 hw_fence_get_qtime(struct hw_fence_driver_data *drv_data)
 {
 #ifdef HWFENCE_USE_SLEEP_TIMER
+	/* the software fence controller can run without the sleep timer registers */
+	if (!drv_data->qtime_io_mem)
+		return arch_timer_read_counter();
+
 	return readl_relaxed(drv_data->qtime_io_mem);
 #else /* USE QTIMER */
 	return arch_timer_read_counter();
@@ -216,6 +222,8 @@ int hw_fence_read_queue(struct msm_hw_fence_client *hw_fence_client,
 	payload->flags = readq_relaxed(&read_ptr_payload->flags);
 	payload->client_data = readq_relaxed(&read_ptr_payload->client_data);
 	payload->error = readl_relaxed(&read_ptr_payload->error);
+	payload->timestamp_lo = readl_relaxed(&read_ptr_payload->timestamp_lo);
+	payload->timestamp_hi = readl_relaxed(&read_ptr_payload->timestamp_hi);
 
 	/* update the read index */
 	writel_relaxed(to_read_idx, &hfi_header->read_index);
@@ -228,15 +236,18 @@ int hw_fence_read_queue(struct msm_hw_fence_client *hw_fence_client,
 }
 
 /*
- * This function writes to the queue of the client. The 'queue_type' determines
- * if this function is writing to the rx or tx queue
+ * This function writes 'count' payloads to the queue of the client, with a single update of the
+ * write index. The 'queue_type' determines if this function is writing to the rx or tx queue.
+ * Payloads that do not fit in the queue are dropped and -EINVAL is returned, payloads written
+ * before them remain in the queue.
  */
-int hw_fence_update_queue(struct hw_fence_driver_data *drv_data,
-	struct msm_hw_fence_client *hw_fence_client, u64 ctxt_id, u64 seqno, u64 hash,
-	u64 flags, u64 client_data, u32 error, int queue_type)
+int hw_fence_update_queue_batch(struct hw_fence_driver_data *drv_data,
+	struct msm_hw_fence_client *hw_fence_client,
+	const struct msm_hw_fence_queue_payload *payloads, u32 count, int queue_type)
 {
 	struct msm_hw_fence_hfi_queue_header *hfi_header;
 	struct msm_hw_fence_queue *queue;
+	const struct msm_hw_fence_queue_payload *payload;
 	u32 read_idx;
 	u32 write_idx;
 	u32 to_write_idx;
@@ -249,6 +260,7 @@ int hw_fence_update_queue(struct hw_fence_driver_data *drv_data,
 	u32 lock_idx;
 	u64 timestamp;
 	u32 *wr_ptr;
+	u32 i, fit;
 	int ret = 0;
 
 	if (queue_type >=
@@ -258,6 +270,9 @@ int hw_fence_update_queue(struct hw_fence_driver_data *drv_data,
 		return -EINVAL;
 	}
 
+	if (!count)
+		return 0;
+
 	queue = &hw_fence_client->queues[queue_type];
 	hfi_header = queue->va_header;
 
@@ -308,62 +323,79 @@ int hw_fence_update_queue(struct hw_fence_driver_data *drv_data,
 		read_idx, write_idx, queue, queue_type,
 		hw_fence_client->skip_txq_wr_idx ? "true" : "false");
 
-	/* Check queue to make sure message will fit */
+	/* Check queue to make sure the messages will fit, one slot always stays empty */
 	q_free_u32 = read_idx <= write_idx ? (q_size_u32 - (write_idx - read_idx)) :
 		(read_idx - write_idx);
-	if (q_free_u32 <= payload_size_u32) {
-		HWFNC_ERR("cannot fit the message size:%d\n", payload_size_u32);
+	fit = q_free_u32 > payload_size_u32 ? (q_free_u32 - 1) / payload_size_u32 : 0;
+	if (fit < count) {
+		HWFNC_ERR("cannot fit %u messages size:%d, only %u fit\n", count,
+			payload_size_u32, fit);
 		ret = -EINVAL;
-		goto exit;
+		count = fit;
+		if (!count)
+			goto exit;
 	}
-	HWFNC_DBG_Q("q_free_u32:%d payload_size_u32:%d\n", q_free_u32, payload_size_u32);
+	HWFNC_DBG_Q("q_free_u32:%d payload_size_u32:%d count:%u\n", q_free_u32,
+		payload_size_u32, count);
 
-	/* Move the pointer where we need to write and cast it */
-	q_payload_write_ptr = ((u32 *)queue->va_queue + write_idx);
-	write_ptr_payload = (struct msm_hw_fence_queue_payload *)q_payload_write_ptr;
-	HWFNC_DBG_Q("q_payload_write_ptr:0x%pK queue: va=0x%pK pa=0x%pK write_ptr_payload:0x%pK\n",
-		q_payload_write_ptr, queue->va_queue, queue->pa_queue, write_ptr_payload);
+	/* all the payloads of the batch share the same timestamp */
+	timestamp = hw_fence_get_qtime(drv_data);
 
-	/* calculate the index after the write */
-	to_write_idx = write_idx + payload_size_u32;
+	for (i = 0; i < count; i++) {
+		payload = &payloads[i];
 
-	HWFNC_DBG_Q("to_write_idx:%d write_idx:%d payload_size\n", to_write_idx, write_idx,
-		payload_size_u32);
-	HWFNC_DBG_L("client_id:%d update %s hash:%llu ctx_id:%llu seqno:%llu flags:%llu error:%u\n",
-		hw_fence_client->client_id, _get_queue_type(queue_type),
-		hash, ctxt_id, seqno, flags, error);
+		/* Move the pointer where we need to write and cast it */
+		q_payload_write_ptr = ((u32 *)queue->va_queue + write_idx);
+		write_ptr_payload = (struct msm_hw_fence_queue_payload *)q_payload_write_ptr;
+		HWFNC_DBG_Q("q_payload_write_ptr:0x%pK queue: va=0x%pK pa=0x%pK write_ptr:0x%pK\n",
+			q_payload_write_ptr, queue->va_queue, queue->pa_queue, write_ptr_payload);
 
-	/*
-	 * wrap-around case, here we are writing to the last element of the queue, therefore
-	 * set to_write_idx, which is the index after the write, to the beginning of the
-	 * queue
-	 */
-	if (to_write_idx >= q_size_u32)
-		to_write_idx = 0;
-
-	/* Update Client Queue */
-	writeq_relaxed(payload_size, &write_ptr_payload->size);
-	writew_relaxed(HW_FENCE_PAYLOAD_TYPE_1, &write_ptr_payload->type);
-	writew_relaxed(HW_FENCE_PAYLOAD_REV(1, 0), &write_ptr_payload->version);
-	writeq_relaxed(ctxt_id, &write_ptr_payload->ctxt_id);
-	writeq_relaxed(seqno, &write_ptr_payload->seqno);
-	writeq_relaxed(hash, &write_ptr_payload->hash);
-	writeq_relaxed(flags, &write_ptr_payload->flags);
-	writeq_relaxed(client_data, &write_ptr_payload->client_data);
-	writel_relaxed(error, &write_ptr_payload->error);
-	timestamp = hw_fence_get_qtime(drv_data);
-	writel_relaxed(timestamp, &write_ptr_payload->timestamp_lo);
-	writel_relaxed(timestamp >> 32, &write_ptr_payload->timestamp_hi);
+		/* calculate the index after the write */
+		to_write_idx = write_idx + payload_size_u32;
+
+		HWFNC_DBG_Q("to_write_idx:%d write_idx:%d payload_size:%d\n", to_write_idx,
+			write_idx, payload_size_u32);
+		HWFNC_DBG_L("client_id:%d update %s hash:%llu ctx_id:%llu seqno:%llu flags:%llu err:%u\n",
+			hw_fence_client->client_id, _get_queue_type(queue_type),
+			payload->hash, payload->ctxt_id, payload->seqno, payload->flags,
+			payload->error);
 
-	/* update memory for the message */
+		/*
+		 * wrap-around case, here we are writing to the last element of the queue, therefore
+		 * set to_write_idx, which is the index after the write, to the beginning of the
+		 * queue
+		 */
+		if (to_write_idx >= q_size_u32)
+			to_write_idx = 0;
+
+		/* Update Client Queue */
+		writeq_relaxed(payload_size, &write_ptr_payload->size);
+		writew_relaxed(HW_FENCE_PAYLOAD_TYPE_1, &write_ptr_payload->type);
+		writew_relaxed(HW_FENCE_PAYLOAD_REV(1, 0), &write_ptr_payload->version);
+		writeq_relaxed(payload->ctxt_id, &write_ptr_payload->ctxt_id);
+		writeq_relaxed(payload->seqno, &write_ptr_payload->seqno);
+		writeq_relaxed(payload->hash, &write_ptr_payload->hash);
+		writeq_relaxed(payload->flags, &write_ptr_payload->flags);
+		writeq_relaxed(payload->client_data, &write_ptr_payload->client_data);
+		writel_relaxed(payload->error, &write_ptr_payload->error);
+		writel_relaxed(timestamp, &write_ptr_payload->timestamp_lo);
+		writel_relaxed(timestamp >> 32, &write_ptr_payload->timestamp_hi);
+
+		write_idx = to_write_idx;
+	}
+
+	/* update memory for the messages */
 	wmb();
 
-	/* update the write index */
-	writel_relaxed(to_write_idx, wr_ptr);
+	/* update the write index once for the whole batch */
+	writel_relaxed(write_idx, wr_ptr);
 
 	/* update memory for the index */
 	wmb();
 
+	atomic64_add(count, &drv_data->signal_stats.payloads);
+	atomic64_inc(&drv_data->signal_stats.queue_updates);
+
 exit:
 	if (lock_client)
 		GLOBAL_ATOMIC_STORE(drv_data, &drv_data->client_lock_tbl[lock_idx], 0); /* unlock */
@@ -371,6 +403,26 @@ exit:
 	return ret;
 }
 
+/*
+ * This function writes to the queue of the client. The 'queue_type' determines
+ * if this function is writing to the rx or tx queue
+ */
+int hw_fence_update_queue(struct hw_fence_driver_data *drv_data,
+	struct msm_hw_fence_client *hw_fence_client, u64 ctxt_id, u64 seqno, u64 hash,
+	u64 flags, u64 client_data, u32 error, int queue_type)
+{
+	struct msm_hw_fence_queue_payload payload = {
+		.ctxt_id = ctxt_id,
+		.seqno = seqno,
+		.hash = hash,
+		.flags = flags,
+		.client_data = client_data,
+		.error = error,
+	};
+
+	return hw_fence_update_queue_batch(drv_data, hw_fence_client, &payload, 1, queue_type);
+}
+
 static int init_global_locks(struct hw_fence_driver_data *drv_data)
 {
 	struct msm_hw_fence_mem_addr *mem_descriptor;
@@ -432,6 +484,11 @@ static int init_hw_fences_table(struct hw_fence_driver_data *drv_data)
 	HWFNC_DBG_INIT("hw_fences_table:0x%pK cnt:%u\n", drv_data->hw_fences_tbl,
 		drv_data->hw_fences_tbl_cnt);
 
+	drv_data->hash_stats.overflow_map = devm_kcalloc(drv_data->dev,
+		BITS_TO_LONGS(drv_data->hw_fences_tbl_cnt), sizeof(unsigned long), GFP_KERNEL);
+	if (!drv_data->hash_stats.overflow_map)
+		return -ENOMEM;
+
 	return 0;
 }
 
@@ -463,8 +520,14 @@ int hw_fence_init(struct hw_fence_driver_data *drv_data)
 		goto exit;
 	}
 
-	/* Allocate hw fence driver mem pool and share it with HYP */
-	ret = hw_fence_utils_alloc_mem(drv_data);
+	/*
+	 * Allocate hw fence driver mem pool and share it with HYP, or allocate plain memory
+	 * when the fence controller is emulated in software
+	 */
+	if (drv_data->sw_ctrl_enabled)
+		ret = hw_fence_sw_ctrl_alloc_mem(drv_data);
+	else
+		ret = hw_fence_utils_alloc_mem(drv_data);
 	if (ret) {
 		HWFNC_ERR("failed to alloc base memory\n");
 		goto exit;
@@ -486,18 +549,28 @@ int hw_fence_init(struct hw_fence_driver_data *drv_data)
 	if (ret)
 		goto exit;
 
-	/* Map ipcc registers */
-	ret = hw_fence_utils_map_ipcc(drv_data);
+	hw_fence_ipcc_sw_loopback_init(drv_data);
+
+	/* Map ipcc registers, the software fence controller loops back the ipc signals instead */
+	if (drv_data->sw_ctrl_enabled)
+		ret = hw_fence_ipcc_sw_init(drv_data);
+	else
+		ret = hw_fence_utils_map_ipcc(drv_data);
 	if (ret) {
 		HWFNC_ERR("ipcc regs mapping failed\n");
 		goto exit;
 	}
 
-	/* Map time register */
-	ret = hw_fence_utils_map_qtime(drv_data);
-	if (ret) {
-		HWFNC_ERR("qtime reg mapping failed\n");
-		goto exit;
+	/* Map time register, optional for the software fence controller */
+	if (drv_data->sw_ctrl_enabled &&
+			!of_find_property(drv_data->dev->of_node, "qcom,qtime-reg", NULL)) {
+		HWFNC_DBG_INIT("no qtime regs, sw fence controller uses the arch timer\n");
+	} else {
+		ret = hw_fence_utils_map_qtime(drv_data);
+		if (ret) {
+			HWFNC_ERR("qtime reg mapping failed\n");
+			goto exit;
+		}
 	}
 
 	/* Map ctl_start registers */
@@ -516,8 +589,11 @@ int hw_fence_init(struct hw_fence_driver_data *drv_data)
 		goto exit;
 	}
 
-	/* Init vIRQ from VM */
-	ret = hw_fence_utils_init_virq(drv_data);
+	/* Init vIRQ from VM, or start the software fence controller that replaces the VM */
+	if (drv_data->sw_ctrl_enabled)
+		ret = hw_fence_sw_ctrl_init(drv_data);
+	else
+		ret = hw_fence_utils_init_virq(drv_data);
 	if (ret) {
 		HWFNC_ERR("failed to init virq\n");
 		goto exit;
@@ -666,45 +742,56 @@ void hw_fence_cleanup_client(struct hw_fence_driver_data *drv_data,
 	kfree(hw_fence_client);
 }
 
+/*
+ * Fences get two home buckets: the original multiplicative hash and a second one from an
+ * independent mix of the same inputs. The first 2 * HW_FENCE_HASH_MAX_PROBE steps alternate
+ * between the slots following each home bucket, so a fence always lands in the emptier of the
+ * two neighborhoods and is found again within a bounded number of probes. Only if both windows
+ * are full the remaining steps linearly walk the whole table starting at the first home bucket.
+ */
 static inline int _calculate_hash(u32 table_total_entries, u64 context, u64 seqno,
 	u64 step, u64 *hash)
 {
 	u64 m_size = table_total_entries;
-	int val = 0;
-
-	if (step == 0) {
-		u64 a_multiplier = HW_FENCE_HASH_A_MULT;
-		u64 c_multiplier = HW_FENCE_HASH_C_MULT;
-		u64 b_multiplier = context + (context - 1); /* odd multiplier */
+	u64 window = 2 * HW_FENCE_HASH_MAX_PROBE;
+	u64 a_multiplier = HW_FENCE_HASH_A_MULT;
+	u64 c_multiplier = HW_FENCE_HASH_C_MULT;
+	u64 b_multiplier = context + (context - 1); /* odd multiplier */
+	u64 home;
 
+	if (step >= window + m_size) {
 		/*
-		 * if m, is power of 2, we can optimize with right shift,
-		 * for now we don't do it, to avoid assuming a power of two
+		 * If we already traversed the whole table, return failure since this means
+		 * there are not available spots, table is either full or full-enough
+		 * that we couldn't find an available spot after traverse the whole table.
 		 */
-		*hash = (a_multiplier * seqno * b_multiplier + (c_multiplier * context)) % m_size;
-	} else {
-		if (step >= m_size) {
-			/*
-			 * If we already traversed the whole table, return failure since this means
-			 * there are not available spots, table is either full or full-enough
-			 * that we couldn't find an available spot after traverse the whole table.
-			 * Ideally table shouldn't be so full that we cannot find a value after some
-			 * iterations, so this maximum step size could be optimized to fail earlier.
-			 */
-			HWFNC_ERR("Fence Table tranversed and no available space!\n");
-			val = -EINVAL;
-		} else {
-			/*
-			 * Linearly increment the hash value to find next element in the table
-			 * note that this relies in the 'scrambled' data from the original hash
-			 * Also, add a mod division to wrap-around in case that we reached the
-			 * end of the table
-			 */
-			*hash = (*hash + 1) % m_size;
-		}
+		HWFNC_ERR("Fence Table tranversed and no available space!\n");
+		return -EINVAL;
 	}
 
-	return val;
+	/*
+	 * if m, is power of 2, we can optimize with right shift,
+	 * for now we don't do it, to avoid assuming a power of two
+	 */
+	home = (a_multiplier * seqno * b_multiplier + (c_multiplier * context)) % m_size;
+
+	if (step >= window)
+		*hash = (home + step - window) % m_size;
+	else if (step & 1)
+		*hash = (hash_64(seqno ^ (context * c_multiplier), 64) + (step >> 1)) % m_size;
+	else
+		*hash = (home + (step >> 1)) % m_size;
+
+	return 0;
+}
+
+/* Histogram bucket for a lookup that completed at @step */
+static inline u32 _hash_probe_bucket(u64 step)
+{
+	if (step >= 2 * HW_FENCE_HASH_MAX_PROBE)
+		return HW_FENCE_HASH_PROBE_HIST - 1;
+
+	return step ? ilog2(step) + 1 : 0;
 }
 
 static inline struct msm_hw_fence *_get_hw_fence(u32 table_total_entries,
@@ -790,6 +877,9 @@ static void  _unreserve_hw_fence(struct hw_fence_driver_data *drv_data,
 	/* unreserve this HW fence */
 	hw_fence->valid = 0;
 
+	if (test_and_clear_bit(hash, drv_data->hash_stats.overflow_map))
+		atomic_dec(&drv_data->hash_stats.overflow);
+
 	HWFNC_DBG_LUT("Unreserved fence client:%d ctx:%llu seq:%llu hash:%llu\n",
 		client_id, context, seqno, hash);
 }
@@ -830,6 +920,26 @@ static void  _fence_found(struct hw_fence_driver_data *drv_data,
 		client_id, context, seqno, hash);
 }
 
+/*
+ * Drop the overflow entries that are no longer valid, in case they were released without going
+ * through a destroy lookup. Called once a lookup already had to walk the whole table.
+ */
+static void _hw_fence_recount_overflow(struct hw_fence_driver_data *drv_data)
+{
+	struct hw_fence_hash_stats *stats = &drv_data->hash_stats;
+	struct msm_hw_fence *hw_fence;
+	u32 i;
+
+	for_each_set_bit(i, stats->overflow_map, drv_data->hw_fences_tbl_cnt) {
+		hw_fence = &drv_data->hw_fences_tbl[i];
+
+		GLOBAL_ATOMIC_STORE(drv_data, &hw_fence->lock, 1);
+		if (!hw_fence->valid && test_and_clear_bit(i, stats->overflow_map))
+			atomic_dec(&stats->overflow);
+		GLOBAL_ATOMIC_STORE(drv_data, &hw_fence->lock, 0);
+	}
+}
+
 char *_get_op_mode(enum hw_fence_lookup_ops op_code)
 {
 	switch (op_code) {
@@ -855,10 +965,12 @@ struct msm_hw_fence *_hw_fence_lookup_and_process(struct hw_fence_driver_data *d
 	bool (*compare_fnc)(struct msm_hw_fence *hfence, u64 context, u64 seqno);
 	void (*process_fnc)(struct hw_fence_driver_data *drv_data, struct msm_hw_fence *hfence,
 			u32 client_id, u64 context, u64 seqno, u32 hash, u32 pending);
+	struct hw_fence_hash_stats *stats;
 	struct msm_hw_fence *hw_fence = NULL;
-	u64 step = 0;
+	u64 step = 0, max_steps;
 	int ret = 0;
 	bool hw_fence_found = false;
+	bool create;
 
 	if (!hash | !drv_data | !hw_fences_tbl) {
 		HWFNC_ERR("Invalid input for hw_fence_lookup\n");
@@ -866,6 +978,7 @@ struct msm_hw_fence *_hw_fence_lookup_and_process(struct hw_fence_driver_data *d
 	}
 
 	*hash = ~0;
+	stats = &drv_data->hash_stats;
 
 	HWFNC_DBG_LUT("hw_fence_lookup: %d\n", op_code);
 
@@ -891,7 +1004,18 @@ struct msm_hw_fence *_hw_fence_lookup_and_process(struct hw_fence_driver_data *d
 		return NULL;
 	}
 
-	while (!hw_fence_found && (step < drv_data->hw_fence_table_entries)) {
+	create = (op_code == HW_FENCE_LOOKUP_OP_CREATE ||
+		op_code == HW_FENCE_LOOKUP_OP_CREATE_JOIN);
+
+	/*
+	 * Existing fences are always within their bounded probe window, unless some fence had to
+	 * be placed outside of it because both windows were full.
+	 */
+	max_steps = 2 * HW_FENCE_HASH_MAX_PROBE;
+	if (create || atomic_read(&stats->overflow))
+		max_steps += drv_data->hw_fence_table_entries;
+
+	while (!hw_fence_found && (step < max_steps)) {
 
 		/* Calculate the Hash for the Fence */
 		ret = _calculate_hash(drv_data->hw_fence_table_entries, context, seqno, step, hash);
@@ -930,11 +1054,14 @@ struct msm_hw_fence *_hw_fence_lookup_and_process(struct hw_fence_driver_data *d
 			HWFNC_DBG_L("client_id:%lu op:%s ctx:%llu seqno:%llu hash:%llu step:%llu\n",
 				client_id, _get_op_mode(op_code), context, seqno, *hash, step);
 
+			/* account the long probe before the fence can be looked up */
+			if (create && step >= 2 * HW_FENCE_HASH_MAX_PROBE &&
+					!test_and_set_bit(*hash, stats->overflow_map))
+				atomic_inc(&stats->overflow);
+
 			hw_fence_found = true;
 		} else {
-			if ((op_code == HW_FENCE_LOOKUP_OP_CREATE ||
-				op_code == HW_FENCE_LOOKUP_OP_CREATE_JOIN) &&
-				seqno == hw_fence->seq_id && context == hw_fence->ctx_id) {
+			if (create && seqno == hw_fence->seq_id && context == hw_fence->ctx_id) {
 				/* ctx & seqno must be unique creating a hw-fence */
 				HWFNC_ERR("cannot create hw fence with same ctx:%llu seqno:%llu\n",
 					context, seqno);
@@ -948,6 +1075,9 @@ struct msm_hw_fence *_hw_fence_lookup_and_process(struct hw_fence_driver_data *d
 
 		GLOBAL_ATOMIC_STORE(drv_data, &hw_fence->lock, 0);
 
+		if (hw_fence_found)
+			break;
+
 		/* Increment step for the next loop */
 		step++;
 	}
@@ -956,6 +1086,15 @@ struct msm_hw_fence *_hw_fence_lookup_and_process(struct hw_fence_driver_data *d
 	if (!hw_fence_found) {
 		HWFNC_ERR("fail to create hw-fence step:%llu\n", step);
 		hw_fence = NULL;
+		if (!create) {
+			stats->lookup_misses++;
+			if (max_steps > 2 * HW_FENCE_HASH_MAX_PROBE)
+				_hw_fence_recount_overflow(drv_data);
+		}
+	} else if (create) {
+		stats->insert_probes[_hash_probe_bucket(step)]++;
+	} else {
+		stats->lookup_probes[_hash_probe_bucket(step)]++;
 	}
 
 	HWFNC_DBG_LUT("lookup:%d hw_fence:%pK ctx:%llu seqno:%llu hash:%llu flags:0x%llx\n",
@@ -1105,15 +1244,62 @@ struct msm_hw_fence *msm_hw_fence_find(struct hw_fence_driver_data *drv_data,
 	return hw_fence;
 }
 
+void hw_fence_signal_batch_flush(struct hw_fence_driver_data *drv_data,
+	struct hw_fence_signal_batch *batch)
+{
+	struct msm_hw_fence_client *hw_fence_client = batch->client;
+	u32 tx_client_id = drv_data->ipcc_client_pid; /* phys id for tx client */
+
+	if (!hw_fence_client || !batch->count)
+		goto reset;
+
+	HWFNC_DBG_H("signal client:%d with %u fences\n", hw_fence_client->client_id,
+		batch->count);
+
+	/* Write all the payloads to the Rx queue with a single write-index update */
+	if (hw_fence_client->update_rxq)
+		hw_fence_update_queue_batch(drv_data, hw_fence_client, batch->payloads,
+			batch->count, HW_FENCE_RX_QUEUE - 1);
+
+	/* Signal the hw fences now, once for the whole batch */
+	if (hw_fence_client->send_ipc)
+		hw_fence_ipcc_trigger_signal(drv_data, tx_client_id,
+			hw_fence_client->ipc_client_vid, hw_fence_client->ipc_signal_id);
+
+reset:
+	batch->client = NULL;
+	batch->count = 0;
+}
+
+/*
+ * Signals the client for the hw-fence. If 'batch' is not NULL the signal is queued in the batch
+ * and the caller must call hw_fence_signal_batch_flush() to deliver it.
+ */
 static void _fence_ctl_signal(struct hw_fence_driver_data *drv_data,
 	struct msm_hw_fence_client *hw_fence_client, struct msm_hw_fence *hw_fence, u64 hash,
-	u64 flags, u64 client_data, u32 error)
+	u64 flags, u64 client_data, u32 error, struct hw_fence_signal_batch *batch)
 {
 	u32 tx_client_id = drv_data->ipcc_client_pid; /* phys id for tx client */
 	u32 rx_client_id = hw_fence_client->ipc_client_vid; /* virt id for rx client */
+	struct msm_hw_fence_queue_payload *payload;
 
 	HWFNC_DBG_H("We must signal the client now! hfence hash:%llu\n", hash);
 
+	if (batch) {
+		if (batch->client != hw_fence_client || batch->count >= HW_FENCE_SIGNAL_BATCH_MAX)
+			hw_fence_signal_batch_flush(drv_data, batch);
+
+		batch->client = hw_fence_client;
+		payload = &batch->payloads[batch->count++];
+		payload->ctxt_id = hw_fence->ctx_id;
+		payload->seqno = hw_fence->seq_id;
+		payload->hash = hash;
+		payload->flags = flags;
+		payload->client_data = client_data;
+		payload->error = error;
+		return;
+	}
+
 	/* Write to Rx queue */
 	if (hw_fence_client->update_rxq)
 		hw_fence_update_queue(drv_data, hw_fence_client, hw_fence->ctx_id,
@@ -1190,7 +1376,7 @@ destroy_fence:
 
 int hw_fence_process_fence_array(struct hw_fence_driver_data *drv_data,
 	struct msm_hw_fence_client *hw_fence_client, struct dma_fence_array *array,
-	u64 *hash_join_fence, u64 client_data)
+	u64 *hash_join_fence, u64 client_data, struct hw_fence_signal_batch *batch)
 {
 	struct msm_hw_fence *join_fence;
 	struct msm_hw_fence *hw_fence_child;
@@ -1305,7 +1491,7 @@ int hw_fence_process_fence_array(struct hw_fence_driver_data *drv_data,
 
 		/* signal the join hw fence */
 		_fence_ctl_signal(drv_data, hw_fence_client, join_fence, *hash_join_fence, 0, 0,
-			client_data);
+			client_data, batch);
 		set_bit(MSM_HW_FENCE_FLAG_SIGNALED_BIT, &array->base.flags);
 
 		/*
@@ -1337,7 +1523,7 @@ error_array:
 
 int hw_fence_register_wait_client(struct hw_fence_driver_data *drv_data,
 		struct dma_fence *fence, struct msm_hw_fence_client *hw_fence_client, u64 context,
-		u64 seqno, u64 *hash, u64 client_data)
+		u64 seqno, u64 *hash, u64 client_data, struct hw_fence_signal_batch *batch)
 {
 	struct msm_hw_fence *hw_fence;
 	enum hw_fence_client_data_id data_id;
@@ -1376,7 +1562,8 @@ int hw_fence_register_wait_client(struct hw_fence_driver_data *drv_data,
 	if (hw_fence->flags & MSM_HW_FENCE_FLAG_SIGNAL) {
 		if (fence != NULL)
 			set_bit(MSM_HW_FENCE_FLAG_SIGNALED_BIT, &fence->flags);
-		_fence_ctl_signal(drv_data, hw_fence_client, hw_fence, *hash, 0, client_data, 0);
+		_fence_ctl_signal(drv_data, hw_fence_client, hw_fence, *hash, 0, client_data, 0,
+			batch);
 	}
 
 	return 0;
@@ -1384,7 +1571,7 @@ int hw_fence_register_wait_client(struct hw_fence_driver_data *drv_data,
 
 int hw_fence_process_fence(struct hw_fence_driver_data *drv_data,
 	struct msm_hw_fence_client *hw_fence_client,
-	struct dma_fence *fence, u64 *hash, u64 client_data)
+	struct dma_fence *fence, u64 *hash, u64 client_data, struct hw_fence_signal_batch *batch)
 {
 	int ret = 0;
 
@@ -1399,7 +1586,7 @@ int hw_fence_process_fence(struct hw_fence_driver_data *drv_data,
 	}
 
 	ret = hw_fence_register_wait_client(drv_data, fence, hw_fence_client, fence->context,
-		fence->seqno, hash, client_data);
+		fence->seqno, hash, client_data, batch);
 	if (ret)
 		HWFNC_ERR("Error registering for wait client:%d\n", hw_fence_client->client_id);
 
@@ -1407,7 +1594,7 @@ int hw_fence_process_fence(struct hw_fence_driver_data *drv_data,
 }
 
 static void _signal_all_wait_clients(struct hw_fence_driver_data *drv_data,
-	struct msm_hw_fence *hw_fence, u64 hash, int error)
+	struct msm_hw_fence *hw_fence, u64 hash, int error, struct hw_fence_signal_batch *batch)
 {
 	enum hw_fence_client_id wait_client_id;
 	enum hw_fence_client_data_id data_id;
@@ -1425,11 +1612,71 @@ static void _signal_all_wait_clients(struct hw_fence_driver_data *drv_data,
 
 			if (hw_fence_wait_client)
 				_fence_ctl_signal(drv_data, hw_fence_wait_client, hw_fence,
-					hash, 0, client_data, error);
+					hash, 0, client_data, error, batch);
 		}
 	}
 }
 
+/*
+ * Signals the hw-fence the way the fence controller does: marks the fence as signaled, signals
+ * its waiting clients and then the parent join-fences for which it was the last pending child.
+ */
+void hw_fence_signal_fence(struct hw_fence_driver_data *drv_data, u64 hash, u32 error,
+	struct hw_fence_signal_batch *batch)
+{
+	u64 parent_list[MSM_HW_FENCE_MAX_JOIN_PARENTS];
+	struct msm_hw_fence *hw_fence, *parent;
+	u32 parents_cnt = 0;
+	bool signal;
+	int i;
+
+	if (hash >= drv_data->hw_fences_tbl_cnt) {
+		HWFNC_ERR("invalid hash:%llu max:%d\n", hash, drv_data->hw_fences_tbl_cnt);
+		return;
+	}
+	hw_fence = &drv_data->hw_fences_tbl[hash];
+
+	GLOBAL_ATOMIC_STORE(drv_data, &hw_fence->lock, 1); /* lock */
+	signal = hw_fence->valid && !(hw_fence->flags & MSM_HW_FENCE_FLAG_SIGNAL);
+	if (signal) {
+		hw_fence->flags |= MSM_HW_FENCE_FLAG_SIGNAL;
+		hw_fence->error = error;
+		hw_fence->fence_trigger_time = hw_fence_get_qtime(drv_data);
+
+		parents_cnt = min_t(u32, hw_fence->parents_cnt, MSM_HW_FENCE_MAX_JOIN_PARENTS);
+		for (i = 0; i < parents_cnt; i++)
+			parent_list[i] = hw_fence->parent_list[i];
+
+		/* update memory for the table update */
+		wmb();
+	}
+	GLOBAL_ATOMIC_STORE(drv_data, &hw_fence->lock, 0); /* unlock */
+
+	if (!signal) {
+		HWFNC_DBG_H("hw fence hash:%llu not valid or already signaled\n", hash);
+		return;
+	}
+
+	_signal_all_wait_clients(drv_data, hw_fence, hash, error, batch);
+
+	for (i = 0; i < parents_cnt; i++) {
+		if (parent_list[i] >= drv_data->hw_fences_tbl_cnt)
+			continue;
+		parent = &drv_data->hw_fences_tbl[parent_list[i]];
+
+		GLOBAL_ATOMIC_STORE(drv_data, &parent->lock, 1); /* lock */
+		signal = parent->pending_child_cnt && --parent->pending_child_cnt == 0;
+
+		/* update memory for the table update */
+		wmb();
+		GLOBAL_ATOMIC_STORE(drv_data, &parent->lock, 0); /* unlock */
+
+		/* join-fences cannot be nested, so this recurses only once */
+		if (signal)
+			hw_fence_signal_fence(drv_data, parent_list[i], error, batch);
+	}
+}
+
 void hw_fence_utils_reset_queues(struct hw_fence_driver_data *drv_data,
 	struct msm_hw_fence_client *hw_fence_client)
 {
@@ -1496,7 +1743,7 @@ int hw_fence_utils_cleanup_fence(struct hw_fence_driver_data *drv_data,
 
 		/* if fence is not signaled, signal with error all the waiting clients */
 		if (!(hw_fence->flags & MSM_HW_FENCE_FLAG_SIGNAL))
-			_signal_all_wait_clients(drv_data, hw_fence, hash, error);
+			_signal_all_wait_clients(drv_data, hw_fence, hash, error, NULL);
 
 		if (reset_flags & MSM_HW_FENCE_RESET_WITHOUT_DESTROY)
 			goto skip_destroy;
@@ -0,0 +1,166 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ */
+
+#include <linux/kthread.h>
+#include <linux/gfp.h>
+#include <linux/io.h>
+
+#include "hw_fence_drv_priv.h"
+#include "hw_fence_drv_utils.h"
+#include "hw_fence_drv_ipc.h"
+#include "hw_fence_drv_debug.h"
+#include "hw_fence_drv_sw_ctrl.h"
+
+int hw_fence_sw_ctrl_alloc_mem(struct hw_fence_driver_data *drv_data)
+{
+	struct hw_fence_sw_ctrl *sw_ctrl = &drv_data->sw_ctrl;
+
+	sw_ctrl->mem_size = PAGE_ALIGN(drv_data->used_mem_size);
+	sw_ctrl->mem = alloc_pages_exact(sw_ctrl->mem_size, GFP_KERNEL | __GFP_ZERO);
+	if (!sw_ctrl->mem) {
+		HWFNC_ERR("failed to alloc 0x%zx bytes for the sw fence controller\n",
+			sw_ctrl->mem_size);
+		return -ENOMEM;
+	}
+
+	drv_data->io_mem_base = (void __force __iomem *)sw_ctrl->mem;
+	drv_data->size = sw_ctrl->mem_size;
+	drv_data->res.start = virt_to_phys(sw_ctrl->mem);
+	drv_data->res.end = drv_data->res.start + sw_ctrl->mem_size - 1;
+
+	/* there is no VM to share the memory with */
+	drv_data->vm_ready = true;
+
+	HWFNC_DBG_INIT("sw ctrl mem:0x%pK start:0x%x size:0x%x\n", sw_ctrl->mem,
+		drv_data->res.start, drv_data->size);
+
+	return 0;
+}
+
+static void _sw_ctrl_update_latency(struct hw_fence_sw_ctrl *sw_ctrl,
+	struct msm_hw_fence_queue_payload *payload, u64 now)
+{
+	u64 timestamp = ((u64)payload->timestamp_hi << 32) | payload->timestamp_lo;
+	u64 latency = now > timestamp ? now - timestamp : 0;
+
+	sw_ctrl->signaled++;
+	sw_ctrl->latency_total += latency;
+	sw_ctrl->latency_max = max(sw_ctrl->latency_max, latency);
+}
+
+/* Signals all the hw-fences written to the tx queue of the client, returns how many were read */
+static int _sw_ctrl_process_client(struct hw_fence_driver_data *drv_data,
+	struct msm_hw_fence_client *hw_fence_client, struct hw_fence_signal_batch *batch)
+{
+	struct msm_hw_fence_queue_payload payload;
+	int read = 1, cnt = 0;
+
+	/* clients that skip the tx queue write-index are not supported by the sw controller */
+	if (hw_fence_client->skip_txq_wr_idx)
+		return 0;
+
+	while (read > 0) {
+		/* the read returns zero both for an empty queue and for its last payload */
+		payload.hash = HW_FENCE_INVALID_PARENT_FENCE;
+		read = hw_fence_read_queue(hw_fence_client, &payload, HW_FENCE_TX_QUEUE - 1);
+		if (read < 0) {
+			HWFNC_ERR("unable to read client:%d txq\n", hw_fence_client->client_id);
+			break;
+		}
+		if (payload.hash == HW_FENCE_INVALID_PARENT_FENCE)
+			break;
+
+		HWFNC_DBG_L("sw ctrl signal client:%d hash:%llu ctx:%llu seq:%llu err:%u\n",
+			hw_fence_client->client_id, payload.hash, payload.ctxt_id, payload.seqno,
+			payload.error);
+
+		hw_fence_signal_fence(drv_data, payload.hash, payload.error, batch);
+		_sw_ctrl_update_latency(&drv_data->sw_ctrl, &payload,
+			hw_fence_get_qtime(drv_data));
+		cnt++;
+	}
+
+	return cnt;
+}
+
+static int _sw_ctrl_thread(void *data)
+{
+	struct hw_fence_driver_data *drv_data = data;
+	struct hw_fence_sw_ctrl *sw_ctrl = &drv_data->sw_ctrl;
+	struct hw_fence_signal_batch batch = { 0 };
+	struct msm_hw_fence_client *hw_fence_client;
+	int client_id;
+
+	while (!kthread_should_stop()) {
+		wait_event_interruptible(sw_ctrl->wait_queue,
+			atomic_read(&sw_ctrl->pending) || kthread_should_stop());
+		if (!atomic_xchg(&sw_ctrl->pending, 0))
+			continue;
+
+		/*
+		 * Clients cannot be unregistered while their queues are consumed, nor while the
+		 * batch still points to one of them.
+		 */
+		mutex_lock(&drv_data->clients_register_lock);
+		for (client_id = 0; client_id < drv_data->clients_num; client_id++) {
+			hw_fence_client = drv_data->clients[client_id];
+			if (!hw_fence_client)
+				continue;
+
+			_sw_ctrl_process_client(drv_data, hw_fence_client, &batch);
+		}
+		hw_fence_signal_batch_flush(drv_data, &batch);
+		mutex_unlock(&drv_data->clients_register_lock);
+	}
+
+	return 0;
+}
+
+int hw_fence_sw_ctrl_init(struct hw_fence_driver_data *drv_data)
+{
+	struct hw_fence_sw_ctrl *sw_ctrl = &drv_data->sw_ctrl;
+	struct task_struct *thread;
+
+	init_waitqueue_head(&sw_ctrl->wait_queue);
+	atomic_set(&sw_ctrl->pending, 0);
+
+	thread = kthread_run(_sw_ctrl_thread, drv_data, "hw_fence_sw_ctrl");
+	if (IS_ERR(thread)) {
+		HWFNC_ERR("failed to start sw fence controller %ld\n", PTR_ERR(thread));
+		return PTR_ERR(thread);
+	}
+	sw_ctrl->thread = thread;
+
+	HWFNC_DBG_INIT("sw fence controller started\n");
+
+	return 0;
+}
+
+void hw_fence_sw_ctrl_deinit(struct hw_fence_driver_data *drv_data)
+{
+	struct hw_fence_sw_ctrl *sw_ctrl = &drv_data->sw_ctrl;
+
+	if (sw_ctrl->thread) {
+		kthread_stop(sw_ctrl->thread);
+		sw_ctrl->thread = NULL;
+	}
+
+	if (sw_ctrl->mem) {
+		free_pages_exact(sw_ctrl->mem, sw_ctrl->mem_size);
+		sw_ctrl->mem = NULL;
+		drv_data->io_mem_base = NULL;
+	}
+}
+
+void hw_fence_sw_ctrl_kick(struct hw_fence_driver_data *drv_data)
+{
+	struct hw_fence_sw_ctrl *sw_ctrl = &drv_data->sw_ctrl;
+
+	if (!sw_ctrl->thread)
+		return;
+
+	atomic_set(&sw_ctrl->pending, 1);
+	wake_up(&sw_ctrl->wait_queue);
+}
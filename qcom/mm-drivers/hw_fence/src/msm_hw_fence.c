@@ -13,9 +13,11 @@
 #include "hw_fence_drv_utils.h"
 #include "hw_fence_drv_debug.h"
 #include "hw_fence_drv_ipc.h"
+#include "hw_fence_drv_sw_ctrl.h"
 
 struct hw_fence_driver_data *hw_fence_drv_data;
 static bool hw_fence_driver_enable;
+static bool hw_fence_sw_ctrl_enable;
 
 void *msm_hw_fence_register(enum hw_fence_client_id client_id_ext,
 	struct msm_hw_fence_mem_addr *mem_descriptor)
@@ -296,6 +298,7 @@ int msm_hw_fence_wait_update_v2(void *client_handle,
 {
 	struct msm_hw_fence_client *hw_fence_client;
 	struct dma_fence_array *array;
+	struct hw_fence_signal_batch batch = { 0 };
 	int i, ret = 0;
 	enum hw_fence_client_data_id data_id;
 
@@ -325,7 +328,10 @@ int msm_hw_fence_wait_update_v2(void *client_handle,
 
 	HWFNC_DBG_H("+\n");
 
-	/* Process all the list of fences */
+	/*
+	 * Process all the list of fences, the fences that are already signaled are batched and
+	 * delivered with a single rx queue update and ipc signal once the list is processed
+	 */
 	for (i = 0; i < num_fences; i++) {
 		struct dma_fence *fence = fence_list[i];
 		u64 hash, client_data = 0;
@@ -337,18 +343,18 @@ int msm_hw_fence_wait_update_v2(void *client_handle,
 		array = to_dma_fence_array(fence);
 		if (array) {
 			ret = hw_fence_process_fence_array(hw_fence_drv_data, hw_fence_client,
-				array, &hash, client_data);
+				array, &hash, client_data, &batch);
 			if (ret) {
 				HWFNC_ERR("Failed to process FenceArray\n");
-				return ret;
+				goto exit;
 			}
 		} else {
 			/* Process individual Fence */
 			ret = hw_fence_process_fence(hw_fence_drv_data, hw_fence_client, fence,
-				&hash, client_data);
+				&hash, client_data, &batch);
 			if (ret) {
 				HWFNC_ERR("Failed to process Fence\n");
-				return ret;
+				goto exit;
 			}
 		}
 
@@ -358,7 +364,11 @@ int msm_hw_fence_wait_update_v2(void *client_handle,
 
 	HWFNC_DBG_H("-\n");
 
-	return 0;
+exit:
+	/* signal the fences registered before any failure too */
+	hw_fence_signal_batch_flush(hw_fence_drv_data, &batch);
+
+	return ret;
 }
 EXPORT_SYMBOL(msm_hw_fence_wait_update_v2);
 
@@ -501,6 +511,7 @@ static int msm_hw_fence_probe_init(struct platform_device *pdev)
 
 	dev_set_drvdata(&pdev->dev, hw_fence_drv_data);
 	hw_fence_drv_data->dev = &pdev->dev;
+	hw_fence_drv_data->sw_ctrl_enabled = hw_fence_sw_ctrl_enable;
 
 	/* Initialize HW Fence Driver resources */
 	rc = hw_fence_init(hw_fence_drv_data);
@@ -517,6 +528,8 @@ static int msm_hw_fence_probe_init(struct platform_device *pdev)
 	return rc;
 
 error:
+	if (hw_fence_drv_data->sw_ctrl_enabled)
+		hw_fence_sw_ctrl_deinit(hw_fence_drv_data);
 	dev_set_drvdata(&pdev->dev, NULL);
 	kfree(hw_fence_drv_data);
 	hw_fence_drv_data = (void *) -EPROBE_DEFER;
@@ -570,6 +583,12 @@ static int msm_hw_fence_remove(struct platform_device *pdev)
 		return -EINVAL;
 	}
 
+	if (hw_fence_drv_data->sw_ctrl_enabled)
+		hw_fence_sw_ctrl_deinit(hw_fence_drv_data);
+
+	hw_fence_drv_data->ipc_sw_loopback = false;
+	cancel_work_sync(&hw_fence_drv_data->ipc_sw_loopback_work);
+
 	dev_set_drvdata(&pdev->dev, NULL);
 	kfree(hw_fence_drv_data);
 	hw_fence_drv_data = (void *) -EPROBE_DEFER;
@@ -623,6 +642,9 @@ static void __exit msm_hw_fence_exit(void)
 module_param_named(enable, hw_fence_driver_enable, bool, 0600);
 MODULE_PARM_DESC(enable, "Enable hardware fences");
 
+module_param_named(sw_ctrl, hw_fence_sw_ctrl_enable, bool, 0400);
+MODULE_PARM_DESC(sw_ctrl, "Emulate the fence controller, ipcc and carved-out memory in software");
+
 module_init(msm_hw_fence_init);
 module_exit(msm_hw_fence_exit);
 
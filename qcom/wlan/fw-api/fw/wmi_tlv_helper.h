@@ -133,6 +133,9 @@ int
 wmitlv_check_and_pad_event_tlvs(
     void *os_ctx, void *param_struc_ptr, A_UINT32 param_buf_len, A_UINT32 wmi_cmd_event_id, void **wmi_cmd_struct_ptr);
 
+void
+wmitlv_attr_index_init(void);
+
 /** This structure is the element for the Version WhiteList
  *  table. */
 typedef struct {
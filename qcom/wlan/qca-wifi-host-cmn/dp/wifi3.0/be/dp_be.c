@@ -1733,17 +1733,8 @@ static inline unsigned
 dp_mlo_peer_find_hash_index(dp_mld_peer_hash_obj_t mld_hash_obj,
 			    union dp_align_mac_addr *mac_addr)
 {
-	uint32_t index;
-
-	index =
-		mac_addr->align2.bytes_ab ^
-		mac_addr->align2.bytes_cd ^
-		mac_addr->align2.bytes_ef;
-
-	index ^= index >> mld_hash_obj->mld_peer_hash.idx_bits;
-	index &= mld_hash_obj->mld_peer_hash.mask;
-
-	return index;
+	return dp_peer_mac_hash(mac_addr,
+				mld_hash_obj->mld_peer_hash.idx_bits);
 }
 
 QDF_STATUS
@@ -1867,34 +1858,35 @@ dp_mlo_peer_find_hash_find_be(struct dp_soc *soc,
 	}
 	/* search mld peer table if no link peer for given mac address */
 	index = dp_mlo_peer_find_hash_index(mld_hash_obj, mac_addr);
-	qdf_spin_lock_bh(&mld_hash_obj->mld_peer_hash_lock);
-	TAILQ_FOREACH(peer, &mld_hash_obj->mld_peer_hash.bins[index],
-		      hash_list_elem) {
-		if (dp_peer_find_mac_addr_cmp(mac_addr, &peer->mac_addr) == 0) {
-			if ((vdev_id == DP_VDEV_ALL) || (
-				dp_peer_find_mac_addr_cmp(
-						&peer->vdev->mld_mac_addr,
-						&vdev->mld_mac_addr) == 0)) {
-				/* take peer reference before returning */
-				if (dp_peer_get_ref(NULL, peer, mod_id) !=
-						QDF_STATUS_SUCCESS)
-					peer = NULL;
-
-				if (vdev)
-					dp_vdev_unref_delete(soc, vdev, mod_id);
-
-				qdf_spin_unlock_bh(
-					&mld_hash_obj->mld_peer_hash_lock);
-				return peer;
-			}
+	qdf_rcu_read_lock();
+	DP_PEER_HASH_FOREACH_RCU(peer,
+				 &mld_hash_obj->mld_peer_hash.bins[index],
+				 hash_list_elem) {
+		if (dp_peer_find_mac_addr_cmp(mac_addr, &peer->mac_addr))
+			continue;
+
+		/* the peer's vdev is only safe to look at under a reference */
+		if (dp_peer_get_ref(NULL, peer, mod_id) != QDF_STATUS_SUCCESS)
+			continue;
+
+		if ((vdev_id == DP_VDEV_ALL) ||
+		    (dp_peer_find_mac_addr_cmp(&peer->vdev->mld_mac_addr,
+					       &vdev->mld_mac_addr) == 0)) {
+			qdf_rcu_read_unlock();
+
+			if (vdev)
+				dp_vdev_unref_delete(soc, vdev, mod_id);
+
+			return peer;
 		}
+
+		dp_peer_unref_delete(peer, mod_id);
 	}
+	qdf_rcu_read_unlock();
 
 	if (vdev)
 		dp_vdev_unref_delete(soc, vdev, mod_id);
 
-	qdf_spin_unlock_bh(&mld_hash_obj->mld_peer_hash_lock);
-
 	return NULL; /* failure */
 }
 
@@ -1923,8 +1915,8 @@ dp_mlo_peer_find_hash_remove_be(struct dp_soc *soc, struct dp_peer *peer)
 		}
 	}
 	QDF_ASSERT(found);
-	TAILQ_REMOVE(&mld_hash_obj->mld_peer_hash.bins[index], peer,
-		     hash_list_elem);
+	DP_PEER_HASH_REMOVE_RCU(&mld_hash_obj->mld_peer_hash.bins[index],
+				peer, hash_list_elem);
 
 	dp_peer_unref_delete(peer, DP_MOD_ID_CONFIG);
 	qdf_spin_unlock_bh(&mld_hash_obj->mld_peer_hash_lock);
@@ -1952,11 +1944,37 @@ dp_mlo_peer_find_hash_add_be(struct dp_soc *soc, struct dp_peer *peer)
 		qdf_spin_unlock_bh(&mld_hash_obj->mld_peer_hash_lock);
 		return;
 	}
-	TAILQ_INSERT_TAIL(&mld_hash_obj->mld_peer_hash.bins[index], peer,
-			  hash_list_elem);
+	DP_PEER_HASH_INSERT_TAIL_RCU(&mld_hash_obj->mld_peer_hash.bins[index],
+				     peer, hash_list_elem);
 	qdf_spin_unlock_bh(&mld_hash_obj->mld_peer_hash_lock);
 }
 
+static void dp_print_mlo_peer_hash_stats_be(struct dp_soc *soc)
+{
+	struct dp_peer_hash_depth_stats stats = {0};
+	uint32_t index, depth;
+	struct dp_peer *peer;
+	dp_mld_peer_hash_obj_t mld_hash_obj;
+
+	mld_hash_obj = dp_mlo_get_peer_hash_obj(soc);
+
+	if (!mld_hash_obj || !mld_hash_obj->mld_peer_hash.bins)
+		return;
+
+	for (index = 0; index <= mld_hash_obj->mld_peer_hash.mask; index++) {
+		depth = 0;
+		qdf_spin_lock_bh(&mld_hash_obj->mld_peer_hash_lock);
+		TAILQ_FOREACH(peer, &mld_hash_obj->mld_peer_hash.bins[index],
+			      hash_list_elem)
+			depth++;
+		qdf_spin_unlock_bh(&mld_hash_obj->mld_peer_hash_lock);
+
+		dp_peer_hash_depth_stats_add(&stats, depth);
+	}
+
+	dp_print_peer_hash_depth_stats("MLD Peer", &stats);
+}
+
 void dp_print_mlo_ast_stats_be(struct dp_soc *soc)
 {
 	uint32_t index;
@@ -2315,6 +2333,7 @@ dp_initialize_arch_ops_be_mlo(struct dp_arch_ops *arch_ops)
 	arch_ops->mlo_peer_find_hash_add = dp_mlo_peer_find_hash_add_be;
 	arch_ops->mlo_peer_find_hash_remove = dp_mlo_peer_find_hash_remove_be;
 	arch_ops->mlo_peer_find_hash_find = dp_mlo_peer_find_hash_find_be;
+	arch_ops->print_mlo_peer_hash_stats = dp_print_mlo_peer_hash_stats_be;
 }
 #else /* WLAN_FEATURE_11BE_MLO */
 static inline void
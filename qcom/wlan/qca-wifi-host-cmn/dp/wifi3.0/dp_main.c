@@ -8854,6 +8854,18 @@ free_vdev:
 
 qdf_export_symbol(dp_vdev_unref_delete);
 
+/*
+ * dp_peer_free_rcu() - free the peer once lockless hash lookups are done
+ * @head: rcu head embedded in the peer
+ *
+ * dp_peer_find_hash_find() may still be looking at the peer's MAC address
+ * and reference count after the peer left the hash table.
+ */
+static void dp_peer_free_rcu(qdf_rcu_head_t *head)
+{
+	qdf_mem_free(qdf_container_of(head, struct dp_peer, rcu_head));
+}
+
 /*
  * dp_peer_unref_delete() - unref and delete peer
  * @peer_handle:    Datapath peer handle
@@ -8924,7 +8936,7 @@ void dp_peer_unref_delete(struct dp_peer *peer, enum dp_mod_id mod_id)
 		qdf_spinlock_destroy(&peer->peer_state_lock);
 
 		dp_txrx_peer_detach(soc, peer);
-		qdf_mem_free(peer);
+		qdf_call_rcu(&peer->rcu_head, dp_peer_free_rcu);
 
 		/*
 		 * Decrement ref count taken at peer create
@@ -10268,6 +10280,7 @@ dp_print_host_stats(struct dp_vdev *vdev,
 	case TXRX_AST_STATS:
 		dp_print_ast_stats(pdev->soc);
 		dp_print_mec_stats(pdev->soc);
+		dp_print_peer_hash_stats(pdev->soc);
 		dp_print_peer_table(vdev);
 		break;
 	case TXRX_SRNG_PTR_STATS:
@@ -381,16 +381,7 @@ static inline uint32_t
 dp_peer_find_hash_index(struct dp_soc *soc,
 			union dp_align_mac_addr *mac_addr)
 {
-	uint32_t index;
-
-	index =
-		mac_addr->align2.bytes_ab ^
-		mac_addr->align2.bytes_cd ^
-		mac_addr->align2.bytes_ef;
-
-	index ^= index >> soc->peer_hash.idx_bits;
-	index &= soc->peer_hash.mask;
-	return index;
+	return dp_peer_mac_hash(mac_addr, soc->peer_hash.idx_bits);
 }
 
 /*
@@ -426,21 +417,28 @@ struct dp_peer *dp_peer_find_hash_find(
 		mac_addr = &local_mac_addr_aligned;
 	}
 	index = dp_peer_find_hash_index(soc, mac_addr);
-	qdf_spin_lock_bh(&soc->peer_hash_lock);
-	TAILQ_FOREACH(peer, &soc->peer_hash.bins[index], hash_list_elem) {
-		if (dp_peer_find_mac_addr_cmp(mac_addr, &peer->mac_addr) == 0 &&
-		    ((peer->vdev->vdev_id == vdev_id) ||
-		     (vdev_id == DP_VDEV_ALL))) {
-			/* take peer reference before returning */
-			if (dp_peer_get_ref(soc, peer, mod_id) !=
-						QDF_STATUS_SUCCESS)
-				peer = NULL;
+	qdf_rcu_read_lock();
+	DP_PEER_HASH_FOREACH_RCU(peer, &soc->peer_hash.bins[index],
+				 hash_list_elem) {
+		if (dp_peer_find_mac_addr_cmp(mac_addr, &peer->mac_addr))
+			continue;
 
-			qdf_spin_unlock_bh(&soc->peer_hash_lock);
+		/*
+		 * Take the peer reference before looking at peer->vdev, a
+		 * peer already on its way out may have released its vdev.
+		 */
+		if (dp_peer_get_ref(soc, peer, mod_id) != QDF_STATUS_SUCCESS)
+			continue;
+
+		if ((peer->vdev->vdev_id == vdev_id) ||
+		    (vdev_id == DP_VDEV_ALL)) {
+			qdf_rcu_read_unlock();
 			return peer;
 		}
+
+		dp_peer_unref_delete(peer, mod_id);
 	}
-	qdf_spin_unlock_bh(&soc->peer_hash_lock);
+	qdf_rcu_read_unlock();
 	return NULL; /* failure */
 }
 
@@ -535,8 +533,8 @@ void dp_peer_find_hash_add(struct dp_soc *soc, struct dp_peer *peer)
 		 * this ensures that if two entries with the same MAC address
 		 * are stored, the one added first will be found first.
 		 */
-		TAILQ_INSERT_TAIL(&soc->peer_hash.bins[index], peer,
-				  hash_list_elem);
+		DP_PEER_HASH_INSERT_TAIL_RCU(&soc->peer_hash.bins[index], peer,
+					     hash_list_elem);
 
 		qdf_spin_unlock_bh(&soc->peer_hash_lock);
 	} else if (peer->peer_type == CDP_MLD_PEER_TYPE) {
@@ -575,8 +573,8 @@ void dp_peer_find_hash_remove(struct dp_soc *soc, struct dp_peer *peer)
 			}
 		}
 		QDF_ASSERT(found);
-		TAILQ_REMOVE(&soc->peer_hash.bins[index], peer,
-			     hash_list_elem);
+		DP_PEER_HASH_REMOVE_RCU(&soc->peer_hash.bins[index], peer,
+					hash_list_elem);
 
 		dp_peer_unref_delete(peer, DP_MOD_ID_CONFIG);
 		qdf_spin_unlock_bh(&soc->peer_hash_lock);
@@ -644,7 +642,8 @@ void dp_peer_find_hash_add(struct dp_soc *soc, struct dp_peer *peer)
 	 * the same MAC address are stored, the one added first will be
 	 * found first.
 	 */
-	TAILQ_INSERT_TAIL(&soc->peer_hash.bins[index], peer, hash_list_elem);
+	DP_PEER_HASH_INSERT_TAIL_RCU(&soc->peer_hash.bins[index], peer,
+				     hash_list_elem);
 
 	qdf_spin_unlock_bh(&soc->peer_hash_lock);
 }
@@ -667,7 +666,8 @@ void dp_peer_find_hash_remove(struct dp_soc *soc, struct dp_peer *peer)
 		}
 	}
 	QDF_ASSERT(found);
-	TAILQ_REMOVE(&soc->peer_hash.bins[index], peer, hash_list_elem);
+	DP_PEER_HASH_REMOVE_RCU(&soc->peer_hash.bins[index], peer,
+				hash_list_elem);
 
 	dp_peer_unref_delete(peer, DP_MOD_ID_CONFIG);
 	qdf_spin_unlock_bh(&soc->peer_hash_lock);
@@ -3324,6 +3324,8 @@ void dp_rx_mlo_peer_unmap_handler(struct dp_soc *soc, uint16_t peer_id)
 void
 dp_peer_find_detach(struct dp_soc *soc)
 {
+	/* let deferred peer frees finish before the hash tables go */
+	qdf_rcu_barrier();
 	dp_soc_wds_detach(soc);
 	dp_peer_find_map_detach(soc);
 	dp_peer_find_hash_detach(soc);
@@ -3335,6 +3337,8 @@ dp_peer_find_detach(struct dp_soc *soc)
 void
 dp_peer_find_detach(struct dp_soc *soc)
 {
+	/* let deferred peer frees finish before the hash tables go */
+	qdf_rcu_barrier();
 	dp_peer_find_map_detach(soc);
 	dp_peer_find_hash_detach(soc);
 }
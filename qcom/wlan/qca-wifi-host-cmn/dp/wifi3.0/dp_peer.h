@@ -37,6 +37,9 @@
 #define DP_PEER_HASH_LOAD_MULT  2
 #define DP_PEER_HASH_LOAD_SHIFT 0
 
+/* Number of buckets in the peer hash bin depth histogram */
+#define DP_PEER_HASH_DEPTH_HIST 8
+
 /* Threshold for peer's cached buf queue beyond which frames are dropped */
 #define DP_RX_CACHED_BUFQ_THRESH 64
 
@@ -538,7 +541,116 @@ dp_peer_state_cmp(struct dp_peer *peer,
 	return is_status_equal;
 }
 
+/**
+ * dp_peer_mac_hash() - hash a MAC address into a table of 2^idx_bits bins
+ * @mac_addr: aligned MAC address
+ * @idx_bits: log2 of the number of bins
+ *
+ * Multiplicative hash over all 48 bits, taking the top bits of the product
+ * so that MAC addresses differing only in the last octets, as handed out
+ * sequentially to test rigs and SoftAP clients, still spread over all bins.
+ *
+ * Return: bin index
+ */
+static inline uint32_t
+dp_peer_mac_hash(union dp_align_mac_addr *mac_addr, uint32_t idx_bits)
+{
+	uint64_t key;
+
+	if (!idx_bits)
+		return 0;
+
+	key = ((uint64_t)mac_addr->align2.bytes_ab << 32) |
+	      ((uint64_t)mac_addr->align2.bytes_cd << 16) |
+	      mac_addr->align2.bytes_ef;
+
+	return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> (64 - idx_bits));
+}
+
+/*
+ * Peer hash bins are walked without the hash lock under qdf_rcu_read_lock()
+ * while writers still serialize on the lock. Inserting publishes the peer
+ * only once its links are set up, and removing leaves the removed peer's
+ * next link intact so that a reader standing on it can carry on. The peer
+ * memory itself is only freed after a grace period, see
+ * dp_peer_unref_delete().
+ */
+#define DP_PEER_HASH_INSERT_TAIL_RCU(head, elm, field) do {		\
+	(elm)->field.tqe_next = NULL;					\
+	(elm)->field.tqe_prev = (head)->tqh_last;			\
+	qdf_rcu_assign_pointer(*(head)->tqh_last, (elm));		\
+	(head)->tqh_last = &(elm)->field.tqe_next;			\
+} while (0)
+
+#define DP_PEER_HASH_REMOVE_RCU(head, elm, field) do {			\
+	if ((elm)->field.tqe_next)					\
+		(elm)->field.tqe_next->field.tqe_prev =			\
+			(elm)->field.tqe_prev;				\
+	else								\
+		(head)->tqh_last = (elm)->field.tqe_prev;		\
+	qdf_rcu_assign_pointer(*(elm)->field.tqe_prev,			\
+			       (elm)->field.tqe_next);			\
+} while (0)
+
+#define DP_PEER_HASH_FOREACH_RCU(var, head, field)			\
+	for ((var) = qdf_rcu_dereference((head)->tqh_first);		\
+	     (var);							\
+	     (var) = qdf_rcu_dereference((var)->field.tqe_next))
+
 void dp_print_ast_stats(struct dp_soc *soc);
+
+/**
+ * struct dp_peer_hash_depth_stats - bin depth summary of a peer hash table
+ * @num_bins: number of bins walked
+ * @num_peers: number of peers found in the bins
+ * @max_depth: depth of the deepest bin
+ * @hist: number of bins of each depth, the last bucket also counts deeper bins
+ */
+struct dp_peer_hash_depth_stats {
+	uint32_t num_bins;
+	uint32_t num_peers;
+	uint32_t max_depth;
+	uint32_t hist[DP_PEER_HASH_DEPTH_HIST];
+};
+
+/**
+ * dp_peer_hash_depth_stats_add() - Account one hash bin in the depth summary
+ * @stats: depth summary being built
+ * @depth: number of peers in the bin
+ *
+ * Return: none
+ */
+static inline void
+dp_peer_hash_depth_stats_add(struct dp_peer_hash_depth_stats *stats,
+			     uint32_t depth)
+{
+	stats->num_bins++;
+	stats->num_peers += depth;
+	if (depth > stats->max_depth)
+		stats->max_depth = depth;
+	if (depth >= DP_PEER_HASH_DEPTH_HIST)
+		depth = DP_PEER_HASH_DEPTH_HIST - 1;
+	stats->hist[depth]++;
+}
+
+/**
+ * dp_print_peer_hash_depth_stats() - Print a peer hash table depth summary
+ * @name: name of the hash table
+ * @stats: depth summary to print
+ *
+ * Return: none
+ */
+void dp_print_peer_hash_depth_stats(const char *name,
+				    struct dp_peer_hash_depth_stats *stats);
+
+/**
+ * dp_print_peer_hash_stats() - Dump peer and MLD peer hash table bin depths
+ * @soc: Datapath soc handle
+ *
+ * Return: none
+ */
+void dp_print_peer_hash_stats(struct dp_soc *soc);
+
 QDF_STATUS dp_rx_peer_map_handler(struct dp_soc *soc, uint16_t peer_id,
 				  uint16_t hw_peer_id, uint8_t vdev_id,
 				  uint8_t *peer_mac_addr, uint16_t ast_hash,
@@ -8090,6 +8090,50 @@ dp_print_soc_rx_stats(struct dp_soc *soc)
 		       soc->stats.rx.err.defrag_ad1_invalid);
 }
 
+void dp_print_peer_hash_depth_stats(const char *name,
+				    struct dp_peer_hash_depth_stats *stats)
+{
+	uint32_t depth;
+
+	DP_PRINT_STATS("%s Hash Stats:", name);
+	DP_PRINT_STATS("\tBins  = %u", stats->num_bins);
+	DP_PRINT_STATS("\tPeers = %u", stats->num_peers);
+	DP_PRINT_STATS("\tMax Bin Depth = %u", stats->max_depth);
+	for (depth = 0; depth < DP_PEER_HASH_DEPTH_HIST - 1; depth++)
+		DP_PRINT_STATS("\tBins With %u Peers  = %u",
+			       depth, stats->hist[depth]);
+	DP_PRINT_STATS("\tBins With %u+ Peers = %u",
+		       depth, stats->hist[depth]);
+}
+
+void dp_print_peer_hash_stats(struct dp_soc *soc)
+{
+	struct dp_peer_hash_depth_stats stats = {0};
+	uint32_t index, depth;
+	struct dp_peer *peer;
+
+	if (!soc->peer_hash.bins)
+		return;
+
+	for (index = 0; index <= soc->peer_hash.mask; index++) {
+		depth = 0;
+		qdf_spin_lock_bh(&soc->peer_hash_lock);
+		TAILQ_FOREACH(peer, &soc->peer_hash.bins[index],
+			      hash_list_elem)
+			depth++;
+		qdf_spin_unlock_bh(&soc->peer_hash_lock);
+
+		dp_peer_hash_depth_stats_add(&stats, depth);
+	}
+
+	dp_print_peer_hash_depth_stats("Peer", &stats);
+
+#ifdef WLAN_FEATURE_11BE_MLO
+	if (soc->arch_ops.print_mlo_peer_hash_stats)
+		soc->arch_ops.print_mlo_peer_hash_stats(soc);
+#endif
+}
+
 #ifdef FEATURE_TSO_STATS
 void dp_print_tso_stats(struct dp_soc *soc,
 			enum qdf_stats_verbosity_level level)
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all
+ * copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * DOC: qdf_rcu
+ * This file provides OS abstraction for read-copy-update: lockless readers
+ * of data whose writers serialize among themselves and defer freeing until
+ * all pre-existing readers are done.
+ */
+
+#ifndef _QDF_RCU_H
+#define _QDF_RCU_H
+
+#include <i_qdf_rcu.h>
+
+/* Platform independent RCU callback head, embedded in the protected object */
+typedef __qdf_rcu_head_t qdf_rcu_head_t;
+
+/* Callback invoked once a grace period has elapsed */
+typedef void (*qdf_rcu_callback_t)(qdf_rcu_head_t *head);
+
+/**
+ * qdf_rcu_read_lock() - enter an RCU read-side critical section
+ *
+ * The section must not sleep.
+ *
+ * Return: none
+ */
+#define qdf_rcu_read_lock() __qdf_rcu_read_lock()
+
+/**
+ * qdf_rcu_read_unlock() - leave an RCU read-side critical section
+ *
+ * Return: none
+ */
+#define qdf_rcu_read_unlock() __qdf_rcu_read_unlock()
+
+/**
+ * qdf_rcu_dereference() - load an RCU protected pointer in a read section
+ * @p: pointer to load
+ *
+ * Return: value of @p, safe to dereference until the read section ends
+ */
+#define qdf_rcu_dereference(p) __qdf_rcu_dereference(p)
+
+/**
+ * qdf_rcu_assign_pointer() - publish an RCU protected pointer
+ * @p: pointer to assign
+ * @v: value to publish, its contents are ordered before the store
+ *
+ * Return: none
+ */
+#define qdf_rcu_assign_pointer(p, v) __qdf_rcu_assign_pointer(p, v)
+
+/**
+ * qdf_call_rcu() - invoke a callback after a grace period
+ * @head: callback head embedded in the object being retired
+ * @func: callback to invoke, typically frees the object
+ *
+ * Return: none
+ */
+static inline void qdf_call_rcu(qdf_rcu_head_t *head, qdf_rcu_callback_t func)
+{
+	__qdf_call_rcu(head, func);
+}
+
+/**
+ * qdf_rcu_barrier() - wait for all queued qdf_call_rcu() callbacks to run
+ *
+ * Must be called from a context that can sleep.
+ *
+ * Return: none
+ */
+static inline void qdf_rcu_barrier(void)
+{
+	__qdf_rcu_barrier();
+}
+
+#endif /* _QDF_RCU_H */
@@ -89,6 +89,11 @@ typedef struct qdf_sglist {
  */
 #define qdf_packed __qdf_packed
 
+/**
+ * qdf_cacheline_aligned - aligns a structure to the L1 cache line size
+ */
+#define qdf_cacheline_aligned __qdf_cacheline_aligned
+
 /**
  * qdf_toupper - char lower to upper.
  */
@@ -220,6 +220,78 @@ void scm_filter_rnr_flag_pno(struct wlan_objmgr_vdev *vdev,
 }
 #endif
 
+/**
+ * enum scm_db_index - lists of the scan db a scan node is linked into
+ * @SCM_DB_INDEX_BSSID: scan_hash_tbl, linked through @node
+ * @SCM_DB_INDEX_SSID: ssid_hash_tbl, linked through @ssid_node
+ * @SCM_DB_INDEX_FREQ: freq_hash_tbl, linked through @freq_node
+ */
+enum scm_db_index {
+	SCM_DB_INDEX_BSSID,
+	SCM_DB_INDEX_SSID,
+	SCM_DB_INDEX_FREQ,
+};
+
+/**
+ * scm_index_link() - get the list node of a scan node for an index
+ * @scan_node: scan node
+ * @index: index
+ *
+ * Return: list node linking @scan_node into @index
+ */
+static inline qdf_list_node_t *
+scm_index_link(struct scan_cache_node *scan_node, enum scm_db_index index)
+{
+	switch (index) {
+	case SCM_DB_INDEX_SSID:
+		return &scan_node->ssid_node;
+	case SCM_DB_INDEX_FREQ:
+		return &scan_node->freq_node;
+	default:
+		return &scan_node->node;
+	}
+}
+
+/**
+ * scm_index_node() - get the scan node from its list node in an index
+ * @link: list node
+ * @index: index @link belongs to
+ *
+ * Return: scan node
+ */
+static inline struct scan_cache_node *
+scm_index_node(qdf_list_node_t *link, enum scm_db_index index)
+{
+	switch (index) {
+	case SCM_DB_INDEX_SSID:
+		return qdf_container_of(link, struct scan_cache_node,
+					ssid_node);
+	case SCM_DB_INDEX_FREQ:
+		return qdf_container_of(link, struct scan_cache_node,
+					freq_node);
+	default:
+		return qdf_container_of(link, struct scan_cache_node, node);
+	}
+}
+
+/**
+ * scm_get_ssid_hash() - get the ssid index bucket of a ssid
+ * @ssid: ssid
+ *
+ * Return: index into ssid_hash_tbl
+ */
+static inline uint8_t scm_get_ssid_hash(struct wlan_ssid *ssid)
+{
+	uint32_t hash = 2166136261U;
+	uint8_t i;
+
+	/* FNV-1a, the last octet alone is too often shared between SSIDs */
+	for (i = 0; i < ssid->length && i < WLAN_SSID_MAX_LEN; i++)
+		hash = (hash ^ ssid->ssid[i]) * 16777619U;
+
+	return hash % SCAN_SSID_HASH_SIZE;
+}
+
 /**
  * scm_del_scan_node() - API to remove scan node from the list
  * @list: hash list
@@ -260,6 +332,13 @@ static QDF_STATUS scm_del_scan_node_from_db(struct scan_dbs *scan_db,
 	if (!scan_node)
 		return QDF_STATUS_E_INVAL;
 
+	hash_idx = scm_get_ssid_hash(&scan_node->entry->ssid);
+	qdf_list_remove_node(&scan_db->ssid_hash_tbl[hash_idx],
+			     &scan_node->ssid_node);
+	hash_idx = SCAN_GET_FREQ_HASH(scan_node->entry->channel.chan_freq);
+	qdf_list_remove_node(&scan_db->freq_hash_tbl[hash_idx],
+			     &scan_node->freq_node);
+
 	hash_idx = SCAN_GET_HASH(scan_node->entry->bssid.bytes);
 	scm_del_scan_node(&scan_db->scan_hash_tbl[hash_idx], scan_node);
 	scan_db->num_entries--;
@@ -383,6 +462,13 @@ static void scm_add_scan_node(struct scan_dbs *scan_db,
 		qdf_list_insert_before(&scan_db->scan_hash_tbl[hash_idx],
 				       &scan_node->node, &dup_node->node);
 
+	hash_idx = scm_get_ssid_hash(&scan_node->entry->ssid);
+	qdf_list_insert_back(&scan_db->ssid_hash_tbl[hash_idx],
+			     &scan_node->ssid_node);
+	hash_idx = SCAN_GET_FREQ_HASH(scan_node->entry->channel.chan_freq);
+	qdf_list_insert_back(&scan_db->freq_hash_tbl[hash_idx],
+			     &scan_node->freq_node);
+
 	scan_db->num_entries++;
 }
 
@@ -392,6 +478,7 @@ static void scm_add_scan_node(struct scan_dbs *scan_db,
  * the list
  * @list: hash list
  * @cur_node: current node pointer
+ * @index: index @list belongs to
  *
  * API to get next active node from the list. If cur_node is NULL
  * it will return first node of the list.
@@ -401,7 +488,7 @@ static void scm_add_scan_node(struct scan_dbs *scan_db,
  */
 static qdf_list_node_t *
 scm_get_next_valid_node(qdf_list_t *list,
-	qdf_list_node_t *cur_node)
+	qdf_list_node_t *cur_node, enum scm_db_index index)
 {
 	qdf_list_node_t *next_node = NULL;
 	qdf_list_node_t *temp_node = NULL;
@@ -413,8 +500,7 @@ scm_get_next_valid_node(qdf_list_t *list,
 		qdf_list_peek_front(list, &next_node);
 
 	while (next_node) {
-		scan_node = qdf_container_of(next_node,
-			struct scan_cache_node, node);
+		scan_node = scm_index_node(next_node, index);
 		if (scan_node->cookie == SCAN_NODE_ACTIVE_COOKIE)
 			return next_node;
 		/*
@@ -430,11 +516,12 @@ scm_get_next_valid_node(qdf_list_t *list,
 }
 
 /**
- * scm_get_next_node() - API get the next scan node from
- * the list
+ * scm_get_next_index_node() - API get the next scan node from
+ * a list of one of the scan db indexes
  * @scan_db: scan data base
  * @list: hash list
  * @cur_node: current node pointer
+ * @index: index @list belongs to
  *
  * API get the next node from the list. If cur_node is NULL
  * it will return first node of the list
@@ -442,25 +529,28 @@ scm_get_next_valid_node(qdf_list_t *list,
  * Return: next scan cache node
  */
 static struct scan_cache_node *
-scm_get_next_node(struct scan_dbs *scan_db,
-	qdf_list_t *list, struct scan_cache_node *cur_node)
+scm_get_next_index_node(struct scan_dbs *scan_db, qdf_list_t *list,
+			struct scan_cache_node *cur_node,
+			enum scm_db_index index)
 {
 	struct scan_cache_node *next_node = NULL;
 	qdf_list_node_t *next_list = NULL;
 
 	qdf_spin_lock_bh(&scan_db->scan_db_lock);
 	if (cur_node) {
-		next_list = scm_get_next_valid_node(list, &cur_node->node);
+		next_list = scm_get_next_valid_node(list,
+						    scm_index_link(cur_node,
+								   index),
+						    index);
 		/* Decrement the ref count of the previous node */
 		scm_scan_entry_put_ref(scan_db,
 			cur_node, false);
 	} else {
-		next_list = scm_get_next_valid_node(list, NULL);
+		next_list = scm_get_next_valid_node(list, NULL, index);
 	}
 	/* Increase the ref count of the obtained node */
 	if (next_list) {
-		next_node = qdf_container_of(next_list,
-			struct scan_cache_node, node);
+		next_node = scm_index_node(next_list, index);
 		scm_scan_entry_get_ref(next_node);
 	}
 	qdf_spin_unlock_bh(&scan_db->scan_db_lock);
@@ -468,6 +558,26 @@ scm_get_next_node(struct scan_dbs *scan_db,
 	return next_node;
 }
 
+/**
+ * scm_get_next_node() - API get the next scan node from
+ * the list
+ * @scan_db: scan data base
+ * @list: hash list
+ * @cur_node: current node pointer
+ *
+ * API get the next node from the list. If cur_node is NULL
+ * it will return first node of the list
+ *
+ * Return: next scan cache node
+ */
+static inline struct scan_cache_node *
+scm_get_next_node(struct scan_dbs *scan_db,
+	qdf_list_t *list, struct scan_cache_node *cur_node)
+{
+	return scm_get_next_index_node(scan_db, list, cur_node,
+				       SCM_DB_INDEX_BSSID);
+}
+
 /**
  * scm_check_and_age_out() - check and age out the old entries
  * @scan_db: scan db
@@ -1333,6 +1443,90 @@ scm_scan_apply_filter_get_entry(struct wlan_objmgr_psoc *psoc,
 	return QDF_STATUS_SUCCESS;
 }
 
+/**
+ * scm_get_results_by_index() - get scan results from the buckets of an index
+ * @psoc: psoc ptr
+ * @scan_db: scan db
+ * @filter: filter to be applied
+ * @scan_list: scan list to which entry is added
+ *
+ * Only walk the buckets an entry must be in to match the filter: the bssid
+ * hash if the filter has a BSSID list, else the ssid index if it has a SSID
+ * list, else the frequency index if it has a frequency list. Entries found
+ * are still run through the full filter.
+ *
+ * Return: false if the filter can't be served from an index
+ */
+static bool scm_get_results_by_index(struct wlan_objmgr_psoc *psoc,
+				     struct scan_dbs *scan_db,
+				     struct scan_filter *filter,
+				     qdf_list_t *scan_list)
+{
+	struct scan_cache_node *cur_node;
+	struct qdf_mac_addr *bssid;
+	enum scm_db_index index;
+	qdf_list_t *tbl;
+	/* None of the tables has more than 64 buckets */
+	uint64_t buckets = 0;
+	uint16_t i;
+
+	index = SCM_DB_INDEX_BSSID;
+	tbl = scan_db->scan_hash_tbl;
+	for (i = 0; i < filter->num_of_bssid; i++) {
+		bssid = &filter->bssid_list[i];
+		/* Zero and broadcast BSSIDs match every entry */
+		if (qdf_is_macaddr_zero(bssid) ||
+		    qdf_is_macaddr_broadcast(bssid)) {
+			buckets = 0;
+			break;
+		}
+		buckets |= 1ULL << SCAN_GET_HASH(bssid->bytes);
+	}
+
+	/* Hidden OWE transition APs match regardless of their SSID */
+	if (!buckets && filter->num_of_ssid &&
+	    !QDF_HAS_PARAM(filter->key_mgmt, WLAN_CRYPTO_KEY_MGMT_OWE)) {
+		index = SCM_DB_INDEX_SSID;
+		tbl = scan_db->ssid_hash_tbl;
+		for (i = 0; i < filter->num_of_ssid; i++)
+			buckets |= 1ULL <<
+				scm_get_ssid_hash(&filter->ssid_list[i]);
+	}
+
+	if (!buckets && filter->num_of_channels) {
+		index = SCM_DB_INDEX_FREQ;
+		tbl = scan_db->freq_hash_tbl;
+		for (i = 0; i < filter->num_of_channels; i++) {
+			/* A zero frequency matches every channel */
+			if (!filter->chan_freq_list[i]) {
+				buckets = 0;
+				break;
+			}
+			buckets |= 1ULL <<
+				SCAN_GET_FREQ_HASH(filter->chan_freq_list[i]);
+		}
+	}
+
+	if (!buckets)
+		return false;
+
+	for (i = 0; buckets; i++, buckets >>= 1) {
+		if (!(buckets & 1))
+			continue;
+
+		cur_node = scm_get_next_index_node(scan_db, &tbl[i], NULL,
+						   index);
+		while (cur_node) {
+			scm_scan_apply_filter_get_entry(psoc,
+				cur_node->entry, filter, scan_list);
+			cur_node = scm_get_next_index_node(scan_db, &tbl[i],
+							   cur_node, index);
+		}
+	}
+
+	return true;
+}
+
 /**
  * scm_get_results() - Iterate and get scan results
  * @psoc: psoc ptr
@@ -1350,6 +1544,10 @@ static void scm_get_results(struct wlan_objmgr_psoc *psoc,
 	struct scan_cache_node *cur_node;
 	struct scan_cache_node *next_node = NULL;
 
+	if (filter &&
+	    scm_get_results_by_index(psoc, scan_db, filter, scan_list))
+		return;
+
 	for (i = 0 ; i < SCAN_HASH_SIZE; i++) {
 		cur_node = scm_get_next_node(scan_db,
 			   &scan_db->scan_hash_tbl[i], NULL);
@@ -1726,6 +1924,12 @@ QDF_STATUS scm_db_init(struct wlan_objmgr_psoc *psoc)
 		for (j = 0; j < SCAN_HASH_SIZE; j++)
 			qdf_list_create(&scan_db->scan_hash_tbl[j],
 				MAX_SCAN_CACHE_SIZE);
+		for (j = 0; j < SCAN_SSID_HASH_SIZE; j++)
+			qdf_list_create(&scan_db->ssid_hash_tbl[j],
+					MAX_SCAN_CACHE_SIZE);
+		for (j = 0; j < SCAN_FREQ_HASH_SIZE; j++)
+			qdf_list_create(&scan_db->freq_hash_tbl[j],
+					MAX_SCAN_CACHE_SIZE);
 	}
 	return QDF_STATUS_SUCCESS;
 }
@@ -1751,6 +1955,10 @@ QDF_STATUS scm_db_deinit(struct wlan_objmgr_psoc *psoc)
 		scm_flush_scan_entries(psoc, scan_db, NULL);
 		for (j = 0; j < SCAN_HASH_SIZE; j++)
 			qdf_list_destroy(&scan_db->scan_hash_tbl[j]);
+		for (j = 0; j < SCAN_SSID_HASH_SIZE; j++)
+			qdf_list_destroy(&scan_db->ssid_hash_tbl[j]);
+		for (j = 0; j < SCAN_FREQ_HASH_SIZE; j++)
+			qdf_list_destroy(&scan_db->freq_hash_tbl[j]);
 		qdf_spinlock_destroy(&scan_db->scan_db_lock);
 	}
 
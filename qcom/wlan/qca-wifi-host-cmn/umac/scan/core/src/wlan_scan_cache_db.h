@@ -34,17 +34,28 @@
 #define SCAN_GET_HASH(addr) \
 	(((const uint8_t *)(addr))[QDF_MAC_ADDR_SIZE - 1] % SCAN_HASH_SIZE)
 
+#define SCAN_SSID_HASH_SIZE 64
+#define SCAN_FREQ_HASH_SIZE 64
+#define SCAN_GET_FREQ_HASH(freq) (((freq) / 5) % SCAN_FREQ_HASH_SIZE)
+
 #define ADJACENT_CHANNEL_RSSI_THRESHOLD -80
 
 /**
  * struct scan_dbs - scan cache data base definition
  * @num_entries: number of scan entries
+ * @scan_db_lock: lock protecting the hash tables
  * @scan_hash_tbl: link list of bssid hashed scan cache entries for a pdev
+ * @ssid_hash_tbl: the same entries hashed by ssid, used as an index for
+ *  filtered lookups
+ * @freq_hash_tbl: the same entries hashed by operating frequency, used as an
+ *  index for filtered lookups
  */
 struct scan_dbs {
 	uint32_t num_entries;
 	qdf_spinlock_t scan_db_lock;
 	qdf_list_t scan_hash_tbl[SCAN_HASH_SIZE];
+	qdf_list_t ssid_hash_tbl[SCAN_SSID_HASH_SIZE];
+	qdf_list_t freq_hash_tbl[SCAN_FREQ_HASH_SIZE];
 };
 
 /**
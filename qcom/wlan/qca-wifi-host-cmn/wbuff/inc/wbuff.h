@@ -48,6 +48,22 @@ struct wbuff_alloc_request {
 	uint16_t size;
 };
 
+/**
+ * struct wbuff_pool_stats - usage counters of one pool of a wbuff module
+ * @hits: buffers handed out from a per-CPU cache
+ * @misses: requests the per-CPU cache could not serve
+ * @refills: buffers moved from the module pool into per-CPU caches
+ * @drains: buffers moved from per-CPU caches back to the module pool
+ * @pending_returns: buffers handed out and not returned yet
+ */
+struct wbuff_pool_stats {
+	uint32_t hits;
+	uint32_t misses;
+	uint32_t refills;
+	uint32_t drains;
+	int32_t pending_returns;
+};
+
 /* Opaque handle for wbuff */
 struct wbuff_mod_handle;
 
@@ -114,6 +130,33 @@ qdf_nbuf_t wbuff_buff_get(struct wbuff_mod_handle *hdl, uint32_t len,
  */
 qdf_nbuf_t wbuff_buff_put(qdf_nbuf_t buf);
 
+/**
+ * wbuff_set_cache_watermark() - set the per-CPU cache size of a pool
+ * @hdl: wbuff_handle corresponding to the module
+ * @slot: pool_slot identifier
+ * @high_wm: number of buffers each CPU may keep cached for @slot, 0 makes
+ * every get and put go to the module pool
+ *
+ * Caches above a lowered watermark are trimmed on their next put.
+ *
+ * Return: QDF_STATUS_SUCCESS - watermark set
+ *         QDF_STATUS_E_INVAL - invalid handle or slot
+ */
+QDF_STATUS wbuff_set_cache_watermark(struct wbuff_mod_handle *hdl,
+				     uint8_t slot, uint16_t high_wm);
+
+/**
+ * wbuff_get_pool_stats() - get the usage counters of a pool
+ * @hdl: wbuff_handle corresponding to the module
+ * @slot: pool_slot identifier
+ * @stats: filled with the counters summed over all CPUs
+ *
+ * Return: QDF_STATUS_SUCCESS - @stats filled
+ *         QDF_STATUS_E_INVAL - invalid handle or slot
+ */
+QDF_STATUS wbuff_get_pool_stats(struct wbuff_mod_handle *hdl, uint8_t slot,
+				struct wbuff_pool_stats *stats);
+
 #else
 
 static inline QDF_STATUS wbuff_module_init(void)
@@ -151,5 +194,19 @@ wbuff_buff_put(qdf_nbuf_t buf)
 	return buf;
 }
 
+static inline QDF_STATUS
+wbuff_set_cache_watermark(struct wbuff_mod_handle *hdl, uint8_t slot,
+			  uint16_t high_wm)
+{
+	return QDF_STATUS_E_NOSUPPORT;
+}
+
+static inline QDF_STATUS
+wbuff_get_pool_stats(struct wbuff_mod_handle *hdl, uint8_t slot,
+		     struct wbuff_pool_stats *stats)
+{
+	return QDF_STATUS_E_NOSUPPORT;
+}
+
 #endif
 #endif /* _WBUFF_H */
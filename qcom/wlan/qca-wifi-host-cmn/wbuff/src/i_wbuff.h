@@ -25,6 +25,7 @@
 #define _I_WBUFF_H
 
 #include <qdf_nbuf.h>
+#include <qdf_util.h>
 
 /* Number of modules supported by wbuff */
 #define WBUFF_MAX_MODULES 4
@@ -57,6 +58,9 @@
 #define WBUFF_PSLOT_SHIFT 1
 #define WBUFF_PSLOT_BITMASK 0xE
 
+/* Upper bound of the default per-CPU cache watermark of a pool */
+#define WBUFF_PCPU_CACHE_MAX 16
+
 /* Comparison array for maximum allocation per pool*/
 uint16_t wbuff_alloc_max[WBUFF_MAX_POOLS] = {WBUFF_POOL_0_MAX,
 					     WBUFF_POOL_1_MAX,
@@ -71,25 +75,44 @@ struct wbuff_handle {
 	uint8_t id;
 };
 
+/**
+ * struct wbuff_pcpu_cache - per-CPU buffer cache in front of the module pools
+ * @lock: Lock for the cache, only contended when the caller migrates
+ * between picking and locking the cache
+ * @pool[]: cached buffers for each pool slot
+ * @count[]: number of buffers in each @pool
+ * @stats[]: usage counters of each pool slot on this CPU
+ *
+ * Cacheline aligned so that neighbouring CPUs' caches in
+ * wbuff_module::cache[] do not share a line.
+ */
+struct wbuff_pcpu_cache {
+	qdf_spinlock_t lock;
+	qdf_nbuf_t pool[WBUFF_MAX_POOLS];
+	uint16_t count[WBUFF_MAX_POOLS];
+	struct wbuff_pool_stats stats[WBUFF_MAX_POOLS];
+} qdf_cacheline_aligned;
+
 /**
  * struct wbuff_module - allocation holder for wbuff registered module
  * @registered: To identify whether module is registered
- * @pending_returns: Number of buffers pending to be returned to
- * wbuff by the module
  * @lock: Lock for accessing per module buffer slots
  * @handle: wbuff handle for the registered module
  * @reserve: nbuf headroom to start with
  * @align: alignment for the nbuf
  * @pool[]: pools for all available buffers for the module
+ * @high_wm[]: max buffers a per-CPU cache keeps for each pool slot
+ * @cache[]: per-CPU caches, lock order is cache lock before @lock
  */
 struct wbuff_module {
 	bool registered;
-	uint16_t pending_returns;
 	qdf_spinlock_t lock;
 	struct wbuff_handle handle;
 	int reserve;
 	int align;
 	qdf_nbuf_t pool[WBUFF_MAX_POOLS];
+	uint16_t high_wm[WBUFF_MAX_POOLS];
+	struct wbuff_pcpu_cache cache[QDF_MAX_AVAILABLE_CPU];
 };
 
 /**
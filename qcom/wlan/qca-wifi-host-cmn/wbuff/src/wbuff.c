@@ -170,10 +170,137 @@ static bool wbuff_is_valid_handle(struct wbuff_handle *handle)
 	return false;
 }
 
+/**
+ * wbuff_get_cache() - get the buffer cache of the current CPU
+ * @mod: wbuff module
+ *
+ * Return: per-CPU cache of @mod
+ */
+static inline struct wbuff_pcpu_cache *wbuff_get_cache(struct wbuff_module *mod)
+{
+	return &mod->cache[qdf_get_cpu() % QDF_MAX_AVAILABLE_CPU];
+}
+
+/**
+ * wbuff_cache_refill() - move buffers from the module pool to a cache
+ * @mod: wbuff module
+ * @cache: per-CPU cache, locked by the caller
+ * @pslot: pool slot
+ *
+ * Moves half a watermark worth of buffers at once, so that the following
+ * gets on this CPU don't need the module lock.
+ *
+ * Return: None
+ */
+static void wbuff_cache_refill(struct wbuff_module *mod,
+			       struct wbuff_pcpu_cache *cache, uint8_t pslot)
+{
+	uint16_t batch = mod->high_wm[pslot] / 2;
+	qdf_nbuf_t buf;
+
+	if (!batch)
+		batch = 1;
+
+	qdf_spin_lock_bh(&mod->lock);
+	while (mod->registered && batch-- && mod->pool[pslot]) {
+		buf = mod->pool[pslot];
+		mod->pool[pslot] = qdf_nbuf_next(buf);
+		qdf_nbuf_set_next(buf, cache->pool[pslot]);
+		cache->pool[pslot] = buf;
+		cache->count[pslot]++;
+		cache->stats[pslot].refills++;
+	}
+	qdf_spin_unlock_bh(&mod->lock);
+}
+
+/**
+ * wbuff_cache_drain() - move buffers from a cache back to the module pool
+ * @mod: wbuff module
+ * @cache: per-CPU cache, locked by the caller
+ * @pslot: pool slot
+ * @keep: number of buffers to leave in the cache
+ *
+ * Return: None
+ */
+static void wbuff_cache_drain(struct wbuff_module *mod,
+			      struct wbuff_pcpu_cache *cache, uint8_t pslot,
+			      uint16_t keep)
+{
+	qdf_nbuf_t buf;
+
+	qdf_spin_lock_bh(&mod->lock);
+	while (cache->count[pslot] > keep) {
+		buf = cache->pool[pslot];
+		cache->pool[pslot] = qdf_nbuf_next(buf);
+		qdf_nbuf_set_next(buf, mod->pool[pslot]);
+		mod->pool[pslot] = buf;
+		cache->count[pslot]--;
+		cache->stats[pslot].drains++;
+	}
+	qdf_spin_unlock_bh(&mod->lock);
+}
+
+/**
+ * wbuff_cache_steal() - take a buffer from the cache of any CPU
+ * @mod: wbuff module
+ * @pslot: pool slot
+ *
+ * Used when both the local cache and the module pool are empty, so that
+ * buffers parked in the caches of idle CPUs still serve the requester.
+ *
+ * Return: nbuf if found
+ *         NULL if all caches are empty
+ */
+static qdf_nbuf_t wbuff_cache_steal(struct wbuff_module *mod, uint8_t pslot)
+{
+	struct wbuff_pcpu_cache *cache;
+	qdf_nbuf_t buf = NULL;
+	int cpu;
+
+	for (cpu = 0; cpu < QDF_MAX_AVAILABLE_CPU && !buf; cpu++) {
+		cache = &mod->cache[cpu];
+		if (!cache->count[pslot])
+			continue;
+
+		qdf_spin_lock_bh(&cache->lock);
+		buf = cache->pool[pslot];
+		if (buf) {
+			cache->pool[pslot] = qdf_nbuf_next(buf);
+			cache->count[pslot]--;
+			cache->stats[pslot].pending_returns++;
+		}
+		qdf_spin_unlock_bh(&cache->lock);
+	}
+
+	return buf;
+}
+
+/**
+ * wbuff_cache_free() - free all buffers of a cache
+ * @cache: per-CPU cache, locked by the caller
+ *
+ * Return: None
+ */
+static void wbuff_cache_free(struct wbuff_pcpu_cache *cache)
+{
+	uint8_t pslot;
+	qdf_nbuf_t buf;
+
+	for (pslot = 0; pslot < WBUFF_MAX_POOLS; pslot++) {
+		while (cache->pool[pslot]) {
+			buf = cache->pool[pslot];
+			cache->pool[pslot] = qdf_nbuf_next(buf);
+			qdf_nbuf_free(buf);
+		}
+		cache->count[pslot] = 0;
+	}
+}
+
 QDF_STATUS wbuff_module_init(void)
 {
 	struct wbuff_module *mod = NULL;
 	uint8_t mslot = 0, pslot = 0;
+	int cpu;
 
 	if (!qdf_nbuf_is_dev_scratch_supported()) {
 		wbuff.initialized = false;
@@ -185,6 +312,10 @@ QDF_STATUS wbuff_module_init(void)
 		qdf_spinlock_create(&mod->lock);
 		for (pslot = 0; pslot < WBUFF_MAX_POOLS; pslot++)
 			mod->pool[pslot] = NULL;
+		for (cpu = 0; cpu < QDF_MAX_AVAILABLE_CPU; cpu++) {
+			qdf_mem_zero(&mod->cache[cpu], sizeof(mod->cache[cpu]));
+			qdf_spinlock_create(&mod->cache[cpu].lock);
+		}
 		mod->registered = false;
 	}
 	wbuff.initialized = true;
@@ -196,6 +327,7 @@ QDF_STATUS wbuff_module_deinit(void)
 {
 	struct wbuff_module *mod = NULL;
 	uint8_t mslot = 0;
+	int cpu;
 
 	if (!wbuff.initialized)
 		return QDF_STATUS_E_INVAL;
@@ -206,6 +338,8 @@ QDF_STATUS wbuff_module_deinit(void)
 		if (mod->registered)
 			wbuff_module_deregister((struct wbuff_mod_handle *)
 						&mod->handle);
+		for (cpu = 0; cpu < QDF_MAX_AVAILABLE_CPU; cpu++)
+			qdf_spinlock_destroy(&mod->cache[cpu].lock);
 		qdf_spinlock_destroy(&mod->lock);
 	}
 
@@ -221,6 +355,7 @@ wbuff_module_register(struct wbuff_alloc_request *req, uint8_t num,
 	uint32_t len = 0;
 	uint16_t idx = 0, psize = 0;
 	uint8_t alloc = 0, mslot = 0, pslot = 0;
+	int cpu;
 
 	if (!wbuff.initialized)
 		return NULL;
@@ -239,10 +374,24 @@ wbuff_module_register(struct wbuff_alloc_request *req, uint8_t num,
 
 	mod->handle.id = mslot;
 
+	for (cpu = 0; cpu < QDF_MAX_AVAILABLE_CPU; cpu++)
+		qdf_mem_zero(mod->cache[cpu].stats,
+			     sizeof(mod->cache[cpu].stats));
+
+	for (pslot = 0; pslot < WBUFF_MAX_POOLS; pslot++)
+		mod->high_wm[pslot] = 0;
+
 	for (alloc = 0; alloc < num; alloc++) {
 		pslot = req[alloc].slot;
 		psize = req[alloc].size;
 		len = wbuff_get_len_from_pool_slot(pslot);
+		/*
+		 * Let the caches of all CPUs together hold at most half of
+		 * the pool by default
+		 */
+		mod->high_wm[pslot] = qdf_min(psize /
+					      (2 * QDF_MAX_AVAILABLE_CPU),
+					      WBUFF_PCPU_CACHE_MAX);
 		/**
 		 * Allocate pool_cnt number of buffers for
 		 * the pool given by pslot
@@ -273,6 +422,7 @@ QDF_STATUS wbuff_module_deregister(struct wbuff_mod_handle *hdl)
 	struct wbuff_module *mod = NULL;
 	uint8_t mslot = 0, pslot = 0;
 	qdf_nbuf_t first = NULL, buf = NULL;
+	int cpu;
 
 	handle = (struct wbuff_handle *)hdl;
 
@@ -282,6 +432,21 @@ QDF_STATUS wbuff_module_deregister(struct wbuff_mod_handle *hdl)
 	mslot = handle->id;
 	mod = &wbuff.mod[mslot];
 
+	qdf_spin_lock_bh(&mod->lock);
+	mod->registered = false;
+	qdf_spin_unlock_bh(&mod->lock);
+
+	/*
+	 * Puts that saw the module registered hold their cache lock until
+	 * done, so once every cache has been emptied nothing adds buffers
+	 * back, and refills stop at the registered check.
+	 */
+	for (cpu = 0; cpu < QDF_MAX_AVAILABLE_CPU; cpu++) {
+		qdf_spin_lock_bh(&mod->cache[cpu].lock);
+		wbuff_cache_free(&mod->cache[cpu]);
+		qdf_spin_unlock_bh(&mod->cache[cpu].lock);
+	}
+
 	qdf_spin_lock_bh(&mod->lock);
 	for (pslot = 0; pslot < WBUFF_MAX_POOLS; pslot++) {
 		first = mod->pool[pslot];
@@ -290,8 +455,8 @@ QDF_STATUS wbuff_module_deregister(struct wbuff_mod_handle *hdl)
 			first = qdf_nbuf_next(buf);
 			qdf_nbuf_free(buf);
 		}
+		mod->pool[pslot] = NULL;
 	}
-	mod->registered = false;
 	qdf_spin_unlock_bh(&mod->lock);
 
 	return QDF_STATUS_SUCCESS;
@@ -302,6 +467,7 @@ qdf_nbuf_t wbuff_buff_get(struct wbuff_mod_handle *hdl, uint32_t len,
 {
 	struct wbuff_handle *handle;
 	struct wbuff_module *mod = NULL;
+	struct wbuff_pcpu_cache *cache;
 	uint8_t mslot = 0;
 	uint8_t pslot = 0;
 	qdf_nbuf_t buf = NULL;
@@ -316,13 +482,26 @@ qdf_nbuf_t wbuff_buff_get(struct wbuff_mod_handle *hdl, uint32_t len,
 	pslot = wbuff_get_pool_slot_from_len(len);
 	mod = &wbuff.mod[mslot];
 
-	qdf_spin_lock_bh(&mod->lock);
-	if (mod->pool[pslot]) {
-		buf = mod->pool[pslot];
-		mod->pool[pslot] = qdf_nbuf_next(buf);
-		mod->pending_returns++;
+	cache = wbuff_get_cache(mod);
+	qdf_spin_lock_bh(&cache->lock);
+	if (cache->pool[pslot]) {
+		cache->stats[pslot].hits++;
+	} else {
+		cache->stats[pslot].misses++;
+		wbuff_cache_refill(mod, cache, pslot);
 	}
-	qdf_spin_unlock_bh(&mod->lock);
+
+	buf = cache->pool[pslot];
+	if (buf) {
+		cache->pool[pslot] = qdf_nbuf_next(buf);
+		cache->count[pslot]--;
+		cache->stats[pslot].pending_returns++;
+	}
+	qdf_spin_unlock_bh(&cache->lock);
+
+	if (!buf)
+		buf = wbuff_cache_steal(mod, pslot);
+
 	if (buf) {
 		qdf_nbuf_set_next(buf, NULL);
 		qdf_net_buf_debug_update_node(buf, func_name, line_num);
@@ -334,6 +513,8 @@ qdf_nbuf_t wbuff_buff_get(struct wbuff_mod_handle *hdl, uint32_t len,
 qdf_nbuf_t wbuff_buff_put(qdf_nbuf_t buf)
 {
 	qdf_nbuf_t buffer = buf;
+	struct wbuff_module *mod;
+	struct wbuff_pcpu_cache *cache;
 	unsigned long slot_info = 0;
 	uint8_t mslot = 0, pslot = 0;
 
@@ -350,16 +531,67 @@ qdf_nbuf_t wbuff_buff_put(qdf_nbuf_t buf)
 	if (mslot >= WBUFF_MAX_MODULES || pslot >= WBUFF_MAX_POOLS)
 		return NULL;
 
-	qdf_nbuf_reset(buffer, wbuff.mod[mslot].reserve, wbuff.mod[mslot].
-		       align);
-	qdf_spin_lock_bh(&wbuff.mod[mslot].lock);
-	if (wbuff.mod[mslot].registered) {
-		qdf_nbuf_set_next(buffer, wbuff.mod[mslot].pool[pslot]);
-		wbuff.mod[mslot].pool[pslot] = buffer;
-		wbuff.mod[mslot].pending_returns--;
+	mod = &wbuff.mod[mslot];
+	qdf_nbuf_reset(buffer, mod->reserve, mod->align);
+
+	cache = wbuff_get_cache(mod);
+	qdf_spin_lock_bh(&cache->lock);
+	if (mod->registered) {
+		qdf_nbuf_set_next(buffer, cache->pool[pslot]);
+		cache->pool[pslot] = buffer;
+		cache->count[pslot]++;
+		cache->stats[pslot].pending_returns--;
+		if (cache->count[pslot] > mod->high_wm[pslot])
+			wbuff_cache_drain(mod, cache, pslot,
+					  mod->high_wm[pslot] / 2);
 		buffer = NULL;
 	}
-	qdf_spin_unlock_bh(&wbuff.mod[mslot].lock);
+	qdf_spin_unlock_bh(&cache->lock);
 
 	return buffer;
 }
+
+QDF_STATUS wbuff_set_cache_watermark(struct wbuff_mod_handle *hdl,
+				     uint8_t slot, uint16_t high_wm)
+{
+	struct wbuff_handle *handle;
+
+	handle = (struct wbuff_handle *)hdl;
+
+	if ((!wbuff.initialized) || (!wbuff_is_valid_handle(handle)) ||
+	    (slot > WBUFF_MAX_POOLS - 1))
+		return QDF_STATUS_E_INVAL;
+
+	wbuff.mod[handle->id].high_wm[slot] = qdf_min(high_wm,
+						      wbuff_alloc_max[slot]);
+
+	return QDF_STATUS_SUCCESS;
+}
+
+QDF_STATUS wbuff_get_pool_stats(struct wbuff_mod_handle *hdl, uint8_t slot,
+				struct wbuff_pool_stats *stats)
+{
+	struct wbuff_handle *handle;
+	struct wbuff_pcpu_cache *cache;
+	int cpu;
+
+	handle = (struct wbuff_handle *)hdl;
+
+	if ((!wbuff.initialized) || (!wbuff_is_valid_handle(handle)) ||
+	    (slot > WBUFF_MAX_POOLS - 1) || !stats)
+		return QDF_STATUS_E_INVAL;
+
+	qdf_mem_zero(stats, sizeof(*stats));
+	for (cpu = 0; cpu < QDF_MAX_AVAILABLE_CPU; cpu++) {
+		cache = &wbuff.mod[handle->id].cache[cpu];
+		qdf_spin_lock_bh(&cache->lock);
+		stats->hits += cache->stats[slot].hits;
+		stats->misses += cache->stats[slot].misses;
+		stats->refills += cache->stats[slot].refills;
+		stats->drains += cache->stats[slot].drains;
+		stats->pending_returns += cache->stats[slot].pending_returns;
+		qdf_spin_unlock_bh(&cache->lock);
+	}
+
+	return QDF_STATUS_SUCCESS;
+}
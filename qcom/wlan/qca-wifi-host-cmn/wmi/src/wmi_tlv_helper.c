@@ -21,6 +21,7 @@
 #include "wmi_tlv_defs.h"
 #include "wmi_version.h"
 #include "qdf_module.h"
+#include "qdf_util.h"
 
 #define WMITLV_GET_ATTRIB_NUM_TLVS  0xFFFFFFFF
 
@@ -54,6 +55,31 @@ uint32_t evt_attr_list[] = {
 	WMITLV_ALL_EVT_LIST(WMITLV_GET_CMD_EVT_ATTRB_LIST)
 };
 
+/*
+ * Open addressed hash index from a command/event ID to the position of its
+ * ATTRB0 word in cmd_attr_list/evt_attr_list, stored as position + 1 so that
+ * 0 marks an empty slot. The tables are kept at most half full.
+ */
+#define WMITLV_COUNT_ID(id) 1 +
+#define WMITLV_NUM_CMDS (WMITLV_ALL_CMD_LIST(WMITLV_COUNT_ID) 0)
+#define WMITLV_NUM_EVTS (WMITLV_ALL_EVT_LIST(WMITLV_COUNT_ID) 0)
+
+#define WMITLV_CMD_INDEX_BITS 11
+#define WMITLV_EVT_INDEX_BITS 10
+
+QDF_COMPILE_TIME_ASSERT(wmitlv_cmd_index_size,
+			2 * WMITLV_NUM_CMDS <= (1 << WMITLV_CMD_INDEX_BITS));
+QDF_COMPILE_TIME_ASSERT(wmitlv_evt_index_size,
+			2 * WMITLV_NUM_EVTS <= (1 << WMITLV_EVT_INDEX_BITS));
+QDF_COMPILE_TIME_ASSERT(wmitlv_cmd_index_range,
+			QDF_ARRAY_SIZE(cmd_attr_list) < 0xFFFF);
+QDF_COMPILE_TIME_ASSERT(wmitlv_evt_index_range,
+			QDF_ARRAY_SIZE(evt_attr_list) < 0xFFFF);
+
+static uint16_t wmitlv_cmd_attr_index[1 << WMITLV_CMD_INDEX_BITS];
+static uint16_t wmitlv_evt_attr_index[1 << WMITLV_EVT_INDEX_BITS];
+static bool wmitlv_attr_index_ready;
+
 #ifdef NO_DYNAMIC_MEM_ALLOC
 static wmitlv_cmd_param_info *g_wmi_static_cmd_param_info_buf;
 uint32_t g_wmi_static_max_cmd_param_tlvs;
@@ -88,6 +114,92 @@ wmitlv_set_static_param_tlv_buf(void *param_tlv_buf,
 #endif
 }
 
+static inline uint32_t wmitlv_attr_hash(uint32_t cmd_event_id, uint32_t bits)
+{
+	return (WMITLV_GET_CMDID(cmd_event_id) * 0x9E3779B1) >> (32 - bits);
+}
+
+static void wmitlv_attr_index_build(uint32_t *attr_list, uint32_t num_entries,
+				    uint16_t *index, uint32_t bits)
+{
+	uint32_t i, slot, mask = (1 << bits) - 1;
+	uint32_t id;
+
+	for (i = 0; i < num_entries;
+	     i += WMITLV_GET_NUM_TLVS(attr_list[i]) + 1) {
+		id = WMITLV_GET_CMDID(attr_list[i]);
+		slot = wmitlv_attr_hash(id, bits);
+		while (index[slot] &&
+		       WMITLV_GET_CMDID(attr_list[index[slot] - 1]) != id)
+			slot = (slot + 1) & mask;
+
+		/* Keep the first definition, as the linear lookup did */
+		if (!index[slot])
+			index[slot] = i + 1;
+	}
+}
+
+/**
+ * wmitlv_attr_index_init() - build the TLV attribute lookup index
+ *
+ * Indexes cmd_attr_list and evt_attr_list by command/event ID so that
+ * wmitlv_get_attributes() does not have to walk the whole list for every
+ * TLV it checks. Must be called before any WMI traffic; lookups fall back
+ * to the linear walk until it has run.
+ *
+ * Return: None
+ */
+void wmitlv_attr_index_init(void)
+{
+	if (wmitlv_attr_index_ready)
+		return;
+
+	wmitlv_attr_index_build(cmd_attr_list, QDF_ARRAY_SIZE(cmd_attr_list),
+				wmitlv_cmd_attr_index, WMITLV_CMD_INDEX_BITS);
+	wmitlv_attr_index_build(evt_attr_list, QDF_ARRAY_SIZE(evt_attr_list),
+				wmitlv_evt_attr_index, WMITLV_EVT_INDEX_BITS);
+	qdf_mb();
+	wmitlv_attr_index_ready = true;
+}
+
+/**
+ * wmitlv_find_attr_entry() - find the attribute entry of a cmd/event
+ * @attr_list: cmd_attr_list or evt_attr_list
+ * @num_entries: number of words in @attr_list
+ * @index: hash index of @attr_list
+ * @bits: log2 of the number of slots in @index
+ * @cmd_event_id: command event id
+ *
+ * Return: position of the ATTRB0 word of @cmd_event_id, or @num_entries if
+ * it has no attribute definitions
+ */
+static uint32_t wmitlv_find_attr_entry(uint32_t *attr_list,
+				       uint32_t num_entries, uint16_t *index,
+				       uint32_t bits, uint32_t cmd_event_id)
+{
+	uint32_t i, slot, mask = (1 << bits) - 1;
+	uint32_t id = WMITLV_GET_CMDID(cmd_event_id);
+
+	if (qdf_likely(wmitlv_attr_index_ready)) {
+		slot = wmitlv_attr_hash(id, bits);
+		while (index[slot]) {
+			i = index[slot] - 1;
+			if (WMITLV_GET_CMDID(attr_list[i]) == id)
+				return i;
+			slot = (slot + 1) & mask;
+		}
+		return num_entries;
+	}
+
+	for (i = 0; i < num_entries;
+	     i += WMITLV_GET_NUM_TLVS(attr_list[i]) + 1) {
+		if (WMITLV_GET_CMDID(attr_list[i]) == id)
+			return i;
+	}
+
+	return num_entries;
+}
+
 /**
  * wmitlv_get_attributes() - tlv helper function
  * @is_cmd_id: boolean for command attribute
@@ -112,67 +224,71 @@ uint32_t wmitlv_get_attributes(uint32_t is_cmd_id, uint32_t cmd_event_id,
 	if (is_cmd_id) {
 		pAttrArrayList = &cmd_attr_list[0];
 		num_entries = QDF_ARRAY_SIZE(cmd_attr_list);
+		i = wmitlv_find_attr_entry(pAttrArrayList, num_entries,
+					   wmitlv_cmd_attr_index,
+					   WMITLV_CMD_INDEX_BITS,
+					   cmd_event_id);
 	} else {
 		pAttrArrayList = &evt_attr_list[0];
 		num_entries = QDF_ARRAY_SIZE(evt_attr_list);
+		i = wmitlv_find_attr_entry(pAttrArrayList, num_entries,
+					   wmitlv_evt_attr_index,
+					   WMITLV_EVT_INDEX_BITS,
+					   cmd_event_id);
 	}
 
-	for (i = 0; i < num_entries; i++) {
-		num_tlvs = WMITLV_GET_NUM_TLVS(pAttrArrayList[i]);
-		if (WMITLV_GET_CMDID(cmd_event_id) ==
-		    WMITLV_GET_CMDID(pAttrArrayList[i])) {
-			tlv_attr_ptr->cmd_num_tlv = num_tlvs;
-			/* Return success from here when only number of TLVS for
-			 * this command/event is required */
-			if (curr_tlv_order == WMITLV_GET_ATTRIB_NUM_TLVS) {
-				wmi_tlv_print_verbose
-					("%s: WMI TLV attribute definitions for %s:0x%x found; num_of_tlvs:%d\n",
-					__func__, (is_cmd_id ? "Cmd" : "Evt"),
-					cmd_event_id, num_tlvs);
-				return 0;
-			}
+	if (i >= num_entries) {
+		wmi_tlv_print_error
+			("%s: ERROR: Didn't found WMI TLV attribute definitions for %s:0x%x\n",
+			__func__, (is_cmd_id ? "Cmd" : "Evt"), cmd_event_id);
+		return 1;
+	}
 
-			/* Return failure if tlv_order is more than the expected
-			 * number of TLVs */
-			if (curr_tlv_order >= num_tlvs) {
-				wmi_tlv_print_error
-					("%s: ERROR: TLV order %d greater than num_of_tlvs:%d for %s:0x%x\n",
-					__func__, curr_tlv_order, num_tlvs,
-					(is_cmd_id ? "Cmd" : "Evt"), cmd_event_id);
-				return 1;
-			}
+	num_tlvs = WMITLV_GET_NUM_TLVS(pAttrArrayList[i]);
+	tlv_attr_ptr->cmd_num_tlv = num_tlvs;
+	/* Return success from here when only number of TLVS for
+	 * this command/event is required */
+	if (curr_tlv_order == WMITLV_GET_ATTRIB_NUM_TLVS) {
+		wmi_tlv_print_verbose
+			("%s: WMI TLV attribute definitions for %s:0x%x found; num_of_tlvs:%d\n",
+			__func__, (is_cmd_id ? "Cmd" : "Evt"),
+			cmd_event_id, num_tlvs);
+		return 0;
+	}
 
-			base_index = i + 1;     /* index to first TLV attributes */
-			wmi_tlv_print_verbose
-				("%s: WMI TLV attributes for %s:0x%x tlv[%d]:0x%x\n",
-				__func__, (is_cmd_id ? "Cmd" : "Evt"),
-				cmd_event_id, curr_tlv_order,
-				pAttrArrayList[(base_index + curr_tlv_order)]);
-			tlv_attr_ptr->tag_order = curr_tlv_order;
-			tlv_attr_ptr->tag_id =
-				WMITLV_GET_TAGID(pAttrArrayList
-						 [(base_index + curr_tlv_order)]);
-			tlv_attr_ptr->tag_struct_size =
-				WMITLV_GET_TAG_STRUCT_SIZE(pAttrArrayList
-							   [(base_index +
-							     curr_tlv_order)]);
-			tlv_attr_ptr->tag_varied_size =
-				WMITLV_GET_TAG_VARIED(pAttrArrayList
-						      [(base_index +
-							curr_tlv_order)]);
-			tlv_attr_ptr->tag_array_size =
-				WMITLV_GET_TAG_ARRAY_SIZE(pAttrArrayList
-							  [(base_index +
-							    curr_tlv_order)]);
-			return 0;
-		}
-		i += num_tlvs;
+	/* Return failure if tlv_order is more than the expected
+	 * number of TLVs */
+	if (curr_tlv_order >= num_tlvs) {
+		wmi_tlv_print_error
+			("%s: ERROR: TLV order %d greater than num_of_tlvs:%d for %s:0x%x\n",
+			__func__, curr_tlv_order, num_tlvs,
+			(is_cmd_id ? "Cmd" : "Evt"), cmd_event_id);
+		return 1;
 	}
 
-	wmi_tlv_print_error
-		("%s: ERROR: Didn't found WMI TLV attribute definitions for %s:0x%x\n",
-		__func__, (is_cmd_id ? "Cmd" : "Evt"), cmd_event_id);
-	return 1;
+	base_index = i + 1;     /* index to first TLV attributes */
+	wmi_tlv_print_verbose
+		("%s: WMI TLV attributes for %s:0x%x tlv[%d]:0x%x\n",
+		__func__, (is_cmd_id ? "Cmd" : "Evt"),
+		cmd_event_id, curr_tlv_order,
+		pAttrArrayList[(base_index + curr_tlv_order)]);
+	tlv_attr_ptr->tag_order = curr_tlv_order;
+	tlv_attr_ptr->tag_id =
+		WMITLV_GET_TAGID(pAttrArrayList
+				 [(base_index + curr_tlv_order)]);
+	tlv_attr_ptr->tag_struct_size =
+		WMITLV_GET_TAG_STRUCT_SIZE(pAttrArrayList
+					   [(base_index +
+					     curr_tlv_order)]);
+	tlv_attr_ptr->tag_varied_size =
+		WMITLV_GET_TAG_VARIED(pAttrArrayList
+				      [(base_index +
+					curr_tlv_order)]);
+	tlv_attr_ptr->tag_array_size =
+		WMITLV_GET_TAG_ARRAY_SIZE(pAttrArrayList
+					  [(base_index +
+					    curr_tlv_order)]);
+	return 0;
 }
 
 /**
@@ -21391,5 +21391,6 @@ qdf_export_symbol(wmi_tlv_attach);
  */
 void wmi_tlv_init(void)
 {
+	wmitlv_attr_index_init();
 	wmi_unified_register_module(WMI_TLV_TARGET, &wmi_tlv_attach);
 }